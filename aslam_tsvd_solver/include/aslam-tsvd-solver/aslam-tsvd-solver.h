@@ -5,13 +5,15 @@
 #include <string>
 #include <vector>
 
-#include <aslam/backend/CompressedColumnJacobianTransposeBuilder.hpp>
 #include <aslam/backend/LinearSystemSolver.hpp>
 #include <Eigen/Core>
 
 #include <truncated-svd-solver/tsvd-solver.h>
 #include <truncated-svd-solver/tsvd-solver-options.h>
 
+#include "aslam-tsvd-solver/jacobian-transpose-builder.h"
+#include "aslam-tsvd-solver/schur-eliminator.h"
+
 template<typename Entry> struct SuiteSparseQR_factorization;
 
 namespace sm {
@@ -26,6 +28,15 @@ template<typename I> class CompressedColumnMatrix;
 }
 
 namespace backend {
+/// Options of the SPQR factorization of the nuisance columns
+struct SpqrOptions {
+  SpqrOptions();
+  /// Fill-reducing column ordering (SPQR_ORDERING_*)
+  int ordering;
+  /// Number of TBB threads used by SPQR, 0 lets TBB decide
+  int num_threads;
+};
+
 /** The class AslamTruncatedSvdSolver interfaces the truncated_svd_solver
  *  and provides the necessary interfaces to work as an aslam solver.
  */
@@ -34,8 +45,9 @@ class AslamTruncatedSvdSolver
       public truncated_svd_solver::TruncatedSvdSolver {
  public:
   typedef truncated_svd_solver::TruncatedSvdSolverOptions Options;
-  /// Constructor with options structure
-  AslamTruncatedSvdSolver(const Options& options = Options());
+  /// Constructor with options structures
+  AslamTruncatedSvdSolver(const Options& options = Options(),
+                          const SpqrOptions& spqr_options = SpqrOptions());
   /// Constructor with property tree configuration
   AslamTruncatedSvdSolver(const sm::PropertyTree& config);
   /// Copy constructor
@@ -53,6 +65,9 @@ class AslamTruncatedSvdSolver
 
   /// Build the system of equations assuming things have been set
   virtual void buildSystem(size_t numThreads, bool useMEstimator) override;
+  /// Build only the equations of the error terms the last initialization
+  /// appended, the kept ones must be unchanged since they were built
+  void buildAppendedSystem(size_t numThreads, bool useMEstimator);
   /// Solve the system of equations assuming things have been set
   virtual bool solveSystem(Eigen::VectorXd& dx) override;
   /// Helper function for dog leg implementation / steepest descent solution
@@ -63,8 +78,47 @@ class AslamTruncatedSvdSolver
   }
 
   bool analyzeMarginal();
+  /// Enables the elimination of block-diagonal nuisance variables
+  void setSchurElimination(bool schur_elimination);
+  /// Returns true if block-diagonal nuisance variables are eliminated
+  bool getSchurElimination() const;
+  /// Returns true if the last solve or analysis used the elimination
+  bool isSchurEliminationApplied() const;
+  /// Sets the SPQR options, the ordering is recomputed on the next solve
+  void setSpqrOptions(const SpqrOptions& spqr_options);
+  /// Returns the SPQR options
+  const SpqrOptions& getSpqrOptions() const;
+  /// Returns the number of symbolic factorizations of the nuisance columns
+  size_t getNumSymbolicFactorizations() const;
+  /// Returns the estimated numerical rank of the nuisance columns
+  std::ptrdiff_t getQRRank() const;
+  /// Returns the estimated numerical rank deficiency of the nuisance columns
+  std::ptrdiff_t getQRRankDeficiency() const;
+  /// Returns the tolerance used for the QR decompositions
+  double getQRTolerance() const;
+  /// Returns the peak memory usage of cholmod and the Jacobian builder [B]
+  size_t getPeakMemoryUsage() const;
+  /// Returns the memory usage of cholmod and the Jacobian builder [B]
+  size_t getMemoryUsage() const;
   const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
       getJacobianTranspose() const;
+  /// Returns a view on the current Jacobian transpose (valid until rebuilt)
+  void getJacobianTransposeView(cholmod_sparse* view);
+  /// Returns the number of non-zeros of the current Jacobian
+  std::size_t getJacobianNnz() const;
+  /// Returns the time spent on the Jacobian structure and values [s]
+  double getJacobianTime() const;
+  /// Returns the time spent solving linear systems [s]
+  double getSolveTime() const;
+  /// Resets the accumulated Jacobian and solve times
+  void resetTimings();
+  /// Saves the Jacobian before error terms are appended to the problem
+  void saveJacobianState();
+  /// Restores the saved Jacobian once the appended error terms are removed,
+  /// keeping the first num_kept_dvs design variables followed by moved_dvs,
+  /// false if it was lost
+  bool restoreJacobianState(size_t num_kept_dvs,
+      const std::vector<aslam::backend::DesignVariable*>& moved_dvs);
 
  protected:
   /// Initialize the matrix structure for the problem
@@ -74,8 +128,44 @@ class AslamTruncatedSvdSolver
       bool use_diagonal_conditioner);
 
  private:
-  aslam::backend::CompressedColumnJacobianTransposeBuilder<std::ptrdiff_t>
-    jacobian_builder_;
+  /// Finds the nuisance blocks if needed, false if they cannot be eliminated
+  bool prepareSchurElimination();
+  /// Returns a view on the reduced system of the last elimination
+  void getReducedView(cholmod_sparse* A, cholmod_dense* b);
+  /// Drops the cholmod state if the sparsity pattern of J changed
+  void updateStructureVersion();
+  /// Computes the ordering and symbolic factorization of J_psi if stale
+  void prepareSymbolicFactorization(const cholmod_sparse& J);
+
+  aslam::backend::IncrementalJacobianTransposeBuilder jacobian_builder_;
+  /// Accumulated time in initMatrixStructure() and buildSystem() [s]
+  double jacobian_time_;
+  /// Accumulated time in solveSystem() [s]
+  double solve_time_;
+  /// Eliminator of the block-diagonal nuisance variables
+  BlockDiagonalSchurEliminator schur_eliminator_;
+  /// True if block-diagonal nuisance variables should be eliminated
+  bool schur_elimination_;
+  /// True if the nuisance blocks reflect the current structure
+  bool schur_structure_valid_;
+  /// True if the nuisance blocks can be eliminated
+  bool schur_structure_eliminable_;
+  /// True if the last solve or analysis used the elimination
+  bool schur_elimination_applied_;
+  /// Number of threads of the last buildSystem() call
+  size_t num_threads_;
+  /// Options of the SPQR factorization
+  SpqrOptions spqr_options_;
+  /// Structure version of the Jacobian the cholmod state was computed for
+  size_t structure_version_;
+  /// True if the cached symbolic factorization follows spqr_options_
+  bool symbolic_valid_;
+  /// Structure version of the cached symbolic factorization
+  size_t symbolic_structure_version_;
+  /// Number of columns of J_psi of the cached symbolic factorization
+  std::ptrdiff_t symbolic_marg_start_index_;
+  /// Number of symbolic factorizations of J_psi
+  size_t num_symbolic_factorizations_;
 };
 
 }  // namespace backend
@@ -0,0 +1,202 @@
+#ifndef ASLAM_TSVD_SOLVER_JACOBIAN_TRANSPOSE_BUILDER_H
+#define ASLAM_TSVD_SOLVER_JACOBIAN_TRANSPOSE_BUILDER_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+struct cholmod_sparse_struct;
+typedef struct cholmod_sparse_struct cholmod_sparse;
+
+namespace aslam {
+namespace backend {
+class DesignVariable;
+class ErrorTerm;
+template<typename I> class CompressedColumnMatrix;
+
+/** The class IncrementalJacobianTransposeBuilder builds the transpose of the
+ *  Jacobian in compressed-column form, i.e., one column per residual row.
+ *  Error terms shared with the previous initialization keep their structure:
+ *  appending a batch only adds the columns of its error terms, and dropping
+ *  batches removes theirs. The kept error terms are validated through the
+ *  design variables they reference, each of which is counted once, so the
+ *  cost of an initialization does not depend on the number of kept error
+ *  terms. When design variables move, e.g., the calibration variables after
+ *  nuisance variables were inserted before them, the row indices are remapped
+ *  in a single pass.
+ *  The state can be saved before appending a batch: the values overwritten
+ *  afterwards are swapped instead of copied, such that dropping the batch
+ *  again restores the saved structure and values without evaluating any
+ *  Jacobian.
+ */
+class IncrementalJacobianTransposeBuilder {
+ public:
+  typedef std::ptrdiff_t Index;
+
+  /// Default constructor
+  IncrementalJacobianTransposeBuilder();
+  /// Copy constructor
+  IncrementalJacobianTransposeBuilder(
+      const IncrementalJacobianTransposeBuilder& other) = delete;
+  /// Copy assignment operator
+  IncrementalJacobianTransposeBuilder& operator= (
+      const IncrementalJacobianTransposeBuilder& other) = delete;
+  /// Destructor
+  ~IncrementalJacobianTransposeBuilder();
+
+  /// Initializes the structure, reusing the common prefix of error terms
+  void initMatrixStructure(const std::vector<DesignVariable*>& dvs,
+                           const std::vector<ErrorTerm*>& errors);
+  /// Evaluates the weighted Jacobians of all the error terms
+  void buildSystem(size_t num_threads, bool use_m_estimator);
+  /// Evaluates the weighted Jacobians of the error terms appended by the last
+  /// initialization, the kept error terms keep their values
+  void buildAppendedErrorTerms(size_t num_threads, bool use_m_estimator);
+  /// Drops the structure
+  void clear();
+  /// Saves the structure and values for a later restoreState()
+  void saveState();
+  /// Restores the saved state after the appended error terms were removed,
+  /// moved_dvs are the design variables moved back by the removal
+  bool restoreState(const std::vector<DesignVariable*>& moved_dvs);
+  /// Drops the saved state
+  void discardState();
+
+  /// Number of rows of J^T, i.e., number of columns of J
+  Index rows() const { return rows_; }
+  /// Number of columns of J^T, i.e., number of rows of J
+  Index cols() const { return col_ptr_.size() - 1; }
+  /// Number of non-zeros
+  Index nnz() const { return row_idx_.size(); }
+  /// Number of error terms
+  size_t numErrorTerms() const { return errors_.size(); }
+  /// Number of error terms whose structure was kept by the last init
+  size_t numReusedErrorTerms() const { return num_reused_errors_; }
+  /// Incremented whenever the sparsity pattern may have changed
+  size_t structureVersion() const { return structure_version_; }
+  /// True if a state was saved and can still be restored
+  bool hasSavedState() const { return has_saved_state_; }
+  /// Returns a cholmod view on J^T (no copy)
+  void getView(cholmod_sparse* view);
+  /// Returns a cholmod view on J, with values refilled from J^T
+  void getJacobianView(cholmod_sparse* view);
+  /// Returns the memory currently held by the builder [B]
+  size_t getMemoryUsage() const;
+  /// Returns the peak memory held by the builder [B]
+  size_t getPeakMemoryUsage() const { return peak_memory_usage_; }
+  /// Returns J^T as an aslam matrix (copied on demand)
+  const CompressedColumnMatrix<Index>& J_transpose() const;
+
+ private:
+  /// Design variable referenced by kept error terms
+  struct Slot {
+    /// Design variable, NULL if the slot is free
+    DesignVariable* dv;
+    /// Column base the row indices were written with, -1 if inactive
+    Index base;
+    /// Column base in the current initialization
+    Index new_base;
+    /// Number of columns in J, 0 if inactive
+    int dim;
+    /// Number of references by error terms
+    size_t refs;
+    /// Initialization in which the design variable was last seen
+    size_t stamp;
+    /// True if the design variable was active when first referenced
+    bool active;
+  };
+
+  /// Keeps the error terms also found in errors in the same order, returns
+  /// the number of kept error terms
+  size_t keepErrorTerms(const std::vector<ErrorTerm*>& errors);
+  /// Drops the error terms from num_errors on
+  void truncateErrorTerms(size_t num_errors);
+  /// Releases the design variables of an error term
+  void releaseErrorTerm(size_t error_idx);
+  /// Checks the design variables of the kept error terms against dvs and
+  /// remaps the row indices if they moved, false if a rebuild is needed
+  bool updateLayout(const std::vector<DesignVariable*>& dvs, bool* moved);
+  /// Returns the slot of a design variable, acquiring a new one if needed
+  size_t acquireSlot(DesignVariable* dv);
+  /// Appends the structure of an error term
+  void appendErrorTerm(ErrorTerm* error);
+  /// Writes the row indices of the columns of an error term
+  void writeRowIndices(size_t error_idx);
+  /// Evaluates the Jacobians of a range of error terms
+  void evaluateJacobians(size_t start, size_t end, bool use_m_estimator);
+  /// Evaluates the Jacobians of the error terms from start on in parallel
+  void evaluateJacobiansFrom(size_t start, size_t num_threads,
+                             bool use_m_estimator);
+  /// Computes the structure of J and the map from J^T entries to J entries
+  void buildJacobianStructure();
+  /// Updates the peak memory usage
+  void updatePeakMemoryUsage();
+
+  /// Error terms in column order
+  std::vector<ErrorTerm*> errors_;
+  /// Slots of the design variables of each error term, sorted by column base
+  std::vector<size_t> error_slots_;
+  /// Index of the first slot of each error term in error_slots_
+  std::vector<size_t> error_dvs_offsets_;
+  /// Index of the first column of each error term
+  std::vector<Index> error_col_offsets_;
+  /// Design variables referenced by the error terms
+  std::vector<Slot> slots_;
+  /// Slot of each referenced design variable
+  std::unordered_map<const DesignVariable*, size_t> slot_indices_;
+  /// Free entries of slots_
+  std::vector<size_t> free_slots_;
+  /// Current initialization, stamps the design variables seen
+  size_t stamp_;
+  /// Map from old to new row indices (buffer kept allocated)
+  std::vector<Index> remap_;
+  /// Number of rows of J^T
+  Index rows_;
+  /// Column pointers of J^T
+  std::vector<Index> col_ptr_;
+  /// Row indices of J^T
+  std::vector<Index> row_idx_;
+  /// Values of J^T
+  std::vector<double> values_;
+  /// Column pointers of J
+  std::vector<Index> j_col_ptr_;
+  /// Row indices of J
+  std::vector<Index> j_row_idx_;
+  /// Values of J
+  std::vector<double> j_values_;
+  /// Position in j_values_ of each entry of values_
+  std::vector<Index> jt_to_j_;
+  /// True if the structure of J does not reflect the one of J^T
+  bool j_dirty_;
+  /// Number of error terms kept by the last initialization
+  size_t num_reused_errors_;
+  /// Version of the sparsity pattern
+  size_t structure_version_;
+  /// True if a state was saved
+  bool has_saved_state_;
+  /// Number of error terms of the saved state
+  size_t saved_num_errors_;
+  /// Number of rows of J^T of the saved state
+  Index saved_rows_;
+  /// True if the saved values were moved to saved_values_
+  bool saved_values_valid_;
+  /// Saved values_ (buffer kept allocated between batches)
+  std::vector<double> saved_values_;
+  /// True if the row indices were saved before a remap
+  bool saved_row_idx_valid_;
+  /// Saved row_idx_ of the saved error terms (buffer kept allocated)
+  std::vector<Index> saved_row_idx_;
+  /// Peak memory held by the builder [B]
+  size_t peak_memory_usage_;
+  /// J^T as aslam matrix, only built on request
+  mutable boost::shared_ptr<CompressedColumnMatrix<Index> > jt_;
+  /// True if jt_ does not reflect the current values
+  mutable bool jt_dirty_;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+#endif // ASLAM_TSVD_SOLVER_JACOBIAN_TRANSPOSE_BUILDER_H
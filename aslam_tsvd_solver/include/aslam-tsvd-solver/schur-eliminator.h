@@ -0,0 +1,136 @@
+#ifndef ASLAM_TSVD_SOLVER_SCHUR_ELIMINATOR_H
+#define ASLAM_TSVD_SOLVER_SCHUR_ELIMINATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/QR>
+
+struct cholmod_sparse_struct;
+typedef struct cholmod_sparse_struct cholmod_sparse;
+
+namespace aslam {
+namespace backend {
+
+/** The class BlockDiagonalSchurEliminator eliminates the nuisance columns
+ *  J_psi of a Jacobian [J_psi J_theta] whose columns split into blocks that
+ *  never share a row, e.g., one pose per image. Each block is factored with
+ *  a dense QR decomposition and its rows of [J_theta e] are projected onto
+ *  the orthogonal complement of its range. The projections are folded into
+ *  a triangular factor R, the reduced system on theta, whose normal matrix
+ *  is the Schur complement of the full system. The nuisance part of the
+ *  solution is then recovered block by block.
+ */
+class BlockDiagonalSchurEliminator {
+ public:
+  typedef std::ptrdiff_t Index;
+
+  /// Constructor with the largest block to eliminate and the QR tolerance
+  explicit BlockDiagonalSchurEliminator(Index max_block_dim = 64,
+                                        double qr_tol = -1.0);
+  /// Copy constructor
+  BlockDiagonalSchurEliminator(
+      const BlockDiagonalSchurEliminator& other) = delete;
+  /// Copy assignment operator
+  BlockDiagonalSchurEliminator& operator= (
+      const BlockDiagonalSchurEliminator& other) = delete;
+  /// Destructor
+  ~BlockDiagonalSchurEliminator();
+
+  /// Finds the blocks of the columns before marg_start_index from J^T,
+  /// false if a block is larger than the maximum block dimension
+  bool analyzeStructure(const cholmod_sparse& J_transpose,
+                        Index marg_start_index);
+  /// Eliminates the blocks, projecting e as well if not null
+  void eliminate(const cholmod_sparse& J_transpose, const Eigen::VectorXd* e,
+                 size_t num_threads);
+  /// Recovers the full solution from the solution of the reduced system
+  void backSubstitute(const Eigen::VectorXd& x_theta,
+                      Eigen::VectorXd& x) const;
+  /// Drops the structure
+  void clear();
+
+  /// Returns a cholmod view on the reduced system matrix (no copy)
+  void getReducedView(cholmod_sparse* view);
+  /// Returns the right-hand side of the reduced system
+  Eigen::VectorXd& getReducedRhs() { return reduced_rhs_; }
+  /// First column of theta in J
+  Index margStartIndex() const { return marg_start_index_; }
+  /// Number of eliminated blocks
+  size_t numBlocks() const { return blocks_.size(); }
+  /// Dimension of the largest block
+  Index maxBlockDim() const { return max_block_found_; }
+  /// Estimated numerical rank of J_psi
+  Index getQRRank() const { return qr_rank_; }
+  /// Estimated numerical rank deficiency of J_psi
+  Index getQRRankDeficiency() const { return marg_start_index_ - qr_rank_; }
+  /// Largest tolerance used for the QR decompositions
+  double getQRTolerance() const { return qr_tolerance_; }
+  /// Returns the memory currently held by the eliminator [B]
+  size_t getMemoryUsage() const;
+
+ private:
+  /// Columns and rows of J of a block
+  struct Block {
+    /// Sorted columns of J
+    std::vector<Index> cols;
+    /// Rows of J touching the columns
+    std::vector<Index> rows;
+  };
+  /// Numerical factorization of a block
+  struct Factor {
+    /// Column-pivoted QR decomposition of the block of J_psi
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr;
+    /// Q^T [J_theta e] restricted to the rows of the block, only the first
+    /// rank rows are kept after elimination
+    Eigen::MatrixXd projected;
+    /// Numerical rank
+    Index rank;
+    /// Tolerance used for the rank
+    double tolerance;
+  };
+  /// Eliminates every stride-th chunk of blocks from first_chunk on
+  void eliminateChunks(const cholmod_sparse& J_transpose,
+                       const Eigen::VectorXd* e, size_t first_chunk,
+                       size_t stride);
+  /// Factors a block and projects its rows of [J_theta e]
+  void eliminateBlock(const cholmod_sparse& J_transpose,
+                      const Eigen::VectorXd* e, size_t b);
+
+  /// Largest block to eliminate
+  Index max_block_dim_;
+  /// QR tolerance (automatic if negative)
+  double qr_tol_;
+  /// First column of theta in J
+  Index marg_start_index_;
+  /// Number of columns of J
+  Index num_cols_;
+  /// Dimension of the largest block found
+  Index max_block_found_;
+  /// Blocks of J_psi
+  std::vector<Block> blocks_;
+  /// Rows of J that do not touch J_psi
+  std::vector<Index> free_rows_;
+  /// Factorization of each block
+  std::vector<Factor> factors_;
+  /// Triangular factor of the projected rows of each chunk of blocks
+  std::vector<Eigen::MatrixXd> chunk_factors_;
+  /// Reduced system matrix
+  Eigen::MatrixXd reduced_;
+  /// Right-hand side of the reduced system
+  Eigen::VectorXd reduced_rhs_;
+  /// Column pointers of the reduced system view
+  std::vector<Index> reduced_col_ptr_;
+  /// Row indices of the reduced system view
+  std::vector<Index> reduced_row_idx_;
+  /// Estimated numerical rank of J_psi
+  Index qr_rank_;
+  /// Largest tolerance used for the QR decompositions
+  double qr_tolerance_;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+#endif // ASLAM_TSVD_SOLVER_SCHUR_ELIMINATOR_H
@@ -1,18 +1,46 @@
 #include "aslam-tsvd-solver/aslam-tsvd-solver.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <utility>
 
 #include <aslam/backend/CompressedColumnMatrix.hpp>
 #include <cholmod.h>
+#include <SuiteSparseQR.hpp>
 #include <Eigen/Dense>
 #include <glog/logging.h>
 #include <sm/PropertyTree.hpp>
-#include <truncated-svd-solver/cholmod-helpers.h>
 #include <truncated-svd-solver/linear-algebra-helpers.h>
 
 namespace aslam {
 namespace backend {
+namespace {
+
+// Largest nuisance block eliminated in closed form, e.g., when landmarks are
+// estimated the poses share their columns and SPQR is used instead.
+const std::ptrdiff_t kMaxSchurBlockDim = 64;
+
+// Orderings accepted in the configuration, SPQR_ORDERING_GIVEN would require
+// a permuted Jacobian.
+const std::pair<const char*, int> kSpqrOrderings[] = {
+  {"fixed", SPQR_ORDERING_FIXED},
+  {"natural", SPQR_ORDERING_NATURAL},
+  {"colamd", SPQR_ORDERING_COLAMD},
+  {"cholmod", SPQR_ORDERING_CHOLMOD},
+  {"amd", SPQR_ORDERING_AMD},
+  {"metis", SPQR_ORDERING_METIS},
+  {"default", SPQR_ORDERING_DEFAULT},
+  {"best", SPQR_ORDERING_BEST},
+  {"bestamd", SPQR_ORDERING_BESTAMD}
+};
+
+double secondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
 
 AslamTruncatedSvdSolver::Options createTsvdOptionsFromPropertyTree(
     const sm::PropertyTree& config) {
@@ -28,31 +56,94 @@ AslamTruncatedSvdSolver::Options createTsvdOptionsFromPropertyTree(
   return tsvd_options;
 }
 
-AslamTruncatedSvdSolver::AslamTruncatedSvdSolver(const Options& options)
-    : truncated_svd_solver::TruncatedSvdSolver(options) {}
+SpqrOptions createSpqrOptionsFromPropertyTree(
+    const sm::PropertyTree& config) {
+  SpqrOptions spqr_options;
+  const std::string ordering = config.getString("spqrOrdering", "best");
+  bool found = false;
+  for (const auto& spqr_ordering : kSpqrOrderings) {
+    if (ordering == spqr_ordering.first) {
+      spqr_options.ordering = spqr_ordering.second;
+      found = true;
+    }
+  }
+  CHECK(found) << "Unknown SPQR ordering " << ordering;
+  spqr_options.num_threads =
+      config.getInt("spqrThreads", spqr_options.num_threads);
+  CHECK_GE(spqr_options.num_threads, 0);
+  return spqr_options;
+}
+
+SpqrOptions::SpqrOptions()
+    : ordering(SPQR_ORDERING_BEST),
+      num_threads(0) {}
+
+AslamTruncatedSvdSolver::AslamTruncatedSvdSolver(
+    const Options& options, const SpqrOptions& spqr_options)
+    : truncated_svd_solver::TruncatedSvdSolver(options),
+      jacobian_time_(0.0),
+      solve_time_(0.0),
+      schur_eliminator_(kMaxSchurBlockDim, options.qrTol),
+      schur_elimination_(false),
+      schur_structure_valid_(false),
+      schur_structure_eliminable_(false),
+      schur_elimination_applied_(false),
+      num_threads_(1),
+      spqr_options_(spqr_options),
+      structure_version_(0),
+      symbolic_valid_(false),
+      symbolic_structure_version_(0),
+      symbolic_marg_start_index_(0),
+      num_symbolic_factorizations_(0) {}
 
 AslamTruncatedSvdSolver::AslamTruncatedSvdSolver(const sm::PropertyTree& config)
-    : AslamTruncatedSvdSolver(createTsvdOptionsFromPropertyTree(config)) {}
+    : AslamTruncatedSvdSolver(createTsvdOptionsFromPropertyTree(config),
+                              createSpqrOptionsFromPropertyTree(config)) {
+  schur_elimination_ = config.getBool("schurElimination", schur_elimination_);
+}
 
 AslamTruncatedSvdSolver::~AslamTruncatedSvdSolver() {}
 
 void AslamTruncatedSvdSolver::buildSystem(size_t numThreads,
                                           bool useMEstimator) {
+  const auto start = std::chrono::steady_clock::now();
+  num_threads_ = numThreads;
   jacobian_builder_.buildSystem(numThreads, useMEstimator);
+  jacobian_time_ += secondsSince(start);
+}
+
+void AslamTruncatedSvdSolver::buildAppendedSystem(size_t numThreads,
+                                                  bool useMEstimator) {
+  const auto start = std::chrono::steady_clock::now();
+  num_threads_ = numThreads;
+  jacobian_builder_.buildAppendedErrorTerms(numThreads, useMEstimator);
+  jacobian_time_ += secondsSince(start);
 }
 
 bool AslamTruncatedSvdSolver::solveSystem(Eigen::VectorXd& dx) {
-  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
-    jacobian_builder_.J_transpose();
-  cholmod_sparse Jt_CS;
-  Jt.getView(&Jt_CS);
-  cholmod_sparse* J_CS = cholmod_l_transpose(&Jt_CS, 1, &cholmod_);
-  if (J_CS == NULL)
-    return false;
-  cholmod_dense e_CD;
-  truncated_svd_solver::eigenDenseToCholmodDenseView(_e, &e_CD);
+  const auto start = std::chrono::steady_clock::now();
   bool status = true;
-  solve(J_CS, &e_CD, margStartIndex_, dx);
+  if (prepareSchurElimination()) {
+    // The truncated SVD only sees the reduced system on the calibration
+    // variables, the nuisance variables are recovered block by block.
+    cholmod_sparse J_jt;
+    jacobian_builder_.getView(&J_jt);
+    schur_eliminator_.eliminate(J_jt, &_e, num_threads_);
+    cholmod_sparse A_CS;
+    cholmod_dense b_CD;
+    getReducedView(&A_CS, &b_CD);
+    Eigen::VectorXd dx_theta;
+    solve(&A_CS, &b_CD, 0, dx_theta);
+    schur_eliminator_.backSubstitute(dx_theta, dx);
+  } else {
+    cholmod_sparse J_CS;
+    jacobian_builder_.getJacobianView(&J_CS);
+    prepareSymbolicFactorization(J_CS);
+    cholmod_dense e_CD;
+    truncated_svd_solver::eigenDenseToCholmodDenseView(_e, &e_CD);
+    solve(&J_CS, &e_CD, margStartIndex_, dx);
+  }
+  solve_time_ += secondsSince(start);
   if (tsvd_options_.verbose) {
     std::cout << "SVD rank: " << getSVDRank() << std::endl;
     std::cout << "SVD rank deficiency: " << getSVDRankDeficiency()
@@ -67,7 +158,6 @@ bool AslamTruncatedSvdSolver::solveSystem(Eigen::VectorXd& dx) {
     std::cout << "V-matrix (observability basis, column vectors correspond to singular values)\n" << getMatrixV()
       << std::endl;
   }
-  cholmod_l_free_sparse(&J_CS, &cholmod_);
   return status;
 }
 
@@ -80,29 +170,203 @@ void AslamTruncatedSvdSolver::initMatrixStructureImplementation(const
     std::vector<aslam::backend::ErrorTerm*>& errors, bool
     useDiagonalConditioner) {
   CHECK(!useDiagonalConditioner) << "useDiagonalConditioner not supported in AslamTruncatedSvdSolver";
-  clear();
+  const auto start = std::chrono::steady_clock::now();
+  // The builder keeps the structure of the error terms shared with the
+  // previous call, i.e., all but the last batch for the incremental estimator.
   jacobian_builder_.initMatrixStructure(dvs, errors);
+  updateStructureVersion();
+  jacobian_time_ += secondsSince(start);
+}
+
+void AslamTruncatedSvdSolver::updateStructureVersion() {
+  // The cholmod state, including the symbolic factorization, and the
+  // nuisance blocks are kept as long as the sparsity pattern is unchanged.
+  if (jacobian_builder_.structureVersion() != structure_version_) {
+    clear();
+    schur_structure_valid_ = false;
+    structure_version_ = jacobian_builder_.structureVersion();
+  }
 }
 
 bool AslamTruncatedSvdSolver::analyzeMarginal() {
-  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
-      jacobian_builder_.J_transpose();
-  cholmod_sparse Jt_CS;
-  Jt.getView(&Jt_CS);
-  truncated_svd_solver::SelfFreeingCholmodPtr<cholmod_sparse> J_CS(
-      cholmod_l_transpose(&Jt_CS, 1, &cholmod_), cholmod_);
-  if (J_CS == nullptr) {
-    return false;
+  if (prepareSchurElimination()) {
+    cholmod_sparse J_jt;
+    jacobian_builder_.getView(&J_jt);
+    schur_eliminator_.eliminate(J_jt, NULL, num_threads_);
+    cholmod_sparse A_CS;
+    cholmod_dense b_CD;
+    getReducedView(&A_CS, &b_CD);
+    truncated_svd_solver::TruncatedSvdSolver::analyzeMarginal(&A_CS, 0);
+    return true;
   }
+  cholmod_sparse J_CS;
+  jacobian_builder_.getJacobianView(&J_CS);
+  prepareSymbolicFactorization(J_CS);
   truncated_svd_solver::TruncatedSvdSolver::analyzeMarginal(
-      J_CS, margStartIndex_);
+      &J_CS, margStartIndex_);
   return true;
 }
 
+void AslamTruncatedSvdSolver::setSchurElimination(bool schur_elimination) {
+  schur_elimination_ = schur_elimination;
+}
+
+bool AslamTruncatedSvdSolver::getSchurElimination() const {
+  return schur_elimination_;
+}
+
+bool AslamTruncatedSvdSolver::isSchurEliminationApplied() const {
+  return schur_elimination_applied_;
+}
+
+void AslamTruncatedSvdSolver::setSpqrOptions(const SpqrOptions& spqr_options) {
+  spqr_options_ = spqr_options;
+  symbolic_valid_ = false;
+}
+
+const SpqrOptions& AslamTruncatedSvdSolver::getSpqrOptions() const {
+  return spqr_options_;
+}
+
+size_t AslamTruncatedSvdSolver::getNumSymbolicFactorizations() const {
+  return num_symbolic_factorizations_;
+}
+
+std::ptrdiff_t AslamTruncatedSvdSolver::getQRRank() const {
+  if (schur_elimination_applied_)
+    return schur_eliminator_.getQRRank();
+  return truncated_svd_solver::TruncatedSvdSolver::getQRRank();
+}
+
+std::ptrdiff_t AslamTruncatedSvdSolver::getQRRankDeficiency() const {
+  if (schur_elimination_applied_)
+    return schur_eliminator_.getQRRankDeficiency();
+  return truncated_svd_solver::TruncatedSvdSolver::getQRRankDeficiency();
+}
+
+double AslamTruncatedSvdSolver::getQRTolerance() const {
+  if (schur_elimination_applied_)
+    return schur_eliminator_.getQRTolerance();
+  return truncated_svd_solver::TruncatedSvdSolver::getQRTolerance();
+}
+
+bool AslamTruncatedSvdSolver::prepareSchurElimination() {
+  schur_elimination_applied_ = false;
+  if (!schur_elimination_ || margStartIndex_ <= 0)
+    return false;
+  if (!schur_structure_valid_ ||
+      schur_eliminator_.margStartIndex() != margStartIndex_) {
+    cholmod_sparse J_jt;
+    jacobian_builder_.getView(&J_jt);
+    schur_structure_eliminable_ =
+        schur_eliminator_.analyzeStructure(J_jt, margStartIndex_);
+    schur_structure_valid_ = true;
+    if (!schur_structure_eliminable_ && tsvd_options_.verbose)
+      std::cout << "Nuisance block of dimension "
+        << schur_eliminator_.maxBlockDim()
+        << " too large for the Schur elimination, using SPQR" << std::endl;
+  }
+  schur_elimination_applied_ = schur_structure_eliminable_;
+  return schur_elimination_applied_;
+}
+
+void AslamTruncatedSvdSolver::getReducedView(cholmod_sparse* A,
+                                             cholmod_dense* b) {
+  schur_eliminator_.getReducedView(A);
+  truncated_svd_solver::eigenDenseToCholmodDenseView(
+      schur_eliminator_.getReducedRhs(), b);
+}
+
+void AslamTruncatedSvdSolver::prepareSymbolicFactorization(
+    const cholmod_sparse& J) {
+  cholmod_.SPQR_nthreads = spqr_options_.num_threads;
+  if (factor_ != NULL && symbolic_valid_ &&
+      symbolic_structure_version_ == structure_version_ &&
+      symbolic_marg_start_index_ == margStartIndex_)
+    return;
+  if (factor_ != NULL) {
+    SuiteSparseQR_free<double>(&factor_, &cholmod_);
+    factor_ = NULL;
+  }
+  if (margStartIndex_ <= 0)
+    return;
+
+  // The base class only runs the numeric factorization when it finds a
+  // symbolic one of the same dimensions, hence the ordering and analysis of
+  // J_psi are done once per structure. J_psi is the leading columns of J.
+  cholmod_sparse J_psi = J;
+  J_psi.ncol = margStartIndex_;
+  J_psi.nzmax = static_cast<const std::ptrdiff_t*>(J.p)[margStartIndex_];
+  factor_ = SuiteSparseQR_symbolic<double>(spqr_options_.ordering, true,
+      &J_psi, &cholmod_);
+  CHECK_NOTNULL(factor_);
+  symbolic_valid_ = true;
+  symbolic_structure_version_ = structure_version_;
+  symbolic_marg_start_index_ = margStartIndex_;
+  ++num_symbolic_factorizations_;
+}
+
+size_t AslamTruncatedSvdSolver::getPeakMemoryUsage() const {
+  return truncated_svd_solver::TruncatedSvdSolver::getPeakMemoryUsage() +
+      jacobian_builder_.getPeakMemoryUsage();
+}
+
+size_t AslamTruncatedSvdSolver::getMemoryUsage() const {
+  return truncated_svd_solver::TruncatedSvdSolver::getMemoryUsage() +
+      jacobian_builder_.getMemoryUsage() + schur_eliminator_.getMemoryUsage();
+}
+
 const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
   AslamTruncatedSvdSolver::getJacobianTranspose() const {
   return jacobian_builder_.J_transpose();
 }
 
+void AslamTruncatedSvdSolver::getJacobianTransposeView(cholmod_sparse* view) {
+  jacobian_builder_.getView(view);
+}
+
+std::size_t AslamTruncatedSvdSolver::getJacobianNnz() const {
+  return jacobian_builder_.nnz();
+}
+
+double AslamTruncatedSvdSolver::getJacobianTime() const {
+  return jacobian_time_;
+}
+
+double AslamTruncatedSvdSolver::getSolveTime() const {
+  return solve_time_;
+}
+
+void AslamTruncatedSvdSolver::resetTimings() {
+  jacobian_time_ = 0.0;
+  solve_time_ = 0.0;
+}
+
+void AslamTruncatedSvdSolver::saveJacobianState() {
+  jacobian_builder_.saveState();
+}
+
+bool AslamTruncatedSvdSolver::restoreJacobianState(size_t num_kept_dvs,
+    const std::vector<aslam::backend::DesignVariable*>& moved_dvs) {
+  // The problem lists are truncated in place instead of being passed again
+  // to initMatrixStructure(), such that the cost depends on the removed
+  // batch only.
+  const auto start = std::chrono::steady_clock::now();
+  if (num_kept_dvs > _designVariables.size() ||
+      !jacobian_builder_.restoreState(moved_dvs))
+    return false;
+  _designVariables.resize(num_kept_dvs);
+  _designVariables.insert(_designVariables.end(), moved_dvs.begin(),
+                          moved_dvs.end());
+  _errorTerms.resize(jacobian_builder_.numErrorTerms());
+  _JCols = jacobian_builder_.rows();
+  _JRows = jacobian_builder_.cols();
+  _e.resize(_JRows);
+  _dx.resize(_JCols);
+  updateStructureVersion();
+  jacobian_time_ += secondsSince(start);
+  return true;
+}
+
 }  // namespace backend
 }  // namespace aslam
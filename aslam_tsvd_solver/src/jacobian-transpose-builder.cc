@@ -0,0 +1,528 @@
+#include "aslam-tsvd-solver/jacobian-transpose-builder.h"
+
+#include <algorithm>
+
+#include <aslam/backend/CompressedColumnMatrix.hpp>
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <cholmod.h>
+#include <glog/logging.h>
+
+namespace aslam {
+namespace backend {
+
+IncrementalJacobianTransposeBuilder::IncrementalJacobianTransposeBuilder()
+    : error_dvs_offsets_(1, 0),
+      error_col_offsets_(1, 0),
+      stamp_(0),
+      rows_(0),
+      col_ptr_(1, 0),
+      j_dirty_(true),
+      num_reused_errors_(0),
+      structure_version_(0),
+      has_saved_state_(false),
+      saved_num_errors_(0),
+      saved_rows_(0),
+      saved_values_valid_(false),
+      saved_row_idx_valid_(false),
+      peak_memory_usage_(0),
+      jt_dirty_(true) {}
+
+IncrementalJacobianTransposeBuilder::~IncrementalJacobianTransposeBuilder() {}
+
+void IncrementalJacobianTransposeBuilder::clear() {
+  errors_.clear();
+  error_slots_.clear();
+  error_dvs_offsets_.assign(1, 0);
+  error_col_offsets_.assign(1, 0);
+  slots_.clear();
+  slot_indices_.clear();
+  free_slots_.clear();
+  rows_ = 0;
+  col_ptr_.assign(1, 0);
+  row_idx_.clear();
+  values_.clear();
+  j_col_ptr_.clear();
+  j_row_idx_.clear();
+  j_values_.clear();
+  jt_to_j_.clear();
+  j_dirty_ = true;
+  num_reused_errors_ = 0;
+  ++structure_version_;
+  jt_dirty_ = true;
+  discardState();
+}
+
+void IncrementalJacobianTransposeBuilder::saveState() {
+  has_saved_state_ = true;
+  saved_num_errors_ = errors_.size();
+  saved_rows_ = rows_;
+  saved_values_valid_ = false;
+  saved_row_idx_valid_ = false;
+}
+
+void IncrementalJacobianTransposeBuilder::discardState() {
+  has_saved_state_ = false;
+  saved_values_valid_ = false;
+  saved_row_idx_valid_ = false;
+}
+
+bool IncrementalJacobianTransposeBuilder::restoreState(
+    const std::vector<DesignVariable*>& moved_dvs) {
+  // The saved error terms are a prefix of the current ones, and only the
+  // design variables after the appended ones moved, i.e., moved_dvs at the
+  // column bases they had when saved. Nothing is modified on failure.
+  const size_t num_errors = saved_num_errors_;
+  if (!has_saved_state_ || errors_.size() < num_errors) {
+    discardState();
+    return false;
+  }
+  Index last_base = -1;
+  Index rows = 0;
+  for (const DesignVariable* dv : moved_dvs) {
+    if (dv->columnBase() <= last_base) {
+      discardState();
+      return false;
+    }
+    last_base = dv->columnBase();
+    rows = last_base + dv->minimalDimensions();
+    const auto it = slot_indices_.find(dv);
+    if (it == slot_indices_.end())
+      continue;
+    const Slot& slot = slots_[it->second];
+    // Without the saved row indices, the rows cannot be moved back.
+    if (!slot.active || (!saved_row_idx_valid_ && slot.base != last_base)) {
+      discardState();
+      return false;
+    }
+  }
+  if (!moved_dvs.empty() && rows != saved_rows_) {
+    discardState();
+    return false;
+  }
+  const bool truncated = errors_.size() != num_errors;
+  truncateErrorTerms(num_errors);
+  if (saved_row_idx_valid_) {
+    CHECK_EQ(saved_row_idx_.size(), row_idx_.size());
+    row_idx_.swap(saved_row_idx_);
+    for (DesignVariable* dv : moved_dvs) {
+      const auto it = slot_indices_.find(dv);
+      if (it != slot_indices_.end())
+        slots_[it->second].base = slots_[it->second].new_base =
+            dv->columnBase();
+    }
+  }
+  if (truncated || saved_row_idx_valid_ || rows_ != saved_rows_)
+    ++structure_version_;
+  rows_ = saved_rows_;
+  if (saved_values_valid_)
+    values_.swap(saved_values_);
+  values_.resize(row_idx_.size());
+  num_reused_errors_ = num_errors;
+  j_dirty_ = true;
+  jt_dirty_ = true;
+  discardState();
+  return true;
+}
+
+void IncrementalJacobianTransposeBuilder::initMatrixStructure(
+    const std::vector<DesignVariable*>& dvs,
+    const std::vector<ErrorTerm*>& errors) {
+  Index rows = 0;
+  for (const DesignVariable* dv : dvs)
+    rows += dv->minimalDimensions();
+  const size_t old_num_errors = errors_.size();
+  num_reused_errors_ = keepErrorTerms(errors);
+  bool moved = false;
+  if (!updateLayout(dvs, &moved)) {
+    clear();
+    num_reused_errors_ = 0;
+  }
+  if (moved || rows != rows_ || num_reused_errors_ != old_num_errors ||
+      errors.size() != num_reused_errors_)
+    ++structure_version_;
+  rows_ = rows;
+  errors_.reserve(errors.size());
+  error_col_offsets_.reserve(errors.size() + 1);
+  error_dvs_offsets_.reserve(errors.size() + 1);
+  for (size_t i = num_reused_errors_; i < errors.size(); ++i)
+    appendErrorTerm(errors[i]);
+  values_.resize(row_idx_.size());
+  j_dirty_ = true;
+  jt_dirty_ = true;
+  updatePeakMemoryUsage();
+}
+
+size_t IncrementalJacobianTransposeBuilder::keepErrorTerms(
+    const std::vector<ErrorTerm*>& errors) {
+  // Error terms are only appended or dropped, e.g., batches evicted from the
+  // window, hence the kept ones are found by walking both lists in order.
+  const size_t num_errors = errors_.size();
+  const size_t max_prefix = std::min(errors.size(), num_errors);
+  const size_t prefix = std::mismatch(errors_.begin(),
+      errors_.begin() + max_prefix, errors.begin()).first - errors_.begin();
+  if (prefix == num_errors)
+    return prefix;
+  // The saved state is lost once its error terms are dropped.
+  if (prefix < saved_num_errors_)
+    discardState();
+
+  // Kept error terms are moved to the front with their columns and values.
+  size_t kept = prefix;
+  Index col = error_col_offsets_[prefix];
+  Index entry = col_ptr_[col];
+  size_t slot = error_dvs_offsets_[prefix];
+  for (size_t i = prefix; i < num_errors; ++i) {
+    if (kept == errors.size() || errors_[i] != errors[kept]) {
+      releaseErrorTerm(i);
+      continue;
+    }
+    const Index col_start = error_col_offsets_[i];
+    const Index num_cols = error_col_offsets_[i + 1] - col_start;
+    const Index entry_start = col_ptr_[col_start];
+    const Index num_entries = col_ptr_[error_col_offsets_[i + 1]] -
+        entry_start;
+    const Index col_entries = num_cols > 0 ? num_entries / num_cols : 0;
+    const size_t slot_start = error_dvs_offsets_[i];
+    const size_t num_slots = error_dvs_offsets_[i + 1] - slot_start;
+    std::copy(error_slots_.begin() + slot_start,
+        error_slots_.begin() + slot_start + num_slots,
+        error_slots_.begin() + slot);
+    std::copy(row_idx_.begin() + entry_start,
+        row_idx_.begin() + entry_start + num_entries,
+        row_idx_.begin() + entry);
+    std::copy(values_.begin() + entry_start,
+        values_.begin() + entry_start + num_entries,
+        values_.begin() + entry);
+    errors_[kept] = errors_[i];
+    for (Index c = 0; c < num_cols; ++c)
+      col_ptr_[col + c + 1] = col_ptr_[col + c] + col_entries;
+    col += num_cols;
+    entry += num_entries;
+    slot += num_slots;
+    error_col_offsets_[kept + 1] = col;
+    error_dvs_offsets_[kept + 1] = slot;
+    ++kept;
+  }
+  errors_.resize(kept);
+  error_col_offsets_.resize(kept + 1);
+  error_dvs_offsets_.resize(kept + 1);
+  error_slots_.resize(slot);
+  col_ptr_.resize(col + 1);
+  row_idx_.resize(entry);
+  values_.resize(entry);
+  return kept;
+}
+
+void IncrementalJacobianTransposeBuilder::truncateErrorTerms(
+    size_t num_errors) {
+  for (size_t i = num_errors; i < errors_.size(); ++i)
+    releaseErrorTerm(i);
+  errors_.resize(num_errors);
+  error_col_offsets_.resize(num_errors + 1);
+  col_ptr_.resize(error_col_offsets_.back() + 1);
+  row_idx_.resize(col_ptr_.back());
+  error_dvs_offsets_.resize(num_errors + 1);
+  error_slots_.resize(error_dvs_offsets_.back());
+}
+
+void IncrementalJacobianTransposeBuilder::releaseErrorTerm(size_t error_idx) {
+  for (size_t k = error_dvs_offsets_[error_idx];
+      k < error_dvs_offsets_[error_idx + 1]; ++k) {
+    Slot& slot = slots_[error_slots_[k]];
+    if (--slot.refs > 0)
+      continue;
+    slot_indices_.erase(slot.dv);
+    slot.dv = NULL;
+    free_slots_.push_back(error_slots_[k]);
+  }
+}
+
+bool IncrementalJacobianTransposeBuilder::updateLayout(
+    const std::vector<DesignVariable*>& dvs, bool* moved) {
+  // Each referenced design variable is checked once, whatever the number of
+  // error terms referencing it.
+  CHECK_NOTNULL(moved);
+  *moved = false;
+  ++stamp_;
+  Index last_base = -1;
+  for (DesignVariable* dv : dvs) {
+    const auto it = slot_indices_.find(dv);
+    if (it == slot_indices_.end())
+      continue;
+    Slot& slot = slots_[it->second];
+    // Reordered design variables would unsort the columns of J^T.
+    if (!slot.active || slot.base <= last_base)
+      return false;
+    last_base = slot.base;
+    slot.new_base = dv->columnBase();
+    slot.stamp = stamp_;
+    *moved |= slot.new_base != slot.base;
+  }
+  // The active design variables of the kept error terms must be unchanged.
+  for (const Slot& slot : slots_) {
+    if (slot.dv == NULL)
+      continue;
+    if (slot.active ? slot.stamp != stamp_ : slot.dv->isActive())
+      return false;
+  }
+  if (!*moved)
+    return true;
+
+  // Design variables were inserted or removed: remap the row indices. The
+  // saved ones are kept first, restoreState() swaps them back.
+  if (has_saved_state_ && !saved_row_idx_valid_) {
+    saved_row_idx_.assign(row_idx_.begin(), row_idx_.begin() +
+        col_ptr_[error_col_offsets_[saved_num_errors_]]);
+    saved_row_idx_valid_ = true;
+  }
+  remap_.assign(rows_, -1);
+  for (Slot& slot : slots_) {
+    if (slot.dv == NULL || !slot.active)
+      continue;
+    for (int d = 0; d < slot.dim; ++d)
+      remap_[slot.base + d] = slot.new_base + d;
+    slot.base = slot.new_base;
+  }
+  for (Index& row : row_idx_)
+    row = remap_[row];
+  return true;
+}
+
+size_t IncrementalJacobianTransposeBuilder::acquireSlot(DesignVariable* dv) {
+  const auto it = slot_indices_.find(dv);
+  if (it != slot_indices_.end()) {
+    ++slots_[it->second].refs;
+    return it->second;
+  }
+  size_t slot_idx = slots_.size();
+  if (free_slots_.empty()) {
+    slots_.push_back(Slot());
+  } else {
+    slot_idx = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  Slot& slot = slots_[slot_idx];
+  slot.dv = dv;
+  slot.active = dv->isActive();
+  slot.base = slot.active ? dv->columnBase() : -1;
+  slot.new_base = slot.base;
+  slot.dim = slot.active ? dv->minimalDimensions() : 0;
+  slot.refs = 1;
+  slot.stamp = stamp_;
+  slot_indices_[dv] = slot_idx;
+  return slot_idx;
+}
+
+void IncrementalJacobianTransposeBuilder::appendErrorTerm(ErrorTerm* error) {
+  const size_t slots_start = error_slots_.size();
+  Index num_entries = 0;
+  for (size_t j = 0; j < error->numDesignVariables(); ++j) {
+    const size_t slot_idx = acquireSlot(error->designVariable(j));
+    error_slots_.push_back(slot_idx);
+    num_entries += slots_[slot_idx].dim;
+  }
+  std::sort(error_slots_.begin() + slots_start, error_slots_.end(),
+      [this](size_t lhs, size_t rhs) {
+        return slots_[lhs].base < slots_[rhs].base;
+      });
+  error_dvs_offsets_.push_back(error_slots_.size());
+  errors_.push_back(error);
+  const Index num_cols = error->dimension();
+  error_col_offsets_.push_back(error_col_offsets_.back() + num_cols);
+  for (Index r = 0; r < num_cols; ++r)
+    col_ptr_.push_back(col_ptr_.back() + num_entries);
+  row_idx_.resize(col_ptr_.back());
+  writeRowIndices(errors_.size() - 1);
+}
+
+void IncrementalJacobianTransposeBuilder::writeRowIndices(size_t error_idx) {
+  Index* row_idx = row_idx_.data() +
+      col_ptr_[error_col_offsets_[error_idx]];
+  const size_t slots_start = error_dvs_offsets_[error_idx];
+  const size_t slots_end = error_dvs_offsets_[error_idx + 1];
+  for (Index c = error_col_offsets_[error_idx];
+      c < error_col_offsets_[error_idx + 1]; ++c) {
+    for (size_t k = slots_start; k < slots_end; ++k) {
+      const Slot& slot = slots_[error_slots_[k]];
+      for (int d = 0; d < slot.dim; ++d)
+        *row_idx++ = slot.base + d;
+    }
+  }
+}
+
+void IncrementalJacobianTransposeBuilder::evaluateJacobians(size_t start,
+    size_t end, bool use_m_estimator) {
+  for (size_t i = start; i < end; ++i) {
+    ErrorTerm* error = errors_[i];
+    JacobianContainer jc(error->dimension());
+    error->getWeightedJacobians(jc, use_m_estimator);
+    const Index value_start = col_ptr_[error_col_offsets_[i]];
+    const Index num_cols = error_col_offsets_[i + 1] - error_col_offsets_[i];
+    if (num_cols == 0)
+      continue;
+    const Index num_entries = (col_ptr_[error_col_offsets_[i + 1]] -
+        value_start) / num_cols;
+    double* values = values_.data() + value_start;
+    std::fill(values, values + num_cols * num_entries, 0.0);
+    for (JacobianContainer::map_t::iterator it = jc.begin(); it != jc.end();
+        ++it) {
+      Index dv_offset = 0;
+      size_t k = error_dvs_offsets_[i];
+      for (; k < error_dvs_offsets_[i + 1] &&
+          slots_[error_slots_[k]].dv != it->first; ++k)
+        dv_offset += slots_[error_slots_[k]].dim;
+      if (k == error_dvs_offsets_[i + 1])
+        continue;
+      const Eigen::MatrixXd& J = it->second;
+      for (Index r = 0; r < num_cols; ++r)
+        for (Index c = 0; c < J.cols(); ++c)
+          values[r * num_entries + dv_offset + c] = J(r, c);
+    }
+  }
+}
+
+void IncrementalJacobianTransposeBuilder::buildSystem(size_t num_threads,
+    bool use_m_estimator) {
+  CHECK_EQ(values_.size(), row_idx_.size());
+  // All the values are evaluated again, hence the saved ones are swapped.
+  if (has_saved_state_ && !saved_values_valid_) {
+    saved_values_.swap(values_);
+    values_.resize(saved_values_.size());
+    saved_values_valid_ = true;
+  }
+  evaluateJacobiansFrom(0, num_threads, use_m_estimator);
+  jt_dirty_ = true;
+}
+
+void IncrementalJacobianTransposeBuilder::buildAppendedErrorTerms(
+    size_t num_threads, bool use_m_estimator) {
+  CHECK_EQ(values_.size(), row_idx_.size());
+  // A saved state that survived the initialization only covers kept error
+  // terms, whose values are left untouched here.
+  evaluateJacobiansFrom(num_reused_errors_, num_threads, use_m_estimator);
+  jt_dirty_ = true;
+}
+
+void IncrementalJacobianTransposeBuilder::evaluateJacobiansFrom(size_t start,
+    size_t num_threads, bool use_m_estimator) {
+  if (start >= errors_.size())
+    return;
+  const size_t num_errors = errors_.size() - start;
+  num_threads = std::max<size_t>(1, std::min(num_threads, num_errors));
+  if (num_threads <= 1) {
+    evaluateJacobians(start, errors_.size(), use_m_estimator);
+  } else {
+    const size_t chunk = (num_errors + num_threads - 1) / num_threads;
+    boost::thread_group threads;
+    for (size_t begin = start; begin < errors_.size(); begin += chunk)
+      threads.create_thread(boost::bind(
+          &IncrementalJacobianTransposeBuilder::evaluateJacobians, this,
+          begin, std::min(begin + chunk, errors_.size()), use_m_estimator));
+    threads.join_all();
+  }
+}
+
+void IncrementalJacobianTransposeBuilder::getView(cholmod_sparse* view) {
+  CHECK_NOTNULL(view);
+  view->nrow = rows_;
+  view->ncol = cols();
+  view->nzmax = nnz();
+  view->p = col_ptr_.data();
+  view->i = row_idx_.data();
+  view->nz = NULL;
+  view->x = values_.data();
+  view->z = NULL;
+  view->stype = 0;
+  view->itype = CHOLMOD_LONG;
+  view->xtype = CHOLMOD_REAL;
+  view->dtype = CHOLMOD_DOUBLE;
+  view->sorted = 1;
+  view->packed = 1;
+}
+
+void IncrementalJacobianTransposeBuilder::buildJacobianStructure() {
+  // Counting sort of the entries of J^T by row, i.e., by column of J.
+  j_col_ptr_.assign(rows_ + 1, 0);
+  for (const Index row : row_idx_)
+    ++j_col_ptr_[row + 1];
+  for (Index c = 0; c < rows_; ++c)
+    j_col_ptr_[c + 1] += j_col_ptr_[c];
+  std::vector<Index> next(j_col_ptr_.begin(), j_col_ptr_.end() - 1);
+  j_row_idx_.resize(row_idx_.size());
+  j_values_.resize(row_idx_.size());
+  jt_to_j_.resize(row_idx_.size());
+  const Index num_cols = cols();
+  for (Index c = 0; c < num_cols; ++c) {
+    for (Index k = col_ptr_[c]; k < col_ptr_[c + 1]; ++k) {
+      const Index pos = next[row_idx_[k]]++;
+      j_row_idx_[pos] = c;
+      jt_to_j_[k] = pos;
+    }
+  }
+  j_dirty_ = false;
+  updatePeakMemoryUsage();
+}
+
+void IncrementalJacobianTransposeBuilder::getJacobianView(
+    cholmod_sparse* view) {
+  CHECK_NOTNULL(view);
+  if (j_dirty_)
+    buildJacobianStructure();
+  // The solver may scale J in place, hence the values are always refilled.
+  const size_t num_entries = values_.size();
+  for (size_t k = 0; k < num_entries; ++k)
+    j_values_[jt_to_j_[k]] = values_[k];
+  view->nrow = cols();
+  view->ncol = rows_;
+  view->nzmax = nnz();
+  view->p = j_col_ptr_.data();
+  view->i = j_row_idx_.data();
+  view->nz = NULL;
+  view->x = j_values_.data();
+  view->z = NULL;
+  view->stype = 0;
+  view->itype = CHOLMOD_LONG;
+  view->xtype = CHOLMOD_REAL;
+  view->dtype = CHOLMOD_DOUBLE;
+  view->sorted = 1;
+  view->packed = 1;
+}
+
+size_t IncrementalJacobianTransposeBuilder::getMemoryUsage() const {
+  return sizeof(ErrorTerm*) * errors_.capacity() +
+      sizeof(Slot) * slots_.capacity() +
+      (sizeof(const DesignVariable*) + 2 * sizeof(size_t)) *
+      slot_indices_.size() +
+      sizeof(Index) * (error_col_offsets_.capacity() + col_ptr_.capacity() +
+      row_idx_.capacity() + saved_row_idx_.capacity() +
+      j_col_ptr_.capacity() + j_row_idx_.capacity() + jt_to_j_.capacity() +
+      remap_.capacity()) +
+      sizeof(size_t) * (error_slots_.capacity() +
+      error_dvs_offsets_.capacity() + free_slots_.capacity()) +
+      sizeof(double) * (values_.capacity() + j_values_.capacity() +
+      saved_values_.capacity());
+}
+
+void IncrementalJacobianTransposeBuilder::updatePeakMemoryUsage() {
+  peak_memory_usage_ = std::max(peak_memory_usage_, getMemoryUsage());
+}
+
+const CompressedColumnMatrix<IncrementalJacobianTransposeBuilder::Index>&
+    IncrementalJacobianTransposeBuilder::J_transpose() const {
+  if (!jt_)
+    jt_.reset(new CompressedColumnMatrix<Index>());
+  if (jt_dirty_) {
+    cholmod_sparse view;
+    const_cast<IncrementalJacobianTransposeBuilder*>(this)->getView(&view);
+    jt_->fromCholmodSparse(&view);
+    jt_dirty_ = false;
+  }
+  return *jt_;
+}
+
+}  // namespace backend
+}  // namespace aslam
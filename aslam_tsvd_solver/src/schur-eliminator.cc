@@ -0,0 +1,304 @@
+#include "aslam-tsvd-solver/schur-eliminator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <cholmod.h>
+#include <glog/logging.h>
+
+namespace aslam {
+namespace backend {
+namespace {
+
+typedef BlockDiagonalSchurEliminator::Index Index;
+
+// Number of blocks folded into the same partial factor, fixed such that the
+// result does not depend on the number of threads.
+const size_t kBlocksPerChunk = 32;
+
+// Folds rows of [J_theta e] into the upper-triangular factor R of the rows
+// folded so far, i.e., re-triangularizes [R; rows].
+void foldRows(const Eigen::Ref<const Eigen::MatrixXd>& rows,
+              Eigen::MatrixXd* R) {
+  if (rows.rows() == 0)
+    return;
+  Eigen::MatrixXd S(R->rows() + rows.rows(), R->cols());
+  S << *R, rows;
+  const Eigen::HouseholderQR<Eigen::MatrixXd> qr(S);
+  *R = qr.matrixQR().topRows(R->rows()).triangularView<Eigen::Upper>();
+}
+
+Index findRoot(std::vector<Index>& parents, Index i) {
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+}  // namespace
+
+BlockDiagonalSchurEliminator::BlockDiagonalSchurEliminator(
+    Index max_block_dim, double qr_tol)
+    : max_block_dim_(max_block_dim),
+      qr_tol_(qr_tol),
+      marg_start_index_(0),
+      num_cols_(0),
+      max_block_found_(0),
+      qr_rank_(0),
+      qr_tolerance_(qr_tol) {}
+
+BlockDiagonalSchurEliminator::~BlockDiagonalSchurEliminator() {}
+
+bool BlockDiagonalSchurEliminator::analyzeStructure(
+    const cholmod_sparse& J_transpose, Index marg_start_index) {
+  clear();
+  const Index* col_ptr = static_cast<const Index*>(J_transpose.p);
+  const Index* row_idx = static_cast<const Index*>(J_transpose.i);
+  const Index num_rows = J_transpose.ncol;
+  num_cols_ = J_transpose.nrow;
+  marg_start_index_ = marg_start_index;
+
+  // Nuisance columns sharing a row of J end up in the same block.
+  std::vector<Index> parents(marg_start_index);
+  std::iota(parents.begin(), parents.end(), 0);
+  for (Index r = 0; r < num_rows; ++r) {
+    Index first = -1;
+    for (Index k = col_ptr[r]; k < col_ptr[r + 1]; ++k) {
+      if (row_idx[k] >= marg_start_index)
+        continue;
+      if (first < 0) {
+        first = findRoot(parents, row_idx[k]);
+      } else {
+        const Index root = findRoot(parents, row_idx[k]);
+        if (root != first)
+          parents[std::max(root, first)] = std::min(root, first);
+        first = std::min(root, first);
+      }
+    }
+  }
+
+  // Blocks are numbered by their first column, columns stay sorted.
+  std::vector<Index> block_idx(marg_start_index, -1);
+  for (Index c = 0; c < marg_start_index; ++c) {
+    const Index root = findRoot(parents, c);
+    if (block_idx[root] < 0) {
+      block_idx[root] = blocks_.size();
+      blocks_.push_back(Block());
+    }
+    block_idx[c] = block_idx[root];
+    Block& block = blocks_[block_idx[c]];
+    block.cols.push_back(c);
+    max_block_found_ = std::max<Index>(max_block_found_, block.cols.size());
+  }
+  for (Index r = 0; r < num_rows; ++r) {
+    Index k = col_ptr[r];
+    while (k < col_ptr[r + 1] && row_idx[k] >= marg_start_index)
+      ++k;
+    if (k < col_ptr[r + 1])
+      blocks_[block_idx[row_idx[k]]].rows.push_back(r);
+    else
+      free_rows_.push_back(r);
+  }
+  factors_.resize(blocks_.size());
+  return max_block_found_ <= max_block_dim_;
+}
+
+void BlockDiagonalSchurEliminator::eliminate(
+    const cholmod_sparse& J_transpose, const Eigen::VectorXd* e,
+    size_t num_threads) {
+  CHECK_EQ(static_cast<Index>(J_transpose.nrow), num_cols_);
+  const Index dim = num_cols_ - marg_start_index_;
+  const size_t num_chunks = (blocks_.size() + kBlocksPerChunk - 1) /
+      kBlocksPerChunk;
+  chunk_factors_.resize(num_chunks);
+  num_threads = std::max<size_t>(1, std::min(num_threads, num_chunks));
+  if (num_threads <= 1) {
+    eliminateChunks(J_transpose, e, 0, 1);
+  } else {
+    boost::thread_group threads;
+    for (size_t t = 0; t < num_threads; ++t)
+      threads.create_thread(boost::bind(
+          &BlockDiagonalSchurEliminator::eliminateChunks, this,
+          boost::cref(J_transpose), e, t, num_threads));
+    threads.join_all();
+  }
+
+  // The reduced system is the factor R of [J_theta e] over the projected
+  // rows of the blocks and the untouched rows, i.e., it has the same
+  // singular values and least-squares solution as the stacked rows without
+  // growing with the number of blocks.
+  Eigen::MatrixXd R = Eigen::MatrixXd::Zero(dim + 1, dim + 1);
+  qr_rank_ = 0;
+  qr_tolerance_ = qr_tol_;
+  for (size_t b = 0; b < factors_.size(); ++b) {
+    qr_rank_ += factors_[b].rank;
+    qr_tolerance_ = std::max(qr_tolerance_, factors_[b].tolerance);
+  }
+  for (size_t c = 0; c < num_chunks; ++c)
+    foldRows(chunk_factors_[c], &R);
+  const Index* col_ptr = static_cast<const Index*>(J_transpose.p);
+  const Index* row_idx = static_cast<const Index*>(J_transpose.i);
+  const double* values = static_cast<const double*>(J_transpose.x);
+  Eigen::MatrixXd free_rows = Eigen::MatrixXd::Zero(free_rows_.size(),
+                                                    dim + 1);
+  for (size_t i = 0; i < free_rows_.size(); ++i) {
+    const Index r = free_rows_[i];
+    for (Index k = col_ptr[r]; k < col_ptr[r + 1]; ++k)
+      free_rows(i, row_idx[k] - marg_start_index_) = values[k];
+    if (e != NULL)
+      free_rows(i, dim) = (*e)(r);
+  }
+  foldRows(free_rows, &R);
+  reduced_ = R.topLeftCorner(dim, dim);
+  reduced_rhs_ = R.col(dim).head(dim);
+
+  // The view is dense, its pattern only depends on the dimension of theta.
+  if (static_cast<Index>(reduced_col_ptr_.size()) != dim + 1 ||
+      reduced_col_ptr_.back() != reduced_.size()) {
+    reduced_col_ptr_.resize(dim + 1);
+    reduced_row_idx_.resize(reduced_.size());
+    for (Index c = 0; c <= dim; ++c)
+      reduced_col_ptr_[c] = c * dim;
+    for (Index k = 0; k < reduced_.size(); ++k)
+      reduced_row_idx_[k] = k % dim;
+  }
+}
+
+void BlockDiagonalSchurEliminator::eliminateChunks(
+    const cholmod_sparse& J_transpose, const Eigen::VectorXd* e,
+    size_t first_chunk, size_t stride) {
+  const Index dim = num_cols_ - marg_start_index_;
+  for (size_t c = first_chunk; c < chunk_factors_.size(); c += stride) {
+    chunk_factors_[c].setZero(dim + 1, dim + 1);
+    const size_t start = c * kBlocksPerChunk;
+    const size_t end = std::min(start + kBlocksPerChunk, blocks_.size());
+    for (size_t b = start; b < end; ++b) {
+      eliminateBlock(J_transpose, e, b);
+
+      // Back-substitution only needs the rows on the range of J_psi.
+      Factor& factor = factors_[b];
+      foldRows(factor.projected.bottomRows(factor.projected.rows() -
+          factor.rank), &chunk_factors_[c]);
+      factor.projected.conservativeResize(factor.rank, dim + 1);
+    }
+  }
+}
+
+void BlockDiagonalSchurEliminator::eliminateBlock(
+    const cholmod_sparse& J_transpose, const Eigen::VectorXd* e, size_t b) {
+  const Index* col_ptr = static_cast<const Index*>(J_transpose.p);
+  const Index* row_idx = static_cast<const Index*>(J_transpose.i);
+  const double* values = static_cast<const double*>(J_transpose.x);
+  const Index dim = num_cols_ - marg_start_index_;
+  const Block& block = blocks_[b];
+  Factor& factor = factors_[b];
+  const Index num_rows = block.rows.size();
+  const Index block_dim = block.cols.size();
+  Eigen::MatrixXd J_psi = Eigen::MatrixXd::Zero(num_rows, block_dim);
+  factor.projected.setZero(num_rows, dim + 1);
+  for (Index i = 0; i < num_rows; ++i) {
+    const Index r = block.rows[i];
+    for (Index k = col_ptr[r]; k < col_ptr[r + 1]; ++k) {
+      if (row_idx[k] < marg_start_index_)
+        J_psi(i, std::lower_bound(block.cols.begin(), block.cols.end(),
+            row_idx[k]) - block.cols.begin()) = values[k];
+      else
+        factor.projected(i, row_idx[k] - marg_start_index_) = values[k];
+    }
+    if (e != NULL)
+      factor.projected(i, dim) = (*e)(r);
+  }
+
+  factor.rank = 0;
+  factor.tolerance = qr_tol_;
+  if (num_rows == 0)
+    return;
+
+  // Same rank estimation as the SPQR factorization of J_psi.
+  factor.qr.compute(J_psi);
+  if (factor.tolerance < 0)
+    factor.tolerance = 20.0 * (num_rows + block_dim) *
+        std::numeric_limits<double>::epsilon() *
+        J_psi.colwise().norm().maxCoeff();
+  const Eigen::MatrixXd& QR = factor.qr.matrixQR();
+  const Index num_pivots = std::min(num_rows, block_dim);
+  while (factor.rank < num_pivots &&
+      std::fabs(QR(factor.rank, factor.rank)) > factor.tolerance)
+    ++factor.rank;
+  factor.projected.applyOnTheLeft(factor.qr.householderQ().adjoint());
+}
+
+void BlockDiagonalSchurEliminator::backSubstitute(
+    const Eigen::VectorXd& x_theta, Eigen::VectorXd& x) const {
+  const Index dim = num_cols_ - marg_start_index_;
+  CHECK_EQ(x_theta.size(), dim);
+  x.setZero(num_cols_);
+  x.tail(dim) = x_theta;
+  for (size_t b = 0; b < blocks_.size(); ++b) {
+    const Factor& factor = factors_[b];
+    const Index rank = factor.rank;
+    if (rank == 0)
+      continue;
+    const Eigen::VectorXd c = factor.projected.col(dim).head(rank) -
+        factor.projected.topLeftCorner(rank, dim) * x_theta;
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(blocks_[b].cols.size());
+    y.head(rank) = factor.qr.matrixQR().topLeftCorner(rank, rank)
+        .triangularView<Eigen::Upper>().solve(c);
+    const Eigen::VectorXd x_block = factor.qr.colsPermutation() * y;
+    for (Index i = 0; i < x_block.size(); ++i)
+      x(blocks_[b].cols[i]) = x_block(i);
+  }
+}
+
+void BlockDiagonalSchurEliminator::clear() {
+  marg_start_index_ = 0;
+  num_cols_ = 0;
+  max_block_found_ = 0;
+  blocks_.clear();
+  free_rows_.clear();
+  factors_.clear();
+  chunk_factors_.clear();
+  qr_rank_ = 0;
+  qr_tolerance_ = qr_tol_;
+}
+
+void BlockDiagonalSchurEliminator::getReducedView(cholmod_sparse* view) {
+  CHECK_NOTNULL(view);
+  view->nrow = reduced_.rows();
+  view->ncol = reduced_.cols();
+  view->nzmax = reduced_.size();
+  view->p = reduced_col_ptr_.data();
+  view->i = reduced_row_idx_.data();
+  view->nz = NULL;
+  view->x = reduced_.data();
+  view->z = NULL;
+  view->stype = 0;
+  view->itype = CHOLMOD_LONG;
+  view->xtype = CHOLMOD_REAL;
+  view->dtype = CHOLMOD_DOUBLE;
+  view->sorted = 1;
+  view->packed = 1;
+}
+
+size_t BlockDiagonalSchurEliminator::getMemoryUsage() const {
+  size_t memory = (reduced_.size() + reduced_rhs_.size()) * sizeof(double) +
+      (reduced_col_ptr_.size() + reduced_row_idx_.size() +
+      free_rows_.size()) * sizeof(Index);
+  for (size_t c = 0; c < chunk_factors_.size(); ++c)
+    memory += chunk_factors_[c].size() * sizeof(double);
+  for (size_t b = 0; b < blocks_.size(); ++b) {
+    memory += (blocks_[b].cols.size() + blocks_[b].rows.size()) *
+        sizeof(Index);
+    memory += (factors_[b].qr.matrixQR().size() +
+        factors_[b].projected.size()) * sizeof(double);
+  }
+  return memory;
+}
+
+}  // namespace backend
+}  // namespace aslam
@@ -0,0 +1,161 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file SplineInitializer.h
+    \brief This file defines the SplineInitializer class, which initializes
+           the translation and rotation splines of a trajectory.
+  */
+
+#ifndef ASLAM_CALIBRATION_ALGORITHMS_SPLINE_INITIALIZER_H
+#define ASLAM_CALIBRATION_ALGORITHMS_SPLINE_INITIALIZER_H
+
+#include <cstddef>
+
+#include <vector>
+#include <functional>
+
+#include <Eigen/Core>
+
+#include <boost/shared_ptr.hpp>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class SplineInitializer fits the translation and rotation splines
+        of a trajectory to pose samples. Both splines are fitted concurrently.
+        The fit itself is delegated to user-provided functions, such that this
+        class does not depend on a particular spline library. A fit requested
+        as reusable is returned again as long as the samples do not change,
+        the caller must then not modify the splines.
+        \brief Spline initializer
+      */
+    template <typename T, typename TS, typename RS>
+    class SplineInitializer {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Timestamp type
+      typedef T Time;
+      /// Translation spline type
+      typedef TS TranslationSpline;
+      /// Rotation spline type
+      typedef RS RotationSpline;
+      /// Translation spline shared pointer
+      typedef boost::shared_ptr<TranslationSpline> TranslationSplineSP;
+      /// Rotation spline shared pointer
+      typedef boost::shared_ptr<RotationSpline> RotationSplineSP;
+      /// Timestamps container
+      typedef std::vector<Time> Timestamps;
+      /// Translation samples container
+      typedef std::vector<Eigen::Vector3d> TranslationPoses;
+      /// Rotation samples (quaternions) container
+      typedef std::vector<Eigen::Vector4d> RotationPoses;
+      /// Fits a new translation spline with a number of segments
+      typedef std::function<TranslationSplineSP(const Timestamps&,
+        const TranslationPoses&, int)> TranslationFitter;
+      /// Fits a new rotation spline with a number of segments
+      typedef std::function<RotationSplineSP(const Timestamps&,
+        const RotationPoses&, int)> RotationFitter;
+      /// Self type
+      typedef SplineInitializer<T, TS, RS> Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs initializer from the fitting functions
+      SplineInitializer(const TranslationFitter& translationFitter,
+        const RotationFitter& rotationFitter, bool parallel = true);
+      /// Copy constructor
+      SplineInitializer(const Self& other) = delete;
+      /// Copy assignment operator
+      SplineInitializer& operator = (const Self& other) = delete;
+      /// Destructor
+      virtual ~SplineInitializer();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /** Fits the splines to the samples and returns true, or returns false
+          if the last reusable fit was made on the same samples
+        */
+      bool initSplines(const Timestamps& timestamps,
+        const TranslationPoses& transPoses, const RotationPoses& rotPoses,
+        int numSegments, bool reuse = false);
+      /// Forgets the last fit
+      void clear();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the last translation spline
+      const TranslationSplineSP& getTranslationSpline() const;
+      /// Returns the last rotation spline
+      const RotationSplineSP& getRotationSpline() const;
+      /// Returns the number of fits performed
+      size_t getNumFits() const;
+      /// Returns the number of fits reused
+      size_t getNumReuses() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Translation fitting function
+      TranslationFitter _translationFitter;
+      /// Rotation fitting function
+      RotationFitter _rotationFitter;
+      /// Fits translation and rotation concurrently
+      bool _parallel;
+      /// Last translation spline
+      TranslationSplineSP _translationSpline;
+      /// Last rotation spline
+      RotationSplineSP _rotationSpline;
+      /// Whether the last fit may be reused
+      bool _reusable;
+      /// Timestamps of the last fit
+      Timestamps _timestamps;
+      /// Translation samples of the last fit
+      TranslationPoses _transPoses;
+      /// Rotation samples of the last fit
+      RotationPoses _rotPoses;
+      /// Number of segments of the last fit
+      int _numSegments;
+      /// Number of fits performed
+      size_t _numFits;
+      /// Number of fits reused
+      size_t _numReuses;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/algorithms/SplineInitializer.tpp"
+
+#endif // ASLAM_CALIBRATION_ALGORITHMS_SPLINE_INITIALIZER_H
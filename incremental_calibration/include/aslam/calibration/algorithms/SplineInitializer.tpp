@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <thread>
+#include <exception>
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    template <typename T, typename TS, typename RS>
+    SplineInitializer<T, TS, RS>::SplineInitializer(const TranslationFitter&
+        translationFitter, const RotationFitter& rotationFitter,
+        bool parallel) :
+        _translationFitter(translationFitter),
+        _rotationFitter(rotationFitter),
+        _parallel(parallel),
+        _reusable(false),
+        _numSegments(0),
+        _numFits(0),
+        _numReuses(0) {
+    }
+
+    template <typename T, typename TS, typename RS>
+    SplineInitializer<T, TS, RS>::~SplineInitializer() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    template <typename T, typename TS, typename RS>
+    const typename SplineInitializer<T, TS, RS>::TranslationSplineSP&
+        SplineInitializer<T, TS, RS>::getTranslationSpline() const {
+      return _translationSpline;
+    }
+
+    template <typename T, typename TS, typename RS>
+    const typename SplineInitializer<T, TS, RS>::RotationSplineSP&
+        SplineInitializer<T, TS, RS>::getRotationSpline() const {
+      return _rotationSpline;
+    }
+
+    template <typename T, typename TS, typename RS>
+    size_t SplineInitializer<T, TS, RS>::getNumFits() const {
+      return _numFits;
+    }
+
+    template <typename T, typename TS, typename RS>
+    size_t SplineInitializer<T, TS, RS>::getNumReuses() const {
+      return _numReuses;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename T, typename TS, typename RS>
+    bool SplineInitializer<T, TS, RS>::initSplines(const Timestamps&
+        timestamps, const TranslationPoses& transPoses, const RotationPoses&
+        rotPoses, int numSegments, bool reuse) {
+      if (reuse && _reusable && numSegments == _numSegments &&
+          timestamps == _timestamps && transPoses == _transPoses &&
+          rotPoses == _rotPoses) {
+        _numReuses++;
+        return false;
+      }
+
+      // the rotation spline is fitted on a helper thread
+      TranslationSplineSP translationSpline;
+      RotationSplineSP rotationSpline;
+      if (_parallel) {
+        std::exception_ptr exception;
+        std::thread rotationThread([&]() {
+          try {
+            rotationSpline = _rotationFitter(timestamps, rotPoses,
+              numSegments);
+          }
+          catch (...) {
+            exception = std::current_exception();
+          }
+        });
+        try {
+          translationSpline = _translationFitter(timestamps, transPoses,
+            numSegments);
+        }
+        catch (...) {
+          rotationThread.join();
+          throw;
+        }
+        rotationThread.join();
+        if (exception)
+          std::rethrow_exception(exception);
+      }
+      else {
+        translationSpline = _translationFitter(timestamps, transPoses,
+          numSegments);
+        rotationSpline = _rotationFitter(timestamps, rotPoses, numSegments);
+      }
+      _translationSpline = translationSpline;
+      _rotationSpline = rotationSpline;
+      _numFits++;
+
+      // only keep the samples around if they can be compared later on
+      _reusable = reuse;
+      if (reuse) {
+        _timestamps = timestamps;
+        _transPoses = transPoses;
+        _rotPoses = rotPoses;
+        _numSegments = numSegments;
+      }
+      else {
+        _timestamps.clear();
+        _transPoses.clear();
+        _rotPoses.clear();
+      }
+      return true;
+    }
+
+    template <typename T, typename TS, typename RS>
+    void SplineInitializer<T, TS, RS>::clear() {
+      _translationSpline.reset();
+      _rotationSpline.reset();
+      _reusable = false;
+      _timestamps.clear();
+      _transPoses.clear();
+      _rotPoses.clear();
+      _numSegments = 0;
+    }
+
+  }
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ArenaAllocator.h
+    \brief This file defines the ArenaAllocator class, which is an STL
+           allocator drawing from a MemoryArena.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_ARENA_ALLOCATOR_H
+#define ASLAM_CALIBRATION_BASE_ARENA_ALLOCATOR_H
+
+#include <cstddef>
+
+#include <boost/shared_ptr.hpp>
+
+#include "aslam/calibration/base/MemoryArena.h"
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class ArenaAllocator is an STL allocator drawing from a
+        MemoryArena. Each copy keeps the arena alive, such that objects
+        created through boost::allocate_shared() release the arena together
+        with the last of them.
+        \brief Arena allocator
+      */
+    template <typename T> class ArenaAllocator {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Value type
+      typedef T value_type;
+      /// Pointer type
+      typedef T* pointer;
+      /// Const pointer type
+      typedef const T* const_pointer;
+      /// Reference type
+      typedef T& reference;
+      /// Const reference type
+      typedef const T& const_reference;
+      /// Size type
+      typedef size_t size_type;
+      /// Difference type
+      typedef std::ptrdiff_t difference_type;
+      /// Memory arena (shared pointer)
+      typedef boost::shared_ptr<MemoryArena> MemoryArenaSP;
+      /// Rebinds the allocator to another type
+      template <typename U> struct rebind {
+        /// Rebound allocator type
+        typedef ArenaAllocator<U> other;
+      };
+      /// Self type
+      typedef ArenaAllocator<T> Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs allocator from an arena
+      ArenaAllocator(const MemoryArenaSP& arena);
+      /// Copy constructor
+      ArenaAllocator(const Self& other) = default;
+      /// Constructs allocator from an allocator of another type
+      template <typename U> ArenaAllocator(const ArenaAllocator<U>& other);
+      /// Copy assignment operator
+      ArenaAllocator& operator = (const Self& other) = default;
+      /// Destructor
+      ~ArenaAllocator();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the arena
+      const MemoryArenaSP& getArena() const;
+      /// Returns the address of an object
+      pointer address(reference x) const;
+      /// Returns the address of an object
+      const_pointer address(const_reference x) const;
+      /// Returns the maximum number of objects that can be allocated
+      size_type max_size() const;
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Allocates memory for n objects
+      pointer allocate(size_type n, const void* hint = 0);
+      /// Deallocates memory of n objects
+      void deallocate(pointer p, size_type n);
+      /// Constructs an object in place
+      template <typename U, typename... Args> void construct(U* p,
+        Args&&... args);
+      /// Destroys an object in place
+      template <typename U> void destroy(U* p);
+      /// Equal comparison
+      template <typename U> bool operator == (const ArenaAllocator<U>& other)
+        const;
+      /// Not equal comparison
+      template <typename U> bool operator != (const ArenaAllocator<U>& other)
+        const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Memory arena
+      MemoryArenaSP _arena;
+      /** @}
+        */
+
+      /// Rebound allocators access the arena
+      template <typename U> friend class ArenaAllocator;
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/base/ArenaAllocator.tpp"
+
+#endif // ASLAM_CALIBRATION_BASE_ARENA_ALLOCATOR_H
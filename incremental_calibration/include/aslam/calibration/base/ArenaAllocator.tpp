@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    template <typename T>
+    ArenaAllocator<T>::ArenaAllocator(const MemoryArenaSP& arena) :
+        _arena(arena) {
+    }
+
+    template <typename T>
+    template <typename U>
+    ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& other) :
+        _arena(other._arena) {
+    }
+
+    template <typename T>
+    ArenaAllocator<T>::~ArenaAllocator() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    template <typename T>
+    const typename ArenaAllocator<T>::MemoryArenaSP&
+        ArenaAllocator<T>::getArena() const {
+      return _arena;
+    }
+
+    template <typename T>
+    typename ArenaAllocator<T>::pointer ArenaAllocator<T>::address(
+        reference x) const {
+      return &x;
+    }
+
+    template <typename T>
+    typename ArenaAllocator<T>::const_pointer ArenaAllocator<T>::address(
+        const_reference x) const {
+      return &x;
+    }
+
+    template <typename T>
+    typename ArenaAllocator<T>::size_type ArenaAllocator<T>::max_size() const {
+      return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename T>
+    typename ArenaAllocator<T>::pointer ArenaAllocator<T>::allocate(
+        size_type n, const void* /*hint*/) {
+      // at least 16 bytes for fixed-size vectorizable Eigen members
+      const size_t alignment = std::max<size_t>(std::alignment_of<T>::value,
+        16);
+      return static_cast<pointer>(_arena->allocate(n * sizeof(T), alignment));
+    }
+
+    template <typename T>
+    void ArenaAllocator<T>::deallocate(pointer p, size_type n) {
+      _arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename T>
+    template <typename U, typename... Args>
+    void ArenaAllocator<T>::construct(U* p, Args&&... args) {
+      ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    template <typename U>
+    void ArenaAllocator<T>::destroy(U* p) {
+      p->~U();
+    }
+
+    template <typename T>
+    template <typename U>
+    bool ArenaAllocator<T>::operator == (const ArenaAllocator<U>& other) const {
+      return _arena == other._arena;
+    }
+
+    template <typename T>
+    template <typename U>
+    bool ArenaAllocator<T>::operator != (const ArenaAllocator<U>& other) const {
+      return !(*this == other);
+    }
+
+  }
+}
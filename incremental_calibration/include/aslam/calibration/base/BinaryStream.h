@@ -0,0 +1,185 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file BinaryStream.h
+    \brief This file defines the BinaryWriter and BinaryReader classes, which
+           provide raw binary serialization of scalars and dense matrices.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_BINARY_STREAM_H
+#define ASLAM_CALIBRATION_BASE_BINARY_STREAM_H
+
+#include <cstddef>
+
+#include <iosfwd>
+
+#include <Eigen/Core>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class BinaryWriter writes scalars and dense matrices as raw
+        8-byte words in native byte order. A matrix is written as its number
+        of rows and columns followed by its coefficients in column-major
+        order, such that every record of the stream stays 8-byte aligned and
+        a file can be memory-mapped and wrapped with Eigen::Map.
+        \brief Binary stream writer
+      */
+    class BinaryWriter {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Self type
+      typedef BinaryWriter Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs writer on an output stream
+      BinaryWriter(std::ostream& stream);
+      /// Copy constructor
+      BinaryWriter(const Self& other) = delete;
+      /// Copy assignment operator
+      BinaryWriter& operator = (const Self& other) = delete;
+      /// Destructor
+      virtual ~BinaryWriter();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Writes a 8-byte scalar
+      template <typename T> void write(const T& value);
+      /// Writes an array of 8-byte scalars without dimensions
+      template <typename T> void write(const T* values, size_t size);
+      /// Writes a dense matrix
+      void write(const Eigen::MatrixXd& matrix);
+      /// Writes a dense vector
+      void write(const Eigen::VectorXd& vector);
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of bytes written so far
+      size_t getNumBytes() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Writes raw bytes
+      void writeBytes(const void* data, size_t size);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Underlying stream
+      std::ostream& _stream;
+      /// Number of bytes written so far
+      size_t _numBytes;
+      /** @}
+        */
+
+    };
+
+    /** The class BinaryReader reads back the records of a BinaryWriter.
+        \brief Binary stream reader
+      */
+    class BinaryReader {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Self type
+      typedef BinaryReader Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs reader on an input stream
+      BinaryReader(std::istream& stream);
+      /// Copy constructor
+      BinaryReader(const Self& other) = delete;
+      /// Copy assignment operator
+      BinaryReader& operator = (const Self& other) = delete;
+      /// Destructor
+      virtual ~BinaryReader();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Reads a 8-byte scalar
+      template <typename T> T read();
+      /// Reads a dense matrix
+      void read(Eigen::MatrixXd& matrix);
+      /// Reads a dense vector
+      void read(Eigen::VectorXd& vector);
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of bytes read so far
+      size_t getNumBytes() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Reads raw bytes
+      void readBytes(void* data, size_t size);
+      /// Reads the dimensions of a matrix
+      void readDimensions(std::ptrdiff_t& rows, std::ptrdiff_t& cols);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Underlying stream
+      std::istream& _stream;
+      /// Number of bytes read so far
+      size_t _numBytes;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/base/BinaryStream.tpp"
+
+#endif // ASLAM_CALIBRATION_BASE_BINARY_STREAM_H
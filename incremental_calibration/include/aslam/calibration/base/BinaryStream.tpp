@@ -0,0 +1,52 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <type_traits>
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename T>
+    void BinaryWriter::write(const T& value) {
+      static_assert(std::is_arithmetic<T>::value && sizeof(T) == 8,
+        "BinaryWriter::write(): only 8-byte scalars keep the alignment");
+      writeBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void BinaryWriter::write(const T* values, size_t size) {
+      static_assert(std::is_arithmetic<T>::value && sizeof(T) == 8,
+        "BinaryWriter::write(): only 8-byte scalars keep the alignment");
+      writeBytes(values, size * sizeof(T));
+    }
+
+    template <typename T>
+    T BinaryReader::read() {
+      static_assert(std::is_arithmetic<T>::value && sizeof(T) == 8,
+        "BinaryReader::read(): only 8-byte scalars keep the alignment");
+      T value;
+      readBytes(&value, sizeof(T));
+      return value;
+    }
+
+  }
+}
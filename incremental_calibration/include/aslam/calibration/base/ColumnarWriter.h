@@ -0,0 +1,170 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ColumnarWriter.h
+    \brief This file defines the ColumnarWriter class, which writes tables of
+           typed columns in a chunked binary format.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_COLUMNAR_WRITER_H
+#define ASLAM_CALIBRATION_BASE_COLUMNAR_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "aslam/calibration/base/BinaryStream.h"
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class ColumnarWriter writes a table row by row and stores it
+        column by column in chunks of rows. The file starts with a header made
+        of the magic word, the format version, the number of columns and, for
+        each column, its type, the length of its name and the name padded with
+        zeros to 8 bytes. Each chunk then holds its number of rows followed by
+        the values of every column in turn. All the records are 8-byte words
+        in native byte order, such that a file can be memory-mapped and each
+        column of a chunk viewed as a contiguous array. If no column has been
+        declared, the first row defines them from the types of its values,
+        with the names given beforehand or default ones.
+        \brief Chunked columnar table writer
+      */
+    class ColumnarWriter {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Column types
+      enum ColumnType {
+        /// Double-precision floating point
+        FLOAT64 = 0,
+        /// Signed 64-bit integer
+        INT64 = 1
+      };
+      /// Self type
+      typedef ColumnarWriter Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs writer on an output stream
+      ColumnarWriter(std::ostream& stream, size_t chunkSize = 4096);
+      /// Copy constructor
+      ColumnarWriter(const Self& other) = delete;
+      /// Copy assignment operator
+      ColumnarWriter& operator = (const Self& other) = delete;
+      /// Destructor, writes the pending rows
+      virtual ~ColumnarWriter();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Declares a column, only before the first row
+      void addColumn(const std::string& name, ColumnType type = FLOAT64);
+      /// Names the columns, only before the first row
+      void setColumnNames(const std::vector<std::string>& names);
+      /// Appends a floating point value to the current row
+      void write(double value);
+      /// Appends an integer value to the current row
+      void write(int64_t value);
+      /// Terminates the current row
+      void endRow();
+      /// Writes the header and the pending rows to the stream
+      void flush();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of columns
+      size_t getNumColumns() const;
+      /// Returns the name of a column
+      const std::string& getColumnName(size_t idx) const;
+      /// Returns the type of a column
+      ColumnType getColumnType(size_t idx) const;
+      /// Returns the number of terminated rows
+      size_t getNumRows() const;
+      /// Returns the number of rows per chunk
+      size_t getChunkSize() const;
+      /** @}
+        */
+
+      /** \name Public members
+        @{
+        */
+      /// Magic word starting the files
+      static const uint64_t magic;
+      /// Format version
+      static const uint64_t version;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Appends a raw value to the current row
+      void writeCell(uint64_t word, ColumnType type);
+      /// Writes the header
+      void writeHeader();
+      /// Writes the pending rows as a chunk
+      void writeChunk();
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Underlying writer
+      BinaryWriter _writer;
+      /// Number of rows per chunk
+      size_t _chunkSize;
+      /// Column names
+      std::vector<std::string> _names;
+      /// Column types
+      std::vector<ColumnType> _types;
+      /// Raw values of the current row
+      std::vector<uint64_t> _row;
+      /// Types of the values of the current row
+      std::vector<ColumnType> _rowTypes;
+      /// Raw values of the pending rows, column by column
+      std::vector<std::vector<uint64_t> > _chunk;
+      /// Number of pending rows
+      size_t _numChunkRows;
+      /// Number of terminated rows
+      size_t _numRows;
+      /// Header written flag
+      bool _headerWritten;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_BASE_COLUMNAR_WRITER_H
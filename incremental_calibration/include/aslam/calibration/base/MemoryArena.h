@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file MemoryArena.h
+    \brief This file defines the MemoryArena class, which provides chunked
+           memory for objects sharing the same lifetime.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_MEMORY_ARENA_H
+#define ASLAM_CALIBRATION_BASE_MEMORY_ARENA_H
+
+#include <cstddef>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class MemoryArena hands out memory from a few large chunks.
+        Individual deallocations are only counted, the chunks are released
+        at once when the arena is destroyed. It is meant for objects sharing
+        the lifetime of a batch, e.g., its error terms.
+        \brief Chunked memory arena
+      */
+    class MemoryArena {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Self type
+      typedef MemoryArena Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs arena with the size of the first chunk
+      MemoryArena(size_t chunkSize = 65536);
+      /// Copy constructor
+      MemoryArena(const Self& other) = delete;
+      /// Copy assignment operator
+      MemoryArena& operator = (const Self& other) = delete;
+      /// Move constructor
+      MemoryArena(Self&& other) = delete;
+      /// Move assignment operator
+      MemoryArena& operator = (Self&& other) = delete;
+      /// Destructor
+      virtual ~MemoryArena();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Allocates aligned memory
+      void* allocate(size_t size, size_t alignment);
+      /// Deallocates memory (reclaimed when the arena is destroyed)
+      void deallocate(void* pointer, size_t size);
+      /// Ensures that the next allocations of size bytes need no new chunk
+      void reserve(size_t size);
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the size of the first chunk
+      size_t getChunkSize() const;
+      /// Returns the number of chunks allocated from the system
+      size_t getNumChunks() const;
+      /// Returns the number of allocations
+      size_t getNumAllocations() const;
+      /// Returns the number of allocations not deallocated yet
+      size_t getNumLiveAllocations() const;
+      /// Returns the number of bytes handed out
+      size_t getNumBytesUsed() const;
+      /// Returns the number of bytes allocated from the system
+      size_t getNumBytesReserved() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Allocates a new chunk of at least size bytes
+      void addChunk(size_t size);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Size of the first chunk
+      size_t _chunkSize;
+      /// Chunks
+      std::vector<std::unique_ptr<char[]> > _chunks;
+      /// Size of the last chunk
+      size_t _lastChunkSize;
+      /// Offset of the free memory in the last chunk
+      size_t _offset;
+      /// Number of allocations
+      size_t _numAllocations;
+      /// Number of allocations not deallocated yet
+      size_t _numLiveAllocations;
+      /// Number of bytes handed out
+      size_t _numBytesUsed;
+      /// Number of bytes allocated from the system
+      size_t _numBytesReserved;
+      /// Mutex protecting the arena
+      mutable std::mutex _mutex;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_BASE_MEMORY_ARENA_H
@@ -0,0 +1,164 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file OrderedWorkerPool.h
+    \brief This file defines the OrderedWorkerPool class, which processes
+           jobs on worker threads and returns the results in queuing order.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_ORDERED_WORKER_POOL_H
+#define ASLAM_CALIBRATION_BASE_ORDERED_WORKER_POOL_H
+
+#include <cstddef>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class OrderedWorkerPool processes jobs on worker threads and
+        returns the results in queuing order. Each thread creates its own
+        worker function, such that per-thread state (e.g., a detector) needs
+        no locking. An exception thrown by a worker is rethrown on the
+        thread popping the corresponding result.
+        \brief Worker pool with ordered results
+      */
+    template <typename J, typename R> class OrderedWorkerPool {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Job type
+      typedef J Job;
+      /// Result type
+      typedef R Result;
+      /// Function processing a job
+      typedef std::function<R(const J&)> Worker;
+      /// Function creating the worker of a thread, called on that thread
+      typedef std::function<Worker()> WorkerFactory;
+      /// Self type
+      typedef OrderedWorkerPool<J, R> Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /** Constructs the pool and starts the threads. Popping blocks while
+          more than maxPending jobs are pending, 0 stands for twice the
+          number of threads.
+        */
+      OrderedWorkerPool(size_t numThreads, const WorkerFactory& factory,
+        size_t maxPending = 0);
+      /// Copy constructor
+      OrderedWorkerPool(const Self& other) = delete;
+      /// Copy assignment operator
+      OrderedWorkerPool& operator = (const Self& other) = delete;
+      /// Move constructor
+      OrderedWorkerPool(Self&& other) = delete;
+      /// Move assignment operator
+      OrderedWorkerPool& operator = (Self&& other) = delete;
+      /// Destructor, discards the pending jobs
+      ~OrderedWorkerPool();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of threads
+      size_t getNumThreads() const;
+      /// Returns the maximum number of pending jobs
+      size_t getMaxPending() const;
+      /// Returns the number of jobs pushed but not popped yet
+      size_t getNumPending() const;
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Pushes a job
+      void push(J job);
+      /** Pops the next result in queuing order if it is available, blocking
+          only while too many jobs are pending. Returns false if no result
+          was popped.
+        */
+      bool popReady(R& result);
+      /** Pops the next result in queuing order, waiting for it if needed.
+          Returns false if no job is pending.
+        */
+      bool popNext(R& result);
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Runs a worker thread
+      void run();
+      /// Pops the next result, waiting for it if requested
+      bool pop(R& result, bool wait);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Worker factory
+      WorkerFactory _factory;
+      /// Maximum number of pending jobs
+      size_t _maxPending;
+      /// Threads
+      std::vector<std::thread> _threads;
+      /// Jobs waiting for a thread with their sequence number
+      std::deque<std::pair<size_t, J> > _jobs;
+      /// Results with the worker exception indexed by sequence number
+      std::map<size_t, std::pair<R, std::exception_ptr> > _results;
+      /// Number of pushed jobs
+      size_t _numPushed;
+      /// Number of popped results
+      size_t _numPopped;
+      /// Stop flag for the threads
+      bool _stop;
+      /// Mutex protecting the queues
+      mutable std::mutex _mutex;
+      /// Signals new jobs or a stop request to the threads
+      std::condition_variable _jobsCondition;
+      /// Signals new results
+      std::condition_variable _resultsCondition;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/base/OrderedWorkerPool.tpp"
+
+#endif // ASLAM_CALIBRATION_BASE_ORDERED_WORKER_POOL_H
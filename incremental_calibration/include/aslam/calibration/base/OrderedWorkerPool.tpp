@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    template <typename J, typename R>
+    OrderedWorkerPool<J, R>::OrderedWorkerPool(size_t numThreads, const
+        WorkerFactory& factory, size_t maxPending) :
+        _factory(factory),
+        _maxPending(maxPending ? maxPending : 2 * numThreads),
+        _numPushed(0),
+        _numPopped(0),
+        _stop(false) {
+      _threads.reserve(numThreads);
+      for (size_t i = 0; i < numThreads; ++i)
+        _threads.push_back(std::thread(&Self::run, this));
+    }
+
+    template <typename J, typename R>
+    OrderedWorkerPool<J, R>::~OrderedWorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _jobsCondition.notify_all();
+      for (auto it = _threads.begin(); it != _threads.end(); ++it)
+        it->join();
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    template <typename J, typename R>
+    size_t OrderedWorkerPool<J, R>::getNumThreads() const {
+      return _threads.size();
+    }
+
+    template <typename J, typename R>
+    size_t OrderedWorkerPool<J, R>::getMaxPending() const {
+      return _maxPending;
+    }
+
+    template <typename J, typename R>
+    size_t OrderedWorkerPool<J, R>::getNumPending() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _numPushed - _numPopped;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename J, typename R>
+    void OrderedWorkerPool<J, R>::push(J job) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::make_pair(_numPushed++, std::move(job)));
+      }
+      _jobsCondition.notify_one();
+    }
+
+    template <typename J, typename R>
+    bool OrderedWorkerPool<J, R>::popReady(R& result) {
+      return pop(result, false);
+    }
+
+    template <typename J, typename R>
+    bool OrderedWorkerPool<J, R>::popNext(R& result) {
+      return pop(result, true);
+    }
+
+    template <typename J, typename R>
+    bool OrderedWorkerPool<J, R>::pop(R& result, bool wait) {
+      std::pair<R, std::exception_ptr> slot;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_numPopped == _numPushed)
+          return false;
+        auto it = _results.find(_numPopped);
+        if (it == _results.end()) {
+          if (!wait && _numPushed - _numPopped <= _maxPending)
+            return false;
+          _resultsCondition.wait(lock, [&](){
+            it = _results.find(_numPopped);
+            return it != _results.end();});
+        }
+        slot = std::move(it->second);
+        _results.erase(it);
+        _numPopped++;
+      }
+      if (slot.second)
+        std::rethrow_exception(slot.second);
+      result = std::move(slot.first);
+      return true;
+    }
+
+    template <typename J, typename R>
+    void OrderedWorkerPool<J, R>::run() {
+      Worker worker = _factory();
+      while (true) {
+        std::pair<size_t, J> job;
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _jobsCondition.wait(lock, [&](){
+            return _stop || !_jobs.empty();});
+          if (_stop)
+            return;
+          job = std::move(_jobs.front());
+          _jobs.pop_front();
+        }
+        std::pair<R, std::exception_ptr> slot;
+        try {
+          slot.first = worker(job.second);
+        }
+        catch (...) {
+          slot.second = std::current_exception();
+        }
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _results[job.first] = std::move(slot);
+        }
+        _resultsCondition.notify_all();
+      }
+    }
+
+  }
+}
@@ -25,18 +25,27 @@
 #define ASLAM_CALIBRATION_CORE_INCREMENTAL_ESTIMATOR_H
 
 #include <cstddef>
+#include <cstdint>
+
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <aslam-tsvd-solver/aslam-tsvd-solver.h>
 #include <aslam/backend/Optimizer2Options.hpp>
 #include <boost/shared_ptr.hpp>
 #include <Eigen/Core>
 
+#include "aslam/calibration/core/IncrementalMarginalAnalyzer.h"
+
 namespace sm {
   class PropertyTree;
 }
 
 namespace aslam {
   namespace backend {
+    class DesignVariable;
     class GaussNewtonTrustRegionPolicy;
     class Optimizer2;
     template<typename I> class CompressedColumnMatrix;
@@ -62,6 +71,11 @@ namespace aslam {
       typedef OptimizationProblem Batch;
       /// Optimization problem type (shared pointer)
       typedef boost::shared_ptr<OptimizationProblem> BatchSP;
+      /// Design variable (shared pointer)
+      typedef boost::shared_ptr<aslam::backend::DesignVariable>
+        DesignVariableSP;
+      /// Container of design variables (shared pointers)
+      typedef std::vector<DesignVariableSP> DesignVariablesSP;
       /// Incremental optimization problem (shared pointer)
       typedef boost::shared_ptr<IncrementalOptimizationProblem>
         IncrementalOptimizationProblemSP;
@@ -80,40 +94,51 @@ namespace aslam {
         Options() :
             infoGainDelta(0.2),
             checkValidity(false),
+            incrementalMarginal(false),
+            marginalRelinearizationThreshold(1e-2),
+            preScreening(false),
+            preScreeningInfoGainDelta(0.1),
+            maxNumBatches(0),
+            maxNumErrorTerms(0),
+            evictLowestInformation(false),
+            scoringThreads(0),
             verbose(false) {
         }
         /// Information gain delta
         double infoGainDelta;
         /// Check validity of the solution
         bool checkValidity;
+        /// Fold new batches into the marginal R factor instead of a full QR
+        bool incrementalMarginal;
+        /// Relative change of theta above which the R factor is rebuilt
+        double marginalRelinearizationThreshold;
+        /// Reject batches from their linearization before optimizing
+        bool preScreening;
+        /// Approximate information gain below which batches are rejected
+        double preScreeningInfoGainDelta;
+        /// Maximum number of batches kept in the problem (0 for unlimited)
+        size_t maxNumBatches;
+        /// Maximum number of error terms kept in the problem (0 for unlimited)
+        size_t maxNumErrorTerms;
+        /// Evict the batches with lowest information gain instead of oldest
+        bool evictLowestInformation;
+        /// Number of threads for scoring candidate batches (0 for all cores)
+        size_t scoringThreads;
         /// Verbosity of the estimator
         bool verbose;
       };
-      /// Return value when adding a batch
-      struct ReturnValue {
-        /// True if the batch was accepted
-        bool batchAccepted;
-        /// Information gain
-        double informationGain;
-        /// Numerical rank of J_psi
-        std::ptrdiff_t rankPsi;
-        /// Numerical rank deficiency of J_psi
-        std::ptrdiff_t rankPsiDeficiency;
-        /// Numerical rank of A_theta
-        std::ptrdiff_t rankTheta;
-        /// Numerical rank deficiency of A_theta
-        std::ptrdiff_t rankThetaDeficiency;
-        /// SVD tolerance used for this batch
-        double svdTolerance;
-        /// QR tolerance used for this batch
-        double qrTolerance;
+      /** Results of the analysis of the marginal system. A snapshot is never
+          modified once published, such that the estimator and the return
+          values of the accepted batches can share it.
+        */
+      struct MarginalResults {
         /// Orthonormal basis for the unobservable subspace of theta
         Eigen::MatrixXd nobsBasis;
         /// Orthonormal basis for the unobservable subspace of scaled theta
         Eigen::MatrixXd nobsBasisScaled;
         /// Orthonormal basis for the observable subspace of theta
         Eigen::MatrixXd obsBasis;
-        /// Orthonormal basis for the observable subspace of theta
+        /// Orthonormal basis for the observable subspace of scaled theta
         Eigen::MatrixXd obsBasisScaled;
         /// Covariance of theta
         Eigen::MatrixXd sigma2Theta;
@@ -127,6 +152,31 @@ namespace aslam {
         Eigen::VectorXd singularValues;
         /// Singular values of scaled A_theta
         Eigen::VectorXd singularValuesScaled;
+      };
+      /// Marginal analysis results (shared pointer to const)
+      typedef boost::shared_ptr<const MarginalResults> MarginalResultsCSP;
+      /// Return value when adding a batch
+      struct ReturnValue {
+        /// True if the batch was accepted
+        bool batchAccepted;
+        /// True if the batch was rejected before the optimization
+        bool preScreened;
+        /// Information gain
+        double informationGain;
+        /// Numerical rank of J_psi
+        std::ptrdiff_t rankPsi;
+        /// Numerical rank deficiency of J_psi
+        std::ptrdiff_t rankPsiDeficiency;
+        /// Numerical rank of A_theta
+        std::ptrdiff_t rankTheta;
+        /// Numerical rank deficiency of A_theta
+        std::ptrdiff_t rankThetaDeficiency;
+        /// SVD tolerance used for this batch
+        double svdTolerance;
+        /// QR tolerance used for this batch
+        double qrTolerance;
+        /// Marginal analysis, shared with the estimator if accepted
+        MarginalResultsCSP marginal;
         /// Number of iterations
         size_t numIterations;
         /// Cost function at start
@@ -135,6 +185,34 @@ namespace aslam {
         double JFinal;
         /// Elapsed time for processing this batch [s]
         double elapsedTime;
+        /// Elapsed time for pre-screening the batch [s]
+        double preScreeningTime;
+        /// Elapsed time for inserting the batch into the problem [s]
+        double insertionTime;
+        /// Elapsed time for ordering the design variables [s]
+        double orderingTime;
+        /// Elapsed time for building the Jacobian structure and values [s]
+        double jacobianTime;
+        /// Elapsed time for solving the linear systems [s]
+        double linearSolverTime;
+        /// Elapsed time for the rest of the optimizer iterations [s]
+        double optimizationTime;
+        /// Elapsed time for analyzing the marginal system [s]
+        double marginalAnalysisTime;
+        /// Elapsed time for rolling back a rejected batch [s]
+        double rollbackTime;
+        /// Elapsed time for evicting batches into the prior [s]
+        double evictionTime;
+        /// Number of batches evicted into the prior
+        size_t numEvictedBatches;
+        /// Number of error terms in the problem
+        size_t numErrorTerms;
+        /// Number of design variables in the problem
+        size_t numDesignVariables;
+        /// Number of non-zeros of the Jacobian
+        size_t jacobianNnz;
+        /// Number of flops of the linear solver
+        double numFlops;
       };
       /** @}
         */
@@ -166,20 +244,40 @@ namespace aslam {
         */
       /// Adds a measurement batch to the estimator
       ReturnValue addBatch(const BatchSP& batch, bool force = false);
+      /// Scores candidate batches concurrently against the current estimate
+      std::vector<ReturnValue> scoreBatches(const std::vector<BatchSP>&
+        batches) const;
+      /// Adds candidate batches, the most informative ones first
+      std::vector<ReturnValue> addBatches(const std::vector<BatchSP>& batches,
+        bool force = false);
       /// Removes a measurement batch from the estimator
       void removeBatch(size_t idx);
       /// Removes a measurement batch from the estimator
       void removeBatch(const BatchSP& batch);
       /// Re-runs the optimizer
       ReturnValue reoptimize();
+      /// Writes a binary checkpoint of the estimator state to a stream
+      void writeCheckpoint(std::ostream& stream) const;
+      /// Writes a binary checkpoint of the estimator state to a file
+      void saveCheckpoint(const std::string& filename) const;
+      /// Restores an empty estimator and its design variables from a stream
+      void readCheckpoint(std::istream& stream,
+        const DesignVariablesSP& designVariables);
+      /// Restores an empty estimator and its design variables from a file
+      void loadCheckpoint(const std::string& filename,
+        const DesignVariablesSP& designVariables);
       /** @}
         */
 
       /** \name Accessors
         @{
         */
-      /// Returns the number of batches
+      /// Returns the number of batches, including the prior batch
       size_t getNumBatches() const;
+      /// Returns the batch holding the prior of the evicted batches if any
+      BatchSP getPriorBatch() const;
+      /// Returns the total number of batches evicted into the prior
+      size_t getNumEvictedBatches() const;
       /// Returns the incremental optimization problem
       const IncrementalOptimizationProblem* getProblem() const;
       /// Returns the current options
@@ -201,6 +299,8 @@ namespace aslam {
       /// Returns the current Jacobian transpose if available
       const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
         getJacobianTranspose() const;
+      /// Returns the linear solver
+      boost::shared_ptr<LinearSolver> getLinearSolver() const;
       /// Returns the current estimated numerical rank of J_psi
       std::ptrdiff_t getRankPsi() const;
       /// Returns the current estimated numerical rank deficiency of J_psi
@@ -223,12 +323,16 @@ namespace aslam {
       const Eigen::MatrixXd& getSigma2ThetaObs(bool scaled = false) const;
       /// Returns the singular values of A_theta
       const Eigen::VectorXd& getSingularValues(bool scaled = false) const;
+      /// Returns the current marginal analysis snapshot
+      MarginalResultsCSP getMarginalResults() const;
       /// Returns the peak memory usage in bytes
       size_t getPeakMemoryUsage() const;
       /// Returns the current memory usage in bytes
       size_t getMemoryUsage() const;
       /// Returns the number of flops of the linear solver
       double getNumFlops() const;
+      /// Returns the number of symbolic factorizations of J_psi so far
+      size_t getNumSymbolicFactorizations() const;
       /// Returns the current initial cost for the estimator
       double getInitialCost() const;
       /// Returns the current final cost for the estimator
@@ -250,14 +354,76 @@ namespace aslam {
         */
       /// Ensures the marginalized variables are well located
       void orderMarginalizedDesignVariables();
-      /// Restores the linear solver
-      void restoreLinearSolver();
+      /** Restores the linear solver, from its saved Jacobian if requested.
+          When rolling back the last batch, the first numUnchangedDVs design
+          variables and all the error terms keep their indices, and only the
+          following design variables are visited. With appendedOnly, only the
+          error terms the solver did not keep are evaluated, the kept ones
+          must be unchanged since the last build.
+        */
+      void restoreLinearSolver(bool fromSavedState = false,
+        size_t numUnchangedDVs = 0, bool appendedOnly = false);
+      /// Returns the number of leading design variables a batch did not move
+      size_t getNumUnchangedDesignVariables(const std::vector<std::pair<size_t,
+        size_t> >& groupsSizes) const;
+      /// Builds the dense Jacobians of a batch, false if psi is shared
+      bool getBatchJacobians(Batch& batch, Eigen::MatrixXd& Jpsi,
+        Eigen::MatrixXd& Jtheta, bool inProblem = true) const;
+      /// Builds the dense Jacobians and weighted errors of a batch
+      bool getBatchJacobians(Batch& batch, Eigen::MatrixXd& Jpsi,
+        Eigen::MatrixXd& Jtheta, Eigen::VectorXd& error, bool inProblem = true)
+        const;
+      /// Evicts batches beyond the retention limits into the prior
+      size_t evictBatches(const BatchSP& newest);
+      /// Checks if a batch in the problem shares nuisance variables
+      bool hasSharedNuisances(const Batch& batch) const;
+      /// Summarizes batches into a square-root prior, false if psi is shared
+      bool summarizeBatches(const std::vector<BatchSP>& batches,
+        Eigen::MatrixXd& R, Eigen::VectorXd& r) const;
+      /// Returns the design variables of theta in the group ordering
+      DesignVariablesSP getMargDesignVariables() const;
+      /// Creates the batch holding the prior on the active design variables
+      BatchSP createPriorBatch(const DesignVariablesSP& designVariables,
+        const Eigen::MatrixXd& R, const Eigen::VectorXd& r) const;
+      /// Folds a batch into a copy of the marginal analyzer, false if invalid
+      bool analyzeMarginalIncrementally(Batch& batch,
+        IncrementalMarginalAnalyzer& marginalAnalyzer, bool& relinearized)
+        const;
+      /// Builds a marginal analyzer from all the batches, false if invalid
+      bool buildMarginalAnalyzer(IncrementalMarginalAnalyzer&
+        marginalAnalyzer) const;
+      /// Rebuilds the marginal analyzer from all the batches
+      void resetMarginalAnalyzer();
+      /// Returns the parameters of the active design variables of theta
+      Eigen::VectorXd getMargParameters() const;
+      /// Returns true if theta moved too far from the marginal analyzer
+      bool isMarginalAnalyzerStale() const;
+      /// Scores a batch from its linearization, false if it cannot be scored
+      bool scoreBatch(Batch& batch, const IncrementalMarginalAnalyzer&
+        currentAnalyzer, ReturnValue& ret) const;
+      /// Returns true if a batch can be rejected without optimization
+      bool preScreenBatch(Batch& batch, ReturnValue& ret) const;
+      /// Fills the return value of a batch that is not optimized
+      void fillSkippedReturnValue(ReturnValue& ret) const;
+      /// Copies the unscaled marginal analysis of a solver or an analyzer
+      template <typename Analyzer>
+      static void fillMarginalResults(const Analyzer& analyzer,
+        MarginalResults& marginal);
+      /// Copies the scaled marginal analysis of the linear solver
+      void fillScaledMarginalResults(MarginalResults& marginal) const;
+      /// Fills the timings of the optimizer and the problem counters
+      void setOptimizerStatistics(ReturnValue& ret, double optimizerTime)
+        const;
       /** @}
         */
 
       /** \name Protected members
         @{
         */
+      /// Magic number of the binary checkpoints
+      static const uint64_t _checkpointMagic;
+      /// Format version of the binary checkpoints
+      static const uint64_t _checkpointVersion;
       /// Options
       Options _options;
       /// Group ID to marginalize
@@ -270,26 +436,8 @@ namespace aslam {
       double _informationGain;
       /// Sum of the log2 of the singular values of A_theta (up to rankTheta)
       double _svLog2Sum;
-      /// Orthonormal basis for the unobservable subspace of theta
-      Eigen::MatrixXd _nobsBasis;
-      /// Orthonormal basis for the unobservable subspace of scaled theta
-      Eigen::MatrixXd _nobsBasisScaled;
-      /// Orthonormal basis for the observable subspace of theta
-      Eigen::MatrixXd _obsBasis;
-      /// Orthonormal basis for the observable subspace of scaled theta
-      Eigen::MatrixXd _obsBasisScaled;
-      /// Covariance of theta
-      Eigen::MatrixXd _sigma2Theta;
-      /// Covariance of scaled theta
-      Eigen::MatrixXd _sigma2ThetaScaled;
-      /// Covariance of theta_obs
-      Eigen::MatrixXd _sigma2ThetaObs;
-      /// Covariance of scaled theta_obs
-      Eigen::MatrixXd _sigma2ThetaObsScaled;
-      /// Singular values of A_theta
-      Eigen::VectorXd _singularValues;
-      /// Singular values of scaled A_theta
-      Eigen::VectorXd _singularValuesScaled;
+      /// Marginal analysis of the accepted batches
+      MarginalResultsCSP _marginal;
       /// Tolerance for SVD
       double _svdTolerance;
       /// Tolerance for QR
@@ -312,6 +460,18 @@ namespace aslam {
       double _initialCost;
       /// Final cost
       double _finalCost;
+      /// Marginal R factor for the incremental analysis
+      IncrementalMarginalAnalyzer _marginalAnalyzer;
+      /// True if the marginal analyzer reflects all the batches
+      bool _marginalAnalyzerValid;
+      /// Parameters of theta the marginal analyzer was linearized at
+      Eigen::VectorXd _marginalLinearizationPoint;
+      /// Information gain of the batches when they were accepted
+      std::unordered_map<const Batch*, double> _batchInformation;
+      /// Batch holding the prior of the evicted batches
+      BatchSP _priorBatch;
+      /// Total number of batches evicted into the prior
+      size_t _numEvictedBatches;
       /** @}
         */
 
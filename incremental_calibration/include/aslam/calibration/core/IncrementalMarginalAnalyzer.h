@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file IncrementalMarginalAnalyzer.h
+    \brief This file defines the IncrementalMarginalAnalyzer class, which
+           maintains the R factor of the marginal system batch by batch.
+  */
+
+#ifndef ASLAM_CALIBRATION_CORE_INCREMENTAL_MARGINAL_ANALYZER_H
+#define ASLAM_CALIBRATION_CORE_INCREMENTAL_MARGINAL_ANALYZER_H
+
+#include <cstddef>
+
+#include <Eigen/Core>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class IncrementalMarginalAnalyzer maintains the upper-triangular
+        factor R_theta of the marginal system A_theta of the calibration
+        parameters. Each batch [J_psi J_theta] only touches its own nuisance
+        variables psi, such that its rows are folded in by projecting J_theta
+        onto the orthogonal complement of J_psi and re-triangularizing
+        [R_theta; Q_2^T J_theta]. The cost of a batch thus depends on its size
+        only. The SVD of R_theta then yields the same quantities as the
+        analysis of the full stacked Jacobian.
+        \brief Incremental marginal analyzer
+      */
+    class IncrementalMarginalAnalyzer {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Self type
+      typedef IncrementalMarginalAnalyzer Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs analyzer with marginal dimension and tolerances
+      IncrementalMarginalAnalyzer(size_t dim = 0, double qrTol = -1.0,
+        double svdTol = -1.0);
+      /// Copy constructor
+      IncrementalMarginalAnalyzer(const Self& other) = default;
+      /// Copy assignment operator
+      IncrementalMarginalAnalyzer& operator = (const Self& other) = default;
+      /// Destructor
+      virtual ~IncrementalMarginalAnalyzer();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Folds in the rows of a batch
+      void addBatch(const Eigen::MatrixXd& Jpsi, const Eigen::MatrixXd& Jtheta);
+      /// Computes the SVD of the current marginal R factor
+      void analyze();
+      /// Clears the analyzer for a given marginal dimension
+      void clear(size_t dim);
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the marginal dimension
+      size_t getDim() const;
+      /// Returns the current marginal R factor
+      const Eigen::MatrixXd& getR() const;
+      /// Returns the estimated numerical rank of J_psi
+      std::ptrdiff_t getQRRank() const;
+      /// Returns the estimated numerical rank deficiency of J_psi
+      std::ptrdiff_t getQRRankDeficiency() const;
+      /// Returns the tolerance used for the QR decompositions
+      double getQRTolerance() const;
+      /// Returns the estimated numerical rank of A_theta
+      std::ptrdiff_t getSVDRank() const;
+      /// Returns the estimated numerical rank deficiency of A_theta
+      std::ptrdiff_t getSVDRankDeficiency() const;
+      /// Returns the tolerance used for the SVD
+      double getSVDTolerance() const;
+      /// Returns the singular values of A_theta (decreasing order)
+      const Eigen::VectorXd& getSingularValues() const;
+      /// Returns the sum of the log2 of the singular values up to the rank
+      double getSingularValuesLog2Sum() const;
+      /// Returns the orthonormal basis for the unobservable subspace of theta
+      const Eigen::MatrixXd& getNullSpace() const;
+      /// Returns the orthonormal basis for the observable subspace of theta
+      const Eigen::MatrixXd& getRowSpace() const;
+      /// Returns the covariance of theta
+      const Eigen::MatrixXd& getCovariance() const;
+      /// Returns the covariance of theta_obs
+      const Eigen::MatrixXd& getRowSpaceCovariance() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Marginal dimension
+      size_t _dim;
+      /// QR tolerance (automatic if negative)
+      double _qrTol;
+      /// SVD tolerance (automatic if negative)
+      double _svdTol;
+      /// Marginal R factor
+      Eigen::MatrixXd _R;
+      /// Number of columns of J_psi folded in so far
+      std::ptrdiff_t _numPsiCols;
+      /// Estimated numerical rank of J_psi
+      std::ptrdiff_t _rankPsi;
+      /// Largest tolerance used for the QR decompositions
+      double _qrTolerance;
+      /// Estimated numerical rank of A_theta
+      std::ptrdiff_t _rankTheta;
+      /// Tolerance used for the SVD
+      double _svdTolerance;
+      /// Singular values of A_theta
+      Eigen::VectorXd _singularValues;
+      /// Sum of the log2 of the singular values up to the rank
+      double _svLog2Sum;
+      /// Orthonormal basis for the unobservable subspace of theta
+      Eigen::MatrixXd _nobsBasis;
+      /// Orthonormal basis for the observable subspace of theta
+      Eigen::MatrixXd _obsBasis;
+      /// Covariance of theta
+      Eigen::MatrixXd _sigma2Theta;
+      /// Covariance of theta_obs
+      Eigen::MatrixXd _sigma2ThetaObs;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_CORE_INCREMENTAL_MARGINAL_ANALYZER_H
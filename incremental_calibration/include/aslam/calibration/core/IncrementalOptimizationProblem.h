@@ -46,7 +46,14 @@ namespace aslam {
     class OptimizationProblem;
 
     /** The class IncrementalOptimizationProblem implements a container for
-        optimization problems.
+        optimization problems. The ordered design variables, the groups
+        offsets and dimensions are updated by the structure changes, so that
+        the constant accessors only read and can be called from concurrent
+        threads. Adding a problem only touches the groups tails, removing one
+        compacts the groups it empties slots in. The groups dimensions only
+        account for the activity of the design variables a structure change
+        touched: (de)activating a design variable already in the problem
+        requires a call to invalidateGroupsDims().
         \brief Incremental optimization problem
       */
     class IncrementalOptimizationProblem :
@@ -73,6 +80,16 @@ namespace aslam {
       /// Container for design variable groups
       typedef std::unordered_map<size_t, DesignVariablesP>
         DesignVariablePGroups;
+      /// Container for the dimensions of the design variable groups
+      typedef std::unordered_map<size_t, size_t> GroupsDims;
+      /// Container for the number of design variables in the groups
+      typedef std::unordered_map<size_t, size_t> GroupsSizes;
+      /// Design variable (pointer) to slot in its group container
+      typedef std::unordered_map<const DesignVariable*, size_t>
+        DesignVariablesPSlots;
+      /// Optimization problem (pointer) to index container
+      typedef std::unordered_map<const OptimizationProblem*, size_t>
+        OptimizationProblemsPIdx;
       /// Error term type
       typedef aslam::backend::ErrorTerm ErrorTerm;
       typedef aslam::backend::ScalarNonSquaredErrorTerm ScalarNonSquaredErrorTerm;
@@ -82,7 +99,7 @@ namespace aslam {
       /// Container for error terms (shared pointer)
       typedef std::vector<ErrorTermSP> ErrorTermsSP;
       /// Container for design variables saving/restoring
-      typedef std::unordered_map<DesignVariable*, Eigen::MatrixXd>
+      typedef std::vector<std::pair<DesignVariable*, Eigen::MatrixXd> >
         DesignVariablesBackup;
       /// Self type
       typedef IncrementalOptimizationProblem Self;
@@ -123,12 +140,16 @@ namespace aslam {
         size_t groupId);
       /// Permutes the optimization problems
       void permuteOptimizationProblems(const std::vector<size_t>& permutation);
-      /// Saves the state of the design variables
+      /// Saves the state of the active design variables
       void saveDesignVariables();
-      /// Restores the state of the design variables
+      /** Restores the state of the saved design variables, the state is
+          dropped when a problem is removed
+        */
       void restoreDesignVariables();
       /// Clears the content of the problem
       void clear();
+      /// Recomputes the groups dimensions (activity changes)
+      void invalidateGroupsDims();
       /** @}
         */
 
@@ -175,6 +196,9 @@ namespace aslam {
       const std::vector<size_t>& getGroupsOrdering() const;
       /// Returns the group id of a design variable
       size_t getGroupId(const DesignVariable* designVariable) const;
+      /// Returns the number of problems a design variable appears in
+      size_t getDesignVariableCount(const DesignVariable* designVariable)
+        const;
       /// Returns the dimension of a group
       size_t getGroupDim(size_t groupId) const;
       /// Checks if a group is in the problem
@@ -206,6 +230,14 @@ namespace aslam {
       void getGroupId(size_t idx, size_t& groupId, size_t& idxGroup) const;
       /// Returns the error term index in a batch from a global index
       void getErrorIdx(size_t idx, size_t& batchIdx, size_t& idxBatch) const;
+      /// Rebuilds the error terms offsets starting from a batch index
+      void updateErrorTermsOffsets(size_t batchIdx = 0);
+      /// Rebuilds the problems indices starting from a batch index
+      void updateOptimizationProblemsIdx(size_t batchIdx = 0);
+      /// Removes the tombstones of a group and recomputes its dimension
+      void compactDesignVariablesGroup(size_t groupId);
+      /// Rebuilds the ordered design variables from a position in the ordering
+      void updateDesignVariablesOrdered(size_t groupIdx = 0);
 
       /// \brief the number of non-squared error terms in this optimization problem
       virtual size_t numNonSquaredErrorTermsImplementation() const{ return 0;}
@@ -225,14 +257,37 @@ namespace aslam {
         */
       /// Optimization problems shared pointers
       OptimizationProblemsSP _optimizationProblems;
+      /// Index of each optimization problem in the container
+      OptimizationProblemsPIdx _optimizationProblemsIdx;
       /// Design variable pointers counts and group ID
       DesignVariablesPCountId _designVariablesCounts;
       /// Storage for the design variables pointers in groups
       DesignVariablePGroups _designVariables;
+      /// Slot of each design variable in its group storage
+      DesignVariablesPSlots _designVariablesSlots;
+      /// Number of design variables in each group
+      GroupsSizes _groupsSizes;
       /// Groups ordering
       std::vector<size_t> _groupsOrdering;
-      /// Backup for design variables
+      /// Backup for design variables (storage kept between saves)
       DesignVariablesBackup _designVariablesBackup;
+      /// Number of design variables in the backup
+      size_t _designVariablesBackupSize;
+      /** Global index of the first error term of each batch, with the total
+          number of error terms as last element. This assumes that batches are
+          not modified once they have been inserted.
+        */
+      std::vector<size_t> _errorTermsOffsets;
+      /// Design variables pointers flattened in the groups ordering
+      DesignVariablesP _designVariablesOrdered;
+      /** Dimensions of the groups, i.e., sum of the minimal dimensions of the
+          active design variables at the last structure change
+        */
+      GroupsDims _groupsDims;
+      /** Index of the first design variable of each group in the groups
+          ordering, with the total number of design variables as last element
+        */
+      std::vector<size_t> _groupsOffsets;
       /** @}
         */
 
@@ -35,6 +35,8 @@
 
 #include <aslam/backend/OptimizationProblemBase.hpp>
 
+#include "aslam/calibration/base/MemoryArena.h"
+
 namespace aslam {
   namespace backend {
 
@@ -79,6 +81,8 @@ namespace aslam {
       /// Container for design variables saving/restoring
       typedef std::unordered_map<DesignVariable*, Eigen::MatrixXd>
         DesignVariablesBackup;
+      /// Memory arena (shared pointer)
+      typedef boost::shared_ptr<MemoryArena> MemoryArenaSP;
       /// Self type
       typedef OptimizationProblem Self;
       /** @}
@@ -126,6 +130,9 @@ namespace aslam {
       void restoreDesignVariables();
       /// Clears the optimization problem
       void clear();
+      /// Creates an object, e.g., an error term, in the problem arena
+      template <typename T, typename... Args>
+        boost::shared_ptr<T> allocate(Args&&... args);
       /** @}
         */
 
@@ -150,6 +157,8 @@ namespace aslam {
       size_t getGroupDim(size_t groupId) const;
       /// Checks if a group is in the problem
       bool isGroupInProblem(size_t groupId) const;
+      /// Returns the memory arena of the problem
+      const MemoryArenaSP& getArena() const;
       /** @}
         */
 
@@ -206,6 +215,8 @@ namespace aslam {
       std::vector<size_t> _groupsOrdering;
       /// Backup for design variables
       DesignVariablesBackup _designVariablesBackup;
+      /// Memory arena for the objects sharing the lifetime of the problem
+      MemoryArenaSP _arena;
       /** @}
         */
 
@@ -214,4 +225,6 @@ namespace aslam {
   }
 }
 
+#include "aslam/calibration/core/OptimizationProblem.tpp"
+
 #endif // ASLAM_CALIBRATION_CORE_OPTIMIZATION_PROBLEM_H
@@ -0,0 +1,39 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <utility>
+
+#include <boost/make_shared.hpp>
+
+#include "aslam/calibration/base/ArenaAllocator.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename T, typename... Args>
+    boost::shared_ptr<T> OptimizationProblem::allocate(Args&&... args) {
+      return boost::allocate_shared<T>(ArenaAllocator<T>(_arena),
+        std::forward<Args>(args)...);
+    }
+
+  }
+}
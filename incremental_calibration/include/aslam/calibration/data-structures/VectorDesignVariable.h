@@ -96,6 +96,9 @@ namespace aslam {
       virtual void getParametersImplementation(Eigen::MatrixXd& value) const;
       /// Sets the content of the design variable
       virtual void setParametersImplementation(const Eigen::MatrixXd& value);
+      /// Computes the difference with a linearization point
+      virtual void minimalDifferenceImplementation(const Eigen::MatrixXd&
+        xHat, Eigen::VectorXd& outDifference) const;
       /** @}
         */
 
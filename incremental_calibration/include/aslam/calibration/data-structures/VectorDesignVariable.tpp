@@ -130,5 +130,14 @@ namespace aslam {
       _value = value;
     }
 
+    template<int M>
+    void VectorDesignVariable<M>::minimalDifferenceImplementation(
+        const Eigen::MatrixXd& xHat, Eigen::VectorXd& outDifference) const {
+      if (xHat.cols() != _value.cols() || xHat.rows() != _value.rows())
+        throw OutOfBoundException<int>(xHat.rows(), _value.rows(),
+          "dimensions must match", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      outDifference = _value - xHat;
+    }
+
   }
 }
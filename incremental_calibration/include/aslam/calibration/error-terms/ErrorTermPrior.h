@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ErrorTermPrior.h
+    \brief This file defines the ErrorTermPrior class, which implements a
+           dense Gaussian prior on a set of design variables.
+  */
+
+#ifndef ASLAM_CALIBRATION_ERROR_TERMS_ERROR_TERM_PRIOR_H
+#define ASLAM_CALIBRATION_ERROR_TERMS_ERROR_TERM_PRIOR_H
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class ErrorTermPrior implements a dense Gaussian prior on a set of
+        design variables x, in square-root form. The error is
+        e = R (x - x_0) + r, where x - x_0 is the minimal difference of the
+        design variables with their values at construction. It typically
+        summarizes measurements that have been removed from a problem after
+        marginalizing their nuisance variables.
+        \brief Dense Gaussian prior error term
+      */
+    class ErrorTermPrior :
+      public aslam::backend::ErrorTermDs {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Design variable type
+      typedef aslam::backend::DesignVariable DesignVariable;
+      /// Self type
+      typedef ErrorTermPrior Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /**
+       * Constructs the prior, linearized at the current design variables.
+       * These must implement minimalDifference(), as VectorDesignVariable.
+       * \brief Constructs the error term
+       *
+       * @param designVariables design variables, ordered as the columns of R
+       * @param R square-root information matrix
+       * @param r residual at the linearization point
+       */
+      ErrorTermPrior(const std::vector<DesignVariable*>& designVariables,
+        const Eigen::MatrixXd& R, const Eigen::VectorXd& r);
+      /// Copy constructor
+      ErrorTermPrior(const Self& other) = delete;
+      /// Assignment operator
+      ErrorTermPrior& operator = (const Self& other) = delete;
+      /// Destructor
+      virtual ~ErrorTermPrior();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the square-root information matrix
+      const Eigen::MatrixXd& getR() const;
+      /// Returns the residual at the linearization point
+      const Eigen::VectorXd& getResidual() const;
+      /// Returns the linearization points of the design variables
+      const std::vector<Eigen::MatrixXd>& getLinearizationPoints() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Evaluate the error term and return the weighted squared error
+      virtual double evaluateErrorImplementation();
+      /// Evaluate the Jacobians
+      virtual void evaluateJacobiansImplementation(
+        aslam::backend::JacobianContainer& jacobians);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Design variables
+      std::vector<DesignVariable*> _designVariables;
+      /// Square-root information matrix
+      Eigen::MatrixXd _R;
+      /// Residual at the linearization point
+      Eigen::VectorXd _r;
+      /// Linearization points of the design variables
+      std::vector<Eigen::MatrixXd> _linearizationPoints;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_ERROR_TERMS_ERROR_TERM_PRIOR_H
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/base/BinaryStream.h"
+
+#include <cstdint>
+
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    BinaryWriter::BinaryWriter(std::ostream& stream) :
+        _stream(stream),
+        _numBytes(0) {
+    }
+
+    BinaryWriter::~BinaryWriter() {
+    }
+
+    BinaryReader::BinaryReader(std::istream& stream) :
+        _stream(stream),
+        _numBytes(0) {
+    }
+
+    BinaryReader::~BinaryReader() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    size_t BinaryWriter::getNumBytes() const {
+      return _numBytes;
+    }
+
+    size_t BinaryReader::getNumBytes() const {
+      return _numBytes;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void BinaryWriter::writeBytes(const void* data, size_t size) {
+      _stream.write(static_cast<const char*>(data), size);
+      if (!_stream)
+        throw InvalidOperationException("BinaryWriter::writeBytes(): "
+          "unable to write to the stream", __FILE__, __LINE__);
+      _numBytes += size;
+    }
+
+    void BinaryWriter::write(const Eigen::MatrixXd& matrix) {
+      write<int64_t>(matrix.rows());
+      write<int64_t>(matrix.cols());
+      writeBytes(matrix.data(), matrix.size() * sizeof(double));
+    }
+
+    void BinaryWriter::write(const Eigen::VectorXd& vector) {
+      write<int64_t>(vector.rows());
+      write<int64_t>(1);
+      writeBytes(vector.data(), vector.size() * sizeof(double));
+    }
+
+    void BinaryReader::readBytes(void* data, size_t size) {
+      _stream.read(static_cast<char*>(data), size);
+      if (static_cast<size_t>(_stream.gcount()) != size)
+        throw InvalidOperationException("BinaryReader::readBytes(): "
+          "unexpected end of stream", __FILE__, __LINE__);
+      _numBytes += size;
+    }
+
+    void BinaryReader::readDimensions(std::ptrdiff_t& rows,
+        std::ptrdiff_t& cols) {
+      const int64_t numRows = read<int64_t>();
+      const int64_t numCols = read<int64_t>();
+      if (numRows < 0 || numCols < 0 || (numCols > 0 && numRows >
+          std::numeric_limits<std::ptrdiff_t>::max() /
+          static_cast<std::ptrdiff_t>(sizeof(double)) / numCols))
+        throw InvalidOperationException("BinaryReader::readDimensions(): "
+          "corrupted matrix dimensions", __FILE__, __LINE__);
+      rows = numRows;
+      cols = numCols;
+    }
+
+    void BinaryReader::read(Eigen::MatrixXd& matrix) {
+      std::ptrdiff_t rows, cols;
+      readDimensions(rows, cols);
+      matrix.resize(rows, cols);
+      readBytes(matrix.data(), matrix.size() * sizeof(double));
+    }
+
+    void BinaryReader::read(Eigen::VectorXd& vector) {
+      std::ptrdiff_t rows, cols;
+      readDimensions(rows, cols);
+      if (cols != 1)
+        throw InvalidOperationException("BinaryReader::read(): "
+          "expected a vector", __FILE__, __LINE__);
+      vector.resize(rows);
+      readBytes(vector.data(), vector.size() * sizeof(double));
+    }
+
+  }
+}
@@ -0,0 +1,213 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/base/ColumnarWriter.h"
+
+#include <cstring>
+
+#include <ostream>
+
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+    const uint64_t ColumnarWriter::magic = 0x534c4f434d4c5341;
+    const uint64_t ColumnarWriter::version = 1;
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    ColumnarWriter::ColumnarWriter(std::ostream& stream, size_t chunkSize) :
+        _writer(stream),
+        _chunkSize(chunkSize),
+        _numChunkRows(0),
+        _numRows(0),
+        _headerWritten(false) {
+      if (chunkSize == 0)
+        throw OutOfBoundException<size_t>(chunkSize, 1,
+          "ColumnarWriter::ColumnarWriter(): chunk size must be positive",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    ColumnarWriter::~ColumnarWriter() {
+      try {
+        flush();
+      }
+      catch (...) {
+      }
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    size_t ColumnarWriter::getNumColumns() const {
+      return _types.size();
+    }
+
+    const std::string& ColumnarWriter::getColumnName(size_t idx) const {
+      if (idx >= _names.size())
+        throw OutOfBoundException<size_t>(idx, _names.size(),
+          "ColumnarWriter::getColumnName(): index out of bound",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return _names[idx];
+    }
+
+    ColumnarWriter::ColumnType ColumnarWriter::getColumnType(size_t idx)
+        const {
+      if (idx >= _types.size())
+        throw OutOfBoundException<size_t>(idx, _types.size(),
+          "ColumnarWriter::getColumnType(): index out of bound",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return _types[idx];
+    }
+
+    size_t ColumnarWriter::getNumRows() const {
+      return _numRows;
+    }
+
+    size_t ColumnarWriter::getChunkSize() const {
+      return _chunkSize;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void ColumnarWriter::addColumn(const std::string& name, ColumnType type) {
+      if (_headerWritten || _numRows > 0 || !_row.empty())
+        throw InvalidOperationException("ColumnarWriter::addColumn(): "
+          "columns must be declared before the first row", __FILE__,
+          __LINE__);
+      _names.push_back(name);
+      _types.push_back(type);
+    }
+
+    void ColumnarWriter::setColumnNames(const std::vector<std::string>&
+        names) {
+      if (_headerWritten || _numRows > 0 || !_row.empty())
+        throw InvalidOperationException("ColumnarWriter::setColumnNames(): "
+          "columns must be named before the first row", __FILE__, __LINE__);
+      if (!_types.empty() && names.size() != _types.size())
+        throw OutOfBoundException<size_t>(names.size(), _types.size(),
+          "ColumnarWriter::setColumnNames(): wrong number of names",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      _names = names;
+    }
+
+    void ColumnarWriter::write(double value) {
+      uint64_t word;
+      std::memcpy(&word, &value, sizeof(word));
+      writeCell(word, FLOAT64);
+    }
+
+    void ColumnarWriter::write(int64_t value) {
+      writeCell(static_cast<uint64_t>(value), INT64);
+    }
+
+    void ColumnarWriter::writeCell(uint64_t word, ColumnType type) {
+      if (!_types.empty() && _row.size() == _types.size())
+        throw OutOfBoundException<size_t>(_row.size(), _types.size(),
+          "ColumnarWriter::writeCell(): too many values in the row",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      _row.push_back(word);
+      _rowTypes.push_back(type);
+    }
+
+    void ColumnarWriter::endRow() {
+      if (_types.empty() && !_headerWritten) {
+        if (_names.size() > _rowTypes.size())
+          throw OutOfBoundException<size_t>(_rowTypes.size(), _names.size(),
+            "ColumnarWriter::endRow(): fewer values than column names",
+            __FILE__, __LINE__, __PRETTY_FUNCTION__);
+        _types = _rowTypes;
+        for (size_t i = _names.size(); i < _types.size(); ++i)
+          _names.push_back("c" + std::to_string(i));
+      }
+      if (_row.size() != _types.size())
+        throw OutOfBoundException<size_t>(_row.size(), _types.size(),
+          "ColumnarWriter::endRow(): wrong number of values in the row",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if (_chunk.size() != _types.size())
+        _chunk.resize(_types.size());
+      for (size_t i = 0; i < _row.size(); ++i) {
+        uint64_t word = _row[i];
+        if (_rowTypes[i] != _types[i]) {
+          if (_types[i] == INT64) {
+            double value;
+            std::memcpy(&value, &word, sizeof(value));
+            word = static_cast<uint64_t>(static_cast<int64_t>(value));
+          }
+          else {
+            const double value = static_cast<int64_t>(word);
+            std::memcpy(&word, &value, sizeof(word));
+          }
+        }
+        _chunk[i].push_back(word);
+      }
+      _row.clear();
+      _rowTypes.clear();
+      _numChunkRows++;
+      _numRows++;
+      if (_numChunkRows == _chunkSize) {
+        if (!_headerWritten)
+          writeHeader();
+        writeChunk();
+      }
+    }
+
+    void ColumnarWriter::flush() {
+      if (!_headerWritten)
+        writeHeader();
+      if (_numChunkRows > 0)
+        writeChunk();
+    }
+
+    void ColumnarWriter::writeHeader() {
+      _writer.write(magic);
+      _writer.write(version);
+      _writer.write<uint64_t>(_types.size());
+      for (size_t i = 0; i < _types.size(); ++i) {
+        _writer.write<uint64_t>(_types[i]);
+        _writer.write<uint64_t>(_names[i].size());
+        std::vector<uint64_t> name((_names[i].size() + 7) / 8, 0);
+        if (!name.empty())
+          std::memcpy(name.data(), _names[i].data(), _names[i].size());
+        _writer.write(name.data(), name.size());
+      }
+      _headerWritten = true;
+    }
+
+    void ColumnarWriter::writeChunk() {
+      _writer.write<uint64_t>(_numChunkRows);
+      for (auto it = _chunk.begin(); it != _chunk.end(); ++it) {
+        _writer.write(it->data(), it->size());
+        it->clear();
+      }
+      _numChunkRows = 0;
+    }
+
+  }
+}
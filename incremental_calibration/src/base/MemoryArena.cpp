@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/base/MemoryArena.h"
+
+#include <cstdint>
+
+#include <algorithm>
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    MemoryArena::MemoryArena(size_t chunkSize) :
+        _chunkSize(chunkSize),
+        _lastChunkSize(0),
+        _offset(0),
+        _numAllocations(0),
+        _numLiveAllocations(0),
+        _numBytesUsed(0),
+        _numBytesReserved(0) {
+    }
+
+    MemoryArena::~MemoryArena() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    size_t MemoryArena::getChunkSize() const {
+      return _chunkSize;
+    }
+
+    size_t MemoryArena::getNumChunks() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _chunks.size();
+    }
+
+    size_t MemoryArena::getNumAllocations() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _numAllocations;
+    }
+
+    size_t MemoryArena::getNumLiveAllocations() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _numLiveAllocations;
+    }
+
+    size_t MemoryArena::getNumBytesUsed() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _numBytesUsed;
+    }
+
+    size_t MemoryArena::getNumBytesReserved() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _numBytesReserved;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void MemoryArena::addChunk(size_t size) {
+      // chunks grow geometrically to keep their number logarithmic
+      const size_t chunkSize = std::max(size, std::max(_chunkSize,
+        2 * _lastChunkSize));
+      _chunks.emplace_back(new char[chunkSize]);
+      _lastChunkSize = chunkSize;
+      _offset = 0;
+      _numBytesReserved += chunkSize;
+    }
+
+    void* MemoryArena::allocate(size_t size, size_t alignment) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      size_t padding = 0;
+      if (!_chunks.empty()) {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(
+          _chunks.back().get()) + _offset;
+        padding = (alignment - address % alignment) % alignment;
+      }
+      if (_chunks.empty() || _offset + padding + size > _lastChunkSize) {
+        addChunk(size + alignment);
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(
+          _chunks.back().get());
+        padding = (alignment - address % alignment) % alignment;
+      }
+      void* pointer = _chunks.back().get() + _offset + padding;
+      _offset += padding + size;
+      _numBytesUsed += size;
+      ++_numAllocations;
+      ++_numLiveAllocations;
+      return pointer;
+    }
+
+    void MemoryArena::deallocate(void* /*pointer*/, size_t /*size*/) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_numLiveAllocations;
+    }
+
+    void MemoryArena::reserve(size_t size) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_chunks.empty() || _offset + size > _lastChunkSize)
+        addChunk(size);
+    }
+
+  }
+}
@@ -18,25 +18,51 @@
 
 #include "aslam/calibration/core/IncrementalEstimator.h"
 
+#include <cmath>
+
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <ostream>
 
 #include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
 #include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
 #include <aslam/backend/Optimizer2.hpp>
 #include <boost/make_shared.hpp>
+#include <Eigen/QR>
 #include <sm/PropertyTree.hpp>
 
 
 #include "aslam/calibration/core/IncrementalOptimizationProblem.h"
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/error-terms/ErrorTermPrior.h"
+#include "aslam/calibration/base/BinaryStream.h"
 #include "aslam/calibration/base/Timestamp.h"
+#include "aslam/calibration/exceptions/BadArgumentException.h"
 #include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
 
 namespace aslam {
   namespace calibration {
 
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+    const uint64_t IncrementalEstimator::_checkpointMagic = 0x54504b434d4c5341;
+    const uint64_t IncrementalEstimator::_checkpointVersion = 2;
+
 /******************************************************************************/
 /* Constructors and Destructor                                                */
 /******************************************************************************/
@@ -50,6 +76,7 @@ namespace aslam {
         _problem(boost::make_shared<IncrementalOptimizationProblem>()),
         _informationGain(0.0),
         _svLog2Sum(0.0),
+        _marginal(boost::make_shared<const MarginalResults>()),
         _svdTolerance(0.0),
         _qrTolerance(-1.0),
         _rankTheta(-1),
@@ -60,7 +87,9 @@ namespace aslam {
         _memoryUsage(0),
         _numFlops(0.0),
         _initialCost(0.0),
-        _finalCost(0.0) {
+        _finalCost(0.0),
+        _marginalAnalyzerValid(false),
+        _numEvictedBatches(0) {
       // create linear solver and trust region policy for the optimizer
       OptimizerOptions& optOptions = _optimizer->options();
       optOptions.linearSystemSolver =
@@ -76,6 +105,7 @@ namespace aslam {
     IncrementalEstimator::IncrementalEstimator(const sm::PropertyTree& config) :
         _informationGain(0.0),
         _svLog2Sum(0.0),
+        _marginal(boost::make_shared<const MarginalResults>()),
         _svdTolerance(0.0),
         _qrTolerance(-1.0),
         _rankTheta(-1),
@@ -86,7 +116,9 @@ namespace aslam {
         _memoryUsage(0),
         _numFlops(0.0),
         _initialCost(0.0),
-        _finalCost(0.0) {
+        _finalCost(0.0),
+        _marginalAnalyzerValid(false),
+        _numEvictedBatches(0) {
       // create the optimizer, linear solver, and trust region policy
       boost::shared_ptr<LinearSolver> linearSolver = boost::make_shared<LinearSolver>(sm::PropertyTree(config, "optimizer/linearSolver"));
       _optimizer = boost::make_shared<Optimizer>(sm::PropertyTree(config, "optimizer"), linearSolver, boost::make_shared<TrustRegionPolicy>());
@@ -100,6 +132,23 @@ namespace aslam {
         _options.infoGainDelta);
       _options.checkValidity = config.getBool("checkValidity",
         _options.checkValidity);
+      _options.incrementalMarginal = config.getBool("incrementalMarginal",
+        _options.incrementalMarginal);
+      _options.marginalRelinearizationThreshold = config.getDouble(
+        "marginalRelinearizationThreshold",
+        _options.marginalRelinearizationThreshold);
+      _options.preScreening = config.getBool("preScreening",
+        _options.preScreening);
+      _options.preScreeningInfoGainDelta = config.getDouble(
+        "preScreeningInfoGainDelta", _options.preScreeningInfoGainDelta);
+      _options.maxNumBatches = config.getInt("maxNumBatches",
+        _options.maxNumBatches);
+      _options.maxNumErrorTerms = config.getInt("maxNumErrorTerms",
+        _options.maxNumErrorTerms);
+      _options.evictLowestInformation = config.getBool(
+        "evictLowestInformation", _options.evictLowestInformation);
+      _options.scoringThreads = config.getInt("scoringThreads",
+        _options.scoringThreads);
       _options.verbose = config.getBool("verbose", _options.verbose);
       _margGroupId = config.getInt("groupId");
     }
@@ -156,6 +205,11 @@ namespace aslam {
       return _optimizer->getSolver<LinearSolver>()->getJacobianTranspose();
     }
 
+    boost::shared_ptr<LinearSolver> IncrementalEstimator::getLinearSolver()
+        const {
+      return _optimizer->getSolver<LinearSolver>();
+    }
+
     std::ptrdiff_t IncrementalEstimator::getRankPsi() const {
       return _rankPsi;
     }
@@ -192,44 +246,62 @@ namespace aslam {
       return _numFlops;
     }
 
+    size_t IncrementalEstimator::getNumSymbolicFactorizations() const {
+      return _optimizer->getSolver<LinearSolver>()->
+        getNumSymbolicFactorizations();
+    }
+
     const Eigen::MatrixXd& IncrementalEstimator::getNobsBasis(bool scaled)
         const {
       if (scaled)
-        return _nobsBasisScaled;
+        return _marginal->nobsBasisScaled;
       else
-        return _nobsBasis;
+        return _marginal->nobsBasis;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getObsBasis(bool scaled)
         const {
       if (scaled)
-        return _obsBasisScaled;
+        return _marginal->obsBasisScaled;
       else
-        return _obsBasis;
+        return _marginal->obsBasis;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getSigma2Theta(bool scaled)
         const {
       if (scaled)
-        return _sigma2ThetaScaled;
+        return _marginal->sigma2ThetaScaled;
       else
-        return _sigma2Theta;
+        return _marginal->sigma2Theta;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getSigma2ThetaObs(bool scaled)
         const {
       if (scaled)
-        return _sigma2ThetaObsScaled;
+        return _marginal->sigma2ThetaObsScaled;
       else
-        return _sigma2ThetaObs;
+        return _marginal->sigma2ThetaObs;
     }
 
     const Eigen::VectorXd& IncrementalEstimator::getSingularValues(bool scaled)
         const {
       if (scaled)
-        return _singularValuesScaled;
+        return _marginal->singularValuesScaled;
       else
-        return _singularValues;
+        return _marginal->singularValues;
+    }
+
+    IncrementalEstimator::MarginalResultsCSP
+        IncrementalEstimator::getMarginalResults() const {
+      return _marginal;
+    }
+
+    IncrementalEstimator::BatchSP IncrementalEstimator::getPriorBatch() const {
+      return _priorBatch;
+    }
+
+    size_t IncrementalEstimator::getNumEvictedBatches() const {
+      return _numEvictedBatches;
     }
 
     double IncrementalEstimator::getInitialCost() const {
@@ -247,6 +319,12 @@ namespace aslam {
     IncrementalEstimator::ReturnValue IncrementalEstimator::reoptimize() {
       // query the time
       const double timeStart = Timestamp::now();
+      ReturnValue ret;
+      ret.preScreeningTime = 0.0;
+      ret.insertionTime = 0.0;
+      ret.rollbackTime = 0.0;
+      ret.evictionTime = 0.0;
+      ret.numEvictedBatches = 0;
 
       // ensure marginalized design variables are well located
       orderMarginalizedDesignVariables();
@@ -259,37 +337,28 @@ namespace aslam {
       const size_t dim = _problem->getGroupDim(_margGroupId);
       auto linearSolver = _optimizer->getSolver<LinearSolver>();
       linearSolver->setMargStartIndex(static_cast<std::ptrdiff_t>(JCols - dim));
+      double timeStage = Timestamp::now();
+      ret.orderingTime = timeStage - timeStart;
 
       // optimize
+      linearSolver->resetTimings();
       aslam::backend::SolutionReturnValue srv = _optimizer->optimize();
+      setOptimizerStatistics(ret, Timestamp::now() - timeStage);
 
       // grep the scaled linear system informations
-      if (linearSolver->getOptions().columnScaling) {
-        _singularValuesScaled = linearSolver->getSingularValues();
-        _nobsBasisScaled = linearSolver->getNullSpace();
-        _obsBasisScaled = linearSolver->getRowSpace();
-        _sigma2ThetaScaled = linearSolver->getCovariance();
-        _sigma2ThetaObsScaled = linearSolver->getRowSpaceCovariance();
-      }
-      else {
-        _singularValuesScaled.resize(0);
-        _nobsBasisScaled.resize(0, 0);
-        _obsBasisScaled.resize(0, 0);
-        _sigma2ThetaScaled.resize(0, 0);
-        _sigma2ThetaObsScaled.resize(0, 0);
-      }
+      auto marginal = boost::make_shared<MarginalResults>();
+      if (linearSolver->getOptions().columnScaling)
+        fillScaledMarginalResults(*marginal);
 
       // analyze the unscaled marginal system
+      timeStage = Timestamp::now();
       linearSolver->analyzeMarginal();
 
       // retrieve informations from the linear solver
       _informationGain = 0.0;
       _svLog2Sum = linearSolver->getSingularValuesLog2Sum();
-      _nobsBasis = linearSolver->getNullSpace();
-      _obsBasis = linearSolver->getRowSpace();
-      _sigma2Theta = linearSolver->getCovariance();
-      _sigma2ThetaObs = linearSolver->getRowSpaceCovariance();
-      _singularValues = linearSolver->getSingularValues();
+      fillMarginalResults(*linearSolver, *marginal);
+      _marginal = marginal;
       _svdTolerance = linearSolver->getSVDTolerance();
       _qrTolerance = linearSolver->getQRTolerance();
       _rankTheta = linearSolver->getSVDRank();
@@ -302,9 +371,14 @@ namespace aslam {
       _initialCost = srv.JStart;
       _finalCost = srv.JFinal;
 
+      // relinearize the marginal R factor at the new estimate
+      if (_options.incrementalMarginal || _options.preScreening)
+        resetMarginalAnalyzer();
+      ret.marginalAnalysisTime = Timestamp::now() - timeStage;
+
       // update output structure
-      ReturnValue ret;
       ret.batchAccepted = true;
+      ret.preScreened = false;
       ret.informationGain = 0.0;
       ret.rankPsi = _rankPsi;
       ret.rankPsiDeficiency = _rankPsiDeficiency;
@@ -312,16 +386,7 @@ namespace aslam {
       ret.rankThetaDeficiency = _rankThetaDeficiency;
       ret.svdTolerance = _svdTolerance;
       ret.qrTolerance = _qrTolerance;
-      ret.nobsBasis = _nobsBasis;
-      ret.nobsBasisScaled = _nobsBasisScaled;
-      ret.obsBasis = _obsBasis;
-      ret.obsBasisScaled = _obsBasisScaled;
-      ret.sigma2Theta = _sigma2Theta;
-      ret.sigma2ThetaScaled = _sigma2ThetaScaled;
-      ret.sigma2ThetaObs = _sigma2ThetaObs;
-      ret.sigma2ThetaObsScaled = _sigma2ThetaObsScaled;
-      ret.singularValues = _singularValues;
-      ret.singularValuesScaled = _singularValuesScaled;
+      ret.marginal = _marginal;
       ret.numIterations = srv.iterations;
       ret.JStart = _initialCost;
       ret.JFinal = _finalCost;
@@ -333,16 +398,52 @@ namespace aslam {
         IncrementalEstimator::addBatch(const BatchSP& problem, bool force) {
       // query the time
       const double timeStart = Timestamp::now();
+      ReturnValue ret;
+      ret.preScreened = false;
+      ret.preScreeningTime = 0.0;
+      ret.rollbackTime = 0.0;
+      ret.evictionTime = 0.0;
+      ret.numEvictedBatches = 0;
+
+      // reject batches without information before optimizing
+      if (_options.preScreening && !force) {
+        const bool preScreened = preScreenBatch(*problem, ret);
+        ret.preScreeningTime = Timestamp::now() - timeStart;
+        if (preScreened) {
+          fillSkippedReturnValue(ret);
+          ret.preScreened = true;
+          ret.elapsedTime = Timestamp::now() - timeStart;
+          return ret;
+        }
+      }
+
+      // remember the groups sizes to only reindex the moved design variables
+      std::vector<std::pair<size_t, size_t> > groupsSizes;
+      if (!force) {
+        const auto& groupsOrdering = _problem->getGroupsOrdering();
+        groupsSizes.reserve(groupsOrdering.size());
+        for (auto it = groupsOrdering.cbegin(); it != groupsOrdering.cend();
+            ++it)
+          groupsSizes.push_back(std::make_pair(*it,
+            _problem->getDesignVariablesGroup(*it).size()));
+      }
 
       // insert new batch in the problem
+      double timeStage = Timestamp::now();
       _problem->add(problem);
+      ret.insertionTime = Timestamp::now() - timeStage;
 
       // ensure marginalized design variables are well located
+      timeStage = Timestamp::now();
       orderMarginalizedDesignVariables();
 
-      // save design variables in case the batch is rejected
-      if (!force)
+      // save design variables and Jacobian in case the batch is rejected
+      size_t numUnchangedDVs = 0;
+      if (!force) {
+        numUnchangedDVs = getNumUnchangedDesignVariables(groupsSizes);
         _problem->saveDesignVariables();
+        _optimizer->getSolver<LinearSolver>()->saveJacobianState();
+      }
 
       // set the marginalization index of the linear solver
       size_t JCols = 0;
@@ -352,12 +453,13 @@ namespace aslam {
       const size_t dim = _problem->getGroupDim(_margGroupId);
       auto linearSolver = _optimizer->getSolver<LinearSolver>();
       linearSolver->setMargStartIndex(static_cast<std::ptrdiff_t>(JCols - dim));
+      ret.orderingTime = Timestamp::now() - timeStage;
 
       // optimize
+      timeStage = Timestamp::now();
+      linearSolver->resetTimings();
       aslam::backend::SolutionReturnValue srv = _optimizer->optimize();
-
-      // return value
-      ReturnValue ret;
+      setOptimizerStatistics(ret, Timestamp::now() - timeStage);
 
       // fill statistics from optimizer
       ret.numIterations = srv.iterations;
@@ -365,36 +467,42 @@ namespace aslam {
       ret.JFinal = srv.JFinal;
 
       // grep the scaled singular values if scaling enabled
-      if (linearSolver->getOptions().columnScaling) {
-        ret.singularValuesScaled = linearSolver->getSingularValues();
-        ret.nobsBasisScaled = linearSolver->getNullSpace();
-        ret.obsBasisScaled = linearSolver->getRowSpace();
-        ret.sigma2ThetaScaled = linearSolver->getCovariance();
-        ret.sigma2ThetaObsScaled = linearSolver->getRowSpaceCovariance();
+      auto marginal = boost::make_shared<MarginalResults>();
+      if (linearSolver->getOptions().columnScaling)
+        fillScaledMarginalResults(*marginal);
+
+      // analyze marginal system (unscaled system), incrementally if possible
+      timeStage = Timestamp::now();
+      IncrementalMarginalAnalyzer marginalAnalyzer;
+      bool relinearized = false;
+      const bool incremental = _options.incrementalMarginal &&
+        analyzeMarginalIncrementally(*problem, marginalAnalyzer, relinearized);
+      double svLog2Sum;
+      if (incremental) {
+        ret.rankPsi = marginalAnalyzer.getQRRank();
+        ret.rankPsiDeficiency = marginalAnalyzer.getQRRankDeficiency();
+        ret.rankTheta = marginalAnalyzer.getSVDRank();
+        ret.rankThetaDeficiency = marginalAnalyzer.getSVDRankDeficiency();
+        ret.svdTolerance = marginalAnalyzer.getSVDTolerance();
+        ret.qrTolerance = marginalAnalyzer.getQRTolerance();
+        fillMarginalResults(marginalAnalyzer, *marginal);
+        svLog2Sum = marginalAnalyzer.getSingularValuesLog2Sum();
       }
       else {
-        ret.singularValuesScaled.resize(0);
-        ret.nobsBasisScaled.resize(0, 0);
-        ret.obsBasisScaled.resize(0, 0);
-        ret.sigma2ThetaScaled.resize(0, 0);
-        ret.sigma2ThetaObsScaled.resize(0, 0);
+        linearSolver->analyzeMarginal();
+
+        // fill statistics from the linear solver
+        ret.rankPsi = linearSolver->getQRRank();
+        ret.rankPsiDeficiency = linearSolver->getQRRankDeficiency();
+        ret.rankTheta = linearSolver->getSVDRank();
+        ret.rankThetaDeficiency = linearSolver->getSVDRankDeficiency();
+        ret.svdTolerance = linearSolver->getSVDTolerance();
+        ret.qrTolerance = linearSolver->getQRTolerance();
+        fillMarginalResults(*linearSolver, *marginal);
+        svLog2Sum = linearSolver->getSingularValuesLog2Sum();
       }
-
-      // analyze marginal system (unscaled system)
-      linearSolver->analyzeMarginal();
-
-      // fill statistics from the linear solver
-      ret.rankPsi = linearSolver->getQRRank();
-      ret.rankPsiDeficiency = linearSolver->getQRRankDeficiency();
-      ret.rankTheta = linearSolver->getSVDRank();
-      ret.rankThetaDeficiency = linearSolver->getSVDRankDeficiency();
-      ret.svdTolerance = linearSolver->getSVDTolerance();
-      ret.qrTolerance = linearSolver->getQRTolerance();
-      ret.nobsBasis = linearSolver->getNullSpace();
-      ret.obsBasis = linearSolver->getRowSpace();
-      ret.sigma2Theta = linearSolver->getCovariance();
-      ret.sigma2ThetaObs = linearSolver->getRowSpaceCovariance();
-      ret.singularValues = linearSolver->getSingularValues();
+      ret.marginal = marginal;
+      ret.marginalAnalysisTime = Timestamp::now() - timeStage;
 
       // check if the solution is valid
       bool solutionValid = true;
@@ -403,7 +511,6 @@ namespace aslam {
         solutionValid = false;
 
       // compute the information gain
-      const double svLog2Sum = linearSolver->getSingularValuesLog2Sum();
       ret.informationGain = 0.5 * (svLog2Sum - _svLog2Sum);
 
       // batch is kept? information gain improvement or rank goes up or force
@@ -420,16 +527,7 @@ namespace aslam {
         // update internal variables
         _informationGain = ret.informationGain;
         _svLog2Sum = svLog2Sum;
-        _nobsBasis = ret.nobsBasis;
-        _nobsBasisScaled = ret.nobsBasisScaled;
-        _obsBasis = ret.obsBasis;
-        _obsBasisScaled = ret.obsBasisScaled;
-        _sigma2Theta = ret.sigma2Theta;
-        _sigma2ThetaScaled = ret.sigma2ThetaScaled;
-        _sigma2ThetaObs = ret.sigma2ThetaObs;
-        _sigma2ThetaObsScaled = ret.sigma2ThetaObsScaled;
-        _singularValues = ret.singularValues;
-        _singularValuesScaled = ret.singularValuesScaled;
+        _marginal = ret.marginal;
         _svdTolerance = ret.svdTolerance;
         _qrTolerance = ret.qrTolerance;
         _rankTheta = ret.rankTheta;
@@ -441,11 +539,28 @@ namespace aslam {
         _numFlops = linearSolver->getNumFlops();
         _initialCost = srv.JStart;
         _finalCost = srv.JFinal;
+
+        // update the marginal R factor
+        if (incremental) {
+          _marginalAnalyzer = std::move(marginalAnalyzer);
+          if (relinearized)
+            _marginalLinearizationPoint = getMargParameters();
+        }
+        else if (_options.incrementalMarginal || _options.preScreening)
+          resetMarginalAnalyzer();
+
+        // enforce the retention limits
+        _batchInformation[problem.get()] = ret.informationGain;
+        timeStage = Timestamp::now();
+        ret.numEvictedBatches = evictBatches(problem);
+        ret.evictionTime = Timestamp::now() - timeStage;
       }
       ret.batchAccepted = keepBatch;
 
       // remove batch if necessary
       if (!keepBatch) {
+        timeStage = Timestamp::now();
+
         // restore variables
         _problem->restoreDesignVariables();
 
@@ -454,7 +569,8 @@ namespace aslam {
 
         // restore the linear solver
         if (_problem->getNumOptimizationProblems() > 0)
-          restoreLinearSolver();
+          restoreLinearSolver(true, numUnchangedDVs);
+        ret.rollbackTime = Timestamp::now() - timeStage;
       }
 
       // insert elapsed time
@@ -464,8 +580,139 @@ namespace aslam {
       return ret;
     }
 
+    std::vector<IncrementalEstimator::ReturnValue>
+        IncrementalEstimator::scoreBatches(const std::vector<BatchSP>& batches)
+        const {
+      std::vector<ReturnValue> rets(batches.size());
+      for (auto it = rets.begin(); it != rets.end(); ++it) {
+        fillSkippedReturnValue(*it);
+        it->informationGain = 0.0;
+        it->rankPsi = -1;
+        it->rankPsiDeficiency = -1;
+        it->rankTheta = -1;
+        it->rankThetaDeficiency = -1;
+        it->svdTolerance = 0.0;
+        it->qrTolerance = -1.0;
+        it->preScreeningTime = 0.0;
+        it->elapsedTime = 0.0;
+      }
+      if (batches.empty() || !_problem->isGroupInProblem(_margGroupId))
+        return rets;
+
+      // marginal R factor of the accepted batches at the current estimate
+      IncrementalMarginalAnalyzer marginalAnalyzer;
+      const IncrementalMarginalAnalyzer* currentAnalyzer = &_marginalAnalyzer;
+      if (!_marginalAnalyzerValid || _marginalAnalyzer.getDim() !=
+          _problem->getGroupDim(_margGroupId) || isMarginalAnalyzerStale()) {
+        if (!buildMarginalAnalyzer(marginalAnalyzer))
+          return rets;
+        currentAnalyzer = &marginalAnalyzer;
+      }
+
+      // candidates sharing nuisance variables cannot be scored in isolation
+      std::vector<bool> isolated(batches.size(), true);
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t> owners;
+      for (size_t i = 0; i < batches.size(); ++i)
+        for (size_t j = 0; j < batches[i]->numDesignVariables(); ++j) {
+          const aslam::backend::DesignVariable* dv =
+            batches[i]->designVariable(j);
+          if (batches[i]->getGroupId(dv) == _margGroupId)
+            continue;
+          auto owner = owners.insert(std::make_pair(dv, i));
+          if (!owner.second && owner.first->second != i) {
+            isolated[i] = false;
+            isolated[owner.first->second] = false;
+          }
+        }
+
+      // candidates only read theta, each one is linearized by a single thread
+      std::atomic<size_t> next(0);
+      auto score = [&]() {
+        for (size_t i = next++; i < batches.size(); i = next++) {
+          if (!isolated[i])
+            continue;
+          const double timeStart = Timestamp::now();
+          scoreBatch(*batches[i], *currentAnalyzer, rets[i]);
+          rets[i].preScreeningTime = Timestamp::now() - timeStart;
+          rets[i].elapsedTime = rets[i].preScreeningTime;
+        }
+      };
+      const size_t numThreads = std::min<size_t>(_options.scoringThreads > 0 ?
+        _options.scoringThreads : std::max(std::thread::hardware_concurrency(),
+        1u), batches.size());
+      if (numThreads <= 1) {
+        score();
+        return rets;
+      }
+      std::vector<std::exception_ptr> exceptions(numThreads);
+      std::vector<std::thread> threads;
+      threads.reserve(numThreads);
+      for (size_t t = 0; t < numThreads; ++t)
+        threads.emplace_back([&, t]() {
+          try {
+            score();
+          }
+          catch (...) {
+            exceptions[t] = std::current_exception();
+          }
+        });
+      for (auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+      for (auto it = exceptions.cbegin(); it != exceptions.cend(); ++it)
+        if (*it)
+          std::rethrow_exception(*it);
+      return rets;
+    }
+
+    std::vector<IncrementalEstimator::ReturnValue>
+        IncrementalEstimator::addBatches(const std::vector<BatchSP>& batches,
+        bool force) {
+      const std::vector<ReturnValue> scores = scoreBatches(batches);
+
+      // batches that cannot be scored first, then by decreasing information
+      std::vector<size_t> order(batches.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(),
+        [&scores](size_t lhs, size_t rhs) {
+          if (!scores[lhs].marginal || !scores[rhs].marginal)
+            return !scores[lhs].marginal && scores[rhs].marginal;
+          return scores[lhs].informationGain > scores[rhs].informationGain;
+        });
+
+      // commit in that order, a candidate is scored again against the
+      // accepted ones before being screened out
+      std::vector<ReturnValue> rets(batches.size());
+      bool accepted = false;
+      for (auto it = order.cbegin(); it != order.cend(); ++it) {
+        ReturnValue score = scores[*it];
+        if (_options.preScreening && !force && score.marginal && accepted) {
+          const double preScreeningTime = score.preScreeningTime;
+          score = scoreBatches(std::vector<BatchSP>(1, batches[*it])).front();
+          score.preScreeningTime += preScreeningTime;
+          score.elapsedTime += preScreeningTime;
+        }
+        if (_options.preScreening && !force && score.marginal &&
+            score.informationGain <= _options.preScreeningInfoGainDelta &&
+            score.rankTheta <= _rankTheta) {
+          rets[*it] = score;
+          fillSkippedReturnValue(rets[*it]);
+          rets[*it].preScreened = true;
+          continue;
+        }
+        rets[*it] = addBatch(batches[*it], force);
+        accepted |= rets[*it].batchAccepted;
+        rets[*it].preScreeningTime += score.preScreeningTime;
+        rets[*it].elapsedTime += score.preScreeningTime;
+      }
+      return rets;
+    }
+
     void IncrementalEstimator::removeBatch(size_t idx) {
       // remove the batch
+      const BatchSP batch = _problem->getOptimizationProblems().at(idx);
+      _batchInformation.erase(batch.get());
+      if (batch == _priorBatch)
+        _priorBatch.reset();
       _problem->remove(idx);
 
       // reoptimize
@@ -478,6 +725,182 @@ namespace aslam {
         removeBatch(std::distance(_problem->getOptimizationProblemBegin(), it));
     }
 
+    void IncrementalEstimator::writeCheckpoint(std::ostream& stream) const {
+      if (!_problem->isGroupInProblem(_margGroupId))
+        throw InvalidOperationException(
+          "IncrementalEstimator::writeCheckpoint(): "
+          "marginalized group ID should appear in the problem", __FILE__,
+          __LINE__);
+
+      // the batches are summarized into their exact prior on theta
+      Eigen::MatrixXd R;
+      Eigen::VectorXd r;
+      if (!summarizeBatches(_problem->getOptimizationProblems(), R, r))
+        throw InvalidOperationException(
+          "IncrementalEstimator::writeCheckpoint(): "
+          "batches sharing nuisance variables cannot be summarized", __FILE__,
+          __LINE__);
+      const size_t numSummarized = _numEvictedBatches + getNumBatches() -
+        (_priorBatch ? 1 : 0);
+
+      BinaryWriter writer(stream);
+      writer.write(_checkpointMagic);
+      writer.write(_checkpointVersion);
+      writer.write<uint64_t>(_margGroupId);
+
+      // design variables of theta, i.e., the linearization point of the prior
+      const auto& margDVs = _problem->getDesignVariablesGroup(_margGroupId);
+      writer.write<uint64_t>(margDVs.size());
+      Eigen::MatrixXd parameters;
+      for (auto it = margDVs.cbegin(); it != margDVs.cend(); ++it) {
+        writer.write<uint64_t>((*it)->isActive());
+        writer.write<uint64_t>((*it)->minimalDimensions());
+        (*it)->getParameters(parameters);
+        writer.write(parameters);
+      }
+      writer.write(R);
+      writer.write(r);
+      writer.write<uint64_t>(numSummarized);
+
+      // estimator state
+      writer.write(_informationGain);
+      writer.write(_svLog2Sum);
+      writer.write(_svdTolerance);
+      writer.write(_qrTolerance);
+      writer.write<int64_t>(_rankTheta);
+      writer.write<int64_t>(_rankThetaDeficiency);
+      writer.write<int64_t>(_rankPsi);
+      writer.write<int64_t>(_rankPsiDeficiency);
+      writer.write(_initialCost);
+      writer.write(_finalCost);
+
+      // marginal analysis snapshot
+      writer.write(_marginal->nobsBasis);
+      writer.write(_marginal->nobsBasisScaled);
+      writer.write(_marginal->obsBasis);
+      writer.write(_marginal->obsBasisScaled);
+      writer.write(_marginal->sigma2Theta);
+      writer.write(_marginal->sigma2ThetaScaled);
+      writer.write(_marginal->sigma2ThetaObs);
+      writer.write(_marginal->sigma2ThetaObsScaled);
+      writer.write(_marginal->singularValues);
+      writer.write(_marginal->singularValuesScaled);
+    }
+
+    void IncrementalEstimator::saveCheckpoint(const std::string& filename)
+        const {
+      std::ofstream file(filename, std::ios::out | std::ios::binary);
+      if (!file.is_open())
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::saveCheckpoint(): unable to open file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      writeCheckpoint(file);
+    }
+
+    void IncrementalEstimator::readCheckpoint(std::istream& stream,
+        const DesignVariablesSP& designVariables) {
+      if (getNumBatches() > 0)
+        throw InvalidOperationException(
+          "IncrementalEstimator::readCheckpoint(): "
+          "the estimator should not contain any batch", __FILE__, __LINE__);
+
+      BinaryReader reader(stream);
+      if (reader.read<uint64_t>() != _checkpointMagic)
+        throw InvalidOperationException(
+          "IncrementalEstimator::readCheckpoint(): not a checkpoint", __FILE__,
+          __LINE__);
+      const uint64_t version = reader.read<uint64_t>();
+      if (version != _checkpointVersion)
+        throw OutOfBoundException<size_t>(version, _checkpointVersion,
+          "IncrementalEstimator::readCheckpoint(): unsupported version",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      const uint64_t margGroupId = reader.read<uint64_t>();
+      if (margGroupId != _margGroupId)
+        throw OutOfBoundException<size_t>(margGroupId, _margGroupId,
+          "IncrementalEstimator::readCheckpoint(): "
+          "wrong marginalized group ID", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+
+      // restore the linearization point of the prior
+      const uint64_t numDVs = reader.read<uint64_t>();
+      if (numDVs != designVariables.size())
+        throw OutOfBoundException<size_t>(designVariables.size(), numDVs,
+          "IncrementalEstimator::readCheckpoint(): "
+          "wrong number of design variables", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      Eigen::MatrixXd parameters;
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it) {
+        const bool active = reader.read<uint64_t>();
+        const uint64_t minimalDimensions = reader.read<uint64_t>();
+        if (minimalDimensions !=
+            static_cast<uint64_t>((*it)->minimalDimensions()))
+          throw OutOfBoundException<size_t>((*it)->minimalDimensions(),
+            minimalDimensions, "IncrementalEstimator::readCheckpoint(): "
+            "wrong design variable dimension", __FILE__, __LINE__,
+            __PRETTY_FUNCTION__);
+        reader.read(parameters);
+        (*it)->setParameters(parameters);
+        (*it)->setActive(active);
+      }
+      Eigen::MatrixXd R;
+      Eigen::VectorXd r;
+      reader.read(R);
+      reader.read(r);
+      const size_t numSummarized = reader.read<uint64_t>();
+
+      // estimator state
+      _informationGain = reader.read<double>();
+      _svLog2Sum = reader.read<double>();
+      _svdTolerance = reader.read<double>();
+      _qrTolerance = reader.read<double>();
+      _rankTheta = reader.read<int64_t>();
+      _rankThetaDeficiency = reader.read<int64_t>();
+      _rankPsi = reader.read<int64_t>();
+      _rankPsiDeficiency = reader.read<int64_t>();
+      _initialCost = reader.read<double>();
+      _finalCost = reader.read<double>();
+
+      // marginal analysis snapshot
+      auto marginal = boost::make_shared<MarginalResults>();
+      reader.read(marginal->nobsBasis);
+      reader.read(marginal->nobsBasisScaled);
+      reader.read(marginal->obsBasis);
+      reader.read(marginal->obsBasisScaled);
+      reader.read(marginal->sigma2Theta);
+      reader.read(marginal->sigma2ThetaScaled);
+      reader.read(marginal->sigma2ThetaObs);
+      reader.read(marginal->sigma2ThetaObsScaled);
+      reader.read(marginal->singularValues);
+      reader.read(marginal->singularValuesScaled);
+      _marginal = marginal;
+
+      // the solver statistics belong to the process that wrote the checkpoint
+      _peakMemoryUsage = 0;
+      _memoryUsage = 0;
+      _numFlops = 0.0;
+
+      // the prior replaces all the checkpointed batches
+      _batchInformation.clear();
+      _numEvictedBatches = numSummarized;
+      _priorBatch = createPriorBatch(designVariables, R, r);
+      _problem->add(_priorBatch);
+      orderMarginalizedDesignVariables();
+      restoreLinearSolver();
+      if (_options.incrementalMarginal || _options.preScreening)
+        resetMarginalAnalyzer();
+    }
+
+    void IncrementalEstimator::loadCheckpoint(const std::string& filename,
+        const DesignVariablesSP& designVariables) {
+      std::ifstream file(filename, std::ios::in | std::ios::binary);
+      if (!file.is_open())
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::loadCheckpoint(): unable to open file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      readCheckpoint(file, designVariables);
+    }
+
     size_t IncrementalEstimator::getNumBatches() const {
       return _problem->getNumOptimizationProblems();
     }
@@ -499,7 +922,71 @@ namespace aslam {
       }
     }
 
-    void IncrementalEstimator::restoreLinearSolver() {
+    template <typename Analyzer>
+    void IncrementalEstimator::fillMarginalResults(const Analyzer& analyzer,
+        MarginalResults& marginal) {
+      marginal.nobsBasis = analyzer.getNullSpace();
+      marginal.obsBasis = analyzer.getRowSpace();
+      marginal.sigma2Theta = analyzer.getCovariance();
+      marginal.sigma2ThetaObs = analyzer.getRowSpaceCovariance();
+      marginal.singularValues = analyzer.getSingularValues();
+    }
+
+    void IncrementalEstimator::fillScaledMarginalResults(
+        MarginalResults& marginal) const {
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      marginal.singularValuesScaled = linearSolver->getSingularValues();
+      marginal.nobsBasisScaled = linearSolver->getNullSpace();
+      marginal.obsBasisScaled = linearSolver->getRowSpace();
+      marginal.sigma2ThetaScaled = linearSolver->getCovariance();
+      marginal.sigma2ThetaObsScaled = linearSolver->getRowSpaceCovariance();
+    }
+
+    void IncrementalEstimator::setOptimizerStatistics(ReturnValue& ret,
+        double optimizerTime) const {
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      ret.jacobianTime = linearSolver->getJacobianTime();
+      ret.linearSolverTime = linearSolver->getSolveTime();
+      ret.optimizationTime = std::max(0.0, optimizerTime - ret.jacobianTime -
+        ret.linearSolverTime);
+      ret.numErrorTerms = _problem->numErrorTerms();
+      ret.numDesignVariables = _problem->numDesignVariables();
+      ret.jacobianNnz = linearSolver->getJacobianNnz();
+      ret.numFlops = linearSolver->getNumFlops();
+    }
+
+    void IncrementalEstimator::restoreLinearSolver(bool fromSavedState,
+        size_t numUnchangedDVs, bool appendedOnly) {
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      if (fromSavedState) {
+        // after a rollback, only the design variables following the unchanged
+        // ones are indexed again and the saved Jacobian is restored in place
+        size_t blockIndex = 0;
+        size_t columnBase = 0;
+        for (size_t i = numUnchangedDVs; i > 0; --i) {
+          const aslam::backend::DesignVariable* dv =
+            _problem->designVariable(i - 1);
+          if (dv->isActive()) {
+            blockIndex = dv->blockIndex() + 1;
+            columnBase = dv->columnBase() + dv->minimalDimensions();
+            break;
+          }
+        }
+        std::vector<aslam::backend::DesignVariable*> dvs;
+        const size_t numDVS = _problem->numDesignVariables();
+        for (size_t i = numUnchangedDVs; i < numDVS; ++i) {
+          aslam::backend::DesignVariable* dv = _problem->designVariable(i);
+          if (dv->isActive()) {
+            dv->setBlockIndex(blockIndex + dvs.size());
+            dv->setColumnBase(columnBase);
+            dvs.push_back(dv);
+            columnBase += dv->minimalDimensions();
+          }
+        }
+        if (linearSolver->restoreJacobianState(blockIndex, dvs))
+          return;
+      }
+
       // init the matrix structure
       std::vector<aslam::backend::DesignVariable*> dvs;
       const size_t numDVS = _problem->numDesignVariables();
@@ -508,9 +995,9 @@ namespace aslam {
       for (size_t i = 0; i < numDVS; ++i) {
         aslam::backend::DesignVariable* dv = _problem->designVariable(i);
         if (dv->isActive()) {
-          dvs.push_back(dv);
-          dv->setBlockIndex(dvs.size() - 1);
+          dv->setBlockIndex(dvs.size());
           dv->setColumnBase(columnBase);
+          dvs.push_back(dv);
           columnBase += dv->minimalDimensions();
         }
       }
@@ -524,11 +1011,407 @@ namespace aslam {
         dim += et->dimension();
         ets.push_back(et);
       }
-      auto linearSolver = _optimizer->getSolver<LinearSolver>();
       linearSolver->initMatrixStructure(dvs, ets, false);
 
       // build the system
-      linearSolver->buildSystem(_optimizer->options().numThreadsJacobian, true);
+      if (appendedOnly)
+        linearSolver->buildAppendedSystem(
+          _optimizer->options().numThreadsJacobian, true);
+      else
+        linearSolver->buildSystem(_optimizer->options().numThreadsJacobian,
+          true);
+    }
+
+    size_t IncrementalEstimator::getNumUnchangedDesignVariables(
+        const std::vector<std::pair<size_t, size_t> >& groupsSizes) const {
+      // new design variables are appended to their groups
+      const auto& groupsOrdering = _problem->getGroupsOrdering();
+      size_t numDVs = 0;
+      for (size_t i = 0; i < groupsOrdering.size(); ++i) {
+        if (i >= groupsSizes.size() ||
+            groupsSizes[i].first != groupsOrdering[i])
+          return numDVs;
+        const size_t groupSize =
+          _problem->getDesignVariablesGroup(groupsOrdering[i]).size();
+        if (groupSize != groupsSizes[i].second)
+          return numDVs + groupsSizes[i].second;
+        numDVs += groupSize;
+      }
+      return numDVs;
+    }
+
+    bool IncrementalEstimator::getBatchJacobians(Batch& batch,
+        Eigen::MatrixXd& Jpsi, Eigen::MatrixXd& Jtheta, bool inProblem)
+        const {
+      Eigen::VectorXd error;
+      return getBatchJacobians(batch, Jpsi, Jtheta, error, inProblem);
+    }
+
+    bool IncrementalEstimator::getBatchJacobians(Batch& batch,
+        Eigen::MatrixXd& Jpsi, Eigen::MatrixXd& Jtheta, Eigen::VectorXd& error,
+        bool inProblem) const {
+      // columns of theta follow the ordering of the marginalized group
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t>
+        thetaCols;
+      size_t thetaDim = 0;
+      const auto& margDVs = _problem->getDesignVariablesGroup(_margGroupId);
+      for (auto it = margDVs.cbegin(); it != margDVs.cend(); ++it)
+        if ((*it)->isActive()) {
+          thetaCols[*it] = thetaDim;
+          thetaDim += (*it)->minimalDimensions();
+        }
+
+      // nuisance variables must belong to this batch only
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t>
+        psiCols;
+      size_t psiDim = 0;
+      const size_t maxCount = inProblem ? 1 : 0;
+      for (size_t i = 0; i < batch.numDesignVariables(); ++i) {
+        const aslam::backend::DesignVariable* dv = batch.designVariable(i);
+        if (!dv->isActive() || thetaCols.count(dv))
+          continue;
+        if (batch.getGroupId(dv) == _margGroupId)
+          return false;
+        if (_problem->isDesignVariableInProblem(dv) &&
+            _problem->getDesignVariableCount(dv) > maxCount)
+          return false;
+        psiCols[dv] = psiDim;
+        psiDim += dv->minimalDimensions();
+      }
+
+      // stack the weighted Jacobians as in the linear solver
+      size_t numRows = 0;
+      for (size_t i = 0; i < batch.numErrorTerms(); ++i)
+        numRows += batch.errorTerm(i)->dimension();
+      Jpsi = Eigen::MatrixXd::Zero(numRows, psiDim);
+      Jtheta = Eigen::MatrixXd::Zero(numRows, thetaDim);
+      error.resize(numRows);
+      size_t row = 0;
+      Eigen::VectorXd e;
+      for (size_t i = 0; i < batch.numErrorTerms(); ++i) {
+        aslam::backend::ErrorTerm* et = batch.errorTerm(i);
+        et->evaluateError();
+        et->getWeightedError(e, true);
+        error.segment(row, et->dimension()) = e;
+        aslam::backend::JacobianContainer jc(et->dimension());
+        et->getWeightedJacobians(jc, true);
+        for (auto it = jc.begin(); it != jc.end(); ++it) {
+          auto thetaIt = thetaCols.find(it->first);
+          if (thetaIt != thetaCols.end())
+            Jtheta.block(row, thetaIt->second, it->second.rows(),
+              it->second.cols()) = it->second;
+          auto psiIt = psiCols.find(it->first);
+          if (psiIt != psiCols.end())
+            Jpsi.block(row, psiIt->second, it->second.rows(),
+              it->second.cols()) = it->second;
+        }
+        row += et->dimension();
+      }
+      return true;
+    }
+
+    bool IncrementalEstimator::analyzeMarginalIncrementally(Batch& batch,
+        IncrementalMarginalAnalyzer& marginalAnalyzer, bool& relinearized)
+        const {
+      relinearized = false;
+      if (!_marginalAnalyzerValid || _marginalAnalyzer.getDim() !=
+          _problem->getGroupDim(_margGroupId))
+        return false;
+
+      // the folded rows are only valid close to their linearization point,
+      // the batch is already in the problem and rebuilt with the others
+      if (isMarginalAnalyzerStale()) {
+        relinearized = true;
+        return buildMarginalAnalyzer(marginalAnalyzer);
+      }
+      Eigen::MatrixXd Jpsi, Jtheta;
+      if (!getBatchJacobians(batch, Jpsi, Jtheta))
+        return false;
+      marginalAnalyzer = _marginalAnalyzer;
+      marginalAnalyzer.addBatch(Jpsi, Jtheta);
+      marginalAnalyzer.analyze();
+      return true;
+    }
+
+    bool IncrementalEstimator::buildMarginalAnalyzer(
+        IncrementalMarginalAnalyzer& marginalAnalyzer) const {
+      const LinearSolverOptions& options = getLinearSolverOptions();
+      marginalAnalyzer = IncrementalMarginalAnalyzer(
+        _problem->getGroupDim(_margGroupId), options.qrTol, options.svdTol);
+      Eigen::MatrixXd Jpsi, Jtheta;
+      for (size_t i = 0; i < _problem->getNumOptimizationProblems(); ++i) {
+        if (!getBatchJacobians(*_problem->getOptimizationProblem(i), Jpsi,
+            Jtheta))
+          return false;
+        marginalAnalyzer.addBatch(Jpsi, Jtheta);
+      }
+      marginalAnalyzer.analyze();
+      return true;
+    }
+
+    void IncrementalEstimator::resetMarginalAnalyzer() {
+      _marginalAnalyzerValid = buildMarginalAnalyzer(_marginalAnalyzer);
+      _marginalLinearizationPoint = getMargParameters();
+    }
+
+    Eigen::VectorXd IncrementalEstimator::getMargParameters() const {
+      if (!_problem->isGroupInProblem(_margGroupId))
+        return Eigen::VectorXd();
+      const auto& margDVs = _problem->getDesignVariablesGroup(_margGroupId);
+      std::vector<Eigen::MatrixXd> parameters;
+      parameters.reserve(margDVs.size());
+      std::ptrdiff_t numParameters = 0;
+      for (auto it = margDVs.cbegin(); it != margDVs.cend(); ++it)
+        if ((*it)->isActive()) {
+          parameters.push_back(Eigen::MatrixXd());
+          (*it)->getParameters(parameters.back());
+          numParameters += parameters.back().size();
+        }
+      Eigen::VectorXd theta(numParameters);
+      std::ptrdiff_t row = 0;
+      for (auto it = parameters.cbegin(); it != parameters.cend(); ++it) {
+        theta.segment(row, it->size()) =
+          Eigen::Map<const Eigen::VectorXd>(it->data(), it->size());
+        row += it->size();
+      }
+      return theta;
+    }
+
+    bool IncrementalEstimator::isMarginalAnalyzerStale() const {
+      const Eigen::VectorXd theta = getMargParameters();
+      if (theta.size() != _marginalLinearizationPoint.size())
+        return true;
+      return (theta - _marginalLinearizationPoint).norm() >
+        _options.marginalRelinearizationThreshold *
+        std::max(_marginalLinearizationPoint.norm(), 1.0);
+    }
+
+    bool IncrementalEstimator::scoreBatch(Batch& batch,
+        const IncrementalMarginalAnalyzer& currentAnalyzer, ReturnValue& ret)
+        const {
+      // linearize the candidate batch at the current estimate
+      Eigen::MatrixXd Jpsi, Jtheta;
+      if (!getBatchJacobians(batch, Jpsi, Jtheta, false))
+        return false;
+      IncrementalMarginalAnalyzer marginalAnalyzer = currentAnalyzer;
+      marginalAnalyzer.addBatch(Jpsi, Jtheta);
+      marginalAnalyzer.analyze();
+      ret.informationGain = 0.5 * (marginalAnalyzer.getSingularValuesLog2Sum()
+        - currentAnalyzer.getSingularValuesLog2Sum());
+      ret.rankPsi = marginalAnalyzer.getQRRank();
+      ret.rankPsiDeficiency = marginalAnalyzer.getQRRankDeficiency();
+      ret.rankTheta = marginalAnalyzer.getSVDRank();
+      ret.rankThetaDeficiency = marginalAnalyzer.getSVDRankDeficiency();
+      ret.svdTolerance = marginalAnalyzer.getSVDTolerance();
+      ret.qrTolerance = marginalAnalyzer.getQRTolerance();
+      auto marginal = boost::make_shared<MarginalResults>();
+      fillMarginalResults(marginalAnalyzer, *marginal);
+      ret.marginal = marginal;
+      return true;
+    }
+
+    bool IncrementalEstimator::preScreenBatch(Batch& batch, ReturnValue& ret)
+        const {
+      if (!_marginalAnalyzerValid || !_problem->isGroupInProblem(_margGroupId)
+          || _marginalAnalyzer.getDim() != _problem->getGroupDim(_margGroupId)
+          || isMarginalAnalyzerStale())
+        return false;
+      if (!scoreBatch(batch, _marginalAnalyzer, ret))
+        return false;
+
+      // keep the batch for the full optimization unless clearly useless
+      return ret.informationGain <= _options.preScreeningInfoGainDelta &&
+        ret.rankTheta <= _marginalAnalyzer.getSVDRank();
+    }
+
+    void IncrementalEstimator::fillSkippedReturnValue(ReturnValue& ret) const {
+      ret.batchAccepted = false;
+      ret.preScreened = false;
+      ret.numIterations = 0;
+      ret.JStart = _finalCost;
+      ret.JFinal = _finalCost;
+      ret.insertionTime = 0.0;
+      ret.orderingTime = 0.0;
+      ret.jacobianTime = 0.0;
+      ret.linearSolverTime = 0.0;
+      ret.optimizationTime = 0.0;
+      ret.marginalAnalysisTime = 0.0;
+      ret.rollbackTime = 0.0;
+      ret.evictionTime = 0.0;
+      ret.numEvictedBatches = 0;
+      ret.numErrorTerms = _problem->numErrorTerms();
+      ret.numDesignVariables = _problem->numDesignVariables();
+      ret.jacobianNnz = _optimizer->getSolver<LinearSolver>()->getJacobianNnz();
+      ret.numFlops = _numFlops;
+    }
+
+    size_t IncrementalEstimator::evictBatches(const BatchSP& newest) {
+      if (_options.maxNumBatches == 0 && _options.maxNumErrorTerms == 0)
+        return 0;
+
+      // candidates in eviction order, never the prior or the newest batch,
+      // a batch without score is evicted first
+      std::vector<std::pair<double, BatchSP> > candidates;
+      const auto& batches = _problem->getOptimizationProblems();
+      for (auto it = batches.cbegin(); it != batches.cend(); ++it)
+        if (*it != newest && *it != _priorBatch) {
+          auto infoIt = _batchInformation.find(it->get());
+          candidates.push_back(std::make_pair(
+            infoIt != _batchInformation.end() ? infoIt->second :
+            -std::numeric_limits<double>::infinity(), *it));
+        }
+      if (_options.evictLowestInformation)
+        std::stable_sort(candidates.begin(), candidates.end(),
+          [](const std::pair<double, BatchSP>& lhs,
+              const std::pair<double, BatchSP>& rhs) {
+            return lhs.first < rhs.first;
+          });
+
+      // select batches until the limits are met
+      size_t numBatches = batches.size() - (_priorBatch ? 1 : 0);
+      size_t numErrorTerms = _problem->numErrorTerms();
+      std::vector<BatchSP> evicted;
+      for (auto it = candidates.cbegin(); it != candidates.cend(); ++it) {
+        if ((_options.maxNumBatches == 0 ||
+            numBatches <= _options.maxNumBatches) &&
+            (_options.maxNumErrorTerms == 0 ||
+            numErrorTerms <= _options.maxNumErrorTerms))
+          break;
+        // nuisance variables shared with other batches cannot be marginalized
+        if (hasSharedNuisances(*it->second))
+          continue;
+        evicted.push_back(it->second);
+        --numBatches;
+        numErrorTerms -= it->second->numErrorTerms();
+      }
+      if (evicted.empty())
+        return 0;
+
+      // fold the evicted batches and the current prior into a new prior, the
+      // problem is left untouched if they cannot be summarized
+      std::vector<BatchSP> summarized = evicted;
+      if (_priorBatch)
+        summarized.push_back(_priorBatch);
+      Eigen::MatrixXd R;
+      Eigen::VectorXd r;
+      if (!summarizeBatches(summarized, R, r))
+        return 0;
+      const BatchSP priorBatch = createPriorBatch(getMargDesignVariables(), R,
+        r);
+      for (auto it = summarized.cbegin(); it != summarized.cend(); ++it) {
+        _batchInformation.erase(it->get());
+        _problem->remove(*it);
+      }
+      _problem->add(priorBatch);
+      _priorBatch = priorBatch;
+      _numEvictedBatches += evicted.size();
+
+      // the marginal R factor is unchanged since the prior carries the same
+      // information, the linear solver drops the removed error terms and only
+      // evaluates the prior; the removed batches are still alive here, so
+      // that no new error term can reuse the address of a removed one
+      orderMarginalizedDesignVariables();
+      restoreLinearSolver(false, 0, true);
+      return evicted.size();
+    }
+
+    bool IncrementalEstimator::hasSharedNuisances(const Batch& batch) const {
+      for (size_t i = 0; i < batch.numDesignVariables(); ++i) {
+        const aslam::backend::DesignVariable* dv = batch.designVariable(i);
+        if (!dv->isActive() || batch.getGroupId(dv) == _margGroupId)
+          continue;
+        if (_problem->getDesignVariableCount(dv) > 1)
+          return true;
+      }
+      return false;
+    }
+
+    bool IncrementalEstimator::summarizeBatches(const std::vector<BatchSP>&
+        batches, Eigen::MatrixXd& R, Eigen::VectorXd& r) const {
+      const std::ptrdiff_t dim = _problem->getGroupDim(_margGroupId);
+      const double qrTol = getLinearSolverOptions().qrTol;
+
+      // project [J_theta e] onto the orthogonal complement of J_psi, as in
+      // the incremental marginal analyzer
+      std::vector<Eigen::MatrixXd> blocks;
+      blocks.reserve(batches.size());
+      std::ptrdiff_t numRows = 0;
+      Eigen::MatrixXd Jpsi, Jtheta;
+      Eigen::VectorXd error;
+      for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+        if (!getBatchJacobians(**it, Jpsi, Jtheta, error))
+          return false;
+        Eigen::MatrixXd A(Jtheta.rows(), dim + 1);
+        A << Jtheta, error;
+        if (Jpsi.cols() > 0 && Jpsi.rows() > 0) {
+          const Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(Jpsi);
+          const Eigen::MatrixXd& QR = qr.matrixQR();
+          const std::ptrdiff_t numPivots = std::min(QR.rows(), QR.cols());
+          const double tol = qrTol >= 0 ? qrTol : 20.0 *
+            (Jpsi.rows() + Jpsi.cols()) *
+            std::numeric_limits<double>::epsilon() *
+            Jpsi.colwise().norm().maxCoeff();
+          std::ptrdiff_t rank = 0;
+          while (rank < numPivots && std::fabs(QR(rank, rank)) > tol)
+            ++rank;
+          A.applyOnTheLeft(qr.householderQ().adjoint());
+          A = A.bottomRows(A.rows() - rank).eval();
+        }
+        numRows += A.rows();
+        blocks.push_back(std::move(A));
+      }
+
+      // triangularize the stacked system, the last row of [R r] is constant
+      Eigen::MatrixXd S(numRows, dim + 1);
+      std::ptrdiff_t row = 0;
+      for (auto it = blocks.cbegin(); it != blocks.cend(); ++it) {
+        S.middleRows(row, it->rows()) = *it;
+        row += it->rows();
+      }
+      const Eigen::HouseholderQR<Eigen::MatrixXd> qr(S);
+      const std::ptrdiff_t rows = std::min(numRows, dim);
+      const Eigen::MatrixXd T =
+        qr.matrixQR().topRows(rows).triangularView<Eigen::Upper>();
+      R = T.leftCols(dim);
+      r = T.col(dim);
+      return true;
+    }
+
+    IncrementalEstimator::DesignVariablesSP
+        IncrementalEstimator::getMargDesignVariables() const {
+      // shared pointers are only held by the batches
+      std::unordered_map<const aslam::backend::DesignVariable*,
+        DesignVariableSP> thetaDVs;
+      const auto& batches = _problem->getOptimizationProblems();
+      for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+        if (!(*it)->isGroupInProblem(_margGroupId))
+          continue;
+        const auto& dvs = (*it)->getDesignVariablesGroup(_margGroupId);
+        for (auto dvIt = dvs.cbegin(); dvIt != dvs.cend(); ++dvIt)
+          thetaDVs[dvIt->get()] = *dvIt;
+      }
+      DesignVariablesSP designVariables;
+      const auto& margDVs = _problem->getDesignVariablesGroup(_margGroupId);
+      designVariables.reserve(margDVs.size());
+      for (auto it = margDVs.cbegin(); it != margDVs.cend(); ++it)
+        designVariables.push_back(thetaDVs.at(*it));
+      return designVariables;
+    }
+
+    IncrementalEstimator::BatchSP IncrementalEstimator::createPriorBatch(
+        const DesignVariablesSP& designVariables, const Eigen::MatrixXd& R,
+        const Eigen::VectorXd& r) const {
+      // same column ordering as the batch Jacobians
+      auto prior = boost::make_shared<Batch>();
+      std::vector<aslam::backend::DesignVariable*> dvs;
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it)
+        if ((*it)->isActive()) {
+          prior->addDesignVariable(*it, _margGroupId);
+          dvs.push_back(it->get());
+        }
+      prior->addErrorTerm(prior->allocate<ErrorTermPrior>(dvs, R, r));
+      return prior;
     }
 
   }
@@ -0,0 +1,202 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/core/IncrementalMarginalAnalyzer.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <limits>
+
+#include <Eigen/QR>
+#include <Eigen/SVD>
+
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    IncrementalMarginalAnalyzer::IncrementalMarginalAnalyzer(size_t dim,
+        double qrTol, double svdTol) :
+        _qrTol(qrTol),
+        _svdTol(svdTol) {
+      clear(dim);
+    }
+
+    IncrementalMarginalAnalyzer::~IncrementalMarginalAnalyzer() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    size_t IncrementalMarginalAnalyzer::getDim() const {
+      return _dim;
+    }
+
+    const Eigen::MatrixXd& IncrementalMarginalAnalyzer::getR() const {
+      return _R;
+    }
+
+    std::ptrdiff_t IncrementalMarginalAnalyzer::getQRRank() const {
+      return _rankPsi;
+    }
+
+    std::ptrdiff_t IncrementalMarginalAnalyzer::getQRRankDeficiency() const {
+      return _numPsiCols - _rankPsi;
+    }
+
+    double IncrementalMarginalAnalyzer::getQRTolerance() const {
+      return _qrTolerance;
+    }
+
+    std::ptrdiff_t IncrementalMarginalAnalyzer::getSVDRank() const {
+      return _rankTheta;
+    }
+
+    std::ptrdiff_t IncrementalMarginalAnalyzer::getSVDRankDeficiency() const {
+      return static_cast<std::ptrdiff_t>(_dim) - _rankTheta;
+    }
+
+    double IncrementalMarginalAnalyzer::getSVDTolerance() const {
+      return _svdTolerance;
+    }
+
+    const Eigen::VectorXd& IncrementalMarginalAnalyzer::getSingularValues()
+        const {
+      return _singularValues;
+    }
+
+    double IncrementalMarginalAnalyzer::getSingularValuesLog2Sum() const {
+      return _svLog2Sum;
+    }
+
+    const Eigen::MatrixXd& IncrementalMarginalAnalyzer::getNullSpace() const {
+      return _nobsBasis;
+    }
+
+    const Eigen::MatrixXd& IncrementalMarginalAnalyzer::getRowSpace() const {
+      return _obsBasis;
+    }
+
+    const Eigen::MatrixXd& IncrementalMarginalAnalyzer::getCovariance() const {
+      return _sigma2Theta;
+    }
+
+    const Eigen::MatrixXd& IncrementalMarginalAnalyzer::getRowSpaceCovariance()
+        const {
+      return _sigma2ThetaObs;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void IncrementalMarginalAnalyzer::clear(size_t dim) {
+      _dim = dim;
+      _R.resize(0, dim);
+      _numPsiCols = 0;
+      _rankPsi = 0;
+      _qrTolerance = _qrTol;
+      _rankTheta = 0;
+      _svdTolerance = _svdTol;
+      _singularValues = Eigen::VectorXd::Zero(dim);
+      _svLog2Sum = 0.0;
+      _nobsBasis = Eigen::MatrixXd::Identity(dim, dim);
+      _obsBasis.resize(dim, 0);
+      _sigma2Theta = Eigen::MatrixXd::Zero(dim, dim);
+      _sigma2ThetaObs.resize(0, 0);
+    }
+
+    void IncrementalMarginalAnalyzer::addBatch(const Eigen::MatrixXd& Jpsi,
+        const Eigen::MatrixXd& Jtheta) {
+      if (static_cast<size_t>(Jtheta.cols()) != _dim)
+        throw OutOfBoundException<size_t>(Jtheta.cols(), _dim,
+          "IncrementalMarginalAnalyzer::addBatch(): "
+          "J_theta must have the marginal dimension as columns",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if (Jpsi.rows() != Jtheta.rows())
+        throw OutOfBoundException<size_t>(Jpsi.rows(), Jtheta.rows(),
+          "IncrementalMarginalAnalyzer::addBatch(): "
+          "J_psi and J_theta must have the same rows",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+
+      // project J_theta onto the orthogonal complement of the range of J_psi
+      Eigen::MatrixXd A = Jtheta;
+      if (Jpsi.cols() > 0 && Jpsi.rows() > 0) {
+        const Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(Jpsi);
+        const Eigen::MatrixXd& QR = qr.matrixQR();
+        const std::ptrdiff_t numPivots = std::min(QR.rows(), QR.cols());
+        double qrTol = _qrTol;
+        if (qrTol < 0) {
+          // same default as SPQR
+          qrTol = 20.0 * (Jpsi.rows() + Jpsi.cols()) *
+            std::numeric_limits<double>::epsilon() *
+            Jpsi.colwise().norm().maxCoeff();
+          _qrTolerance = std::max(_qrTolerance, qrTol);
+        }
+        std::ptrdiff_t rank = 0;
+        while (rank < numPivots && std::fabs(QR(rank, rank)) > qrTol)
+          ++rank;
+        A.applyOnTheLeft(qr.householderQ().adjoint());
+        A = A.bottomRows(A.rows() - rank).eval();
+        _rankPsi += rank;
+      }
+      _numPsiCols += Jpsi.cols();
+
+      // re-triangularize [R_theta; Q_2^T J_theta]
+      Eigen::MatrixXd S(_R.rows() + A.rows(), _dim);
+      S << _R, A;
+      const Eigen::HouseholderQR<Eigen::MatrixXd> qr(S);
+      const std::ptrdiff_t numRows = std::min<std::ptrdiff_t>(S.rows(), _dim);
+      _R = qr.matrixQR().topRows(numRows).triangularView<Eigen::Upper>();
+    }
+
+    void IncrementalMarginalAnalyzer::analyze() {
+      const std::ptrdiff_t dim = _dim;
+      _singularValues = Eigen::VectorXd::Zero(dim);
+      Eigen::MatrixXd V = Eigen::MatrixXd::Identity(dim, dim);
+      if (_R.rows() > 0 && dim > 0) {
+        const Eigen::JacobiSVD<Eigen::MatrixXd> svd(_R, Eigen::ComputeFullV);
+        _singularValues.head(svd.singularValues().size()) =
+          svd.singularValues();
+        V = svd.matrixV();
+      }
+      _svdTolerance = _svdTol;
+      if (_svdTolerance < 0)
+        _svdTolerance = std::max<std::ptrdiff_t>(_R.rows(), dim) *
+          (dim > 0 ? _singularValues(0) : 0.0) *
+          std::numeric_limits<double>::epsilon();
+      _rankTheta = 0;
+      _svLog2Sum = 0.0;
+      while (_rankTheta < dim && _singularValues(_rankTheta) > _svdTolerance)
+        _svLog2Sum += std::log2(_singularValues(_rankTheta++));
+      _obsBasis = V.leftCols(_rankTheta);
+      _nobsBasis = V.rightCols(dim - _rankTheta);
+      const Eigen::VectorXd invSv2 =
+        _singularValues.head(_rankTheta).array().square().inverse();
+      _sigma2ThetaObs = invSv2.asDiagonal();
+      _sigma2Theta = _obsBasis * invSv2.asDiagonal() * _obsBasis.transpose();
+    }
+
+  }
+}
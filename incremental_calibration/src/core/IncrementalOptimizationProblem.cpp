@@ -38,7 +38,10 @@ namespace aslam {
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
-    IncrementalOptimizationProblem::IncrementalOptimizationProblem() {
+    IncrementalOptimizationProblem::IncrementalOptimizationProblem() :
+        _designVariablesBackupSize(0),
+        _errorTermsOffsets(1, 0),
+        _groupsOffsets(1, 0) {
     }
 
     IncrementalOptimizationProblem::~IncrementalOptimizationProblem() {
@@ -146,7 +149,14 @@ namespace aslam {
             __FILE__, __LINE__, __PRETTY_FUNCTION__);
         groupsLookup.insert(*it);
       }
+      if (groupsOrdering == _groupsOrdering)
+        return;
+      // the first groups that keep their position keep their offsets
+      size_t groupIdx = 0;
+      while (groupsOrdering[groupIdx] == _groupsOrdering[groupIdx])
+        ++groupIdx;
       _groupsOrdering = groupsOrdering;
+      updateDesignVariablesOrdered(groupIdx);
     }
 
     const std::vector<size_t>&
@@ -163,15 +173,21 @@ namespace aslam {
            __FILE__, __LINE__, __PRETTY_FUNCTION__);
     }
 
+    size_t IncrementalOptimizationProblem::getDesignVariableCount(
+        const DesignVariable* designVariable) const {
+      if (isDesignVariableInProblem(designVariable))
+        return _designVariablesCounts.at(designVariable).first;
+      else
+        throw InvalidOperationException("design variable is not in the problem",
+           __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    }
+
     size_t IncrementalOptimizationProblem::getGroupDim(size_t groupId) const {
-      const DesignVariablesP& designVariables =
-        getDesignVariablesGroup(groupId);
-      size_t dim = 0;
-      for (auto it = designVariables.cbegin(); it != designVariables.cend();
-          ++it)
-        if ((*it)->isActive())
-          dim += (*it)->minimalDimensions();
-      return dim;
+      if (isGroupInProblem(groupId))
+        return _groupsDims.at(groupId);
+      else
+        throw OutOfBoundException<size_t>(groupId, "unknown group",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
     }
 
     bool IncrementalOptimizationProblem::
@@ -190,6 +206,8 @@ namespace aslam {
           __PRETTY_FUNCTION__);
       // update design variable counts, grouping, and storing
       const size_t numDV = problem->numDesignVariables();
+      const size_t numGroups = _groupsOrdering.size();
+      GroupsSizes numAdded;
       _designVariablesCounts.reserve(_designVariablesCounts.size() + numDV);
       for (size_t i = 0; i < numDV; ++i) {
         const DesignVariable* dv = problem->designVariable(i);
@@ -199,7 +217,14 @@ namespace aslam {
         if (!isDesignVariableInProblem(dv)) {
           _designVariablesCounts.insert(std::make_pair(dv,
             std::make_pair(1, groupId)));
-          _designVariables[groupId].push_back(dv);
+          DesignVariablesP& designVariables = _designVariables[groupId];
+          _designVariablesSlots[dv] = designVariables.size();
+          designVariables.push_back(dv);
+          _groupsSizes[groupId]++;
+          numAdded[groupId]++;
+          size_t& groupDim = _groupsDims[groupId];
+          if (dv->isActive())
+            groupDim += dv->minimalDimensions();
         }
         else {
           if (getGroupId(dv) != groupId)
@@ -219,7 +244,34 @@ namespace aslam {
       }
 
       // insert the problem
+      _optimizationProblemsIdx[problem.get()] = _optimizationProblems.size();
       _optimizationProblems.push_back(problem);
+      _errorTermsOffsets.push_back(_errorTermsOffsets.back() + numET);
+
+      // insert the new design variables at the tails of their groups, from
+      // the last group so that the offsets of the previous ones still hold
+      if (numAdded.empty())
+        return;
+      for (size_t i = numGroups; i > 0; --i) {
+        auto it = numAdded.find(_groupsOrdering[i - 1]);
+        if (it == numAdded.end())
+          continue;
+        const DesignVariablesP& designVariables =
+          _designVariables.at(it->first);
+        _designVariablesOrdered.insert(_designVariablesOrdered.begin() +
+          _groupsOffsets[i], designVariables.cend() - it->second,
+          designVariables.cend());
+      }
+      for (size_t i = numGroups; i < _groupsOrdering.size(); ++i) {
+        const DesignVariablesP& designVariables =
+          _designVariables.at(_groupsOrdering[i]);
+        _designVariablesOrdered.insert(_designVariablesOrdered.end(),
+          designVariables.cbegin(), designVariables.cend());
+      }
+      _groupsOffsets.resize(_groupsOrdering.size() + 1);
+      for (size_t i = 0; i < _groupsOrdering.size(); ++i)
+        _groupsOffsets[i + 1] = _groupsOffsets[i] +
+          _groupsSizes.at(_groupsOrdering[i]);
     }
 
     void IncrementalOptimizationProblem::remove(
@@ -235,30 +287,55 @@ namespace aslam {
       // get the optimization problem to remove
       const OptimizationProblemSP& problem = _optimizationProblems.at(idx);
 
-      // update design variable counts and remove the pointers if necessary
+      // update design variable counts and leave a tombstone in the group
+      // storage if necessary, the touched groups are compacted afterwards
       const size_t numDV = problem->numDesignVariables();
+      std::unordered_set<size_t> touchedGroups;
+      size_t groupIdx = _groupsOrdering.size();
       for (size_t i = 0; i < numDV; ++i) {
         const DesignVariable* dv = problem->designVariable(i);
-        _designVariablesCounts[dv].first--;
-        if (_designVariablesCounts[dv].first == 0) {
-          const size_t groupId = getGroupId(dv);
-          _designVariablesCounts.erase(dv);
-          auto it = std::find(_designVariables[groupId].begin(),
-            _designVariables[groupId].end(), dv);
-          _designVariables[groupId].erase(it);
-          if (_designVariables[groupId].empty()) {
+        auto countIt = _designVariablesCounts.find(dv);
+        if (--countIt->second.first == 0) {
+          const size_t groupId = countIt->second.second;
+          _designVariablesCounts.erase(countIt);
+          auto slotIt = _designVariablesSlots.find(dv);
+          _designVariables[groupId][slotIt->second] = nullptr;
+          _designVariablesSlots.erase(slotIt);
+          if (touchedGroups.insert(groupId).second) {
+            // an erased group only shifts the groups after it
+            const size_t idx = std::distance(_groupsOrdering.cbegin(),
+              std::find(_groupsOrdering.cbegin(), _groupsOrdering.cend(),
+              groupId));
+            groupIdx = std::min(groupIdx, idx);
+          }
+          if (--_groupsSizes[groupId] == 0) {
             _designVariables.erase(groupId);
+            _groupsSizes.erase(groupId);
+            _groupsDims.erase(groupId);
+            touchedGroups.erase(groupId);
             auto it = std::find(_groupsOrdering.begin(), _groupsOrdering.end(),
               groupId);
             _groupsOrdering.erase(it);
           }
-          _designVariablesBackup.erase(const_cast<DesignVariable*>(dv));
         }
       }
 
+      // the backup may refer to the removed design variables
+      _designVariablesBackupSize = 0;
+
       // remove problem from the container
-      // costly if not at the end of the container
+      // the indices of the following problems are shifted
+      _optimizationProblemsIdx.erase(problem.get());
       _optimizationProblems.erase(problemIt);
+      _errorTermsOffsets.pop_back();
+      updateErrorTermsOffsets(idx);
+      updateOptimizationProblemsIdx(idx);
+
+      // the groups before the first touched one keep their offsets
+      for (auto it = touchedGroups.cbegin(); it != touchedGroups.cend(); ++it)
+        compactDesignVariablesGroup(*it);
+      if (groupIdx < _groupsOffsets.size() - 1)
+        updateDesignVariablesOrdered(groupIdx);
     }
 
     void IncrementalOptimizationProblem::remove(size_t idx) {
@@ -267,9 +344,23 @@ namespace aslam {
 
     void IncrementalOptimizationProblem::clear() {
       _optimizationProblems.clear();
+      _optimizationProblemsIdx.clear();
       _designVariablesCounts.clear();
       _designVariables.clear();
+      _designVariablesSlots.clear();
+      _groupsSizes.clear();
       _groupsOrdering.clear();
+      _errorTermsOffsets.assign(1, 0);
+      _designVariablesOrdered.clear();
+      _groupsOffsets.assign(1, 0);
+      _groupsDims.clear();
+      _designVariablesBackupSize = 0;
+    }
+
+    void IncrementalOptimizationProblem::invalidateGroupsDims() {
+      for (auto it = _groupsOrdering.cbegin(); it != _groupsOrdering.cend();
+          ++it)
+        compactDesignVariablesGroup(*it);
     }
 
     size_t IncrementalOptimizationProblem::
@@ -280,27 +371,24 @@ namespace aslam {
     IncrementalOptimizationProblem::DesignVariable*
         IncrementalOptimizationProblem::
         designVariableImplementation(size_t idx) {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
-      return const_cast<DesignVariable*>(
-        _designVariables.at(groupId)[idxGroup]);
+      if (idx >= _designVariablesOrdered.size())
+        throw OutOfBoundException<size_t>(idx, _designVariablesOrdered.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return const_cast<DesignVariable*>(_designVariablesOrdered[idx]);
     }
 
     const IncrementalOptimizationProblem::DesignVariable*
         IncrementalOptimizationProblem::
         designVariableImplementation(size_t idx) const {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
-      return _designVariables.at(groupId)[idxGroup];
-    };
+      if (idx >= _designVariablesOrdered.size())
+        throw OutOfBoundException<size_t>(idx, _designVariablesOrdered.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return _designVariablesOrdered[idx];
+    }
 
     size_t IncrementalOptimizationProblem::IncrementalOptimizationProblem::
         numErrorTermsImplementation() const {
-      size_t numErrorTerms = 0;
-      for (auto it = _optimizationProblems.cbegin();
-          it != _optimizationProblems.cend(); ++it)
-        numErrorTerms += (*it)->numErrorTerms();
-      return numErrorTerms;
+      return _errorTermsOffsets.back();
     }
 
     IncrementalOptimizationProblem::ErrorTerm*
@@ -329,15 +417,21 @@ namespace aslam {
     void IncrementalOptimizationProblem::
         permuteOptimizationProblems(const std::vector<size_t>& permutation) {
       permute(_optimizationProblems, permutation);
+      updateErrorTermsOffsets();
+      updateOptimizationProblemsIdx();
     }
 
     void IncrementalOptimizationProblem::permuteDesignVariables(
         const std::vector<size_t>& permutation, size_t groupId) {
-      if (isGroupInProblem(groupId))
-        permute(_designVariables.at(groupId), permutation);
-      else
+      if (!isGroupInProblem(groupId))
         throw OutOfBoundException<size_t>(groupId, "unknown group", __FILE__,
           __LINE__, __PRETTY_FUNCTION__);
+      DesignVariablesP& designVariables = _designVariables.at(groupId);
+      permute(designVariables, permutation);
+      for (size_t i = 0; i < designVariables.size(); ++i)
+        _designVariablesSlots[designVariables[i]] = i;
+      updateDesignVariablesOrdered(std::distance(_groupsOrdering.cbegin(),
+        std::find(_groupsOrdering.cbegin(), _groupsOrdering.cend(), groupId)));
     }
 
     void IncrementalOptimizationProblem::getGroupId(size_t idx, size_t& groupId,
@@ -345,44 +439,76 @@ namespace aslam {
       if (idx >= _designVariablesCounts.size())
         throw OutOfBoundException<size_t>(idx, _designVariablesCounts.size(),
           "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      size_t idxRunning = 0;
-      size_t groupIdRunning = 0;
-      for (auto it = _groupsOrdering.cbegin(); it != _groupsOrdering.cend();
-          ++it) {
-        const DesignVariablesP& designVariables = _designVariables.at(*it);
-        const size_t groupSize = designVariables.size();
-        if ((idxRunning + groupSize) > idx) {
-          groupIdRunning = *it;
-          break;
-        }
-        else
-          idxRunning += groupSize;
-      }
-      groupId = groupIdRunning;
-      idxGroup = idx - idxRunning;
+      // last group starting at or before idx
+      auto it = std::upper_bound(_groupsOffsets.cbegin(),
+        _groupsOffsets.cend(), idx);
+      const size_t groupIdx = std::distance(_groupsOffsets.cbegin(), it) - 1;
+      groupId = _groupsOrdering[groupIdx];
+      idxGroup = idx - _groupsOffsets[groupIdx];
     }
 
     void IncrementalOptimizationProblem::getErrorIdx(size_t idx,
         size_t& batchIdx, size_t& idxBatch) const {
-      size_t idxRunning = 0;
-      size_t batchIdxRunning = 0;
-      bool found = false;
-      for (auto it = _optimizationProblems.cbegin();
-          it != _optimizationProblems.cend(); ++it) {
-        const size_t batchSize = (*it)->numErrorTerms();
-        if ((idxRunning + batchSize) > idx) {
-          batchIdxRunning = std::distance(_optimizationProblems.cbegin(), it);
-          found = true;
-          break;
-        }
-        else
-          idxRunning += batchSize;
-      }
-      if (!found)
+      if (idx >= _errorTermsOffsets.back())
         throw OutOfBoundException<size_t>(idx, "index out of bounds", __FILE__,
           __LINE__, __PRETTY_FUNCTION__);
-      batchIdx = batchIdxRunning;
-      idxBatch = idx - idxRunning;
+      // first batch whose offset is larger than idx is one past the batch
+      auto it = std::upper_bound(_errorTermsOffsets.cbegin(),
+        _errorTermsOffsets.cend(), idx);
+      batchIdx = std::distance(_errorTermsOffsets.cbegin(), it) - 1;
+      idxBatch = idx - _errorTermsOffsets[batchIdx];
+    }
+
+    void IncrementalOptimizationProblem::compactDesignVariablesGroup(
+        size_t groupId) {
+      DesignVariablesP& designVariables = _designVariables.at(groupId);
+      // compact the tombstones while keeping the order
+      if (designVariables.size() != _groupsSizes.at(groupId)) {
+        size_t slot = 0;
+        for (auto it = designVariables.cbegin(); it != designVariables.cend();
+            ++it)
+          if (*it) {
+            if (slot != static_cast<size_t>(
+                std::distance(designVariables.cbegin(), it)))
+              _designVariablesSlots[*it] = slot;
+            designVariables[slot++] = *it;
+          }
+        designVariables.resize(slot);
+      }
+      size_t dim = 0;
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it)
+        if ((*it)->isActive())
+          dim += (*it)->minimalDimensions();
+      _groupsDims[groupId] = dim;
+    }
+
+    void IncrementalOptimizationProblem::updateDesignVariablesOrdered(
+        size_t groupIdx) {
+      _groupsOffsets.resize(groupIdx + 1);
+      _designVariablesOrdered.resize(_groupsOffsets.back());
+      _designVariablesOrdered.reserve(_designVariablesCounts.size());
+      for (size_t i = groupIdx; i < _groupsOrdering.size(); ++i) {
+        const DesignVariablesP& designVariables =
+          _designVariables.at(_groupsOrdering[i]);
+        _designVariablesOrdered.insert(_designVariablesOrdered.end(),
+          designVariables.cbegin(), designVariables.cend());
+        _groupsOffsets.push_back(_designVariablesOrdered.size());
+      }
+    }
+
+    void IncrementalOptimizationProblem::updateErrorTermsOffsets(
+        size_t batchIdx) {
+      _errorTermsOffsets.resize(_optimizationProblems.size() + 1);
+      for (size_t i = batchIdx; i < _optimizationProblems.size(); ++i)
+        _errorTermsOffsets[i + 1] = _errorTermsOffsets[i] +
+          _optimizationProblems[i]->numErrorTerms();
+    }
+
+    void IncrementalOptimizationProblem::updateOptimizationProblemsIdx(
+        size_t batchIdx) {
+      for (size_t i = batchIdx; i < _optimizationProblems.size(); ++i)
+        _optimizationProblemsIdx[_optimizationProblems[i].get()] = i;
     }
 
     void IncrementalOptimizationProblem::remove(const OptimizationProblemSP&
@@ -398,8 +524,11 @@ namespace aslam {
     IncrementalOptimizationProblem::OptimizationProblemsSPIt
         IncrementalOptimizationProblem::getOptimizationProblem(const
         OptimizationProblemSP& problem) {
-      return std::find(_optimizationProblems.begin(),
-        _optimizationProblems.end(), problem);
+      auto it = _optimizationProblemsIdx.find(problem.get());
+      if (it != _optimizationProblemsIdx.end())
+        return _optimizationProblems.begin() + it->second;
+      else
+        return _optimizationProblems.end();
     }
 
     IncrementalOptimizationProblem::OptimizationProblemsSPIt
@@ -413,16 +542,25 @@ namespace aslam {
     }
 
     void IncrementalOptimizationProblem::saveDesignVariables() {
-      for (auto it = _designVariablesCounts.cbegin();
-          it != _designVariablesCounts.cend(); ++it)
-        it->first->getParameters(
-          _designVariablesBackup[const_cast<DesignVariable*>(it->first)]);
+      // a sequential copy into the storage of the previous save, the
+      // optimizer does not move the inactive design variables
+      _designVariablesBackupSize = 0;
+      for (auto it = _designVariablesOrdered.cbegin();
+          it != _designVariablesOrdered.cend(); ++it) {
+        if (!(*it)->isActive())
+          continue;
+        if (_designVariablesBackupSize == _designVariablesBackup.size())
+          _designVariablesBackup.resize(_designVariablesBackupSize + 1);
+        auto& backup = _designVariablesBackup[_designVariablesBackupSize++];
+        backup.first = const_cast<DesignVariable*>(*it);
+        backup.first->getParameters(backup.second);
+      }
     }
 
     void IncrementalOptimizationProblem::restoreDesignVariables() {
-      for (auto it = _designVariablesBackup.cbegin();
-          it != _designVariablesBackup.cend(); ++it)
-        it->first->setParameters(_designVariablesBackup[it->first]);
+      for (size_t i = 0; i < _designVariablesBackupSize; ++i)
+        _designVariablesBackup[i].first->setParameters(
+          _designVariablesBackup[i].second);
     }
 
   }
@@ -20,6 +20,8 @@
 
 #include <utility>
 
+#include <boost/make_shared.hpp>
+
 #include <aslam/backend/DesignVariable.hpp>
 #include <aslam/backend/ErrorTerm.hpp>
 
@@ -35,7 +37,8 @@ namespace aslam {
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
-    OptimizationProblem::OptimizationProblem() {
+    OptimizationProblem::OptimizationProblem() :
+        _arena(boost::make_shared<MemoryArena>()) {
     }
 
     OptimizationProblem::~OptimizationProblem() {
@@ -116,6 +119,11 @@ namespace aslam {
       return _designVariables.count(groupId);
     }
 
+    const OptimizationProblem::MemoryArenaSP& OptimizationProblem::getArena()
+        const {
+      return _arena;
+    }
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
@@ -172,6 +180,8 @@ namespace aslam {
       _errorTerms.clear();
       _groupsOrdering.clear();
       _designVariablesBackup.clear();
+      // objects still referenced keep the previous arena alive
+      _arena = boost::make_shared<MemoryArena>(_arena->getChunkSize());
     }
 
     size_t OptimizationProblem::numDesignVariablesImplementation() const {
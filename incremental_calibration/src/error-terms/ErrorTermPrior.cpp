@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/error-terms/ErrorTermPrior.h"
+
+#include <exception>
+
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    ErrorTermPrior::ErrorTermPrior(const std::vector<DesignVariable*>&
+        designVariables, const Eigen::MatrixXd& R, const Eigen::VectorXd& r) :
+        aslam::backend::ErrorTermDs(R.rows()),
+        _designVariables(designVariables),
+        _R(R),
+        _r(r) {
+      if (R.rows() != r.size())
+        throw OutOfBoundException<size_t>(r.size(), R.rows(),
+          "ErrorTermPrior::ErrorTermPrior(): "
+          "R and r must have the same rows",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      std::ptrdiff_t dim = 0;
+      _linearizationPoints.resize(_designVariables.size());
+      Eigen::VectorXd difference;
+      for (size_t i = 0; i < _designVariables.size(); ++i) {
+        _designVariables[i]->getParameters(_linearizationPoints[i]);
+        dim += _designVariables[i]->minimalDimensions();
+        // the error needs the minimal difference, which is optional
+        bool implemented = true;
+        try {
+          _designVariables[i]->minimalDifference(_linearizationPoints[i],
+            difference);
+        }
+        catch (const std::exception&) {
+          implemented = false;
+        }
+        if (!implemented || difference.size() !=
+            _designVariables[i]->minimalDimensions())
+          throw InvalidOperationException("ErrorTermPrior::ErrorTermPrior(): "
+            "the design variables must implement minimalDifference()",
+            __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      }
+      if (R.cols() != dim)
+        throw OutOfBoundException<size_t>(R.cols(), dim,
+          "ErrorTermPrior::ErrorTermPrior(): "
+          "R must have the dimension of the design variables as columns",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      setInvR(Eigen::MatrixXd::Identity(R.rows(), R.rows()));
+      setDesignVariables(_designVariables);
+    }
+
+    ErrorTermPrior::~ErrorTermPrior() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    const Eigen::MatrixXd& ErrorTermPrior::getR() const {
+      return _R;
+    }
+
+    const Eigen::VectorXd& ErrorTermPrior::getResidual() const {
+      return _r;
+    }
+
+    const std::vector<Eigen::MatrixXd>& ErrorTermPrior::getLinearizationPoints()
+        const {
+      return _linearizationPoints;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    double ErrorTermPrior::evaluateErrorImplementation() {
+      Eigen::VectorXd error = _r;
+      std::ptrdiff_t col = 0;
+      Eigen::VectorXd difference;
+      for (size_t i = 0; i < _designVariables.size(); ++i) {
+        _designVariables[i]->minimalDifference(_linearizationPoints[i],
+          difference);
+        error.noalias() += _R.middleCols(col, difference.size()) * difference;
+        col += difference.size();
+      }
+      setError(error);
+      return error.squaredNorm();
+    }
+
+    void ErrorTermPrior::evaluateJacobiansImplementation(
+        aslam::backend::JacobianContainer& jacobians) {
+      std::ptrdiff_t col = 0;
+      for (size_t i = 0; i < _designVariables.size(); ++i) {
+        const int dim = _designVariables[i]->minimalDimensions();
+        jacobians.add(_designVariables[i], _R.middleCols(col, dim));
+        col += dim;
+      }
+    }
+
+  }
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file BinaryStreamTest.cpp
+    \brief This file tests the BinaryWriter and BinaryReader classes.
+  */
+
+#include <cstdint>
+
+#include <sstream>
+#include <string>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/base/BinaryStream.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testBinaryStream) {
+  const Eigen::MatrixXd M = Eigen::MatrixXd::Random(7, 3);
+  const Eigen::VectorXd v = Eigen::VectorXd::Random(5);
+  std::stringstream stream;
+  BinaryWriter writer(stream);
+  writer.write<uint64_t>(42);
+  writer.write(3.5);
+  writer.write(M);
+  writer.write(v);
+  writer.write(Eigen::MatrixXd(0, 4));
+  ASSERT_EQ(writer.getNumBytes(), 8 * (2 + 2 + 21 + 2 + 5 + 2));
+  ASSERT_EQ(writer.getNumBytes(), stream.str().size());
+
+  // column-major coefficients right after the dimensions
+  const std::string data = stream.str();
+  const double* words = reinterpret_cast<const double*>(data.data());
+  ASSERT_EQ(Eigen::Map<const Eigen::MatrixXd>(words + 4, 7, 3), M);
+
+  BinaryReader reader(stream);
+  ASSERT_EQ(reader.read<uint64_t>(), 42);
+  ASSERT_EQ(reader.read<double>(), 3.5);
+  Eigen::MatrixXd MRead;
+  reader.read(MRead);
+  ASSERT_EQ(MRead, M);
+  Eigen::VectorXd vRead;
+  reader.read(vRead);
+  ASSERT_EQ(vRead, v);
+  reader.read(MRead);
+  ASSERT_EQ(MRead.rows(), 0);
+  ASSERT_EQ(MRead.cols(), 4);
+  ASSERT_EQ(reader.getNumBytes(), writer.getNumBytes());
+  ASSERT_THROW(reader.read<double>(), InvalidOperationException);
+
+  // a matrix record cannot be read as a vector
+  std::stringstream matrixStream;
+  BinaryWriter matrixWriter(matrixStream);
+  matrixWriter.write(M);
+  BinaryReader matrixReader(matrixStream);
+  ASSERT_THROW(matrixReader.read(vRead), InvalidOperationException);
+}
@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ColumnarWriterTest.cpp
+    \brief This file tests the ColumnarWriter class.
+  */
+
+#include <cstdint>
+#include <cstring>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/base/ColumnarWriter.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testColumnarWriter) {
+  const size_t numRows = 10;
+  const size_t chunkSize = 4;
+  const Eigen::MatrixXd values = Eigen::MatrixXd::Random(numRows, 2);
+  std::stringstream stream;
+  {
+    ColumnarWriter writer(stream, chunkSize);
+    writer.addColumn("t", ColumnarWriter::INT64);
+    writer.addColumn("left");
+    writer.addColumn("right");
+    for (size_t i = 0; i < numRows; ++i) {
+      writer.write(static_cast<int64_t>(1000 * i));
+      writer.write(values(i, 0));
+      writer.write(values(i, 1));
+      writer.endRow();
+    }
+    ASSERT_EQ(writer.getNumRows(), numRows);
+    ASSERT_THROW(writer.addColumn("late"), InvalidOperationException);
+    // an incomplete row is kept, its value converted to the column type
+    writer.write(1.0);
+    ASSERT_THROW(writer.endRow(), OutOfBoundException<size_t>);
+    writer.write(2.0);
+    writer.write(3.0);
+    ASSERT_THROW(writer.write(4.0), OutOfBoundException<size_t>);
+    writer.endRow();
+  }
+
+  // header
+  const std::string data = stream.str();
+  ASSERT_EQ(data.size() % 8, 0);
+  const uint64_t* words = reinterpret_cast<const uint64_t*>(data.data());
+  ASSERT_EQ(words[0], ColumnarWriter::magic);
+  ASSERT_EQ(std::string(data.data(), 8), "ASLMCOLS");
+  ASSERT_EQ(words[1], ColumnarWriter::version);
+  ASSERT_EQ(words[2], 3);
+  ASSERT_EQ(words[3], ColumnarWriter::INT64);
+  ASSERT_EQ(words[4], 1);
+  ASSERT_EQ(std::string(data.data() + 5 * 8), "t");
+  ASSERT_EQ(words[6], ColumnarWriter::FLOAT64);
+  ASSERT_EQ(words[7], 4);
+  ASSERT_EQ(std::string(data.data() + 8 * 8, 4), "left");
+  ASSERT_EQ(words[9], ColumnarWriter::FLOAT64);
+  ASSERT_EQ(words[10], 5);
+  ASSERT_EQ(std::string(data.data() + 11 * 8, 5), "right");
+
+  // chunks of contiguous columns, the last one holding the remainder
+  size_t offset = 12;
+  size_t row = 0;
+  while (offset < data.size() / 8) {
+    const size_t rows = words[offset++];
+    ASSERT_LE(rows, chunkSize);
+    for (size_t i = 0; i < rows; ++i)
+      ASSERT_EQ(static_cast<int64_t>(words[offset + i]), row + i < numRows ?
+        static_cast<int64_t>(1000 * (row + i)) : 1);
+    offset += rows;
+    const double* left = reinterpret_cast<const double*>(words + offset);
+    const double* right = left + rows;
+    for (size_t i = 0; i < rows; ++i) {
+      if (row + i < numRows) {
+        ASSERT_EQ(left[i], values(row + i, 0));
+        ASSERT_EQ(right[i], values(row + i, 1));
+      }
+      else {
+        ASSERT_EQ(left[i], 2.0);
+        ASSERT_EQ(right[i], 3.0);
+      }
+    }
+    offset += 2 * rows;
+    row += rows;
+  }
+  ASSERT_EQ(offset, data.size() / 8);
+  ASSERT_EQ(row, numRows + 1);
+
+  // columns inferred from the first row, values converted to their type
+  std::stringstream inferredStream;
+  ColumnarWriter inferred(inferredStream);
+  inferred.setColumnNames(std::vector<std::string>(1, "t"));
+  inferred.write(static_cast<int64_t>(7));
+  inferred.write(0.5);
+  inferred.endRow();
+  inferred.write(8.9);
+  inferred.write(static_cast<int64_t>(2));
+  inferred.endRow();
+  ASSERT_EQ(inferred.getNumColumns(), 2);
+  ASSERT_EQ(inferred.getColumnName(0), "t");
+  ASSERT_EQ(inferred.getColumnName(1), "c1");
+  ASSERT_THROW(inferred.setColumnNames(std::vector<std::string>()),
+    InvalidOperationException);
+  ASSERT_EQ(inferred.getColumnType(0), ColumnarWriter::INT64);
+  ASSERT_EQ(inferred.getColumnType(1), ColumnarWriter::FLOAT64);
+  inferred.flush();
+  const std::string inferredData = inferredStream.str();
+  const uint64_t* inferredWords =
+    reinterpret_cast<const uint64_t*>(inferredData.data());
+  ASSERT_EQ(inferredWords[9], 2);
+  ASSERT_EQ(inferredWords[10], 7);
+  ASSERT_EQ(inferredWords[11], 8);
+  double value;
+  std::memcpy(&value, inferredWords + 13, sizeof(value));
+  ASSERT_EQ(value, 2.0);
+}
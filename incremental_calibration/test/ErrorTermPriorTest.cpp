@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ErrorTermPriorTest.cpp
+    \brief This file tests the ErrorTermPrior class.
+  */
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+#include "aslam/calibration/error-terms/ErrorTermPrior.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+
+namespace {
+
+  // scalar design variable without minimal difference
+  class ScalarDesignVariable :
+    public aslam::backend::DesignVariable {
+  protected:
+    virtual int minimalDimensionsImplementation() const {
+      return 1;
+    }
+    virtual void updateImplementation(const double* dp, int /*size*/) {
+      _oldValue = _value;
+      _value += dp[0];
+    }
+    virtual void revertUpdateImplementation() {
+      _value = _oldValue;
+    }
+    virtual void getParametersImplementation(Eigen::MatrixXd& value) const {
+      value = Eigen::MatrixXd::Constant(1, 1, _value);
+    }
+    virtual void setParametersImplementation(const Eigen::MatrixXd& value) {
+      _value = value(0, 0);
+    }
+    double _value = 0.0;
+    double _oldValue = 0.0;
+  };
+
+}
+
+TEST(AslamCalibrationTestSuite, testErrorTermPrior) {
+  using namespace aslam::calibration;
+
+  VectorDesignVariable<2> dv1(Eigen::Vector2d::Random());
+  dv1.setActive(true);
+  VectorDesignVariable<3> dv2(Eigen::Vector3d::Random());
+  dv2.setActive(true);
+  std::vector<aslam::backend::DesignVariable*> dvs = {&dv1, &dv2};
+  const Eigen::MatrixXd R = Eigen::MatrixXd::Random(4, 5);
+  const Eigen::VectorXd r = Eigen::VectorXd::Random(4);
+  ErrorTermPrior prior(dvs, R, r);
+  ASSERT_EQ(prior.dimension(), 4u);
+
+  // the error is the residual at the linearization point
+  ASSERT_NEAR(prior.evaluateError(), r.squaredNorm(), 1e-12);
+  ASSERT_TRUE(prior.error().isApprox(r));
+
+  // linear in the minimal difference
+  Eigen::VectorXd dx = Eigen::VectorXd::Random(5);
+  dv1.update(dx.data(), 2);
+  dv2.update(dx.data() + 2, 3);
+  prior.evaluateError();
+  ASSERT_TRUE(prior.error().isApprox(r + R * dx));
+
+  // Jacobians are the blocks of R
+  aslam::backend::JacobianContainer J(4);
+  prior.evaluateJacobians(J);
+  for (auto it = J.begin(); it != J.end(); ++it) {
+    if (it->first == &dv1)
+      ASSERT_TRUE(it->second.isApprox(R.leftCols(2)));
+    else if (it->first == &dv2)
+      ASSERT_TRUE(it->second.isApprox(R.rightCols(3)));
+    else
+      FAIL();
+  }
+
+  ASSERT_THROW(ErrorTermPrior(dvs, R, Eigen::VectorXd::Zero(3)),
+    OutOfBoundException<size_t>);
+  ASSERT_THROW(ErrorTermPrior(dvs, Eigen::MatrixXd::Zero(4, 4), r),
+    OutOfBoundException<size_t>);
+
+  // the error needs the minimal difference of all the design variables
+  ScalarDesignVariable dv3;
+  dv3.setActive(true);
+  dvs.push_back(&dv3);
+  ASSERT_THROW(ErrorTermPrior(dvs, Eigen::MatrixXd::Random(4, 6), r),
+    InvalidOperationException);
+}
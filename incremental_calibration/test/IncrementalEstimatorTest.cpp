@@ -0,0 +1,756 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file IncrementalEstimatorTest.cpp
+    \brief This file tests the IncrementalEstimator class.
+  */
+
+#include <cstddef>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+#include "aslam/calibration/core/IncrementalEstimator.h"
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+
+/// Scalar measurement y = s + b * s^2 / 2 + c' * psi with s = a' * theta,
+/// linear in theta unless a curvature b is given
+class LinearErrorTerm :
+  public aslam::backend::ErrorTermFs<1> {
+public:
+  LinearErrorTerm(aslam::calibration::VectorDesignVariable<Eigen::Dynamic>*
+      theta, aslam::calibration::VectorDesignVariable<3>* psi,
+      const Eigen::VectorXd& a, const Eigen::Vector3d& c, double y,
+      double b = 0.0) :
+      _theta(theta),
+      _psi(psi),
+      _a(a.transpose()),
+      _c(c.transpose()),
+      _y(y),
+      _b(b) {
+    setInvR(Eigen::Matrix<double, 1, 1>::Identity());
+    setDesignVariables(theta, psi);
+  }
+  LinearErrorTerm(const LinearErrorTerm& other) = delete;
+  LinearErrorTerm& operator = (const LinearErrorTerm& other) = delete;
+  virtual ~LinearErrorTerm() {};
+protected:
+  virtual double evaluateErrorImplementation() {
+    const double s = _a.dot(_theta->getValue());
+    error_t error;
+    error(0) = _y - s - 0.5 * _b * s * s - _c.dot(_psi->getValue());
+    setError(error);
+    return evaluateChiSquaredError();
+  };
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& J) {
+    const double s = _a.dot(_theta->getValue());
+    J.add(_theta, -(1.0 + _b * s) * _a);
+    J.add(_psi, -_c);
+  };
+  aslam::calibration::VectorDesignVariable<Eigen::Dynamic>* _theta;
+  aslam::calibration::VectorDesignVariable<3>* _psi;
+  Eigen::RowVectorXd _a;
+  Eigen::RowVector3d _c;
+  double _y;
+  double _b;
+};
+
+/// Scalar design variable without minimal difference
+class ScalarDesignVariable :
+  public aslam::backend::DesignVariable {
+public:
+  double getValue() const {
+    return _value;
+  }
+protected:
+  virtual int minimalDimensionsImplementation() const {
+    return 1;
+  }
+  virtual void updateImplementation(const double* dp, int /*size*/) {
+    _oldValue = _value;
+    _value += dp[0];
+  }
+  virtual void revertUpdateImplementation() {
+    _value = _oldValue;
+  }
+  virtual void getParametersImplementation(Eigen::MatrixXd& value) const {
+    value = Eigen::MatrixXd::Constant(1, 1, _value);
+  }
+  virtual void setParametersImplementation(const Eigen::MatrixXd& value) {
+    _value = value(0, 0);
+  }
+  double _value = 0.0;
+  double _oldValue = 0.0;
+};
+
+/// Scalar measurement y = a * x + c' * psi of a scalar design variable
+class ScalarErrorTerm :
+  public aslam::backend::ErrorTermFs<1> {
+public:
+  ScalarErrorTerm(ScalarDesignVariable* x,
+      aslam::calibration::VectorDesignVariable<3>* psi, double a,
+      const Eigen::Vector3d& c, double y) :
+      _x(x),
+      _psi(psi),
+      _a(a),
+      _c(c.transpose()),
+      _y(y) {
+    setInvR(Eigen::Matrix<double, 1, 1>::Identity());
+    setDesignVariables(x, psi);
+  }
+  ScalarErrorTerm(const ScalarErrorTerm& other) = delete;
+  ScalarErrorTerm& operator = (const ScalarErrorTerm& other) = delete;
+  virtual ~ScalarErrorTerm() {};
+protected:
+  virtual double evaluateErrorImplementation() {
+    error_t error;
+    error(0) = _y - _a * _x->getValue() - _c.dot(_psi->getValue());
+    setError(error);
+    return evaluateChiSquaredError();
+  };
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& J) {
+    J.add(_x, -_a * Eigen::Matrix<double, 1, 1>::Identity());
+    J.add(_psi, -_c);
+  };
+  ScalarDesignVariable* _x;
+  aslam::calibration::VectorDesignVariable<3>* _psi;
+  double _a;
+  Eigen::RowVector3d _c;
+  double _y;
+};
+
+
+using namespace aslam::calibration;
+
+/// Theta design variable (shared pointer)
+typedef boost::shared_ptr<VectorDesignVariable<Eigen::Dynamic> > ThetaSP;
+/// Nuisance design variable (shared pointer)
+typedef boost::shared_ptr<VectorDesignVariable<3> > PsiSP;
+
+/// Measurements y = s + b * s^2 / 2 + c' * psi, s = a' * theta, of a batch
+struct LinearMeasurements {
+  std::vector<Eigen::VectorXd> a;
+  std::vector<Eigen::Vector3d> c;
+  std::vector<double> y;
+  double b;
+};
+
+/// Creates an active theta design variable initialized at zero
+ThetaSP createTheta(size_t dim) {
+  auto theta = boost::make_shared<VectorDesignVariable<Eigen::Dynamic> >(
+    Eigen::VectorXd::Zero(dim));
+  theta->setActive(true);
+  return theta;
+}
+
+/// Creates an active nuisance design variable
+PsiSP createPsi() {
+  auto psi = boost::make_shared<VectorDesignVariable<3> >();
+  psi->setActive(true);
+  return psi;
+}
+
+/// Generates measurements of theta, uninformative ones have a = 0
+LinearMeasurements createMeasurements(const Eigen::VectorXd& thetaTrue,
+    size_t numMeasurements, double noise = 0.0, bool informative = true,
+    double curvature = 0.0) {
+  LinearMeasurements measurements;
+  measurements.b = curvature;
+  const Eigen::Vector3d psiTrue = Eigen::Vector3d::Random();
+  for (size_t j = 0; j < numMeasurements; ++j) {
+    measurements.a.push_back(informative ?
+      Eigen::VectorXd(Eigen::VectorXd::Random(thetaTrue.size())) :
+      Eigen::VectorXd(Eigen::VectorXd::Zero(thetaTrue.size())));
+    measurements.c.push_back(Eigen::Vector3d::Random());
+    const double s = measurements.a.back().dot(thetaTrue);
+    measurements.y.push_back(s + 0.5 * curvature * s * s +
+      measurements.c.back().dot(psiTrue) +
+      noise * Eigen::VectorXd::Random(1)(0));
+  }
+  return measurements;
+}
+
+/// Creates a batch of measurements, with new nuisance variables if none given
+IncrementalEstimator::BatchSP createBatch(const ThetaSP& theta,
+    const LinearMeasurements& measurements, PsiSP psi = PsiSP()) {
+  if (!psi)
+    psi = createPsi();
+  auto batch = boost::make_shared<OptimizationProblem>();
+  batch->addDesignVariable(theta, 1);
+  batch->addDesignVariable(psi, 0);
+  for (size_t j = 0; j < measurements.a.size(); ++j)
+    batch->addErrorTerm(boost::make_shared<LinearErrorTerm>(theta.get(),
+      psi.get(), measurements.a[j], measurements.c[j], measurements.y[j],
+      measurements.b));
+  return batch;
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorMarginalResults) {
+  const size_t numBatches = 3;
+  for (size_t dim = 100; dim <= 500; dim += 100) {
+    const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+    auto theta = createTheta(dim);
+    IncrementalEstimator estimator(1);
+    size_t numAccepted = 0;
+    for (size_t i = 0; i < numBatches; ++i) {
+      auto batch = createBatch(theta,
+        createMeasurements(thetaTrue, dim / 2 + 10));
+      auto marginal = estimator.getMarginalResults();
+      const IncrementalEstimator::ReturnValue ret =
+        estimator.addBatch(batch);
+      ASSERT_TRUE(ret.marginal);
+      if (ret.batchAccepted) {
+        // the accepted results are published, not duplicated
+        ++numAccepted;
+        ASSERT_EQ(ret.marginal, estimator.getMarginalResults());
+        ASSERT_EQ(&ret.marginal->sigma2Theta, &estimator.getSigma2Theta());
+      }
+      else
+        ASSERT_EQ(marginal, estimator.getMarginalResults());
+    }
+    ASSERT_GE(numAccepted, 1);
+    const IncrementalEstimator::MarginalResultsCSP marginal =
+      estimator.getMarginalResults();
+    ASSERT_EQ(static_cast<size_t>(marginal->sigma2Theta.rows()), dim);
+    ASSERT_EQ(static_cast<size_t>(marginal->singularValues.size()), dim);
+
+    const IncrementalEstimator::MarginalResults copy = *marginal;
+    ASSERT_EQ(copy.sigma2Theta, marginal->sigma2Theta);
+
+    // the snapshot outlives the estimator state it was taken from
+    const IncrementalEstimator::ReturnValue ret = estimator.reoptimize();
+    ASSERT_EQ(ret.marginal, estimator.getMarginalResults());
+    ASSERT_EQ(marginal->sigma2Theta, copy.sigma2Theta);
+  }
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorRelinearization) {
+  const size_t dim = 10;
+  const size_t numBatches = 5;
+  const double curvature = 0.5;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+
+  // same batches for the full analysis, the incremental one relinearized at
+  // every batch and the incremental one never relinearized
+  auto thetaFull = createTheta(dim);
+  auto thetaRelinearized = createTheta(dim);
+  auto thetaStale = createTheta(dim);
+  IncrementalEstimator::OptimizerOptions optimizerOptions;
+  optimizerOptions.convergenceDeltaX = 1e-12;
+  optimizerOptions.convergenceDeltaJ = 1e-14;
+  optimizerOptions.maxIterations = 50;
+  IncrementalEstimator::Options options;
+  IncrementalEstimator full(1, options,
+    LinearSolverOptions(), optimizerOptions);
+  options.incrementalMarginal = true;
+  options.marginalRelinearizationThreshold = 0.0;
+  IncrementalEstimator relinearized(1, options,
+    LinearSolverOptions(), optimizerOptions);
+  options.marginalRelinearizationThreshold =
+    std::numeric_limits<double>::infinity();
+  IncrementalEstimator stale(1, options,
+    LinearSolverOptions(), optimizerOptions);
+  for (size_t i = 0; i < numBatches; ++i) {
+    const LinearMeasurements measurements =
+      createMeasurements(thetaTrue, dim + 5, 1e-1, true, curvature);
+    full.addBatch(createBatch(thetaFull, measurements), true);
+    relinearized.addBatch(createBatch(thetaRelinearized, measurements), true);
+    stale.addBatch(createBatch(thetaStale, measurements), true);
+
+    // theta moves with each batch, the folded rows must follow it
+    ASSERT_TRUE(thetaRelinearized->getValue().isApprox(thetaFull->getValue(),
+      1e-9));
+    ASSERT_TRUE(relinearized.getSigma2Theta().isApprox(full.getSigma2Theta(),
+      1e-6));
+    ASSERT_EQ(relinearized.getRankTheta(), full.getRankTheta());
+  }
+
+  // the rows folded at older estimates drift away from the full analysis
+  ASSERT_TRUE(thetaStale->getValue().isApprox(thetaFull->getValue(), 1e-9));
+  ASSERT_GT((stale.getSigma2Theta() - full.getSigma2Theta()).norm(),
+    (relinearized.getSigma2Theta() - full.getSigma2Theta()).norm());
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorEviction) {
+  const size_t dim = 10;
+  const size_t numBatches = 6;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+
+  // same noisy batches for a windowed and an unbounded estimator
+  auto thetaWindow = createTheta(dim);
+  auto thetaFull = createTheta(dim);
+  IncrementalEstimator::Options options;
+  options.maxNumBatches = 2;
+  IncrementalEstimator window(1, options);
+  IncrementalEstimator full(1);
+  for (size_t i = 0; i < numBatches; ++i) {
+    const LinearMeasurements measurements =
+      createMeasurements(thetaTrue, dim, 1e-2);
+    auto batchWindow = createBatch(thetaWindow, measurements);
+    auto batchFull = createBatch(thetaFull, measurements);
+    const IncrementalEstimator::ReturnValue ret =
+      window.addBatch(batchWindow, true);
+    full.addBatch(batchFull, true);
+    ASSERT_EQ(ret.numEvictedBatches, i < 2 ? 0u : 1u);
+  }
+
+  // two batches and the prior are left, the evicted information is kept
+  ASSERT_EQ(window.getNumBatches(), 3u);
+  ASSERT_EQ(window.getNumEvictedBatches(), numBatches - 2);
+  ASSERT_TRUE(window.getPriorBatch());
+  ASSERT_EQ(window.getPriorBatch()->numErrorTerms(), 1u);
+  ASSERT_EQ(full.getNumBatches(), numBatches);
+  ASSERT_TRUE(thetaWindow->getValue().isApprox(thetaFull->getValue(), 1e-6));
+  ASSERT_TRUE(window.getSigma2Theta().isApprox(full.getSigma2Theta(), 1e-6));
+  ASSERT_EQ(window.getRankTheta(), full.getRankTheta());
+
+  // removing the prior forgets the evicted batches
+  window.removeBatch(window.getPriorBatch());
+  ASSERT_FALSE(window.getPriorBatch());
+  ASSERT_EQ(window.getNumBatches(), 2u);
+}
+
+TEST(AslamCalibrationTestSuite,
+    testIncrementalEstimatorEvictionMinimalDifference) {
+  IncrementalEstimator::Options options;
+  options.maxNumBatches = 1;
+  IncrementalEstimator estimator(1, options);
+  auto x = boost::make_shared<ScalarDesignVariable>();
+  x->setActive(true);
+  auto createScalarBatch = [&]() {
+    auto psi = createPsi();
+    auto batch = boost::make_shared<OptimizationProblem>();
+    batch->addDesignVariable(x, 1);
+    batch->addDesignVariable(psi, 0);
+    for (size_t j = 0; j < 10; ++j)
+      batch->addErrorTerm(boost::make_shared<ScalarErrorTerm>(x.get(),
+        psi.get(), Eigen::VectorXd::Random(1)(0), Eigen::Vector3d::Random(),
+        Eigen::VectorXd::Random(1)(0)));
+    return batch;
+  };
+  estimator.addBatch(createScalarBatch(), true);
+
+  // the prior cannot be evaluated, the batches are left in the problem
+  ASSERT_THROW(estimator.addBatch(createScalarBatch(), true),
+    InvalidOperationException);
+  ASSERT_EQ(estimator.getNumBatches(), 2u);
+  ASSERT_EQ(estimator.getNumEvictedBatches(), 0u);
+  ASSERT_FALSE(estimator.getPriorBatch());
+}
+
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorCheckpoint) {
+  const size_t dim = 200;
+  const size_t numBatches = 4;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+
+  auto theta = createTheta(dim);
+  IncrementalEstimator estimator(1);
+  for (size_t i = 0; i < numBatches; ++i)
+    estimator.addBatch(createBatch(theta,
+      createMeasurements(thetaTrue, dim / 2 + 10, 1e-2)), true);
+
+  std::stringstream stream;
+  estimator.writeCheckpoint(stream);
+
+  // restore into a fresh estimator and fresh design variables
+  auto thetaRestored =
+    boost::make_shared<VectorDesignVariable<Eigen::Dynamic> >(
+    Eigen::VectorXd::Zero(dim));
+  IncrementalEstimator restored(1);
+  restored.readCheckpoint(stream,
+    IncrementalEstimator::DesignVariablesSP(1, thetaRestored));
+  ASSERT_TRUE(thetaRestored->isActive());
+  ASSERT_EQ(thetaRestored->getValue(), theta->getValue());
+  ASSERT_EQ(restored.getNumBatches(), 1u);
+  ASSERT_EQ(restored.getNumEvictedBatches(), numBatches);
+  ASSERT_EQ(restored.getRankTheta(), estimator.getRankTheta());
+  ASSERT_EQ(restored.getFinalCost(), estimator.getFinalCost());
+  ASSERT_EQ(restored.getSigma2Theta(), estimator.getSigma2Theta());
+  ASSERT_EQ(restored.getSingularValues(), estimator.getSingularValues());
+  ASSERT_EQ(restored.getPeakMemoryUsage(), 0u);
+  ASSERT_EQ(restored.getMemoryUsage(), 0u);
+  ASSERT_EQ(restored.getNumFlops(), 0.0);
+
+  // both estimators continue identically
+  const LinearMeasurements measurements =
+    createMeasurements(thetaTrue, dim / 2 + 10, 1e-2);
+  estimator.addBatch(createBatch(theta, measurements), true);
+  restored.addBatch(createBatch(thetaRestored, measurements), true);
+  ASSERT_TRUE(thetaRestored->getValue().isApprox(theta->getValue(), 1e-6));
+  ASSERT_TRUE(restored.getSigma2Theta().isApprox(estimator.getSigma2Theta(),
+    1e-6));
+
+  // a checkpoint is only restored into an empty estimator
+  std::stringstream other;
+  estimator.writeCheckpoint(other);
+  ASSERT_THROW(restored.readCheckpoint(other,
+    IncrementalEstimator::DesignVariablesSP(1, thetaRestored)),
+    InvalidOperationException);
+  IncrementalEstimator empty(1);
+  std::stringstream garbage("garbage");
+  ASSERT_THROW(empty.readCheckpoint(garbage,
+    IncrementalEstimator::DesignVariablesSP(1, thetaRestored)),
+    InvalidOperationException);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorScoreBatches) {
+  const size_t dim = 20;
+  const size_t numCandidates = 6;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+  auto theta = createTheta(dim);
+  IncrementalEstimator estimator(1);
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, dim / 2)), true);
+
+  // the last two candidates share their nuisance variables
+  std::vector<IncrementalEstimator::BatchSP> candidates;
+  for (size_t i = 0; i + 1 < numCandidates; ++i)
+    candidates.push_back(createBatch(theta,
+      createMeasurements(thetaTrue, (i + 1) * dim / 4)));
+  auto sharedPsi = candidates.back()->getDesignVariablesGroup(0).front();
+  candidates.push_back(createBatch(theta, createMeasurements(thetaTrue, dim),
+    boost::dynamic_pointer_cast<VectorDesignVariable<3> >(sharedPsi)));
+
+  // concurrent scoring matches the serial one and leaves the state untouched
+  const Eigen::VectorXd thetaValue = theta->getValue();
+  estimator.getOptions().scoringThreads = 1;
+  const std::vector<IncrementalEstimator::ReturnValue> serial =
+    estimator.scoreBatches(candidates);
+  estimator.getOptions().scoringThreads = 4;
+  const std::vector<IncrementalEstimator::ReturnValue> concurrent =
+    estimator.scoreBatches(candidates);
+  ASSERT_EQ(theta->getValue(), thetaValue);
+  ASSERT_EQ(estimator.getNumBatches(), 1u);
+  ASSERT_EQ(concurrent.size(), numCandidates);
+  for (size_t i = 0; i < numCandidates; ++i) {
+    ASSERT_FALSE(concurrent[i].batchAccepted);
+    ASSERT_EQ(static_cast<bool>(concurrent[i].marginal), i + 2 <
+      numCandidates);
+    ASSERT_NEAR(concurrent[i].informationGain, serial[i].informationGain,
+      1e-12);
+    ASSERT_EQ(concurrent[i].rankTheta, serial[i].rankTheta);
+  }
+  ASSERT_GT(concurrent[3].informationGain, concurrent[0].informationGain);
+  ASSERT_EQ(concurrent[3].rankTheta, static_cast<std::ptrdiff_t>(dim));
+
+  // committing the candidates reports them in the input order
+  const std::vector<IncrementalEstimator::ReturnValue> rets =
+    estimator.addBatches(candidates);
+  ASSERT_EQ(rets.size(), numCandidates);
+  size_t numAccepted = 0;
+  for (auto it = rets.cbegin(); it != rets.cend(); ++it)
+    numAccepted += it->batchAccepted;
+  ASSERT_GE(numAccepted, 1u);
+  ASSERT_EQ(estimator.getNumBatches(), numAccepted + 1);
+  ASSERT_EQ(estimator.getRankTheta(), static_cast<std::ptrdiff_t>(dim));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorAddBatchesRescoring) {
+  const size_t dim = 3;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+  auto theta = createTheta(dim);
+  IncrementalEstimator::Options options;
+  options.preScreening = true;
+  IncrementalEstimator estimator(1, options);
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, 4 * dim)), true);
+
+  // the curvature cancels the Jacobian on theta at the current estimate,
+  // the measurements are taken at an estimate moved along a
+  const Eigen::VectorXd a = theta->getValue().normalized();
+  const Eigen::VectorXd thetaMoved = theta->getValue() + a;
+  const double s = a.dot(thetaMoved);
+  const Eigen::Vector3d psiTrue = Eigen::Vector3d::Random();
+  LinearMeasurements measurements;
+  measurements.b = -1.0 / a.dot(theta->getValue());
+  for (size_t j = 0; j < 100 * dim; ++j) {
+    measurements.a.push_back(a);
+    measurements.c.push_back(Eigen::Vector3d::Random());
+    measurements.y.push_back(s + 0.5 * measurements.b * s * s +
+      measurements.c.back().dot(psiTrue));
+  }
+  std::vector<IncrementalEstimator::BatchSP> candidates;
+  candidates.push_back(createBatch(theta, measurements));
+  candidates.push_back(createBatch(theta,
+    createMeasurements(thetaMoved, 20 * dim)));
+
+  // scored at the current estimate, the first candidate is useless
+  const std::vector<IncrementalEstimator::ReturnValue> scores =
+    estimator.scoreBatches(candidates);
+  ASSERT_TRUE(scores[0].marginal);
+  ASSERT_LE(scores[0].informationGain, options.preScreeningInfoGainDelta);
+  ASSERT_LE(scores[0].rankTheta, estimator.getRankTheta());
+  ASSERT_GT(scores[1].informationGain, scores[0].informationGain);
+
+  // once the second candidate moved theta, the first one is informative
+  const std::vector<IncrementalEstimator::ReturnValue> rets =
+    estimator.addBatches(candidates);
+  ASSERT_TRUE(rets[1].batchAccepted);
+  ASSERT_FALSE(rets[0].preScreened);
+  ASSERT_GT(rets[0].informationGain, options.preScreeningInfoGainDelta);
+  ASSERT_TRUE(rets[0].batchAccepted);
+  ASSERT_EQ(estimator.getNumBatches(), 3u);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorRollback) {
+  const size_t dim = 10;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+  auto theta = createTheta(dim);
+  IncrementalEstimator estimator(1);
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, 2 * dim)), true);
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, 2 * dim)), true);
+  cholmod_sparse view;
+  estimator.getLinearSolver()->getJacobianTransposeView(&view);
+  const size_t nnz = view.nzmax;
+  const std::vector<std::ptrdiff_t> rowIdx(
+    static_cast<const std::ptrdiff_t*>(view.i),
+    static_cast<const std::ptrdiff_t*>(view.i) + nnz);
+  const std::vector<double> values(static_cast<const double*>(view.x),
+    static_cast<const double*>(view.x) + nnz);
+  const Eigen::VectorXd thetaValue = theta->getValue();
+  const int thetaBlockIndex = theta->blockIndex();
+  const int thetaColumnBase = theta->columnBase();
+
+  // a batch without information on theta is rolled back to the same system
+  const IncrementalEstimator::ReturnValue ret =
+    estimator.addBatch(createBatch(theta,
+      createMeasurements(thetaTrue, 2 * dim, 0.0, false)));
+  ASSERT_FALSE(ret.batchAccepted);
+  ASSERT_EQ(estimator.getNumBatches(), 2u);
+  ASSERT_EQ(theta->getValue(), thetaValue);
+  ASSERT_EQ(theta->blockIndex(), thetaBlockIndex);
+  ASSERT_EQ(theta->columnBase(), thetaColumnBase);
+  estimator.getLinearSolver()->getJacobianTransposeView(&view);
+  ASSERT_EQ(view.nzmax, nnz);
+  ASSERT_TRUE(std::equal(rowIdx.begin(), rowIdx.end(),
+    static_cast<const std::ptrdiff_t*>(view.i)));
+  ASSERT_TRUE(std::equal(values.begin(), values.end(),
+    static_cast<const double*>(view.x)));
+
+  // the next batch builds on the restored system
+  const IncrementalEstimator::ReturnValue next =
+    estimator.addBatch(createBatch(theta,
+      createMeasurements(thetaTrue, 2 * dim)), true);
+  ASSERT_TRUE(next.batchAccepted);
+  ASSERT_EQ(estimator.getNumBatches(), 3u);
+  ASSERT_EQ(estimator.getRankTheta(), static_cast<std::ptrdiff_t>(dim));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorPreScreening) {
+  const size_t dim = 10;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+
+  // same batches for a pre-screening and a plain estimator
+  auto thetaScreened = createTheta(dim);
+  auto thetaPlain = createTheta(dim);
+  IncrementalEstimator::Options options;
+  options.preScreening = true;
+  IncrementalEstimator screened(1, options);
+  IncrementalEstimator plain(1);
+  for (size_t i = 0; i < 2; ++i) {
+    const LinearMeasurements measurements =
+      createMeasurements(thetaTrue, 2 * dim);
+    screened.addBatch(createBatch(thetaScreened, measurements), true);
+    plain.addBatch(createBatch(thetaPlain, measurements), true);
+  }
+  const size_t nnz = screened.getLinearSolver()->getJacobianNnz();
+  const Eigen::VectorXd thetaValue = thetaScreened->getValue();
+
+  // a batch without information on theta is rejected before the solve
+  const LinearMeasurements measurements =
+    createMeasurements(thetaTrue, 2 * dim, 0.0, false);
+  const IncrementalEstimator::ReturnValue retScreened =
+    screened.addBatch(createBatch(thetaScreened, measurements));
+  const IncrementalEstimator::ReturnValue retPlain =
+    plain.addBatch(createBatch(thetaPlain, measurements));
+  ASSERT_TRUE(retScreened.preScreened);
+  ASSERT_FALSE(retPlain.preScreened);
+  ASSERT_EQ(retScreened.numIterations, 0u);
+  ASSERT_EQ(retScreened.insertionTime, 0.0);
+  ASSERT_EQ(retScreened.linearSolverTime, 0.0);
+  ASSERT_EQ(screened.getLinearSolver()->getJacobianNnz(), nnz);
+
+  // the outcome matches the rejection after the full solve
+  ASSERT_FALSE(retScreened.batchAccepted);
+  ASSERT_FALSE(retPlain.batchAccepted);
+  ASSERT_NEAR(retScreened.informationGain, retPlain.informationGain, 1e-8);
+  ASSERT_EQ(retScreened.rankTheta, retPlain.rankTheta);
+  ASSERT_EQ(retScreened.rankThetaDeficiency, retPlain.rankThetaDeficiency);
+  ASSERT_TRUE(retScreened.marginal);
+  ASSERT_TRUE(retScreened.marginal->sigma2Theta.isApprox(
+    retPlain.marginal->sigma2Theta, 1e-6));
+  ASSERT_EQ(retScreened.JFinal, screened.getFinalCost());
+  ASSERT_EQ(retScreened.numErrorTerms, 4 * dim);
+  ASSERT_EQ(retScreened.jacobianNnz, nnz);
+  ASSERT_EQ(screened.getNumBatches(), plain.getNumBatches());
+  ASSERT_EQ(thetaScreened->getValue(), thetaValue);
+  ASSERT_TRUE(thetaScreened->getValue().isApprox(thetaPlain->getValue(),
+    1e-12));
+  ASSERT_EQ(screened.getRankTheta(), plain.getRankTheta());
+  ASSERT_TRUE(screened.getSigma2Theta().isApprox(plain.getSigma2Theta(),
+    1e-12));
+  ASSERT_NEAR(screened.getFinalCost(), plain.getFinalCost(), 1e-8);
+
+  // an informative batch still goes through the full solve
+  const IncrementalEstimator::ReturnValue next = screened.addBatch(
+    createBatch(thetaScreened, createMeasurements(thetaTrue, 2 * dim)));
+  ASSERT_FALSE(next.preScreened);
+  ASSERT_GT(next.numIterations, 0u);
+  ASSERT_TRUE(next.batchAccepted);
+  ASSERT_EQ(screened.getNumBatches(), 3u);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorStatistics) {
+  const size_t dim = 10;
+  const size_t numMeasurements = 2 * dim;
+  const size_t numBatches = 3;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+  auto theta = createTheta(dim);
+  IncrementalEstimator estimator(1);
+  for (size_t i = 0; i < numBatches; ++i) {
+    const IncrementalEstimator::ReturnValue ret = estimator.addBatch(
+      createBatch(theta, createMeasurements(thetaTrue, numMeasurements)),
+      true);
+
+    // the counters describe the whole problem after this batch
+    ASSERT_EQ(ret.numErrorTerms, (i + 1) * numMeasurements);
+    ASSERT_EQ(ret.numDesignVariables, i + 2);
+    // each error term touches theta and its own 3 nuisances
+    ASSERT_EQ(ret.jacobianNnz, (i + 1) * numMeasurements * (dim + 3));
+    ASSERT_EQ(ret.jacobianNnz, estimator.getLinearSolver()->getJacobianNnz());
+    ASSERT_GT(ret.numFlops, 0.0);
+    ASSERT_EQ(ret.numFlops, estimator.getNumFlops());
+    ASSERT_EQ(ret.numFlops, estimator.getLinearSolver()->getNumFlops());
+
+    // the stage timings only cover this batch
+    ASSERT_GT(ret.elapsedTime, 0.0);
+    ASSERT_GE(ret.jacobianTime, 0.0);
+    ASSERT_GE(ret.linearSolverTime, 0.0);
+    ASSERT_GE(ret.optimizationTime, 0.0);
+    ASSERT_GE(ret.insertionTime, 0.0);
+    ASSERT_GE(ret.orderingTime, 0.0);
+    ASSERT_GE(ret.marginalAnalysisTime, 0.0);
+    ASSERT_EQ(ret.preScreeningTime, 0.0);
+    ASSERT_EQ(ret.rollbackTime, 0.0);
+    ASSERT_LE(ret.insertionTime + ret.orderingTime + ret.jacobianTime +
+      ret.linearSolverTime + ret.optimizationTime + ret.marginalAnalysisTime +
+      ret.evictionTime, ret.elapsedTime + 1e-6);
+    ASSERT_EQ(ret.linearSolverTime,
+      estimator.getLinearSolver()->getSolveTime());
+    ASSERT_EQ(ret.jacobianTime,
+      estimator.getLinearSolver()->getJacobianTime());
+  }
+
+  // the solver timings are reset explicitly and before each optimization
+  estimator.getLinearSolver()->resetTimings();
+  ASSERT_EQ(estimator.getLinearSolver()->getSolveTime(), 0.0);
+  ASSERT_EQ(estimator.getLinearSolver()->getJacobianTime(), 0.0);
+  const IncrementalEstimator::ReturnValue ret = estimator.reoptimize();
+  ASSERT_EQ(ret.insertionTime, 0.0);
+  ASSERT_EQ(ret.rollbackTime, 0.0);
+  ASSERT_GE(ret.linearSolverTime, 0.0);
+  ASSERT_EQ(ret.linearSolverTime,
+    estimator.getLinearSolver()->getSolveTime());
+  ASSERT_EQ(ret.numErrorTerms, numBatches * numMeasurements);
+  ASSERT_EQ(ret.jacobianNnz, numBatches * numMeasurements * (dim + 3));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorSchurElimination) {
+  const size_t numBatches = 4;
+  for (size_t dim = 10; dim <= 160; dim *= 2) {
+    const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+
+    // same batches for the plain SPQR path and the eliminated nuisances
+    auto thetaSpqr = createTheta(dim);
+    auto thetaSchur = createTheta(dim);
+    IncrementalEstimator spqr(1);
+    IncrementalEstimator schur(1);
+    spqr.getLinearSolver()->setSchurElimination(false);
+    schur.getLinearSolver()->setSchurElimination(true);
+    for (size_t i = 0; i < numBatches; ++i) {
+      const LinearMeasurements measurements =
+        createMeasurements(thetaTrue, dim / 2 + 10, 1e-2);
+      const IncrementalEstimator::ReturnValue retSpqr =
+        spqr.addBatch(createBatch(thetaSpqr, measurements), true);
+      const IncrementalEstimator::ReturnValue retSchur =
+        schur.addBatch(createBatch(thetaSchur, measurements), true);
+      ASSERT_FALSE(spqr.getLinearSolver()->isSchurEliminationApplied());
+      ASSERT_TRUE(schur.getLinearSolver()->isSchurEliminationApplied());
+
+      // each batch has its own nuisances, the blocks are all eliminated
+      ASSERT_EQ(retSchur.rankPsi, retSpqr.rankPsi);
+      ASSERT_EQ(retSchur.rankPsiDeficiency, 0);
+      ASSERT_EQ(retSchur.rankTheta, retSpqr.rankTheta);
+      ASSERT_TRUE(thetaSchur->getValue().isApprox(thetaSpqr->getValue(),
+        1e-6));
+      ASSERT_TRUE(retSchur.marginal->singularValues.isApprox(
+        retSpqr.marginal->singularValues, 1e-6));
+      ASSERT_TRUE(schur.getSigma2Theta().isApprox(spqr.getSigma2Theta(),
+        1e-6));
+    }
+  }
+}
+
+TEST(AslamCalibrationTestSuite,
+    testIncrementalEstimatorSymbolicFactorization) {
+  const size_t dim = 20;
+  const Eigen::VectorXd thetaTrue = Eigen::VectorXd::Random(dim);
+  auto theta = createTheta(dim);
+  IncrementalEstimator estimator(1);
+  ASSERT_EQ(estimator.getNumSymbolicFactorizations(), 0);
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, dim, 1e-2)), true);
+  const size_t numSymbolicFactorizations =
+    estimator.getNumSymbolicFactorizations();
+  ASSERT_GE(numSymbolicFactorizations, 1);
+  ASSERT_EQ(estimator.getNumSymbolicFactorizations(),
+    estimator.getLinearSolver()->getNumSymbolicFactorizations());
+
+  // repeated solves on an unchanged pattern reuse the factorization
+  estimator.reoptimize();
+  estimator.reoptimize();
+  ASSERT_EQ(estimator.getNumSymbolicFactorizations(),
+    numSymbolicFactorizations);
+
+  // new nuisance columns change the pattern
+  estimator.addBatch(createBatch(theta,
+    createMeasurements(thetaTrue, dim, 1e-2)), true);
+  ASSERT_GT(estimator.getNumSymbolicFactorizations(),
+    numSymbolicFactorizations);
+}
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file IncrementalMarginalAnalyzerTest.cpp
+    \brief This file tests the IncrementalMarginalAnalyzer class.
+  */
+
+#include <cmath>
+#include <cstddef>
+
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/core/IncrementalMarginalAnalyzer.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+TEST(AslamCalibrationTestSuite, testIncrementalMarginalAnalyzer) {
+  using namespace aslam::calibration;
+
+  const size_t numBatches = 5;
+  const size_t numRows = 30;
+  const size_t psiDim = 6;
+  const size_t thetaDim = 4;
+
+  // block-angular Jacobian, theta_3 only observable in the last batch
+  std::vector<Eigen::MatrixXd> Jpsis, Jthetas;
+  for (size_t i = 0; i < numBatches; ++i) {
+    Jpsis.push_back(Eigen::MatrixXd::Random(numRows, psiDim));
+    Jthetas.push_back(Eigen::MatrixXd::Random(numRows, thetaDim));
+    if (i + 1 < numBatches)
+      Jthetas.back().col(thetaDim - 1).setZero();
+  }
+  // one rank deficient nuisance block
+  Jpsis[1].col(2) = Jpsis[1].col(0) + Jpsis[1].col(1);
+
+  // full recomputation from the stacked Jacobian
+  Eigen::MatrixXd Jpsi = Eigen::MatrixXd::Zero(numBatches * numRows,
+    numBatches * psiDim);
+  Eigen::MatrixXd Jtheta(numBatches * numRows, thetaDim);
+  for (size_t i = 0; i < numBatches; ++i) {
+    Jpsi.block(i * numRows, i * psiDim, numRows, psiDim) = Jpsis[i];
+    Jtheta.middleRows(i * numRows, numRows) = Jthetas[i];
+  }
+  IncrementalMarginalAnalyzer full(thetaDim);
+  full.addBatch(Jpsi, Jtheta);
+  full.analyze();
+
+  // incremental path
+  IncrementalMarginalAnalyzer incremental(thetaDim);
+  for (size_t i = 0; i + 1 < numBatches; ++i)
+    incremental.addBatch(Jpsis[i], Jthetas[i]);
+  incremental.analyze();
+  ASSERT_EQ(incremental.getSVDRank(), thetaDim - 1);
+  ASSERT_EQ(incremental.getSVDRankDeficiency(), 1);
+  ASSERT_NEAR(std::fabs(incremental.getNullSpace()(thetaDim - 1, 0)), 1.0,
+    1e-9);
+  incremental.addBatch(Jpsis.back(), Jthetas.back());
+  incremental.analyze();
+
+  // both paths against the Schur complement of the normal equations
+  const Eigen::JacobiSVD<Eigen::MatrixXd> svd(Jpsi, Eigen::ComputeThinU);
+  size_t rankPsi = 0;
+  while (rankPsi < numBatches * psiDim && svd.singularValues()(rankPsi) >
+      1e-9 * svd.singularValues()(0))
+    ++rankPsi;
+  ASSERT_EQ(rankPsi, numBatches * psiDim - 1);
+  const Eigen::MatrixXd U = svd.matrixU().leftCols(rankPsi);
+  const Eigen::MatrixXd Atheta = Jtheta - U * (U.transpose() * Jtheta);
+  const Eigen::MatrixXd schur = Atheta.transpose() * Atheta;
+  ASSERT_TRUE((full.getR().transpose() * full.getR()).isApprox(schur, 1e-9));
+  ASSERT_TRUE((incremental.getR().transpose() * incremental.getR()).isApprox(
+    schur, 1e-9));
+
+  ASSERT_EQ(incremental.getQRRank(), full.getQRRank());
+  ASSERT_EQ(incremental.getQRRankDeficiency(), 1);
+  ASSERT_EQ(incremental.getSVDRank(), full.getSVDRank());
+  ASSERT_EQ(incremental.getSVDRank(), thetaDim);
+  ASSERT_TRUE(incremental.getSingularValues().isApprox(
+    full.getSingularValues(), 1e-9));
+  ASSERT_NEAR(incremental.getSingularValuesLog2Sum(),
+    full.getSingularValuesLog2Sum(), 1e-9);
+  ASSERT_TRUE(incremental.getCovariance().isApprox(full.getCovariance(),
+    1e-9));
+  ASSERT_TRUE(incremental.getCovariance().isApprox(schur.inverse(), 1e-9));
+
+  ASSERT_THROW(incremental.addBatch(Jpsis[0], Eigen::MatrixXd::Zero(numRows,
+    thetaDim + 1)), OutOfBoundException<size_t>);
+  ASSERT_THROW(incremental.addBatch(Jpsis[0], Eigen::MatrixXd::Zero(
+    numRows + 1, thetaDim)), OutOfBoundException<size_t>);
+}
@@ -20,6 +20,9 @@
     \brief This file tests the IncrementalOptimizationProblem class.
   */
 
+#include <iostream>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 
@@ -33,6 +36,7 @@
 #include "aslam/calibration/data-structures/VectorDesignVariable.h"
 #include "aslam/calibration/exceptions/OutOfBoundException.h"
 #include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/base/Timestamp.h"
 
 class DummyErrorTerm :
   public aslam::backend::ErrorTermFs<3> {
@@ -51,6 +55,13 @@ protected:
 
 using namespace aslam::calibration;
 
+// exposes the lookup of the group of a design variable index
+class IncrementalOptimizationProblemIndices :
+  public IncrementalOptimizationProblem {
+public:
+  using IncrementalOptimizationProblem::getGroupId;
+};
+
 TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   auto problem1 = boost::make_shared<OptimizationProblem>();
   auto dv1 = boost::make_shared<VectorDesignVariable<2> >();
@@ -225,3 +236,176 @@ TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   ASSERT_EQ(dv1Param, Eigen::Vector2d::Zero());
   ASSERT_EQ(dv6Param, Eigen::MatrixXd::Ones(6, 1));
 }
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemScaling) {
+  // mimics the Jacobian construction, i.e., a sweep over all the error terms,
+  // while the estimator accumulates accepted batches
+  const size_t numBatches = 500;
+  const size_t numErrorTerms = 50;
+  IncrementalOptimizationProblem incProblem;
+  auto calibDv = boost::make_shared<VectorDesignVariable<4> >();
+  calibDv->setActive(true);
+  std::vector<boost::shared_ptr<OptimizationProblem> > batches;
+  batches.reserve(numBatches);
+  for (size_t i = 0; i < numBatches; ++i) {
+    auto batch = boost::make_shared<OptimizationProblem>();
+    auto dv = boost::make_shared<VectorDesignVariable<6> >();
+    dv->setActive(true);
+    batch->addDesignVariable(dv, 0);
+    batch->addDesignVariable(calibDv, 1);
+    for (size_t j = 0; j < numErrorTerms; ++j)
+      batch->addErrorTerm(boost::make_shared<DummyErrorTerm>());
+    incProblem.add(batch);
+    batches.push_back(batch);
+    if ((i + 1) % 100 == 0) {
+      const size_t numTotal = incProblem.numErrorTerms();
+      ASSERT_EQ(numTotal, (i + 1) * numErrorTerms);
+      const double timeStart = Timestamp::now();
+      for (size_t k = 0; k < numTotal; ++k)
+        ASSERT_EQ(incProblem.errorTerm(k),
+          batches[k / numErrorTerms]->errorTerm(k % numErrorTerms));
+      const double elapsed = Timestamp::now() - timeStart;
+      std::cout << "batches: " << i + 1 << ", error terms: " << numTotal
+        << ", lookup time per error term [ns]: " << elapsed / numTotal * 1e9
+        << std::endl;
+    }
+  }
+  ASSERT_THROW(incProblem.errorTerm(numBatches * numErrorTerms),
+    OutOfBoundException<size_t>);
+  ASSERT_EQ(incProblem.numDesignVariables(), numBatches + 1);
+  ASSERT_EQ(incProblem.getGroupDim(0), numBatches * 6);
+  ASSERT_EQ(incProblem.getGroupDim(1), 4);
+  const double timeStart = Timestamp::now();
+  for (size_t k = 0; k < numBatches; ++k)
+    ASSERT_EQ(incProblem.designVariable(k), batches[k]->designVariable(0));
+  ASSERT_EQ(incProblem.designVariable(numBatches), calibDv.get());
+  std::cout << "design variables: " << numBatches + 1
+    << ", lookup time per design variable [ns]: "
+    << (Timestamp::now() - timeStart) / (numBatches + 1) * 1e9 << std::endl;
+  incProblem.setGroupsOrdering({1, 0});
+  ASSERT_EQ(incProblem.designVariable(0), calibDv.get());
+  ASSERT_EQ(incProblem.designVariable(1), batches[0]->designVariable(0));
+  ASSERT_THROW(incProblem.designVariable(numBatches + 1),
+    OutOfBoundException<size_t>);
+  incProblem.remove(batches.front());
+  ASSERT_EQ(incProblem.numErrorTerms(), (numBatches - 1) * numErrorTerms);
+  ASSERT_EQ(incProblem.getGroupDim(0), (numBatches - 1) * 6);
+  ASSERT_EQ(incProblem.designVariable(1), batches[1]->designVariable(0));
+  ASSERT_EQ(incProblem.errorTerm(0), batches[1]->errorTerm(0));
+  ASSERT_EQ(incProblem.errorTerm(numErrorTerms), batches[2]->errorTerm(0));
+  std::vector<size_t> permutation(numBatches - 1);
+  for (size_t i = 0; i < permutation.size(); ++i)
+    permutation[i] = permutation.size() - 1 - i;
+  incProblem.permuteOptimizationProblems(permutation);
+  ASSERT_EQ(incProblem.errorTerm(0), batches.back()->errorTerm(0));
+  ASSERT_EQ(incProblem.errorTerm(numErrorTerms),
+    batches[numBatches - 2]->errorTerm(0));
+  ASSERT_EQ(incProblem.getOptimizationProblem(batches.back()),
+    incProblem.getOptimizationProblemBegin());
+  ASSERT_EQ(incProblem.getOptimizationProblem(batches.front()),
+    incProblem.getOptimizationProblemEnd());
+
+  // evict every other batch, the design variables keep their order
+  const double timeStartRemove = Timestamp::now();
+  for (size_t i = 1; i < numBatches; i += 2)
+    incProblem.remove(batches[i]);
+  std::cout << "batches removed: " << numBatches / 2
+    << ", removal time per batch [ns]: " << (Timestamp::now() -
+    timeStartRemove) / (numBatches / 2) * 1e9 << std::endl;
+  const size_t numLeft = numBatches / 2 - 1;
+  ASSERT_EQ(incProblem.getNumOptimizationProblems(), numLeft);
+  ASSERT_EQ(incProblem.numDesignVariables(), numLeft + 1);
+  ASSERT_EQ(incProblem.getGroupDim(0), numLeft * 6);
+  const auto& dvs0 = incProblem.getDesignVariablesGroup(0);
+  ASSERT_EQ(dvs0.size(), numLeft);
+  for (size_t i = 0; i < numLeft; ++i) {
+    ASSERT_EQ(dvs0[i], batches[2 * (i + 1)]->designVariable(0));
+    ASSERT_EQ(incProblem.designVariable(i + 1), dvs0[i]);
+  }
+  ASSERT_EQ(incProblem.getOptimizationProblem(batches[2]),
+    incProblem.getOptimizationProblemEnd() - 1);
+  ASSERT_THROW(incProblem.remove(batches[1]), InvalidOperationException);
+  incProblem.add(batches[1]);
+  ASSERT_EQ(incProblem.getDesignVariablesGroup(0).back(),
+    batches[1]->designVariable(0));
+  ASSERT_EQ(incProblem.getOptimizationProblem(batches[1]),
+    incProblem.getOptimizationProblemEnd() - 1);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemActivity) {
+  IncrementalOptimizationProblem incProblem;
+  auto problem = boost::make_shared<OptimizationProblem>();
+  auto dv1 = boost::make_shared<VectorDesignVariable<2> >();
+  dv1->setActive(true);
+  auto dv2 = boost::make_shared<VectorDesignVariable<3> >();
+  dv2->setActive(false);
+  problem->addDesignVariable(dv1, 0);
+  problem->addDesignVariable(dv2, 0);
+  incProblem.add(problem);
+  ASSERT_EQ(incProblem.getGroupDim(0), 2);
+
+  // the groups dimensions are frozen at the last structure change
+  dv2->setActive(true);
+  ASSERT_EQ(incProblem.getGroupDim(0), 2);
+  incProblem.invalidateGroupsDims();
+  ASSERT_EQ(incProblem.getGroupDim(0), 5);
+  dv1->setActive(false);
+  incProblem.invalidateGroupsDims();
+  ASSERT_EQ(incProblem.getGroupDim(0), 3);
+
+  // adding a problem only accounts for its new design variables
+  dv1->setActive(true);
+  auto problem2 = boost::make_shared<OptimizationProblem>();
+  auto dv3 = boost::make_shared<VectorDesignVariable<4> >();
+  dv3->setActive(true);
+  problem2->addDesignVariable(dv3, 0);
+  incProblem.add(problem2);
+  ASSERT_EQ(incProblem.getGroupDim(0), 7);
+  incProblem.invalidateGroupsDims();
+  ASSERT_EQ(incProblem.getGroupDim(0), 9);
+
+  // removing a problem recomputes the groups it touched
+  dv3->setActive(false);
+  incProblem.remove(problem);
+  ASSERT_EQ(incProblem.getGroupDim(0), 0);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemGroupIndices) {
+  IncrementalOptimizationProblemIndices incProblem;
+  std::vector<boost::shared_ptr<OptimizationProblem> > batches;
+  auto calibDv = boost::make_shared<VectorDesignVariable<4> >();
+  calibDv->setActive(true);
+  for (size_t i = 0; i < 3; ++i) {
+    auto batch = boost::make_shared<OptimizationProblem>();
+    for (size_t j = 0; j <= i; ++j) {
+      auto dv = boost::make_shared<VectorDesignVariable<2> >();
+      dv->setActive(true);
+      batch->addDesignVariable(dv, i + 2);
+    }
+    batch->addDesignVariable(calibDv, 1);
+    incProblem.add(batch);
+    batches.push_back(batch);
+  }
+
+  // groups ordering {2, 1, 3, 4} with sizes {1, 1, 2, 3}
+  const size_t groupIds[] = {2, 1, 3, 3, 4, 4, 4};
+  const size_t idxGroups[] = {0, 0, 0, 1, 0, 1, 2};
+  size_t groupId, idxGroup;
+  for (size_t i = 0; i < 7; ++i) {
+    incProblem.getGroupId(i, groupId, idxGroup);
+    ASSERT_EQ(groupId, groupIds[i]);
+    ASSERT_EQ(idxGroup, idxGroups[i]);
+  }
+  ASSERT_THROW(incProblem.getGroupId(7, groupId, idxGroup),
+    OutOfBoundException<size_t>);
+
+  // removing a batch drops its group and shifts the following ones
+  incProblem.remove(batches[1]);
+  incProblem.getGroupId(2, groupId, idxGroup);
+  ASSERT_EQ(groupId, 4u);
+  ASSERT_EQ(idxGroup, 0u);
+  incProblem.setGroupsOrdering({4, 2, 1});
+  incProblem.getGroupId(3, groupId, idxGroup);
+  ASSERT_EQ(groupId, 2u);
+  ASSERT_EQ(idxGroup, 0u);
+}
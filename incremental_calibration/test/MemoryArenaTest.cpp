@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file MemoryArenaTest.cpp
+    \brief This file tests the MemoryArena and ArenaAllocator classes.
+  */
+
+#include <cstdint>
+
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/base/MemoryArena.h"
+#include "aslam/calibration/base/ArenaAllocator.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testMemoryArena) {
+  MemoryArena arena(1024);
+  ASSERT_EQ(arena.getNumChunks(), 0);
+  std::vector<void*> pointers;
+  for (size_t i = 0; i < 10; ++i) {
+    pointers.push_back(arena.allocate(24, 16));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(pointers.back()) % 16, 0);
+  }
+  ASSERT_EQ(arena.getNumChunks(), 1);
+  ASSERT_EQ(arena.getNumAllocations(), 10);
+  ASSERT_EQ(arena.getNumLiveAllocations(), 10);
+  ASSERT_EQ(arena.getNumBytesUsed(), 240);
+  ASSERT_EQ(arena.getNumBytesReserved(), 1024);
+  pointers.push_back(arena.allocate(2000, 16));
+  ASSERT_EQ(arena.getNumChunks(), 2);
+  ASSERT_GE(arena.getNumBytesReserved(), 1024 + 2016);
+  for (auto it = pointers.cbegin(); it != pointers.cend(); ++it)
+    arena.deallocate(*it, 0);
+  ASSERT_EQ(arena.getNumLiveAllocations(), 0);
+  ASSERT_EQ(arena.getNumAllocations(), 11);
+
+  // reserving up front costs a single chunk
+  MemoryArena reserved(1024);
+  reserved.reserve(1000 * 32);
+  for (size_t i = 0; i < 1000; ++i)
+    reserved.allocate(32, 16);
+  ASSERT_EQ(reserved.getNumChunks(), 1);
+  ASSERT_EQ(reserved.getNumAllocations(), 1000);
+}
+
+TEST(AslamCalibrationTestSuite, testArenaAllocator) {
+  auto arena = boost::make_shared<MemoryArena>();
+  boost::weak_ptr<MemoryArena> weakArena = arena;
+  std::vector<boost::shared_ptr<Eigen::Vector4d> > objects;
+  for (size_t i = 0; i < 100; ++i) {
+    objects.push_back(boost::allocate_shared<Eigen::Vector4d>(
+      ArenaAllocator<Eigen::Vector4d>(arena), Eigen::Vector4d::Constant(i)));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(objects.back().get()) % 16,
+      0);
+  }
+  ASSERT_EQ(arena->getNumChunks(), 1);
+  ASSERT_EQ(arena->getNumAllocations(), 100);
+  ASSERT_EQ(*objects[42], Eigen::Vector4d::Constant(42));
+
+  // the objects keep the arena alive
+  arena.reset();
+  ASSERT_FALSE(weakArena.expired());
+  objects.resize(50);
+  ASSERT_EQ(weakArena.lock()->getNumLiveAllocations(), 50);
+  objects.clear();
+  ASSERT_TRUE(weakArena.expired());
+
+  ArenaAllocator<double> doubleAllocator(boost::make_shared<MemoryArena>());
+  ArenaAllocator<int> intAllocator(doubleAllocator);
+  ASSERT_TRUE(doubleAllocator == intAllocator);
+  ASSERT_FALSE(doubleAllocator != intAllocator);
+  ASSERT_EQ(intAllocator.getArena(), doubleAllocator.getArena());
+}
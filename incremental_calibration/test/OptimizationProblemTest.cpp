@@ -22,6 +22,7 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include <gtest/gtest.h>
 
@@ -131,3 +132,27 @@ TEST(AslamCalibrationTestSuite, testOptimizationProblem) {
   dv1->getParameters(dv1Param);
   ASSERT_EQ(dv1Param, Eigen::Vector2d::Zero());
 }
+
+TEST(AslamCalibrationTestSuite, testOptimizationProblemArena) {
+  const size_t numErrorTerms = 1000;
+  boost::weak_ptr<MemoryArena> weakArena;
+  {
+    OptimizationProblem problem;
+    weakArena = problem.getArena();
+    problem.getArena()->reserve(numErrorTerms * (sizeof(DummyErrorTerm) +
+      128));
+    for (size_t i = 0; i < numErrorTerms; ++i)
+      problem.addErrorTerm(problem.allocate<DummyErrorTerm>());
+    ASSERT_EQ(problem.numErrorTerms(), numErrorTerms);
+    ASSERT_EQ(problem.getArena()->getNumChunks(), 1);
+    ASSERT_EQ(problem.getArena()->getNumAllocations(), numErrorTerms);
+    ASSERT_EQ(problem.getArena()->getNumLiveAllocations(), numErrorTerms);
+
+    // objects outliving the problem keep the arena alive
+    auto errorTerm = problem.getErrorTerms().front();
+    problem.clear();
+    ASSERT_NE(problem.getArena(), weakArena.lock());
+    ASSERT_EQ(weakArena.lock()->getNumLiveAllocations(), 1);
+  }
+  ASSERT_TRUE(weakArena.expired());
+}
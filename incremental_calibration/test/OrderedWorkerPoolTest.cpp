@@ -0,0 +1,95 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file OrderedWorkerPoolTest.cpp
+    \brief This file tests the OrderedWorkerPool class.
+  */
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/base/OrderedWorkerPool.h"
+
+using namespace aslam::calibration;
+
+namespace {
+
+  typedef OrderedWorkerPool<size_t, size_t> Pool;
+
+  /// Creates a factory whose workers finish later jobs first
+  Pool::WorkerFactory createFactory(std::atomic<size_t>& numWorkers) {
+    return [&numWorkers](){
+      numWorkers++;
+      return [](const size_t& job) {
+        if (job == 13)
+          throw std::runtime_error("job failed");
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+          (7 - job % 7) * 2));
+        return job * job;
+      };
+    };
+  }
+
+}
+
+TEST(AslamCalibrationTestSuite, testOrderedWorkerPool) {
+  std::atomic<size_t> numWorkers(0);
+  std::vector<size_t> results;
+  {
+    Pool pool(4, createFactory(numWorkers));
+    ASSERT_EQ(pool.getNumThreads(), 4);
+    ASSERT_EQ(pool.getMaxPending(), 8);
+    size_t result;
+    ASSERT_FALSE(pool.popReady(result));
+    ASSERT_FALSE(pool.popNext(result));
+
+    // results come back in pushing order and the pending jobs are bounded
+    for (size_t i = 0; i < 13; ++i) {
+      pool.push(i);
+      while (pool.popReady(result))
+        results.push_back(result);
+      ASSERT_LE(pool.getNumPending(), pool.getMaxPending());
+    }
+    while (pool.popNext(result))
+      results.push_back(result);
+    ASSERT_EQ(pool.getNumPending(), 0);
+    ASSERT_EQ(results.size(), 13);
+    for (size_t i = 0; i < results.size(); ++i)
+      ASSERT_EQ(results[i], i * i);
+
+    // the exception of a worker is rethrown in order and the pool goes on
+    for (size_t i = 13; i < 16; ++i)
+      pool.push(i);
+    ASSERT_THROW(pool.popNext(result), std::runtime_error);
+    ASSERT_TRUE(pool.popNext(result));
+    ASSERT_EQ(result, 14 * 14);
+    ASSERT_TRUE(pool.popNext(result));
+    ASSERT_EQ(result, 15 * 15);
+    ASSERT_FALSE(pool.popNext(result));
+
+    // pending jobs are discarded on destruction
+    for (size_t i = 0; i < 20; ++i)
+      pool.push(i);
+  }
+  ASSERT_EQ(numWorkers, 4);
+}
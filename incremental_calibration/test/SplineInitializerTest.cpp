@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file SplineInitializerTest.cpp
+    \brief This file tests the SplineInitializer class.
+  */
+
+#include <cstdint>
+
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+#include <boost/make_shared.hpp>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/algorithms/SplineInitializer.h"
+
+struct DummySpline {
+  size_t numSamples;
+  int numSegments;
+  std::thread::id threadId;
+};
+
+TEST(AslamCalibrationTestSuite, testSplineInitializer) {
+  using namespace aslam::calibration;
+  typedef SplineInitializer<int64_t, DummySpline, DummySpline> Initializer;
+
+  bool throwRotation = false;
+  auto fitter = [&](const Initializer::Timestamps& timestamps, int
+      numSegments) {
+    auto spline = boost::make_shared<DummySpline>();
+    spline->numSamples = timestamps.size();
+    spline->numSegments = numSegments;
+    spline->threadId = std::this_thread::get_id();
+    return spline;
+  };
+  Initializer initializer(
+    [&](const Initializer::Timestamps& timestamps,
+        const Initializer::TranslationPoses&, int numSegments) {
+      return fitter(timestamps, numSegments);},
+    [&](const Initializer::Timestamps& timestamps,
+        const Initializer::RotationPoses&, int numSegments) {
+      if (throwRotation)
+        throw std::runtime_error("rotation fit failed");
+      return fitter(timestamps, numSegments);});
+
+  const Initializer::Timestamps timestamps({0, 10, 20, 30});
+  Initializer::TranslationPoses transPoses(4, Eigen::Vector3d::Zero());
+  const Initializer::RotationPoses rotPoses(4, Eigen::Vector4d::UnitW());
+
+  // fits meant to be modified are never reused
+  ASSERT_TRUE(initializer.initSplines(timestamps, transPoses, rotPoses, 3));
+  ASSERT_TRUE(initializer.initSplines(timestamps, transPoses, rotPoses, 3,
+    true));
+  ASSERT_EQ(initializer.getNumFits(), 2);
+  ASSERT_EQ(initializer.getTranslationSpline()->numSamples, 4);
+  ASSERT_EQ(initializer.getRotationSpline()->numSegments, 3);
+  ASSERT_NE(initializer.getTranslationSpline()->threadId,
+    initializer.getRotationSpline()->threadId);
+
+  // unchanged samples reuse the splines
+  auto translationSpline = initializer.getTranslationSpline();
+  ASSERT_FALSE(initializer.initSplines(timestamps, transPoses, rotPoses, 3,
+    true));
+  ASSERT_EQ(initializer.getTranslationSpline(), translationSpline);
+  ASSERT_EQ(initializer.getNumReuses(), 1);
+  ASSERT_TRUE(initializer.initSplines(timestamps, transPoses, rotPoses, 2,
+    true));
+  transPoses[1](0) = 1.0;
+  ASSERT_TRUE(initializer.initSplines(timestamps, transPoses, rotPoses, 2,
+    true));
+  ASSERT_EQ(initializer.getNumFits(), 4);
+  ASSERT_NE(initializer.getTranslationSpline(), translationSpline);
+
+  // failures on the helper thread reach the caller
+  throwRotation = true;
+  ASSERT_THROW(initializer.initSplines(timestamps, transPoses, rotPoses, 2),
+    std::runtime_error);
+  throwRotation = false;
+  initializer.clear();
+  ASSERT_FALSE(initializer.getTranslationSpline());
+  ASSERT_TRUE(initializer.initSplines(timestamps, transPoses, rotPoses, 2,
+    true));
+}
@@ -62,4 +62,11 @@ TEST(AslamCalibrationTestSuite, testVectorDesignVariable) {
   ASSERT_EQ(Eigen::Vector3d::Ones(), dv1Param);
   ASSERT_THROW(dv1.setParameters(Eigen::Vector2d::Ones()),
     aslam::calibration::OutOfBoundException<int>);
+
+  // Difference with a linearization point
+  Eigen::VectorXd dv1Diff;
+  dv1.minimalDifference(Eigen::Vector3d::Zero(), dv1Diff);
+  ASSERT_EQ(Eigen::VectorXd(Eigen::Vector3d::Ones()), dv1Diff);
+  ASSERT_THROW(dv1.minimalDifference(Eigen::Vector2d::Zero(), dv1Diff),
+    aslam::calibration::OutOfBoundException<int>);
 }
@@ -268,10 +268,10 @@ int main(int argc, char** argv) {
     std::cout << "rank of Theta: " << ret.rankTheta << std::endl;
     std::cout << "rank deficiency of Theta: " << ret.rankThetaDeficiency
       << std::endl;
-    std::cout << "unobservable basis: " << std::endl << ret.nobsBasis
-      << std::endl;
+    std::cout << "unobservable basis: " << std::endl
+      << ret.marginal->nobsBasis << std::endl;
     std::cout << "unobservable basis (scaled): " << std::endl
-      << ret.nobsBasisScaled << std::endl;
+      << ret.marginal->nobsBasisScaled << std::endl;
     std::cout << "QR tolerance: " << ret.qrTolerance << std::endl;
     std::cout << "SVD tolerance: " << ret.svdTolerance << std::endl;
     std::cout << "time [s]: " << ret.elapsedTime << std::endl;
@@ -26,7 +26,9 @@
 
 #include <cstddef>
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Core>
@@ -35,6 +37,8 @@
 
 #include <sm/timing/NsecTimeUtilities.hpp>
 
+#include <aslam/calibration/base/OrderedWorkerPool.h>
+
 namespace cv {
 
   class Mat;
@@ -107,6 +111,41 @@ namespace aslam {
       /// Camera intrinsics design variable containter shared pointer
       typedef boost::shared_ptr<CameraDesignVariableContainer>
         CameraDesignVariableContainerPtr;
+      /// Image queued for target detection
+      struct DetectionJob {
+        /// Image (copy owned by the queue)
+        boost::shared_ptr<cv::Mat> image;
+        /// Timestamp
+        sm::timing::NsecTime timestamp;
+      };
+      /// Result of the target detection in a queued image
+      struct DetectionResult {
+        /// Observation, null if the target was not found
+        ObservationPtr observation;
+        /// Timestamp
+        sm::timing::NsecTime timestamp;
+      };
+      /// Detection worker pool
+      typedef OrderedWorkerPool<DetectionJob, DetectionResult> DetectionPool;
+      /// Detection worker pool shared pointer
+      typedef boost::shared_ptr<DetectionPool> DetectionPoolPtr;
+      /// Summary of the reprojection errors of a batch
+      struct ResidualSummary {
+        /// Number of error terms
+        size_t numErrors;
+        /// Sum of the errors
+        Eigen::Vector2d errorsSum;
+        /// Sum of the outer products of the errors
+        Eigen::Matrix2d squaredErrorsSum;
+        /// Maximum absolute x error
+        double maxXError;
+        /// Maximum absolute y error
+        double maxYError;
+        /// Number of outliers
+        size_t numOutliers;
+        /// Parameters of the batch design variables at evaluation
+        std::vector<double> parameters;
+      };
       /// Self type
       typedef CameraCalibrator Self;
       /// Options for the camera calibrator
@@ -135,6 +174,8 @@ namespace aslam {
             batchNumImages(1),
             useMEstimator(false),
             sigma2(1.0),
+            detectionThreads(0),
+            statisticsThreads(0),
             verbose(false) {}
         /// Number of rows in the checkerboard
         size_t rows;
@@ -180,6 +221,10 @@ namespace aslam {
         bool useMEstimator;
         /// Variance of the measurements (assume isotropic Gaussian)
         double sigma2;
+        /// Number of threads detecting the target in queued images
+        size_t detectionThreads;
+        /// Number of threads evaluating the residual statistics
+        size_t statisticsThreads;
         /// Verbose mode
         bool verbose;
       };
@@ -263,6 +308,13 @@ namespace aslam {
       bool initGeometry(const cv::Mat& image);
       /// Add an image to the calibrator
       bool addImage(const cv::Mat& image, sm::timing::NsecTime timestamp);
+      /** Queues an image for target detection on the worker threads and adds
+          the detected observations in queuing order. Falls back to addImage()
+          without detection threads.
+        */
+      void queueImage(const cv::Mat& image, sm::timing::NsecTime timestamp);
+      /// Waits until all the queued images have been added
+      void waitForImages();
       /// Process the current batch
       void processBatch();
       /// Write camera parameters to property tree
@@ -280,6 +332,32 @@ namespace aslam {
       void initBatch();
       /// Add an observation into the batch
       void addObservation(const Observation& observation);
+      /// Creates a camera geometry of the configured projection type
+      CameraGeometryPtr createGeometry() const;
+      /// Creates a detector on a geometry and a calibration target
+      DetectorPtr createDetector(const CameraGeometryPtr& geometry, const
+        CalibrationTargetPtr& calibrationTarget, bool display) const;
+      /// Creates a calibration target
+      CalibrationTargetPtr createCalibrationTarget(bool display) const;
+      /** Detects the target in an image, returns null if it is not found.
+          Called concurrently from the detection threads.
+        */
+      virtual ObservationPtr detectTarget(Detector& detector, const cv::Mat&
+        image, sm::timing::NsecTime timestamp) const;
+      /// Adds a detected observation, possibly processing the batch
+      virtual bool addDetection(const ObservationPtr& observation,
+        sm::timing::NsecTime timestamp);
+      /// Starts the detection threads
+      void startDetection();
+      /// Stops the detection threads
+      void stopDetection();
+      /// Creates the worker of a detection thread
+      DetectionPool::Worker createDetectionWorker();
+      /// Re-evaluates the residual summaries of the modified batches
+      void updateResidualSummaries();
+      /// Evaluates the residual summaries of a range of batches
+      void evaluateResidualSummaries(const std::vector<size_t>& batches,
+        size_t start, size_t end, std::vector<ResidualSummary>& summaries);
       /** @}
         */
 
@@ -314,6 +392,24 @@ namespace aslam {
       ObservationPtr _lastObservation;
       /// Quantile for outlier detection
       double _q;
+      /// Detection threads
+      DetectionPoolPtr _detectionPool;
+      /// Camera parameters used by the detection threads
+      Eigen::MatrixXd _detectionParameters;
+      /// Version of the camera parameters used by the detection threads
+      size_t _detectionGeometryVersion;
+      /// Mutex protecting the camera parameters of the detection threads
+      std::mutex _detectionMutex;
+      /// Identifier of the current batch
+      size_t _batchId;
+      /// Next batch identifier
+      size_t _nextBatchId;
+      /// Identifiers of the batches in the estimator
+      std::unordered_map<const OptimizationProblem*, size_t> _batchIds;
+      /// Residual summaries of the batches in the estimator by identifier
+      std::unordered_map<size_t, ResidualSummary> _residualSummaries;
+      /// Parameters of the shared design variables at the last evaluation
+      std::vector<double> _residualSharedParameters;
       /** @}
         */
 
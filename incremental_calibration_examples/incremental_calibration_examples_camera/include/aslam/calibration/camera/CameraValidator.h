@@ -35,6 +35,7 @@
 
 #include <sm/timing/NsecTimeUtilities.hpp>
 
+#include <aslam/calibration/base/OrderedWorkerPool.h>
 #include <aslam/calibration/statistics/EstimatorML.h>
 #include <aslam/calibration/statistics/NormalDistribution.h>
 
@@ -84,6 +85,27 @@ namespace aslam {
       typedef aslam::cameras::GridCalibrationTargetObservation Observation;
       /// Grid observation shared pointer
       typedef boost::shared_ptr<Observation> ObservationPtr;
+      /// Image queued for validation
+      struct ValidationJob {
+        /// Image (copy owned by the queue)
+        boost::shared_ptr<cv::Mat> image;
+        /// Timestamp
+        sm::timing::NsecTime timestamp;
+      };
+      /// Result of the validation of a queued image
+      struct ValidationResult {
+        /// Observation, null if the target was not found
+        ObservationPtr observation;
+        /// Reprojection errors of the observed corners
+        Eigen::Matrix2Xd errors;
+        /// Timestamp
+        sm::timing::NsecTime timestamp;
+      };
+      /// Validation worker pool
+      typedef OrderedWorkerPool<ValidationJob, ValidationResult>
+        ValidationPool;
+      /// Validation worker pool shared pointer
+      typedef boost::shared_ptr<ValidationPool> ValidationPoolPtr;
       /// Self type
       typedef CameraValidator Self;
       /// Options for the camera validator
@@ -106,6 +128,8 @@ namespace aslam {
             filterCornerMinReprojError(0.2),
             cameraProjectionType("pinhole"),
             sigma2(1.0),
+            validationThreads(0),
+            keepObservations(true),
             verbose(false) {}
         /// Number of rows in the checkerboard
         size_t rows;
@@ -139,6 +163,10 @@ namespace aslam {
         std::string cameraProjectionType;
         /// Variance of the measurements (assume isotropic Gaussian)
         double sigma2;
+        /// Number of threads validating queued images
+        size_t validationThreads;
+        /// Keep the observations and their images, e.g., for rendering
+        bool keepObservations;
         /// Verbose mode
         bool verbose;
       };
@@ -202,6 +230,13 @@ namespace aslam {
         */
       /// Add an image to the validator
       bool addImage(const cv::Mat& image, sm::timing::NsecTime timestamp);
+      /** Queues an image for validation on the worker threads, the results
+          are added in queuing order. Falls back to addImage() without
+          validation threads.
+        */
+      void queueImage(const cv::Mat& image, sm::timing::NsecTime timestamp);
+      /// Waits until all the queued images have been added
+      void waitForImages();
       /** @}
         */
 
@@ -211,6 +246,32 @@ namespace aslam {
         */
       /// Init the vision framework
       void initVisionFramework(const sm::PropertyTree& config);
+      /// Creates a calibration target
+      CalibrationTargetPtr createCalibrationTarget(bool display) const;
+      /// Returns a copy of the camera geometry
+      CameraGeometryPtr copyGeometry() const;
+      /// Creates a detector on a geometry and a calibration target
+      DetectorPtr createDetector(const CameraGeometryPtr& geometry, const
+        CalibrationTargetPtr& calibrationTarget, bool display) const;
+      /** Detects the target in an image, returns null if it is not found.
+          Called concurrently from the validation threads.
+        */
+      virtual ObservationPtr detectTarget(Detector& detector, const cv::Mat&
+        image, sm::timing::NsecTime timestamp) const;
+      /// Validates an image with a detector and a geometry
+      ValidationResult validateImage(Detector& detector, const CameraGeometry&
+        geometry, const cv::Mat& image, sm::timing::NsecTime timestamp) const;
+      /// Computes the reprojection errors of an observation
+      void computeErrors(Observation& observation, const CameraGeometry&
+        geometry, Eigen::Matrix2Xd& errors) const;
+      /// Adds the result of the validation of an image
+      bool addResult(const ValidationResult& result);
+      /// Starts the validation threads
+      void startValidation();
+      /// Stops the validation threads
+      void stopValidation();
+      /// Creates the worker of a validation thread
+      ValidationPool::Worker createValidationWorker() const;
       /** @}
         */
 
@@ -237,6 +298,12 @@ namespace aslam {
       std::vector<Eigen::Vector2d> _errors;
       /// Squared Mahalanobis distances of the errors
       std::vector<double> _errorsMd2;
+      /// Last observation
+      ObservationPtr _lastObservation;
+      /// Chi-square quantile for the outliers in the rendered images
+      double _q;
+      /// Validation threads
+      ValidationPoolPtr _validationPool;
       /** @}
         */
 
@@ -20,10 +20,12 @@
 
 #include <cmath>
 
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <algorithm>
 #include <sstream>
+#include <thread>
 
 #include <boost/make_shared.hpp>
 #include <boost/math/distributions/chi_squared.hpp>
@@ -64,7 +66,6 @@
 #include <aslam/calibration/exceptions/InvalidOperationException.h>
 #include <aslam/calibration/exceptions/OutOfBoundException.h>
 #include <aslam/calibration/base/Timestamp.h>
-#include <aslam/calibration/statistics/EstimatorML.h>
 #include <aslam/calibration/statistics/NormalDistribution.h>
 
 namespace aslam {
@@ -80,14 +81,20 @@ namespace aslam {
         _estimator(estimator),
         _geometryInitialized(false),
         _batchNumImages(0),
-        _q(0.0) {
+        _q(0.0),
+        _detectionGeometryVersion(0),
+        _batchId(0),
+        _nextBatchId(0) {
       initVisionFramework();
     }
 
     CameraCalibrator::CameraCalibrator(const sm::PropertyTree& config) :
         _geometryInitialized(false),
         _batchNumImages(0),
-        _q(0.0) {
+        _q(0.0),
+        _detectionGeometryVersion(0),
+        _batchId(0),
+        _nextBatchId(0) {
       // read the options from the property tree
       _options.rows = config.getInt("rows", _options.rows);
       _options.cols = config.getInt("cols", _options.cols);
@@ -128,6 +135,10 @@ namespace aslam {
       _options.useMEstimator = config.getBool("useMEstimator",
         _options.useMEstimator);
       _options.sigma2 = config.getDouble("sigma2", _options.sigma2);
+      _options.detectionThreads = config.getInt("detectionThreads",
+        _options.detectionThreads);
+      _options.statisticsThreads = config.getInt("statisticsThreads",
+        _options.statisticsThreads);
       _options.verbose = config.getBool("verbose", _options.verbose);
 
       // init vision framework
@@ -139,6 +150,7 @@ namespace aslam {
     }
 
     CameraCalibrator::~CameraCalibrator() {
+      stopDetection();
     }
 
 /******************************************************************************/
@@ -250,28 +262,43 @@ namespace aslam {
     void CameraCalibrator::getStatistics(Eigen::VectorXd&
         mean, Eigen::VectorXd& variance, Eigen::VectorXd& standardDeviation,
         double& maxXError, double& maxYError, size_t& numOutliers) {
-      std::vector<Eigen::Vector2d> errors;
-      std::vector<double> errorsMd2;
-      getErrors(errors, errorsMd2);
-      EstimatorML<NormalDistribution<2> > statistics;
-      statistics.addPoints(errors);
-      if (statistics.getValid()) {
-        mean = statistics.getDistribution().getMean();
-        variance = statistics.getDistribution().getCovariance().diagonal();
-        standardDeviation = variance.array().sqrt();
-        maxXError = 0.0;
-        maxYError = 0.0;
-        for (auto it = errors.cbegin(); it != errors.cend(); ++it) {
-          if (std::fabs((*it)(0)) > maxXError)
-            maxXError = std::fabs((*it)(0));
-          if (std::fabs((*it)(1)) > maxYError)
-            maxYError = std::fabs((*it)(1));
+      // merge the summaries of the batches, only the modified ones are
+      // evaluated again
+      updateResidualSummaries();
+      size_t numErrors = 0;
+      Eigen::Vector2d errorsSum = Eigen::Vector2d::Zero();
+      Eigen::Matrix2d squaredErrorsSum = Eigen::Matrix2d::Zero();
+      maxXError = 0.0;
+      maxYError = 0.0;
+      numOutliers = 0;
+      for (auto it = _residualSummaries.cbegin();
+          it != _residualSummaries.cend(); ++it) {
+        numErrors += it->second.numErrors;
+        errorsSum += it->second.errorsSum;
+        squaredErrorsSum += it->second.squaredErrorsSum;
+        maxXError = std::max(maxXError, it->second.maxXError);
+        maxYError = std::max(maxYError, it->second.maxYError);
+        numOutliers += it->second.numOutliers;
+      }
+
+      // same maximum likelihood estimate as EstimatorML
+      NormalDistribution<2> distribution;
+      bool valid = numErrors > 0;
+      if (valid) {
+        try {
+          const Eigen::Vector2d errorsMean = errorsSum / numErrors;
+          distribution.setMean(errorsMean);
+          distribution.setCovariance(squaredErrorsSum / numErrors -
+            errorsMean * errorsMean.transpose());
         }
-        if (_q == 0.0)
-          _q = boost::math::quantile(boost::math::chi_squared_distribution<>(2),
-            0.975);
-        numOutliers = std::count_if(errorsMd2.cbegin(), errorsMd2.cend(),
-          [&](decltype(*errorsMd2.cbegin()) x){return x > _q;});
+        catch (...) {
+          valid = false;
+        }
+      }
+      if (valid) {
+        mean = distribution.getMean();
+        variance = distribution.getCovariance().diagonal();
+        standardDeviation = variance.array().sqrt();
       }
       else {
         mean.resize(0);
@@ -287,15 +314,16 @@ namespace aslam {
         std::vector<double>& errorsMd2) {
       errors.clear();
       errorsMd2.clear();
-      auto problem = const_cast<IncrementalOptimizationProblem*>(
-        _estimator->getProblem());
+      auto problem = _estimator->getProblem();
       errors.reserve(problem->numErrorTerms());
       errorsMd2.reserve(problem->numErrorTerms());
-      for (size_t i = 0; i != problem->numErrorTerms(); ++i) {
-        auto e_re = problem->errorTerm(i);
-        errorsMd2.push_back(e_re->evaluateError());
-        errors.push_back(
-          dynamic_cast<aslam::ReprojectionError*>(e_re)->error());
+      for (size_t i = 0; i < problem->getNumOptimizationProblems(); ++i) {
+        const auto& errorTerms = problem->getErrorTerms(i);
+        for (auto it = errorTerms.cbegin(); it != errorTerms.cend(); ++it) {
+          errorsMd2.push_back((*it)->evaluateError());
+          errors.push_back(
+            dynamic_cast<aslam::ReprojectionError*>(it->get())->error());
+        }
       }
     }
 
@@ -308,41 +336,59 @@ namespace aslam {
 /* Methods                                                                    */
 /******************************************************************************/
 
-    void CameraCalibrator::initVisionFramework() {
-      // create calibration target
+    CameraCalibrator::CalibrationTargetPtr
+        CameraCalibrator::createCalibrationTarget(bool display) const {
       CalibrationTarget::CheckerboardOptions targetOptions;
       targetOptions.useAdaptiveThreshold = _options.useAdaptiveThreshold;
       targetOptions.normalizeImage = _options.normalizeImage;
       targetOptions.filterQuads = _options.filterQuads;
       targetOptions.doSubpixelRefinement = _options.doSubpixelRefinement;
-      targetOptions.showExtractionVideo = _options.showExtractionVideo;
-      _calibrationTarget = boost::make_shared<CalibrationTarget>(_options.rows,
+      targetOptions.showExtractionVideo = display &&
+        _options.showExtractionVideo;
+      return boost::make_shared<CalibrationTarget>(_options.rows,
         _options.cols, _options.rowSpacingMeters, _options.colSpacingMeters,
         targetOptions);
+    }
 
-      // create camera geometry
+    CameraCalibrator::CameraGeometryPtr CameraCalibrator::createGeometry()
+        const {
       if (_options.cameraProjectionType == "omni")
-        _geometry =
+        return
           boost::make_shared<aslam::cameras::DistortedOmniCameraGeometry>();
       else if (_options.cameraProjectionType == "pinhole")
-        _geometry =
+        return
           boost::make_shared<aslam::cameras::DistortedPinholeCameraGeometry>();
       else
         throw BadArgumentException<std::string>(_options.cameraProjectionType,
           "unkown camera projection type", __FILE__, __LINE__,
           __PRETTY_FUNCTION__);
+    }
 
-      // create detector
+    CameraCalibrator::DetectorPtr CameraCalibrator::createDetector(const
+        CameraGeometryPtr& geometry, const CalibrationTargetPtr&
+        calibrationTarget, bool display) const {
       Detector::GridDetectorOptions detectorOptions;
-      detectorOptions.plotCornerReprojection = _options.plotCornerReprojection;
-      detectorOptions.imageStepping = _options.imageStepping;
+      detectorOptions.plotCornerReprojection = display &&
+        _options.plotCornerReprojection;
+      detectorOptions.imageStepping = display && _options.imageStepping;
       detectorOptions.filterCornerOutliers = _options.filterCornerOutliers;
       detectorOptions.filterCornerSigmaThreshold =
         _options.filterCornerSigmaThreshold;
       detectorOptions.filterCornerMinReprojError =
         _options.filterCornerMinReprojError;
-      _detector = boost::make_shared<Detector>(_geometry, _calibrationTarget,
+      return boost::make_shared<Detector>(geometry, calibrationTarget,
         detectorOptions);
+    }
+
+    void CameraCalibrator::initVisionFramework() {
+      // create calibration target
+      _calibrationTarget = createCalibrationTarget(true);
+
+      // create camera geometry
+      _geometry = createGeometry();
+
+      // create detector
+      _detector = createDetector(_geometry, _calibrationTarget, true);
 
       // create design variables for landmarks
       _landmarkDesignVariables.reserve(_calibrationTarget->size());
@@ -372,6 +418,7 @@ namespace aslam {
     void CameraCalibrator::initBatch() {
       // create batch / overwrite older if already existing
       _batch = boost::make_shared<OptimizationProblem>();
+      _batchId = _nextBatchId++;
 
       // add the landmark design variables
       for (auto it = _landmarkDesignVariables.cbegin();
@@ -448,14 +495,27 @@ namespace aslam {
           __LINE__, __PRETTY_FUNCTION__);
 
       // find the target in the input image
+      return addDetection(detectTarget(*_detector, image, timestamp),
+        timestamp);
+    }
+
+    CameraCalibrator::ObservationPtr CameraCalibrator::detectTarget(Detector&
+        detector, const cv::Mat& image, sm::timing::NsecTime timestamp) const {
       auto observation = boost::make_shared<Observation>();
-      const bool status = _detector->findTarget(image, aslam::Time(
-        sm::timing::nsecToSec(timestamp)), *observation);
-      if (!status) {
+      if (detector.findTarget(image, aslam::Time(
+          sm::timing::nsecToSec(timestamp)), *observation))
+        return observation;
+      else
+        return ObservationPtr();
+    }
+
+    bool CameraCalibrator::addDetection(const ObservationPtr& observation,
+        sm::timing::NsecTime timestamp) {
+      if (!observation) {
         if (_options.verbose)
           std::cerr << __PRETTY_FUNCTION__ << ": target not found at time "
             << sm::timing::nsecToSec(timestamp) << std::endl;
-        return status;
+        return false;
       }
       else {
         if (_options.verbose)
@@ -475,11 +535,193 @@ namespace aslam {
       return true;
     }
 
+    void CameraCalibrator::queueImage(const cv::Mat& image,
+        sm::timing::NsecTime timestamp) {
+      if (!_options.detectionThreads) {
+        addImage(image, timestamp);
+        return;
+      }
+      if (!_geometryInitialized)
+        throw InvalidOperationException("geometry not initialized", __FILE__,
+          __LINE__, __PRETTY_FUNCTION__);
+      if (!_detectionPool)
+        startDetection();
+
+      // the image is copied since the caller may reuse its buffer
+      _detectionPool->push(DetectionJob{
+        boost::make_shared<cv::Mat>(image.clone()), timestamp});
+
+      // add the finished detections, blocking when too many are in flight
+      DetectionResult result;
+      while (_detectionPool->popReady(result))
+        addDetection(result.observation, result.timestamp);
+    }
+
+    void CameraCalibrator::waitForImages() {
+      if (!_detectionPool)
+        return;
+      DetectionResult result;
+      while (_detectionPool->popNext(result))
+        addDetection(result.observation, result.timestamp);
+    }
+
+    void CameraCalibrator::startDetection() {
+      _geometry->getParameters(_detectionParameters, true, true, true);
+      _detectionGeometryVersion++;
+      _detectionPool = boost::make_shared<DetectionPool>(
+        _options.detectionThreads, std::bind(&Self::createDetectionWorker,
+        this));
+    }
+
+    void CameraCalibrator::stopDetection() {
+      _detectionPool.reset();
+    }
+
+    CameraCalibrator::DetectionPool::Worker
+        CameraCalibrator::createDetectionWorker() {
+      // each thread detects on its own copy of the geometry, refreshed from
+      // the last estimate whenever a batch has been processed
+      auto geometry = createGeometry();
+      auto detector = createDetector(geometry, createCalibrationTarget(false),
+        false);
+      auto geometryVersion = boost::make_shared<size_t>(0);
+      return [this, geometry, detector, geometryVersion](const DetectionJob&
+          job) {
+        {
+          std::lock_guard<std::mutex> lock(_detectionMutex);
+          if (*geometryVersion != _detectionGeometryVersion) {
+            geometry->setParameters(_detectionParameters, true, true, true);
+            *geometryVersion = _detectionGeometryVersion;
+          }
+        }
+        DetectionResult result;
+        result.observation = detectTarget(*detector, *job.image,
+          job.timestamp);
+        result.timestamp = job.timestamp;
+        return result;
+      };
+    }
+
+    void CameraCalibrator::updateResidualSummaries() {
+      if (_q == 0.0)
+        _q = boost::math::quantile(boost::math::chi_squared_distribution<>(2),
+          0.975);
+      auto appendParameters = [](const aslam::backend::DesignVariable* dv,
+          std::vector<double>& parameters) {
+        Eigen::MatrixXd value;
+        dv->getParameters(value);
+        parameters.insert(parameters.end(), value.data(),
+          value.data() + value.size());
+      };
+
+      // landmarks and intrinsics are shared, any change affects all batches
+      std::vector<double> sharedParameters;
+      for (auto it = _landmarkDesignVariables.cbegin();
+          it != _landmarkDesignVariables.cend(); ++it)
+        appendParameters(it->get(), sharedParameters);
+      aslam::backend::DesignVariable::set_t cameraDesignVariables;
+      _cameraDesignVariableContainer->getDesignVariables(cameraDesignVariables);
+      for (auto it = cameraDesignVariables.cbegin();
+          it != cameraDesignVariables.cend(); ++it)
+        appendParameters(*it, sharedParameters);
+      const bool sharedChanged =
+        sharedParameters != _residualSharedParameters;
+      _residualSharedParameters.swap(sharedParameters);
+
+      // batches whose poses did not move keep their summary, the summaries
+      // are keyed by identifier since the address of a removed batch may be
+      // reused by a new one
+      auto problem = _estimator->getProblem();
+      const size_t numBatches = problem->getNumOptimizationProblems();
+      std::vector<ResidualSummary> summaries(numBatches);
+      std::vector<size_t> batchIds(numBatches);
+      std::vector<size_t> dirtyBatches;
+      for (size_t i = 0; i < numBatches; ++i) {
+        const OptimizationProblem* batch = problem->getOptimizationProblem(i);
+        auto batchIdIt = _batchIds.find(batch);
+        batchIds[i] = batchIdIt != _batchIds.end() ? batchIdIt->second :
+          _nextBatchId++;
+        std::vector<double> parameters;
+        if (batch->isGroupInProblem(_options.transformationsGroupId)) {
+          const auto& dvs = batch->getDesignVariablesGroup(
+            _options.transformationsGroupId);
+          for (auto it = dvs.cbegin(); it != dvs.cend(); ++it)
+            appendParameters(it->get(), parameters);
+        }
+        auto summaryIt = _residualSummaries.find(batchIds[i]);
+        if (!sharedChanged && summaryIt != _residualSummaries.end() &&
+            summaryIt->second.numErrors == batch->getErrorTerms().size() &&
+            summaryIt->second.parameters == parameters)
+          summaries[i] = summaryIt->second;
+        else {
+          summaries[i].parameters.swap(parameters);
+          dirtyBatches.push_back(i);
+        }
+      }
+
+      // evaluate the modified batches
+      const size_t numThreads = std::min(_options.statisticsThreads,
+        dirtyBatches.size());
+      if (numThreads <= 1)
+        evaluateResidualSummaries(dirtyBatches, 0, dirtyBatches.size(),
+          summaries);
+      else {
+        const size_t chunk = (dirtyBatches.size() + numThreads - 1) /
+          numThreads;
+        std::vector<std::thread> workers;
+        workers.reserve(numThreads);
+        for (size_t start = 0; start < dirtyBatches.size(); start += chunk)
+          workers.push_back(std::thread(&Self::evaluateResidualSummaries,
+            this, std::cref(dirtyBatches), start,
+            std::min(start + chunk, dirtyBatches.size()),
+            std::ref(summaries)));
+        for (auto it = workers.begin(); it != workers.end(); ++it)
+          it->join();
+      }
+
+      // removed batches are dropped
+      _batchIds.clear();
+      _residualSummaries.clear();
+      for (size_t i = 0; i < numBatches; ++i) {
+        _batchIds[problem->getOptimizationProblem(i)] = batchIds[i];
+        _residualSummaries[batchIds[i]] = std::move(summaries[i]);
+      }
+    }
+
+    void CameraCalibrator::evaluateResidualSummaries(const std::vector<size_t>&
+        batches, size_t start, size_t end, std::vector<ResidualSummary>&
+        summaries) {
+      auto problem = _estimator->getProblem();
+      for (size_t i = start; i < end; ++i) {
+        ResidualSummary& summary = summaries[batches[i]];
+        summary.numErrors = 0;
+        summary.errorsSum = Eigen::Vector2d::Zero();
+        summary.squaredErrorsSum = Eigen::Matrix2d::Zero();
+        summary.maxXError = 0.0;
+        summary.maxYError = 0.0;
+        summary.numOutliers = 0;
+        const auto& errorTerms = problem->getErrorTerms(batches[i]);
+        for (auto it = errorTerms.cbegin(); it != errorTerms.cend(); ++it) {
+          const double md2 = (*it)->evaluateError();
+          const Eigen::Vector2d error =
+            dynamic_cast<aslam::ReprojectionError*>(it->get())->error();
+          summary.numErrors++;
+          summary.errorsSum += error;
+          summary.squaredErrorsSum += error * error.transpose();
+          summary.maxXError = std::max(summary.maxXError, std::fabs(error(0)));
+          summary.maxYError = std::max(summary.maxYError, std::fabs(error(1)));
+          if (md2 > _q)
+            summary.numOutliers++;
+        }
+      }
+    }
+
     void CameraCalibrator::processBatch() {
       if (!_batch)
         return;
       auto ret = _estimator->addBatch(_batch);
       if (ret.batchAccepted) {
+        _batchIds[_batch.get()] = _batchId;
         _estimatorObservations.insert(_estimatorObservations.begin(),
           _batchObservations.begin(), _batchObservations.end());
       }
@@ -488,14 +730,14 @@ namespace aslam {
         ret.batchAccepted ? std::cout << "ACCEPTED" : std::cout << "REJECTED";
         std::cout << std::endl;
         std::cout << "information gain: " << ret.informationGain << std::endl;
-        std::cout << "unobservable basis: " << std::endl << ret.nobsBasis
-          << std::endl;
+        std::cout << "unobservable basis: " << std::endl
+          << ret.marginal->nobsBasis << std::endl;
         std::cout << "singular values: "
-          << ret.singularValues.transpose() << std::endl;
+          << ret.marginal->singularValues.transpose() << std::endl;
         std::cout << "unobservable basis (scaled): " << std::endl
-          << ret.nobsBasisScaled << std::endl;
+          << ret.marginal->nobsBasisScaled << std::endl;
         std::cout << "singular values (scaled): "
-          << ret.singularValuesScaled.transpose() << std::endl;
+          << ret.marginal->singularValuesScaled.transpose() << std::endl;
         std::cout << "projection: " << getProjection().transpose() << std::endl;
         std::cout << "projection standard deviation: "
           << getProjectionStandardDeviation().transpose() << std::endl;
@@ -520,6 +762,15 @@ namespace aslam {
       }
       initBatch();
       _batchNumImages = 0;
+
+      // publish the new estimate to the detection threads
+      if (_detectionPool) {
+        Eigen::MatrixXd parameters;
+        _geometry->getParameters(parameters, true, true, true);
+        std::lock_guard<std::mutex> lock(_detectionMutex);
+        _detectionParameters = parameters;
+        _detectionGeometryVersion++;
+      }
     }
 
     void CameraCalibrator::write(sm::PropertyTree& config) const {
@@ -20,6 +20,7 @@
 
 #include <cmath>
 
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -57,14 +58,18 @@ namespace aslam {
         const Options& options) :
         _options(options),
         _maxXError(0.0),
-        _maxYError(0.0) {
+        _maxYError(0.0),
+        _q(boost::math::quantile(boost::math::chi_squared_distribution<>(2),
+          0.975)) {
       initVisionFramework(intrinsics);
     }
 
     CameraValidator::CameraValidator(const sm::PropertyTree& intrinsics, const
         sm::PropertyTree& config) :
         _maxXError(0.0),
-        _maxYError(0.0) {
+        _maxYError(0.0),
+        _q(boost::math::quantile(boost::math::chi_squared_distribution<>(2),
+          0.975)) {
       // read the options from the property tree
       _options.rows = config.getInt("rows", _options.rows);
       _options.cols = config.getInt("cols", _options.cols);
@@ -93,6 +98,10 @@ namespace aslam {
       _options.cameraProjectionType = config.getString("cameraProjectionType",
         _options.cameraProjectionType);
       _options.sigma2 = config.getDouble("sigma2", _options.sigma2);
+      _options.validationThreads = config.getInt("validationThreads",
+        _options.validationThreads);
+      _options.keepObservations = config.getBool("keepObservations",
+        _options.keepObservations);
       _options.verbose = config.getBool("verbose", _options.verbose);
 
       // init vision framework
@@ -100,6 +109,7 @@ namespace aslam {
     }
 
     CameraValidator::~CameraValidator() {
+      stopValidation();
     }
 
 /******************************************************************************/
@@ -151,9 +161,9 @@ namespace aslam {
     }
 
     void CameraValidator::getLastImage(cv::Mat& image) const {
-      if (_observations.empty())
+      if (!_lastObservation)
         return;
-      auto observation = _observations.back();
+      auto observation = _lastObservation;
       cv::Mat imageCopy(observation->image().rows,
         observation->image().cols, CV_8UC3);
       cv::cvtColor(observation->image(), imageCopy, CV_GRAY2RGB);
@@ -210,11 +220,7 @@ namespace aslam {
         errorNormSum += errorNorm;
         if (errorNorm > maxErrorNorm)
           maxErrorNorm = errorNorm;
-        const double q = boost::math::quantile(
-          boost::math::chi_squared_distribution<>(2), 0.975);
-        const double md2 = (error.transpose() *
-          (1.0 / _options.sigma2) * Eigen::Matrix2d::Identity() * error)(0, 0);
-        if (md2 > q)
+        if (error.squaredNorm() / _options.sigma2 > _q)
           numOutliers++;
       }
       std::stringstream stream;
@@ -244,7 +250,7 @@ namespace aslam {
     }
 
     size_t CameraValidator::getNumOutliers(double p) const {
-      const double q = boost::math::quantile(
+      const double q = p == 0.975 ? _q : boost::math::quantile(
         boost::math::chi_squared_distribution<>(2), p);
       return std::count_if(_errorsMd2.cbegin(), _errorsMd2.cend(), [&](decltype(
         *_errorsMd2.cbegin()) x){return x > q;});
@@ -257,15 +263,7 @@ namespace aslam {
     void CameraValidator::initVisionFramework(const sm::PropertyTree&
         intrinsics) {
       // create calibration target
-      CalibrationTarget::CheckerboardOptions targetOptions;
-      targetOptions.useAdaptiveThreshold = _options.useAdaptiveThreshold;
-      targetOptions.normalizeImage = _options.normalizeImage;
-      targetOptions.filterQuads = _options.filterQuads;
-      targetOptions.doSubpixelRefinement = _options.doSubpixelRefinement;
-      targetOptions.showExtractionVideo = _options.showExtractionVideo;
-      _calibrationTarget = boost::make_shared<CalibrationTarget>(_options.rows,
-        _options.cols, _options.rowSpacingMeters, _options.colSpacingMeters,
-        targetOptions);
+      _calibrationTarget = createCalibrationTarget(true);
 
       // create camera geometry
       if (intrinsics.getString("projection/type") == "omni")
@@ -283,71 +281,188 @@ namespace aslam {
           __PRETTY_FUNCTION__);
 
       // create detector
+      _detector = createDetector(_geometry, _calibrationTarget, true);
+    }
+
+    CameraValidator::CalibrationTargetPtr
+        CameraValidator::createCalibrationTarget(bool display) const {
+      CalibrationTarget::CheckerboardOptions targetOptions;
+      targetOptions.useAdaptiveThreshold = _options.useAdaptiveThreshold;
+      targetOptions.normalizeImage = _options.normalizeImage;
+      targetOptions.filterQuads = _options.filterQuads;
+      targetOptions.doSubpixelRefinement = _options.doSubpixelRefinement;
+      targetOptions.showExtractionVideo = display &&
+        _options.showExtractionVideo;
+      return boost::make_shared<CalibrationTarget>(_options.rows,
+        _options.cols, _options.rowSpacingMeters, _options.colSpacingMeters,
+        targetOptions);
+    }
+
+    CameraValidator::CameraGeometryPtr CameraValidator::copyGeometry() const {
+      if (auto omni = boost::dynamic_pointer_cast<
+          aslam::cameras::DistortedOmniCameraGeometry>(_geometry))
+        return boost::make_shared<
+          aslam::cameras::DistortedOmniCameraGeometry>(*omni);
+      else
+        return boost::make_shared<
+          aslam::cameras::DistortedPinholeCameraGeometry>(
+          *boost::dynamic_pointer_cast<
+          aslam::cameras::DistortedPinholeCameraGeometry>(_geometry));
+    }
+
+    CameraValidator::DetectorPtr CameraValidator::createDetector(const
+        CameraGeometryPtr& geometry, const CalibrationTargetPtr&
+        calibrationTarget, bool display) const {
       Detector::GridDetectorOptions detectorOptions;
-      detectorOptions.plotCornerReprojection = _options.plotCornerReprojection;
-      detectorOptions.imageStepping = _options.imageStepping;
+      detectorOptions.plotCornerReprojection = display &&
+        _options.plotCornerReprojection;
+      detectorOptions.imageStepping = display && _options.imageStepping;
       detectorOptions.filterCornerOutliers = _options.filterCornerOutliers;
       detectorOptions.filterCornerSigmaThreshold =
         _options.filterCornerSigmaThreshold;
       detectorOptions.filterCornerMinReprojError =
         _options.filterCornerMinReprojError;
-      _detector = boost::make_shared<Detector>(_geometry, _calibrationTarget,
+      return boost::make_shared<Detector>(geometry, calibrationTarget,
         detectorOptions);
     }
 
-    bool CameraValidator::addImage(const cv::Mat& image, sm::timing::NsecTime
-        timestamp) {
-      // find the target in the input image
-      auto observation = boost::make_shared<Observation>();
-      const bool status = _detector->findTarget(image, aslam::Time(
-        sm::timing::nsecToSec(timestamp)), *observation);
-      if (!status) {
-        if (_options.verbose)
-          std::cerr << __PRETTY_FUNCTION__ << ": target not found at time "
-            << sm::timing::nsecToSec(timestamp) << std::endl;
-        return status;
-      }
-      else {
-        if (_options.verbose)
-          std::cout << __PRETTY_FUNCTION__ << ": target found at time "
-            << sm::timing::nsecToSec(timestamp) << std::endl;
-      }
-
-      // transformation from camera to target
-      auto T_t_c = observation->T_t_c();
-
+    void CameraValidator::computeErrors(Observation& observation, const
+        CameraGeometry& geometry, Eigen::Matrix2Xd& errors) const {
       // transformation from target to camera
-      auto T_c_t = T_t_c.inverse();
+      auto T_c_t = observation.T_t_c().inverse();
 
       // iterate over checkerboard corners
+      errors.resize(2, _calibrationTarget->size());
+      size_t numErrors = 0;
       for (size_t i = 0; i < _calibrationTarget->size(); ++i) {
         auto targetPoint = sm::kinematics::toHomogeneous(
           _calibrationTarget->point(i));
         Eigen::Vector2d observedPoint;
-        bool success = observation->imagePoint(i, observedPoint);
+        bool success = observation.imagePoint(i, observedPoint);
         if (!success)
           continue;
         Eigen::VectorXd predictedPoint;
-        success = _geometry->vsHomogeneousToKeypoint(T_c_t * targetPoint,
+        success = geometry.vsHomogeneousToKeypoint(T_c_t * targetPoint,
           predictedPoint);
         if (!success)
           continue;
-        const Eigen::Vector2d error = predictedPoint - observedPoint;
-        _reprojectionErrorsStatistics.addPoint(error);
-        if (std::fabs(error(0)) > _maxXError)
-          _maxXError = std::fabs(error(0));
-        if (std::fabs(error(1)) > _maxYError)
-          _maxYError = std::fabs(error(1));
-        _errors.push_back(error);
-        _errorsMd2.push_back((error.transpose() *
-          (1.0 / _options.sigma2) * Eigen::Matrix2d::Identity() * error)(0, 0));
+        errors.col(numErrors++) = predictedPoint - observedPoint;
+      }
+      errors.conservativeResize(2, numErrors);
+    }
+
+    bool CameraValidator::addImage(const cv::Mat& image, sm::timing::NsecTime
+        timestamp) {
+      return addResult(validateImage(*_detector, *_geometry, image,
+        timestamp));
+    }
+
+    CameraValidator::ObservationPtr CameraValidator::detectTarget(Detector&
+        detector, const cv::Mat& image, sm::timing::NsecTime timestamp) const {
+      auto observation = boost::make_shared<Observation>();
+      if (detector.findTarget(image, aslam::Time(
+          sm::timing::nsecToSec(timestamp)), *observation))
+        return observation;
+      else
+        return ObservationPtr();
+    }
+
+    CameraValidator::ValidationResult CameraValidator::validateImage(
+        Detector& detector, const CameraGeometry& geometry, const cv::Mat&
+        image, sm::timing::NsecTime timestamp) const {
+      // find the target in the input image
+      ValidationResult result;
+      result.timestamp = timestamp;
+      result.observation = detectTarget(detector, image, timestamp);
+      if (result.observation)
+        computeErrors(*result.observation, geometry, result.errors);
+      return result;
+    }
+
+    bool CameraValidator::addResult(const ValidationResult& result) {
+      if (!result.observation) {
+        if (_options.verbose)
+          std::cerr << __PRETTY_FUNCTION__ << ": target not found at time "
+            << sm::timing::nsecToSec(result.timestamp) << std::endl;
+        return false;
+      }
+      else {
+        if (_options.verbose)
+          std::cout << __PRETTY_FUNCTION__ << ": target found at time "
+            << sm::timing::nsecToSec(result.timestamp) << std::endl;
+      }
+
+      // accumulate the statistics, the noise is isotropic
+      const Eigen::Matrix2Xd& errors = result.errors;
+      if (errors.cols() > 0) {
+        _maxXError = std::max(_maxXError, errors.row(0).cwiseAbs().maxCoeff());
+        _maxYError = std::max(_maxYError, errors.row(1).cwiseAbs().maxCoeff());
+      }
+      const Eigen::VectorXd md2 = errors.colwise().squaredNorm().transpose() /
+        _options.sigma2;
+      _errors.reserve(_errors.size() + errors.cols());
+      _errorsMd2.reserve(_errorsMd2.size() + errors.cols());
+      for (std::ptrdiff_t i = 0; i < errors.cols(); ++i) {
+        _reprojectionErrorsStatistics.addPoint(errors.col(i));
+        _errors.push_back(errors.col(i));
+        _errorsMd2.push_back(md2(i));
       }
 
       // store observation for later use if needed
-      _observations.push_back(observation);
+      if (_options.keepObservations)
+        _observations.push_back(result.observation);
+      _lastObservation = result.observation;
 
       return true;
     }
 
+    void CameraValidator::queueImage(const cv::Mat& image,
+        sm::timing::NsecTime timestamp) {
+      if (!_options.validationThreads) {
+        addImage(image, timestamp);
+        return;
+      }
+      if (!_validationPool)
+        startValidation();
+
+      // the image is copied since the caller may reuse its buffer
+      _validationPool->push(ValidationJob{
+        boost::make_shared<cv::Mat>(image.clone()), timestamp});
+
+      // add the finished results, blocking when too many are in flight
+      ValidationResult result;
+      while (_validationPool->popReady(result))
+        addResult(result);
+    }
+
+    void CameraValidator::waitForImages() {
+      if (!_validationPool)
+        return;
+      ValidationResult result;
+      while (_validationPool->popNext(result))
+        addResult(result);
+    }
+
+    void CameraValidator::startValidation() {
+      _validationPool = boost::make_shared<ValidationPool>(
+        _options.validationThreads, std::bind(&Self::createValidationWorker,
+        this));
+    }
+
+    void CameraValidator::stopValidation() {
+      _validationPool.reset();
+    }
+
+    CameraValidator::ValidationPool::Worker
+        CameraValidator::createValidationWorker() const {
+      // each thread detects on its own target and copy of the geometry
+      auto geometry = copyGeometry();
+      auto detector = createDetector(geometry, createCalibrationTarget(false),
+        false);
+      return [this, geometry, detector](const ValidationJob& job) {
+        return validateImage(*detector, *geometry, *job.image, job.timestamp);
+      };
+    }
+
   }
 }
@@ -84,6 +84,23 @@ int main(int argc, char** argv) {
     }
   }
 
+  // saves the images of the observations accepted since a given count;
+  // accepted observations are inserted at the front, and queued images may
+  // have been added several at a time
+  auto saveEstimatorImages = [&](size_t numObservations) {
+    if (!config.getBool("camera/calibrator/saveEstimatorImages"))
+      return;
+    const auto& observations = calibrator.getEstimatorObservations();
+    for (size_t i = 0; i < observations.size() - numObservations; ++i) {
+      if (!boost::filesystem::exists("images"))
+        boost::filesystem::create_directory("images");
+      std::stringstream stream;
+      stream << "images/" << config.getString("camera/cameraId") << "-"
+        << observations[i]->time().toNSec() << ".png";
+      cv::imwrite(stream.str().c_str(), observations[i]->image());
+    }
+  };
+
   // processing ros bag file
   std::cout << "Processing BAG file..." << std::endl;
   size_t viewCounter = 0;
@@ -95,21 +112,13 @@ int main(int argc, char** argv) {
       auto cvImage = cv_bridge::toCvCopy(image);
       const size_t numObservations =
         calibrator.getEstimatorObservations().size();
-      calibrator.addImage(cvImage->image, image->header.stamp.toNSec());
-      if (config.getBool("camera/calibrator/saveEstimatorImages")) {
-        if (calibrator.getEstimatorObservations().size() != numObservations) {
-          cv::Mat checkerboardImage;
-          calibrator.getLastCheckerboardImage(checkerboardImage);
-          if (!boost::filesystem::exists("images"))
-            boost::filesystem::create_directory("images");
-          std::stringstream stream;
-          stream << "images/" << config.getString("camera/cameraId") << "-"
-            << image->header.stamp.toNSec() << ".png";
-          cv::imwrite(stream.str().c_str(), checkerboardImage);
-        }
-      }
+      calibrator.queueImage(cvImage->image, image->header.stamp.toNSec());
+      saveEstimatorImages(numObservations);
     }
   }
+  const size_t numObservations = calibrator.getEstimatorObservations().size();
+  calibrator.waitForImages();
+  saveEstimatorImages(numObservations);
   calibrator.processBatch();
 
   std::cout << "final parameters: " << std::endl;
@@ -85,8 +85,11 @@ int main(int argc, char** argv) {
     if (it->getTopic() == rosTopic) {
       sensor_msgs::ImagePtr image(it->instantiate<sensor_msgs::Image>());
       auto cvImage = cv_bridge::toCvCopy(image);
-      validator.addImage(cvImage->image, image->header.stamp.toNSec());
-      if (config.getBool("camera/validator/visualization")) {
+      // without rendering, the images are validated on the worker threads
+      if (!config.getBool("camera/validator/visualization"))
+        validator.queueImage(cvImage->image, image->header.stamp.toNSec());
+      else {
+        validator.addImage(cvImage->image, image->header.stamp.toNSec());
         cv::Mat resultImage;
         validator.getLastImage(resultImage);
         if (resultImage.data != NULL) {
@@ -104,6 +107,7 @@ int main(int argc, char** argv) {
       }
     }
   }
+  validator.waitForImages();
 
   // results
   std::cout << "reprojection error mean: "
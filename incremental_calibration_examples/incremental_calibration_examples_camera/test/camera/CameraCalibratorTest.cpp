@@ -0,0 +1,267 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file CameraCalibratorTest.cpp
+    \brief This file tests the CameraCalibrator class.
+  */
+
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <opencv2/core/core.hpp>
+
+#include <boost/make_shared.hpp>
+#include <boost/math/distributions/chi_squared.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <sm/kinematics/Transformation.hpp>
+
+#include <aslam/cameras.hpp>
+#include <aslam/cameras/GridCalibrationTargetCheckerboard.hpp>
+#include <aslam/cameras/GridCalibrationTargetObservation.hpp>
+
+#include <aslam/backend/DesignVariable.hpp>
+
+#include <aslam/calibration/core/IncrementalEstimator.h>
+#include <aslam/calibration/core/IncrementalOptimizationProblem.h>
+#include <aslam/calibration/core/OptimizationProblem.h>
+
+#include "aslam/calibration/camera/CameraCalibrator.h"
+
+using namespace aslam::calibration;
+
+namespace {
+
+  // fakes the detection and records the detections in adding order
+  class CameraCalibratorQueue :
+    public CameraCalibrator {
+  public:
+    CameraCalibratorQueue(const Options& options) :
+        CameraCalibrator(boost::make_shared<IncrementalEstimator>(
+          options.calibrationGroupId), options),
+        failure(-1) {
+      _geometryInitialized = true;
+    }
+    virtual ~CameraCalibratorQueue() {
+      // the threads call back into this object
+      stopDetection();
+    }
+    virtual ObservationPtr detectTarget(Detector& /*detector*/, const
+        cv::Mat& /*image*/, sm::timing::NsecTime timestamp) const override {
+      // later images finish first within a round of the threads
+      std::this_thread::sleep_for(std::chrono::milliseconds(
+        (5 - timestamp % 5) * 2));
+      if (timestamp == failure)
+        throw std::runtime_error("detection failed");
+      return timestamp % 3 ? boost::make_shared<Observation>() :
+        ObservationPtr();
+    }
+    virtual bool addDetection(const ObservationPtr& observation,
+        sm::timing::NsecTime timestamp) override {
+      timestamps.push_back(timestamp);
+      EXPECT_EQ(static_cast<bool>(observation), timestamp % 3 != 0);
+      return static_cast<bool>(observation);
+    }
+    // timestamp of the image whose detection throws
+    sm::timing::NsecTime failure;
+    // timestamps of the added detections
+    std::vector<sm::timing::NsecTime> timestamps;
+  };
+
+  // adds synthetic observations of the target projected by a pinhole camera
+  class CameraCalibratorSynthetic :
+    public CameraCalibrator {
+  public:
+    CameraCalibratorSynthetic(const Options& options) :
+        CameraCalibrator(boost::make_shared<IncrementalEstimator>(
+          options.calibrationGroupId), options) {
+      Eigen::MatrixXd projection(4, 1);
+      projection << 500.0, 500.0, 320.0, 240.0;
+      _geometry->setParameters(projection, true, false, false);
+      _geometryInitialized = true;
+    }
+    void addSyntheticImage(size_t idx) {
+      const Eigen::Vector3d t_t_c(0.15 + 0.02 * idx, 0.18 - 0.01 * idx,
+        -1.0 - 0.05 * idx);
+      const sm::kinematics::Transformation T_t_c(
+        sm::kinematics::axisAngle2quat(Eigen::Vector3d(0.05 * idx, -0.03 *
+        idx, 0.1)), t_t_c);
+      const sm::kinematics::Transformation T_c_t = T_t_c.inverse();
+      auto observation = boost::make_shared<Observation>(_calibrationTarget);
+      for (size_t i = 0; i < _calibrationTarget->size(); ++i) {
+        const Eigen::Vector3d p_c = T_c_t * _calibrationTarget->point(i);
+        observation->updateImagePoint(i, Eigen::Vector2d(
+          500.0 * p_c(0) / p_c(2) + 320.0, 500.0 * p_c(1) / p_c(2) + 240.0) +
+          0.5 * Eigen::Vector2d::Random());
+      }
+      observation->set_T_t_c(T_t_c);
+      addDetection(observation, idx);
+    }
+    void moveFocalLength(double delta) {
+      Eigen::MatrixXd projection;
+      _geometry->getParameters(projection, true, false, false);
+      projection(0) += delta;
+      projection(1) += delta;
+      _geometry->setParameters(projection, true, false, false);
+    }
+  };
+
+  // compares the merged summaries to the statistics of all the errors
+  void checkStatistics(CameraCalibrator& calibrator) {
+    Eigen::VectorXd mean, variance, standardDeviation;
+    double maxXError, maxYError;
+    size_t numOutliers;
+    calibrator.getStatistics(mean, variance, standardDeviation, maxXError,
+      maxYError, numOutliers);
+    std::vector<Eigen::Vector2d> errors;
+    std::vector<double> errorsMd2;
+    calibrator.getErrors(errors, errorsMd2);
+    ASSERT_FALSE(errors.empty());
+    const double q = boost::math::quantile(
+      boost::math::chi_squared_distribution<>(2), 0.975);
+    Eigen::Vector2d errorsSum = Eigen::Vector2d::Zero();
+    Eigen::Matrix2d squaredErrorsSum = Eigen::Matrix2d::Zero();
+    double expectedMaxXError = 0.0;
+    double expectedMaxYError = 0.0;
+    size_t expectedNumOutliers = 0;
+    for (size_t i = 0; i < errors.size(); ++i) {
+      errorsSum += errors[i];
+      squaredErrorsSum += errors[i] * errors[i].transpose();
+      expectedMaxXError = std::max(expectedMaxXError, std::fabs(errors[i](0)));
+      expectedMaxYError = std::max(expectedMaxYError, std::fabs(errors[i](1)));
+      if (errorsMd2[i] > q)
+        expectedNumOutliers++;
+    }
+    const double numErrors = errors.size();
+    const Eigen::Vector2d expectedMean = errorsSum / numErrors;
+    const Eigen::Vector2d expectedVariance = (squaredErrorsSum / numErrors -
+      expectedMean * expectedMean.transpose()).diagonal();
+    ASSERT_EQ(mean.size(), 2);
+    ASSERT_EQ(variance.size(), 2);
+    for (std::ptrdiff_t i = 0; i < 2; ++i) {
+      ASSERT_NEAR(mean(i), expectedMean(i), 1e-9);
+      ASSERT_NEAR(variance(i), expectedVariance(i), 1e-9);
+    }
+    ASSERT_DOUBLE_EQ(maxXError, expectedMaxXError);
+    ASSERT_DOUBLE_EQ(maxYError, expectedMaxYError);
+    ASSERT_EQ(numOutliers, expectedNumOutliers);
+  }
+
+}
+
+TEST(AslamCalibrationTestSuite, testCameraCalibratorQueue) {
+  const cv::Mat image(8, 8, CV_8UC1, cv::Scalar(0));
+  const size_t numImages = 20;
+
+  // without detection threads, the images are added right away
+  CameraCalibrator::Options options;
+  CameraCalibratorQueue serial(options);
+  for (size_t i = 0; i < numImages; ++i) {
+    serial.queueImage(image, i);
+    ASSERT_EQ(serial.timestamps.size(), i + 1);
+  }
+  serial.waitForImages();
+
+  // the detections are added in queuing order with bounded lag
+  options.detectionThreads = 3;
+  CameraCalibratorQueue threaded(options);
+  for (size_t i = 0; i < numImages; ++i) {
+    threaded.queueImage(image, i);
+    ASSERT_LE(i + 1 - threaded.timestamps.size(),
+      2 * options.detectionThreads);
+  }
+  threaded.waitForImages();
+  ASSERT_EQ(threaded.timestamps.size(), numImages);
+  ASSERT_EQ(threaded.timestamps, serial.timestamps);
+
+  // a detection exception is rethrown after the preceding images are added
+  const size_t failure = 5;
+  CameraCalibratorQueue failing(options);
+  failing.failure = failure;
+  bool thrown = false;
+  try {
+    for (size_t i = 0; i < numImages; ++i)
+      failing.queueImage(image, i);
+    failing.waitForImages();
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_TRUE(thrown);
+  ASSERT_EQ(failing.timestamps.size(), failure);
+  for (size_t i = 0; i < failing.timestamps.size(); ++i)
+    ASSERT_EQ(failing.timestamps[i], static_cast<sm::timing::NsecTime>(i));
+
+  // the remaining images are still added in order
+  failing.waitForImages();
+  for (size_t i = failure; i < failing.timestamps.size(); ++i)
+    ASSERT_EQ(failing.timestamps[i], static_cast<sm::timing::NsecTime>(i + 1));
+}
+
+TEST(AslamCalibrationTestSuite, testCameraCalibratorStatistics) {
+  CameraCalibrator::Options options;
+  options.batchNumImages = 2;
+  CameraCalibratorSynthetic calibrator(options);
+  auto estimator = calibrator.getEstimator();
+
+  // accepted batches
+  size_t idx = 0;
+  for (; idx < 6; ++idx)
+    calibrator.addSyntheticImage(idx);
+  const size_t numBatches = estimator->getNumBatches();
+  ASSERT_GE(numBatches, 1);
+  checkStatistics(calibrator);
+
+  // a rejected batch leaves the summaries of the others valid
+  const double infoGainDelta = estimator->getOptions().infoGainDelta;
+  estimator->getOptions().infoGainDelta =
+    std::numeric_limits<double>::max();
+  for (; idx < 8; ++idx)
+    calibrator.addSyntheticImage(idx);
+  ASSERT_EQ(estimator->getNumBatches(), numBatches);
+  checkStatistics(calibrator);
+  estimator->getOptions().infoGainDelta = infoGainDelta;
+
+  // a moved pose only invalidates its batch
+  const auto& dvs = estimator->getProblem()->getOptimizationProblem(0)->
+    getDesignVariablesGroup(options.transformationsGroupId);
+  ASSERT_FALSE(dvs.empty());
+  const Eigen::Vector3d dt(1e-2, -2e-2, 3e-2);
+  dvs.back()->update(dt.data(), dt.size());
+  checkStatistics(calibrator);
+
+  // moved intrinsics invalidate all the batches
+  calibrator.moveFocalLength(5.0);
+  checkStatistics(calibrator);
+
+  // accepted batches after the changes
+  for (; idx < 12; ++idx)
+    calibrator.addSyntheticImage(idx);
+  checkStatistics(calibrator);
+}
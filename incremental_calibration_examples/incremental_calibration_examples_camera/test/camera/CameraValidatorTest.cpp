@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file CameraValidatorTest.cpp
+    \brief This file tests the CameraValidator class.
+  */
+
+#include <cmath>
+#include <cstddef>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <opencv2/core/core.hpp>
+
+#include <boost/make_shared.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sm/BoostPropertyTree.hpp>
+
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <sm/kinematics/Transformation.hpp>
+
+#include <aslam/cameras/GridCalibrationTargetCheckerboard.hpp>
+#include <aslam/cameras/GridCalibrationTargetObservation.hpp>
+
+#include "aslam/calibration/camera/CameraValidator.h"
+
+using namespace aslam::calibration;
+
+namespace {
+
+  // detects a synthetic target projected by a pinhole camera with noise
+  class CameraValidatorSynthetic :
+    public CameraValidator {
+  public:
+    CameraValidatorSynthetic(const sm::PropertyTree& intrinsics, const
+        Options& options) :
+        CameraValidator(intrinsics, options) {
+    }
+    virtual ~CameraValidatorSynthetic() {
+      // the threads call back into this object
+      stopValidation();
+    }
+    virtual ObservationPtr detectTarget(Detector& /*detector*/, const
+        cv::Mat& /*image*/, sm::timing::NsecTime timestamp) const override {
+      // later images finish first within a round of the threads
+      std::this_thread::sleep_for(std::chrono::milliseconds(
+        (5 - timestamp % 5) * 2));
+      if (timestamp % 4 == 3)
+        return ObservationPtr();
+      const double t = timestamp;
+      const sm::kinematics::Transformation T_t_c(
+        sm::kinematics::axisAngle2quat(Eigen::Vector3d(0.05 * t, -0.03 * t,
+        0.1)), Eigen::Vector3d(0.15 + 0.01 * t, 0.18 - 0.01 * t,
+        -1.0 - 0.05 * t));
+      const sm::kinematics::Transformation T_c_t = T_t_c.inverse();
+      auto observation = boost::make_shared<Observation>(_calibrationTarget);
+      for (size_t i = 0; i < _calibrationTarget->size(); ++i) {
+        const Eigen::Vector3d p_c = T_c_t * _calibrationTarget->point(i);
+        // deterministic noise, the threads share no random state
+        const Eigen::Vector2d noise(std::sin(7.0 * t + i),
+          std::cos(3.0 * t + 2.0 * i));
+        observation->updateImagePoint(i, Eigen::Vector2d(
+          500.0 * p_c(0) / p_c(2) + 320.0, 500.0 * p_c(1) / p_c(2) + 240.0) +
+          0.5 * noise);
+      }
+      observation->set_T_t_c(T_t_c);
+      return observation;
+    }
+  };
+
+  // pinhole intrinsics in the format written by the calibrator
+  sm::BoostPropertyTree createIntrinsics() {
+    sm::BoostPropertyTree intrinsics;
+    intrinsics.setString("projection/type", "pinhole");
+    intrinsics.setDouble("projection/fu", 500.0);
+    intrinsics.setDouble("projection/fv", 500.0);
+    intrinsics.setDouble("projection/cu", 320.0);
+    intrinsics.setDouble("projection/cv", 240.0);
+    intrinsics.setInt("projection/ru", 640);
+    intrinsics.setInt("projection/rv", 480);
+    intrinsics.setDouble("projection/distortion/k1", 0.0);
+    intrinsics.setDouble("projection/distortion/k2", 0.0);
+    intrinsics.setDouble("projection/distortion/p1", 0.0);
+    intrinsics.setDouble("projection/distortion/p2", 0.0);
+    intrinsics.setDouble("shutter/line-delay", 0.0);
+    intrinsics.setString("mask/mask-file", "");
+    return intrinsics;
+  }
+
+}
+
+TEST(AslamCalibrationTestSuite, testCameraValidatorThreads) {
+  const cv::Mat image(8, 8, CV_8UC1, cv::Scalar(0));
+  const size_t numImages = 20;
+  const sm::BoostPropertyTree intrinsics = createIntrinsics();
+
+  CameraValidator::Options options;
+  CameraValidatorSynthetic serial(intrinsics, options);
+  for (size_t i = 0; i < numImages; ++i)
+    serial.queueImage(image, i);
+  serial.waitForImages();
+  ASSERT_EQ(serial.getObservations().size(), numImages - numImages / 4);
+  ASSERT_FALSE(serial.getErrors().empty());
+
+  // the threads accumulate the same statistics in the same order
+  options.validationThreads = 3;
+  CameraValidatorSynthetic threaded(intrinsics, options);
+  for (size_t i = 0; i < numImages; ++i)
+    threaded.queueImage(image, i);
+  threaded.waitForImages();
+  ASSERT_EQ(threaded.getObservations().size(),
+    serial.getObservations().size());
+  ASSERT_EQ(threaded.getErrors(), serial.getErrors());
+  ASSERT_EQ(threaded.getMahalanobisDistances(),
+    serial.getMahalanobisDistances());
+  ASSERT_EQ(threaded.getReprojectionErrorMean(),
+    serial.getReprojectionErrorMean());
+  ASSERT_EQ(threaded.getReprojectionErrorVariance(),
+    serial.getReprojectionErrorVariance());
+  ASSERT_EQ(threaded.getReprojectionErrorMaxXError(),
+    serial.getReprojectionErrorMaxXError());
+  ASSERT_EQ(threaded.getReprojectionErrorMaxYError(),
+    serial.getReprojectionErrorMaxYError());
+  ASSERT_EQ(threaded.getNumOutliers(), serial.getNumOutliers());
+  for (size_t i = 0; i < serial.getObservations().size(); ++i)
+    ASSERT_EQ(threaded.getObservations()[i]->T_t_c().T(),
+      serial.getObservations()[i]->T_t_c().T());
+}
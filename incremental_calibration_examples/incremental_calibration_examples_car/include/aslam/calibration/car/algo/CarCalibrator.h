@@ -24,6 +24,13 @@
 #ifndef ASLAM_CALIBRATION_CAR_CALIBRATOR_H
 #define ASLAM_CALIBRATION_CAR_CALIBRATOR_H
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Core>
@@ -38,8 +45,12 @@
 #include <bsplines/EuclideanBSpline.hpp>
 #include <bsplines/UnitQuaternionBSpline.hpp>
 
+#include <aslam/calibration/core/IncrementalEstimator.h>
+#include <aslam/calibration/algorithms/SplineInitializer.h>
+
 #include "aslam/calibration/car/data/MeasurementsContainer.h"
 #include "aslam/calibration/car/algo/CarCalibratorOptions.h"
+#include "aslam/calibration/car/algo/PredictionStatistics.h"
 
 namespace sm {
 
@@ -52,10 +63,14 @@ namespace bsplines {
 
 }
 namespace aslam {
+  namespace backend {
+
+    class ErrorTerm;
+
+  }
   namespace calibration {
 
     class OptimizationProblemSpline;
-    class IncrementalEstimator;
     struct PoseMeasurement;
     struct VelocitiesMeasurement;
     struct WheelSpeedsMeasurement;
@@ -64,6 +79,11 @@ namespace aslam {
     struct OdometryDesignVariables;
 
     /** The class CarCalibrator implements the car calibration algorithm.
+        In asynchronous mode, a worker thread owns the design variables, the
+        estimator, the splines, and the histories while batches are queued.
+        Their accessors therefore wait for the queued batches first, and what
+        they return is stable until the next addMeasurements(). From the batch
+        callback, they return right away.
         \brief Car calibration algorithm.
       */
     class CarCalibrator {
@@ -90,6 +110,9 @@ namespace aslam {
         bsplines::NsecTimePolicy>::CONF>::BSpline TranslationSpline;
       /// Euclidean spline shared pointer
       typedef boost::shared_ptr<TranslationSpline> TranslationSplineSP;
+      /// Splines initializer
+      typedef SplineInitializer<sm::timing::NsecTime, TranslationSpline,
+        RotationSpline> PoseSplineInitializer;
       /// Optimization problem shared pointer
       typedef boost::shared_ptr<OptimizationProblemSpline>
         OptimizationProblemSplineSP;
@@ -106,6 +129,52 @@ namespace aslam {
       /// Steering measurements
       typedef MeasurementsContainer<SteeringMeasurement>::Type
         SteeringMeasurements;
+      /// Measurements of one batch
+      struct BatchMeasurements {
+        /// Pose measurements
+        PoseMeasurements pose;
+        /// Velocities measurements
+        VelocitiesMeasurements velocities;
+        /// Applanix DMI measurements
+        DMIMeasurements dmi;
+        /// CAN front wheels speed measurements
+        WheelSpeedsMeasurements frontWheelSpeeds;
+        /// CAN rear wheels speed measurements
+        WheelSpeedsMeasurements rearWheelSpeeds;
+        /// CAN steering measurements
+        SteeringMeasurements steering;
+      };
+      /// Estimator return value for a batch
+      typedef IncrementalEstimator::ReturnValue ReturnValue;
+      /// Future on the estimator return value for a batch
+      typedef std::shared_future<ReturnValue> ReturnValueFuture;
+      /// Callback for processed batches
+      typedef std::function<void(const ReturnValue&)> BatchCallback;
+      /// Sensors whose measurements are predicted
+      enum PredictionSensor {
+        /// Pose measurements
+        POSE,
+        /// Velocities measurements
+        VELOCITIES,
+        /// Applanix DMI measurements
+        DMI,
+        /// CAN front wheels speed measurements
+        FRONT_WHEELS,
+        /// CAN rear wheels speed measurements
+        REAR_WHEELS,
+        /// CAN steering measurements
+        STEERING,
+        /// Number of sensors
+        NUM_PREDICTION_SENSORS
+      };
+      /// Sink for the prediction errors and their squared norms
+      typedef std::function<void(PredictionSensor, sm::timing::NsecTime,
+        const Eigen::VectorXd&, double)> PredictionSink;
+      /// Error terms built for a batch
+      typedef std::vector<boost::shared_ptr<aslam::backend::ErrorTerm> >
+        ErrorTerms;
+      /// Builds the error terms of the measurement at an index
+      typedef std::function<void(size_t, ErrorTerms&)> ErrorTermsBuilder;
       /// Self type
       typedef CarCalibrator Self;
       /** @}
@@ -205,6 +274,18 @@ namespace aslam {
       const std::vector<Eigen::VectorXd>& getSteeringPredictionErrors() const;
       /// Returns the steering prediction squared errors
       const std::vector<double>& getSteeringPredictionErrors2() const;
+      /** Sets the callback for processed batches. In asynchronous mode, it runs
+          on the worker thread and must neither wait for the batches nor
+          predict, which throw an InvalidOperationException there.
+        */
+      void setBatchCallback(const BatchCallback& callback);
+      /// Returns the running statistics of the prediction errors of a sensor
+      const PredictionStatistics& getPredictionStatistics(PredictionSensor
+        sensor) const;
+      /// Sets the sink receiving every prediction error
+      void setPredictionSink(const PredictionSink& sink);
+      /// Returns the number of batches queued or being processed
+      size_t getNumPendingBatches() const;
       /** @}
         */
 
@@ -229,13 +310,15 @@ namespace aslam {
       /// Adds a CAN steering measurement
       void addSteeringMeasurement(const SteeringMeasurement& data,
         sm::timing::NsecTime timestamp);
-      /// Adds the currently stored measurements to the estimator
-      void addMeasurements();
+      /// Adds the stored measurements to the estimator, queued if asynchronous
+      ReturnValueFuture addMeasurements();
+      /// Waits until all the queued batches have been processed
+      void waitForBatches();
       /// Clears the stored measurements
       void clearMeasurements();
       /// Predicts the stored measurements
       void predict();
-      /// Clears the predictions
+      /// Clears the predictions and their statistics
       void clearPredictions();
       /** @}
         */
@@ -246,6 +329,15 @@ namespace aslam {
         */
       /// Adds a new measurement
       void addMeasurement(sm::timing::NsecTime timestamp);
+      /// Builds a batch from measurements and adds it to the estimator
+      ReturnValue processBatch(const BatchMeasurements& measurements);
+      /// Worker thread processing the queued batches
+      void processBatches();
+      /// Waits for the queued batches unless called from the worker thread
+      void waitForWorker() const;
+      /// Builds error terms on the worker threads and adds them in order
+      void addErrorTerms(size_t numMeasurements, const ErrorTermsBuilder&
+        builder, const OptimizationProblemSplineSP& batch);
       /// Adds pose error terms
       void addPoseErrorTerms(const PoseMeasurements& measurements, const
         OptimizationProblemSplineSP& batch);
@@ -276,8 +368,22 @@ namespace aslam {
         const OptimizationProblemSplineSP& batch);
       /// Predicts CAN data st measurements
       void predictSteering(const SteeringMeasurements& measurements);
+      /// Reports a prediction error to the statistics and the sink
+      void reportPrediction(PredictionSensor sensor, sm::timing::NsecTime
+        timestamp, const Eigen::VectorXd& error, double error2);
       /// Initializes the splines from a batch of pose measurements
-      void initSplines(const PoseMeasurements& measurements);
+      void initSplines(const PoseMeasurements& measurements,
+        bool reuse = false);
+      /// Fits a translation spline to samples
+      TranslationSplineSP fitTranslationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const;
+      /// Fits a rotation spline to samples
+      RotationSplineSP fitRotationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const;
       /** @}
         */
 
@@ -342,14 +448,35 @@ namespace aslam {
       std::vector<Eigen::VectorXd> _steeringMeasurementsPredErrors;
       /// Steering measurements squared errors
       std::vector<double> _steeringMeasurementsPredErrors2;
+      /// Running statistics of the prediction errors per sensor
+      std::vector<PredictionStatistics> _predictionStatistics;
+      /// Sink receiving every prediction error
+      PredictionSink _predictionSink;
       /// Current rotation spline
       RotationSplineSP _rotationSpline;
       /// Current translation spline
       TranslationSplineSP _translationSpline;
+      /// Splines initializer
+      PoseSplineInitializer _splineInitializer;
       /// Information gain history
       std::vector<double> _infoGainHistory;
       /// Calibration variables history
       std::vector<Eigen::VectorXd> _odometryVariablesHistory;
+      /// Callback for processed batches
+      BatchCallback _batchCallback;
+      /// Batches waiting for the worker thread
+      std::deque<std::pair<BatchMeasurements, std::promise<ReturnValue> > >
+        _batchQueue;
+      /// Number of batches being processed by the worker thread
+      size_t _numBatchesInProgress;
+      /// Stops the worker thread once the queue is empty
+      bool _stopWorker;
+      /// Mutex protecting the queue
+      mutable std::mutex _batchQueueMutex;
+      /// Condition variable signaling queue changes
+      mutable std::condition_variable _batchQueueCondition;
+      /// Worker thread
+      std::thread _worker;
       /** @}
         */
 
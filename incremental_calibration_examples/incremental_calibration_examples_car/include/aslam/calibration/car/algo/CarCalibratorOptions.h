@@ -23,6 +23,7 @@
 #ifndef ASLAM_CALIBRATION_CAR_CALIBRATOR_OPTIONS_H
 #define ASLAM_CALIBRATION_CAR_CALIBRATOR_OPTIONS_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include <sm/timing/NsecTimeUtilities.hpp>
@@ -103,6 +104,14 @@ namespace aslam {
       bool useVelocities;
       /// Bound for time delay
       sm::timing::NsecTime delayBound;
+      /// Process batches on a worker thread
+      bool asyncProcessing;
+      /// Maximum number of batches waiting for the worker thread
+      size_t asyncQueueSize;
+      /// Number of threads for building the error terms of a batch
+      size_t errorTermsThreads;
+      /// Only accumulate statistics of the predictions instead of storing them
+      bool streamPredictions;
       /** @}
         */
 
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file DataWriter.h
+    \brief This file defines the DataWriter class, which writes rows of data
+           either as text or as a columnar binary table.
+  */
+
+#ifndef ASLAM_CALIBRATION_CAR_DATA_WRITER_H
+#define ASLAM_CALIBRATION_CAR_DATA_WRITER_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <sm/timing/NsecTimeUtilities.hpp>
+
+#include <aslam/calibration/base/ColumnarWriter.h>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class DataWriter writes rows of values separated by spaces in a
+        text file, or as a ColumnarWriter table. Timestamps are written in
+        seconds in text and in nanoseconds in binary.
+        \brief Text or binary data writer
+      */
+    class DataWriter {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Self type
+      typedef DataWriter Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs writer on a file, with .bin or .txt extension appended
+      DataWriter(const std::string& fileName, bool binary = false,
+        const std::vector<std::string>& columns = std::vector<std::string>());
+      /// Constructs writer on a stream
+      DataWriter(std::ostream& stream, bool binary = false,
+        const std::vector<std::string>& columns = std::vector<std::string>());
+      /// Copy constructor
+      DataWriter(const Self& other) = delete;
+      /// Copy assignment operator
+      DataWriter& operator = (const Self& other) = delete;
+      /// Destructor
+      virtual ~DataWriter();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Appends a value to the current row
+      DataWriter& operator << (double value);
+      /// Appends a timestamp to the current row
+      DataWriter& operator << (sm::timing::NsecTime timestamp);
+      /// Appends the coefficients of a matrix to the current row
+      template <typename Derived>
+      DataWriter& operator << (const Eigen::MatrixBase<Derived>& values);
+      /// Terminates the current row
+      void endRow();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Checks if the writer is binary
+      bool isBinary() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected methods
+        @{
+        */
+      /// Initializes the writer
+      void init(bool binary, const std::vector<std::string>& columns);
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Owned file
+      std::unique_ptr<std::ofstream> _file;
+      /// Underlying stream
+      std::ostream& _stream;
+      /// Columnar writer in binary mode
+      std::unique_ptr<ColumnarWriter> _columnarWriter;
+      /// Separator needed before the next text value
+      bool _separator;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/car/algo/DataWriter.tpp"
+
+#endif // ASLAM_CALIBRATION_CAR_DATA_WRITER_H
@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file PredictionStatistics.h
+    \brief This file defines the PredictionStatistics class, which accumulates
+           running statistics of prediction errors.
+  */
+
+#ifndef ASLAM_CALIBRATION_CAR_PREDICTION_STATISTICS_H
+#define ASLAM_CALIBRATION_CAR_PREDICTION_STATISTICS_H
+
+#include <cstddef>
+
+#include <Eigen/Core>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class PredictionStatistics accumulates the mean and variance of
+        prediction errors, and of their squared Mahalanobis norms, with
+        Welford's update. Its memory does not depend on the number of
+        predictions.
+        \brief Running statistics of prediction errors
+      */
+    class PredictionStatistics {
+    public:
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Default constructor
+      PredictionStatistics();
+      /// Destructor
+      virtual ~PredictionStatistics();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Adds an error and its squared Mahalanobis norm
+      void addError(const Eigen::VectorXd& error, double error2);
+      /// Resets the statistics
+      void reset();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of errors
+      size_t getNumErrors() const;
+      /// Returns the mean of the errors
+      const Eigen::VectorXd& getMean() const;
+      /// Returns the variance of the errors (per component)
+      Eigen::VectorXd getVariance() const;
+      /// Returns the mean of the squared Mahalanobis norms
+      double getMeanError2() const;
+      /// Returns the variance of the squared Mahalanobis norms
+      double getVarianceError2() const;
+      /// Returns the largest squared Mahalanobis norm
+      double getMaxError2() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Number of errors
+      size_t _numErrors;
+      /// Mean of the errors
+      Eigen::VectorXd _mean;
+      /// Sum of squared differences from the mean of the errors
+      Eigen::VectorXd _m2;
+      /// Mean of the squared Mahalanobis norms
+      double _meanError2;
+      /// Sum of squared differences from the mean of the norms
+      double _m2Error2;
+      /// Largest squared Mahalanobis norm
+      double _maxError2;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_CAR_PREDICTION_STATISTICS_H
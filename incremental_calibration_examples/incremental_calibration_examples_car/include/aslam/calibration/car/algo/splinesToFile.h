@@ -42,6 +42,7 @@ namespace aslam {
   namespace calibration {
 
     class IncrementalEstimator;
+    class DataWriter;
 
     /** \name Types definitions
       @{
@@ -72,6 +73,12 @@ namespace aslam {
     /// Write spline data from spline structure
     void writeSplines(const TranslationSplineSP& transSpline, const
       RotationSplineSP& rotSpline, double dt, std::ofstream& stream);
+    /// Write spline data from incremental estimator to a data writer
+    void writeSplines(const IncrementalEstimatorSP& estimator, double dt,
+      DataWriter& writer);
+    /// Write spline data from spline structure to a data writer
+    void writeSplines(const TranslationSplineSP& transSpline, const
+      RotationSplineSP& rotSpline, double dt, DataWriter& writer);
     /** @}
       */
 
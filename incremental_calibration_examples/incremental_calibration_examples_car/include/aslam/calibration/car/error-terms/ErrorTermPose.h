@@ -94,6 +94,14 @@ namespace aslam {
       /** @}
         */
 
+      /** \name Methods
+        @{
+        */
+      /// Computes the error of a transformation matrix against a measurement
+      static Input computeError(const Eigen::Matrix4d& T, const Input& Tm);
+      /** @}
+        */
+
     protected:
       /** \name Protected methods
         @{
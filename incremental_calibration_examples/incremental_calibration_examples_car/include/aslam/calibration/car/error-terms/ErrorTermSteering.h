@@ -77,6 +77,15 @@ namespace aslam {
       /** @}
         */
 
+      /** \name Methods
+        @{
+        */
+      /// Computes the error of a steering measurement given the wheel velocity
+      static double computeError(const Eigen::Vector3d& v_v_mw,
+        const Eigen::Vector4d& params, double measurement);
+      /** @}
+        */
+
     protected:
       /** \name Protected methods
         @{
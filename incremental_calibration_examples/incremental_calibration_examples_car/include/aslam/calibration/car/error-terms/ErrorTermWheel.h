@@ -96,6 +96,18 @@ namespace aslam {
       /** @}
         */
 
+      /** \name Methods
+        @{
+        */
+      /// Computes the error of a wheel velocity against a measurement
+      static Eigen::Vector3d computeError(const Eigen::Vector3d& v_v_mw,
+        double k, double measurement, bool frontEnabled = false);
+      /// Computes the predicted measurement of a wheel velocity
+      static double computeMeasurement(const Eigen::Vector3d& v_v_mw,
+        double k, bool frontEnabled = false);
+      /** @}
+        */
+
     protected:
       /** \name Protected methods
         @{
@@ -20,6 +20,9 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <exception>
+#include <utility>
 
 #include <boost/make_shared.hpp>
 
@@ -43,6 +46,8 @@
 
 #include <aslam/calibration/core/IncrementalEstimator.h>
 #include <aslam/calibration/data-structures/VectorDesignVariable.h>
+#include <aslam/calibration/exceptions/OutOfBoundException.h>
+#include <aslam/calibration/exceptions/InvalidOperationException.h>
 
 #include "aslam/calibration/car/error-terms/ErrorTermPose.h"
 #include "aslam/calibration/car/error-terms/ErrorTermVelocities.h"
@@ -73,7 +78,19 @@ namespace aslam {
 
     CarCalibrator::CarCalibrator(const PropertyTree& config) :
         _currentBatchStartTimestamp(-1),
-        _lastTimestamp(-1) {
+        _lastTimestamp(-1),
+        _predictionStatistics(NUM_PREDICTION_SENSORS),
+        _splineInitializer(
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::TranslationPoses& transPoses,
+              int numSegments) {
+            return fitTranslationSpline(timestamps, transPoses, numSegments);},
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::RotationPoses& rotPoses,
+              int numSegments) {
+            return fitRotationSpline(timestamps, rotPoses, numSegments);}),
+        _numBatchesInProgress(0),
+        _stopWorker(false) {
       // create the underlying estimator
       _estimator = boost::make_shared<IncrementalEstimator>(
         sm::PropertyTree(config, "estimator"));
@@ -88,9 +105,21 @@ namespace aslam {
       // save initial guess
       _odometryVariablesHistory.push_back(
         _odometryDesignVariables->getParameters());
+
+      // start the worker thread for asynchronous processing
+      if (_options.asyncProcessing)
+        _worker = std::thread(&CarCalibrator::processBatches, this);
     }
 
     CarCalibrator::~CarCalibrator() {
+      if (_worker.joinable()) {
+        {
+          std::lock_guard<std::mutex> lock(_batchQueueMutex);
+          _stopWorker = true;
+        }
+        _batchQueueCondition.notify_all();
+        _worker.join();
+      }
     }
 
 /******************************************************************************/
@@ -107,20 +136,24 @@ namespace aslam {
 
     const CarCalibrator::OdometryDesignVariablesSP&
         CarCalibrator::getOdometryDesignVariables() const {
+      waitForWorker();
       return _odometryDesignVariables;
     }
 
     CarCalibrator::OdometryDesignVariablesSP&
         CarCalibrator::getOdometryDesignVariables() {
+      waitForWorker();
       return _odometryDesignVariables;
     }
 
     const CarCalibrator::IncrementalEstimatorSP CarCalibrator::getEstimator()
         const {
+      waitForWorker();
       return _estimator;
     }
 
     CarCalibrator::IncrementalEstimatorSP CarCalibrator::getEstimator() {
+      waitForWorker();
       return _estimator;
     }
 
@@ -133,25 +166,30 @@ namespace aslam {
     }
 
     const std::vector<double> CarCalibrator::getInformationGainHistory() const {
+      waitForWorker();
       return _infoGainHistory;
     }
 
     const std::vector<Eigen::VectorXd>
         CarCalibrator::getOdometryVariablesHistory() const {
+      waitForWorker();
       return _odometryVariablesHistory;
     }
 
     Eigen::VectorXd CarCalibrator::getOdometryVariablesVariance() const {
+      waitForWorker();
       return _estimator->getSigma2Theta().diagonal();
     }
 
     const CarCalibrator::TranslationSplineSP&
         CarCalibrator::getTranslationSpline() const {
+      waitForWorker();
       return _translationSpline;
     }
 
     const CarCalibrator::RotationSplineSP&
         CarCalibrator::getRotationSpline() const {
+      waitForWorker();
       return _rotationSpline;
     }
 
@@ -273,6 +311,29 @@ namespace aslam {
       return _steeringMeasurementsPredErrors2;
     }
 
+    void CarCalibrator::setBatchCallback(const BatchCallback& callback) {
+      std::lock_guard<std::mutex> lock(_batchQueueMutex);
+      _batchCallback = callback;
+    }
+
+    const PredictionStatistics& CarCalibrator::getPredictionStatistics(
+        PredictionSensor sensor) const {
+      if (sensor >= NUM_PREDICTION_SENSORS)
+        throw OutOfBoundException<size_t>(sensor, NUM_PREDICTION_SENSORS,
+          "CarCalibrator::getPredictionStatistics(): unknown sensor",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return _predictionStatistics[sensor];
+    }
+
+    void CarCalibrator::setPredictionSink(const PredictionSink& sink) {
+      _predictionSink = sink;
+    }
+
+    size_t CarCalibrator::getNumPendingBatches() const {
+      std::lock_guard<std::mutex> lock(_batchQueueMutex);
+      return _batchQueue.size() + _numBatchesInProgress;
+    }
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
@@ -296,10 +357,14 @@ namespace aslam {
       _steeringMeasurementsPred.clear();
       _steeringMeasurementsPredErrors.clear();
       _steeringMeasurementsPredErrors2.clear();
+      for (auto it = _predictionStatistics.begin();
+          it != _predictionStatistics.end(); ++it)
+        it->reset();
     }
 
     void CarCalibrator::predict() {
-      initSplines(_poseMeasurements);
+      waitForBatches();
+      initSplines(_poseMeasurements, true);
       predictPoses(_poseMeasurements);
       predictVelocities(_velocitiesMeasurements);
       predictDMI(_dmiMeasurements);
@@ -353,25 +418,108 @@ namespace aslam {
         addMeasurements();
     }
 
-    void CarCalibrator::addMeasurements() {
+    CarCalibrator::ReturnValueFuture CarCalibrator::addMeasurements() {
       if (_poseMeasurements.size() < 2)
+        return ReturnValueFuture();
+
+      BatchMeasurements measurements;
+      measurements.pose.swap(_poseMeasurements);
+      measurements.velocities.swap(_velocitiesMeasurements);
+      measurements.dmi.swap(_dmiMeasurements);
+      measurements.frontWheelSpeeds.swap(_frontWheelSpeedsMeasurements);
+      measurements.rearWheelSpeeds.swap(_rearWheelSpeedsMeasurements);
+      measurements.steering.swap(_steeringMeasurements);
+      _currentBatchStartTimestamp = _lastTimestamp;
+
+      if (!_options.asyncProcessing) {
+        std::promise<ReturnValue> promise;
+        promise.set_value(processBatch(measurements));
+        return promise.get_future().share();
+      }
+
+      // back-pressure: wait for the worker when the queue is full
+      std::unique_lock<std::mutex> lock(_batchQueueMutex);
+      _batchQueueCondition.wait(lock, [this]() {
+        return _batchQueue.size() < std::max<size_t>(_options.asyncQueueSize,
+          1);});
+      _batchQueue.emplace_back(std::move(measurements),
+        std::promise<ReturnValue>());
+      ReturnValueFuture future = _batchQueue.back().second.get_future().share();
+      lock.unlock();
+      _batchQueueCondition.notify_all();
+      return future;
+    }
+
+    void CarCalibrator::waitForBatches() {
+      // the worker would wait for the batch it is processing
+      if (std::this_thread::get_id() == _worker.get_id())
+        throw InvalidOperationException("CarCalibrator::waitForBatches(): "
+          "cannot wait from the batch callback", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      waitForWorker();
+    }
+
+    void CarCalibrator::waitForWorker() const {
+      // the worker thread owns the state while it processes batches
+      if (!_worker.joinable() ||
+          std::this_thread::get_id() == _worker.get_id())
         return;
+      std::unique_lock<std::mutex> lock(_batchQueueMutex);
+      _batchQueueCondition.wait(lock, [this]() {
+        return _batchQueue.empty() && _numBatchesInProgress == 0;});
+    }
 
+    void CarCalibrator::processBatches() {
+      for (;;) {
+        std::unique_lock<std::mutex> lock(_batchQueueMutex);
+        _batchQueueCondition.wait(lock, [this]() {
+          return _stopWorker || !_batchQueue.empty();});
+        if (_batchQueue.empty())
+          return;
+        auto job = std::move(_batchQueue.front());
+        _batchQueue.pop_front();
+        ++_numBatchesInProgress;
+        lock.unlock();
+        _batchQueueCondition.notify_all();
+        try {
+          job.second.set_value(processBatch(job.first));
+        }
+        catch (...) {
+          job.second.set_exception(std::current_exception());
+        }
+        lock.lock();
+        --_numBatchesInProgress;
+        lock.unlock();
+        _batchQueueCondition.notify_all();
+      }
+    }
+
+    CarCalibrator::ReturnValue CarCalibrator::processBatch(
+        const BatchMeasurements& measurements) {
       auto batch = boost::make_shared<OptimizationProblemSpline>();
       _odometryDesignVariables->addToBatch(batch, 1);
-      initSplines(_poseMeasurements);
+      initSplines(measurements.pose);
       batch->addSpline(_translationSpline, 0);
       batch->addSpline(_rotationSpline, 0);
+      // one arena chunk for the error terms, with headroom for the control
+      // blocks and alignment
+      const size_t headroom = 128;
+      batch->getArena()->reserve(
+        measurements.velocities.size() * (sizeof(ErrorTermVelocities) +
+        headroom) + measurements.pose.size() * (sizeof(ErrorTermPose) +
+        headroom) + (measurements.dmi.size() + 2 *
+        measurements.frontWheelSpeeds.size() + 2 *
+        measurements.rearWheelSpeeds.size()) * (sizeof(ErrorTermWheel) +
+        headroom) + measurements.steering.size() *
+        (sizeof(ErrorTermSteering) + headroom));
       if (_options.useVelocities)
-        addVelocitiesErrorTerms(_velocitiesMeasurements, batch);
+        addVelocitiesErrorTerms(measurements.velocities, batch);
       if (_options.usePose)
-        addPoseErrorTerms(_poseMeasurements, batch);
-      addDMIErrorTerms(_dmiMeasurements, batch);
-      addFrontWheelsErrorTerms(_frontWheelSpeedsMeasurements, batch);
-      addRearWheelsErrorTerms(_rearWheelSpeedsMeasurements, batch);
-      addSteeringErrorTerms(_steeringMeasurements, batch);
-      clearMeasurements();
-      _currentBatchStartTimestamp = _lastTimestamp;
+        addPoseErrorTerms(measurements.pose, batch);
+      addDMIErrorTerms(measurements.dmi, batch);
+      addFrontWheelsErrorTerms(measurements.frontWheelSpeeds, batch);
+      addRearWheelsErrorTerms(measurements.rearWheelSpeeds, batch);
+      addSteeringErrorTerms(measurements.steering, batch);
       batch->setGroupsOrdering({0, 1});
       if (_options.verbose) {
         std::cout << "calibration before batch: " << std::endl;
@@ -385,45 +533,55 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *_odometryDesignVariables << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << ret.marginal->singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
-        std::cout << "e_r: " << ret.obsBasisScaled.row(0).norm() << std::endl;
-        std::cout << "e_f: " << ret.obsBasisScaled.row(1).norm() << std::endl;
-        std::cout << "L: " << ret.obsBasisScaled.row(2).norm() << std::endl;
-        std::cout << "a0: " << ret.obsBasisScaled.row(3).norm() << std::endl;
-        std::cout << "a1: " << ret.obsBasisScaled.row(4).norm() << std::endl;
-        std::cout << "a2: " << ret.obsBasisScaled.row(5).norm() << std::endl;
-        std::cout << "a3: " << ret.obsBasisScaled.row(6).norm() << std::endl;
-        std::cout << "k_rl: " << ret.obsBasisScaled.row(7).norm() << std::endl;
-        std::cout << "k_rr: " << ret.obsBasisScaled.row(8).norm() << std::endl;
-        std::cout << "k_fl: " << ret.obsBasisScaled.row(9).norm() << std::endl;
-        std::cout << "k_fr: " << ret.obsBasisScaled.row(10).norm() << std::endl;
-        std::cout << "k_dmi: " << ret.obsBasisScaled.row(11).norm()
+        const Eigen::MatrixXd& obsBasis = ret.marginal->obsBasisScaled;
+        std::cout << "e_r: " << obsBasis.row(0).norm() << std::endl;
+        std::cout << "e_f: " << obsBasis.row(1).norm() << std::endl;
+        std::cout << "L: " << obsBasis.row(2).norm() << std::endl;
+        std::cout << "a0: " << obsBasis.row(3).norm() << std::endl;
+        std::cout << "a1: " << obsBasis.row(4).norm() << std::endl;
+        std::cout << "a2: " << obsBasis.row(5).norm() << std::endl;
+        std::cout << "a3: " << obsBasis.row(6).norm() << std::endl;
+        std::cout << "k_rl: " << obsBasis.row(7).norm() << std::endl;
+        std::cout << "k_rr: " << obsBasis.row(8).norm() << std::endl;
+        std::cout << "k_fl: " << obsBasis.row(9).norm() << std::endl;
+        std::cout << "k_fr: " << obsBasis.row(10).norm() << std::endl;
+        std::cout << "k_dmi: " << obsBasis.row(11).norm()
           << std::endl;
-        std::cout << "v_r_vr_1: " << ret.obsBasisScaled.row(12).norm()
+        std::cout << "v_r_vr_1: " << obsBasis.row(12).norm()
           << std::endl;
-        std::cout << "v_r_vr_2: " << ret.obsBasisScaled.row(13).norm()
+        std::cout << "v_r_vr_2: " << obsBasis.row(13).norm()
           << std::endl;
-        std::cout << "v_r_vr_3: " << ret.obsBasisScaled.row(14).norm()
+        std::cout << "v_r_vr_3: " << obsBasis.row(14).norm()
           << std::endl;
-        std::cout << "v_R_r_1: " << ret.obsBasisScaled.row(15).norm()
+        std::cout << "v_R_r_1: " << obsBasis.row(15).norm()
           << std::endl;
-        std::cout << "v_R_r_2: " << ret.obsBasisScaled.row(16).norm()
+        std::cout << "v_R_r_2: " << obsBasis.row(16).norm()
           << std::endl;
-        std::cout << "v_R_r_3: " << ret.obsBasisScaled.row(17).norm()
+        std::cout << "v_R_r_3: " << obsBasis.row(17).norm()
           << std::endl;
-        std::cout << "t_r: " << ret.obsBasisScaled.row(18).norm() << std::endl;
-        std::cout << "t_f: " << ret.obsBasisScaled.row(19).norm() << std::endl;
-        std::cout << "t_s: " << ret.obsBasisScaled.row(20).norm() << std::endl;
-        std::cout << "t_dmi: " << ret.obsBasisScaled.row(21).norm()
+        std::cout << "t_r: " << obsBasis.row(18).norm() << std::endl;
+        std::cout << "t_f: " << obsBasis.row(19).norm() << std::endl;
+        std::cout << "t_s: " << obsBasis.row(20).norm() << std::endl;
+        std::cout << "t_dmi: " << obsBasis.row(21).norm()
           << std::endl;
       }
       _infoGainHistory.push_back(ret.informationGain);
       _odometryVariablesHistory.push_back(
         _odometryDesignVariables->getParameters());
+      BatchCallback callback;
+      {
+        std::lock_guard<std::mutex> lock(_batchQueueMutex);
+        callback = _batchCallback;
+      }
+      if (callback)
+        callback(ret);
+      return ret;
     }
 
-    void CarCalibrator::initSplines(const PoseMeasurements& measurements) {
+    void CarCalibrator::initSplines(const PoseMeasurements& measurements,
+        bool reuse) {
       const size_t numMeasurements = measurements.size();
       std::vector<NsecTime> timestamps;
       timestamps.reserve(numMeasurements);
@@ -460,24 +618,83 @@ namespace aslam {
       else
         numSegments = numMeasurements;
 
-      _translationSpline = boost::make_shared<TranslationSpline>(
+      _splineInitializer.initSplines(timestamps, transPoses, rotPoses,
+        numSegments, reuse);
+      _translationSpline = _splineInitializer.getTranslationSpline();
+      _rotationSpline = _splineInitializer.getRotationSpline();
+    }
+
+    CarCalibrator::TranslationSplineSP CarCalibrator::fitTranslationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const {
+      auto translationSpline = boost::make_shared<TranslationSpline>(
         EuclideanBSpline<Eigen::Dynamic, 3, NsecTimePolicy>::CONF(
         EuclideanBSpline<Eigen::Dynamic, 3,
         NsecTimePolicy>::CONF::ManifoldConf(3), _options.transSplineOrder));
-      BSplineFitter<TranslationSpline>::initUniformSpline(*_translationSpline,
+      BSplineFitter<TranslationSpline>::initUniformSpline(*translationSpline,
         timestamps, transPoses, numSegments, _options.transSplineLambda);
+      return translationSpline;
+    }
 
-      _rotationSpline = boost::make_shared<RotationSpline>(
+    CarCalibrator::RotationSplineSP CarCalibrator::fitRotationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const {
+      auto rotationSpline = boost::make_shared<RotationSpline>(
         UnitQuaternionBSpline<Eigen::Dynamic, NsecTimePolicy>::CONF(
         UnitQuaternionBSpline<Eigen::Dynamic,
         NsecTimePolicy>::CONF::ManifoldConf(), _options.rotSplineOrder));
-      BSplineFitter<RotationSpline>::initUniformSpline(*_rotationSpline,
+      BSplineFitter<RotationSpline>::initUniformSpline(*rotationSpline,
         timestamps, rotPoses, numSegments, _options.rotSplineLambda);
+      return rotationSpline;
+    }
+
+    void CarCalibrator::addErrorTerms(size_t numMeasurements,
+        const ErrorTermsBuilder& builder, const OptimizationProblemSplineSP&
+        batch) {
+      const size_t numThreads = std::min(std::max<size_t>(
+        _options.errorTermsThreads, 1), numMeasurements);
+      if (numThreads <= 1) {
+        ErrorTerms errorTerms;
+        for (size_t i = 0; i < numMeasurements; ++i)
+          builder(i, errorTerms);
+        for (auto it = errorTerms.cbegin(); it != errorTerms.cend(); ++it)
+          batch->addErrorTerm(*it);
+        return;
+      }
+
+      // contiguous chunks, inserted in chunk order to keep the serial order
+      std::vector<ErrorTerms> chunks(numThreads);
+      std::vector<std::exception_ptr> exceptions(numThreads);
+      std::vector<std::thread> threads;
+      threads.reserve(numThreads);
+      for (size_t t = 0; t < numThreads; ++t)
+        threads.emplace_back([&, t]() {
+          try {
+            const size_t begin = t * numMeasurements / numThreads;
+            const size_t end = (t + 1) * numMeasurements / numThreads;
+            for (size_t i = begin; i < end; ++i)
+              builder(i, chunks[t]);
+          }
+          catch (...) {
+            exceptions[t] = std::current_exception();
+          }
+        });
+      for (auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+      for (auto it = exceptions.cbegin(); it != exceptions.cend(); ++it)
+        if (*it)
+          std::rethrow_exception(*it);
+      for (auto it = chunks.cbegin(); it != chunks.cend(); ++it)
+        for (auto jt = it->cbegin(); jt != it->cend(); ++jt)
+          batch->addErrorTerm(*jt);
     }
 
     void CarCalibrator::addPoseErrorTerms(const PoseMeasurements& measurements,
         const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         auto timestamp = it->first;
         ErrorTermPose::Input m_T_r;
         m_T_r.head<3>() = it->second.m_r_mr;
@@ -499,10 +716,11 @@ namespace aslam {
         auto m_r_mr = m_r_mv + m_r_vr;
         auto v_R_r = RotationExpression(_odometryDesignVariables->v_R_r);
         auto m_R_r = m_R_v * v_R_r;
-        auto e_pose = boost::make_shared<ErrorTermPose>(
+        auto e_pose = batch->allocate<ErrorTermPose>(
           TransformationExpression(m_R_r, m_r_mr), m_T_r, Q);
-        batch->addErrorTerm(e_pose);
-      }
+        errorTerms.push_back(e_pose);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictPoses(const PoseMeasurements& measurements) {
@@ -528,14 +746,19 @@ namespace aslam {
         auto m_r_mr = m_r_mv + m_r_vr;
         auto v_R_r = RotationExpression(_odometryDesignVariables->v_R_r);
         auto m_R_r = m_R_v * v_R_r;
-        auto e_pose = boost::make_shared<ErrorTermPose>(
-          TransformationExpression(m_R_r, m_r_mr), m_T_r, Q);
-        auto sr = e_pose->evaluateError();
-        auto error = e_pose->error();
+        Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+        T.topLeftCorner<3, 3>() = m_R_r.toRotationMatrix();
+        T.topRightCorner<3, 1>() = m_r_mr.toValue();
+        const ErrorTermPose::Input error = ErrorTermPose::computeError(T,
+          m_T_r);
+        const double sr = error.dot(Q.ldlt().solve(error));
+        reportPrediction(POSE, timestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         PoseMeasurement pose;
-        pose.m_r_mr = m_r_mr.toValue();
+        pose.m_r_mr = T.topRightCorner<3, 1>();
         const EulerAnglesYawPitchRoll ypr;
-        pose.m_R_r = ypr.rotationMatrixToParameters(m_R_r.toRotationMatrix());
+        pose.m_R_r = ypr.rotationMatrixToParameters(T.topLeftCorner<3, 3>());
         _poseMeasurementsPred.push_back(std::make_pair(timestamp, pose));
         _poseMeasurementsPredErrors.push_back(error);
         _poseMeasurementsPredErrors2.push_back(sr);
@@ -544,11 +767,12 @@ namespace aslam {
 
     void CarCalibrator::addVelocitiesErrorTerms(const VelocitiesMeasurements&
         measurements, const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         auto timestamp = it->first;
         if (_translationSpline->getMinTime() > timestamp ||
             _translationSpline->getMaxTime() < timestamp)
-          continue;
+          return;
 
         auto translationExpressionFactory =
           _translationSpline->getExpressionFactoryAt<1>(timestamp);
@@ -568,11 +792,12 @@ namespace aslam {
         auto r_v_mr = v_R_r.inverse() * (v_v_mv + v_om_mv.cross(v_r_vr));
         auto r_om_mr = v_R_r.inverse() * v_om_mv;
 
-        auto e_vel = boost::make_shared<ErrorTermVelocities>(r_v_mr, r_om_mr,
+        auto e_vel = batch->allocate<ErrorTermVelocities>(r_v_mr, r_om_mr,
           it->second.r_v_mr, it->second.r_om_mr, it->second.sigma2_r_v_mr,
           it->second.sigma2_r_om_mr);
-        batch->addErrorTerm(e_vel);
-      }
+        errorTerms.push_back(e_vel);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictVelocities(const VelocitiesMeasurements&
@@ -601,14 +826,19 @@ namespace aslam {
         auto r_v_mr = v_R_r.inverse() * (v_v_mv + v_om_mv.cross(v_r_vr));
         auto r_om_mr = v_R_r.inverse() * v_om_mv;
 
-        auto e_vel = boost::make_shared<ErrorTermVelocities>(r_v_mr, r_om_mr,
-          it->second.r_v_mr, it->second.r_om_mr, it->second.sigma2_r_v_mr,
-          it->second.sigma2_r_om_mr);
-        auto sr = e_vel->evaluateError();
-        auto error = e_vel->error();
         VelocitiesMeasurement vel;
         vel.r_v_mr = r_v_mr.toValue();
         vel.r_om_mr = r_om_mr.toValue();
+        Eigen::Matrix<double, 6, 1> error;
+        error.head<3>() = it->second.r_v_mr - vel.r_v_mr;
+        error.tail<3>() = it->second.r_om_mr - vel.r_om_mr;
+        const double sr = error.head<3>().dot(
+          it->second.sigma2_r_v_mr.ldlt().solve(error.head<3>())) +
+          error.tail<3>().dot(
+          it->second.sigma2_r_om_mr.ldlt().solve(error.tail<3>()));
+        reportPrediction(VELOCITIES, timestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         _velocitiesMeasurementsPred.push_back(std::make_pair(timestamp, vel));
         _velocitiesMeasurementsPredErrors.push_back(error);
         _velocitiesMeasurementsPredErrors2.push_back(sr);
@@ -617,7 +847,8 @@ namespace aslam {
 
     void CarCalibrator::addDMIErrorTerms(const DMIMeasurements& measurements,
         const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         auto timestamp = it->first;
         auto timeDelay = _odometryDesignVariables->t_dmi->toExpression();
         auto timestampDelay = timeDelay +
@@ -630,7 +861,7 @@ namespace aslam {
           timestampDelay.toScalar().getNumerator();
 
         if(uBound > Tmax || lBound < Tmin)
-          continue;
+          return;
 
         auto translationExpressionFactory =
           _translationSpline->getExpressionFactoryAt<1>(timestampDelay,
@@ -651,12 +882,13 @@ namespace aslam {
         auto v_r_wl = EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_r;
         auto w_v_mw = v_v_mv + v_om_mv.cross(v_r_wl);
 
-        auto e_dmi = boost::make_shared<ErrorTermWheel>(w_v_mw,
+        auto e_dmi = batch->allocate<ErrorTermWheel>(w_v_mw,
           ScalarExpression(_odometryDesignVariables->k_dmi),
           it->second.wheelSpeed, Eigen::Vector3d(_options.dmiVariance,
           _options.vyVariance, _options.vzVariance).asDiagonal());
-        batch->addErrorTerm(e_dmi);
-      }
+        errorTerms.push_back(e_dmi);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictDMI(const DMIMeasurements& measurements) {
@@ -694,17 +926,20 @@ namespace aslam {
         auto v_r_wl = EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_r;
         auto w_v_mw = v_v_mv + v_om_mv.cross(v_r_wl);
 
-        auto e_dmi = boost::make_shared<ErrorTermWheel>(w_v_mw,
-          ScalarExpression(_odometryDesignVariables->k_dmi),
-          it->second.wheelSpeed, Eigen::Vector3d(_options.dmiVariance,
-          _options.vyVariance, _options.vzVariance).asDiagonal());
-        auto sr = e_dmi->evaluateError();
-        auto error = e_dmi->error();
+        const Eigen::Vector3d w_v_mw_value = w_v_mw.toValue();
+        const double k = _odometryDesignVariables->k_dmi->toScalar();
+        const Eigen::Vector3d error = ErrorTermWheel::computeError(
+          w_v_mw_value, k, it->second.wheelSpeed);
+        const double sr = error.cwiseQuotient(Eigen::Vector3d(
+          _options.dmiVariance, _options.vyVariance,
+          _options.vzVariance)).dot(error);
+        const NsecTime predTimestamp = timestampDelay.toScalar().getNumerator();
+        reportPrediction(DMI, predTimestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         DMIMeasurement dmi;
-        dmi.wheelSpeed = _odometryDesignVariables->k_dmi->toScalar() *
-          w_v_mw.toValue()(0);
-        _dmiMeasurementsPred.push_back(std::make_pair(
-          timestampDelay.toScalar().getNumerator(), dmi));
+        dmi.wheelSpeed = ErrorTermWheel::computeMeasurement(w_v_mw_value, k);
+        _dmiMeasurementsPred.push_back(std::make_pair(predTimestamp, dmi));
         _dmiMeasurementsPredErrors.push_back(error);
         _dmiMeasurementsPredErrors2.push_back(sr);
       }
@@ -712,10 +947,11 @@ namespace aslam {
 
     void CarCalibrator::addFrontWheelsErrorTerms(const WheelSpeedsMeasurements&
         measurements, const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         if (it->second.left < _options.wheelSpeedSensorCutoff ||
             it->second.right < _options.wheelSpeedSensorCutoff)
-          continue;
+          return;
 
         auto timestamp = it->first;
         auto timeDelay = _odometryDesignVariables->t_f->toExpression();
@@ -729,7 +965,7 @@ namespace aslam {
           timestampDelay.toScalar().getNumerator();
 
         if(uBound > Tmax || lBound < Tmin)
-          continue;
+          return;
 
         auto translationExpressionFactory =
           _translationSpline->getExpressionFactoryAt<1>(timestampDelay,
@@ -744,7 +980,7 @@ namespace aslam {
           translationExpressionFactory.getValueExpression(1));
         auto v_v_mv = m_R_v.inverse() * m_v_mv;
         if (v_v_mv.toValue()(0) < 0)
-          continue;
+          return;
         auto m_om_mv = -EuclideanExpression(
           rotationExpressionFactory.getAngularVelocityExpression());
         auto v_om_mv = m_R_v.inverse() * m_om_mv;
@@ -759,18 +995,19 @@ namespace aslam {
           EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_f;
         auto v_v_mw_r = v_v_mv + v_om_mv.cross(v_r_wr);
 
-        auto e_flw = boost::make_shared<ErrorTermWheel>(v_v_mw_l,
+        auto e_flw = batch->allocate<ErrorTermWheel>(v_v_mw_l,
           ScalarExpression(_odometryDesignVariables->k_fl),
           it->second.left, Eigen::Vector3d(_options.flwVariance,
           _options.vyVariance, _options.vzVariance).asDiagonal(), true);
-        batch->addErrorTerm(e_flw);
+        errorTerms.push_back(e_flw);
           _odometryDesignVariables->k_fr->toScalar();
-        auto e_frw = boost::make_shared<ErrorTermWheel>(v_v_mw_r,
+        auto e_frw = batch->allocate<ErrorTermWheel>(v_v_mw_r,
           ScalarExpression(_odometryDesignVariables->k_fr),
           it->second.right, Eigen::Vector3d(_options.frwVariance,
           _options.vyVariance, _options.vzVariance).asDiagonal(), true);
-        batch->addErrorTerm(e_frw);
-      }
+        errorTerms.push_back(e_frw);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictFrontWheels(const WheelSpeedsMeasurements&
@@ -822,46 +1059,43 @@ namespace aslam {
           EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_f;
         auto v_v_mw_r = v_v_mv + v_om_mv.cross(v_r_wr);
 
-        auto e_flw = boost::make_shared<ErrorTermWheel>(v_v_mw_l,
-          ScalarExpression(_odometryDesignVariables->k_fl),
-          it->second.left, Eigen::Vector3d(_options.flwVariance,
-          _options.vyVariance, _options.vzVariance).asDiagonal(), true);
-          _odometryDesignVariables->k_fr->toScalar();
-        auto e_frw = boost::make_shared<ErrorTermWheel>(v_v_mw_r,
-          ScalarExpression(_odometryDesignVariables->k_fr),
-          it->second.right, Eigen::Vector3d(_options.frwVariance,
-          _options.vyVariance, _options.vzVariance).asDiagonal(), true);
-        auto sr_l = e_flw->evaluateError();
-        auto error_l = e_flw->error();
-        auto sr_r = e_frw->evaluateError();
-        auto error_r = e_frw->error();
-        double v0 = v_v_mw_l.toValue()(0);
-        double v1 = v_v_mw_l.toValue()(1);
-        double k = _odometryDesignVariables->k_fl->toScalar();
-        double temp = std::sqrt(v1 * v1 / (v0 * v0) + 1);
+        const Eigen::Vector3d v_v_mw_l_value = v_v_mw_l.toValue();
+        const Eigen::Vector3d v_v_mw_r_value = v_v_mw_r.toValue();
+        const double k_l = _odometryDesignVariables->k_fl->toScalar();
+        const double k_r = _odometryDesignVariables->k_fr->toScalar();
+        Eigen::Matrix<double, 6, 1> error;
+        error.head<3>() = ErrorTermWheel::computeError(v_v_mw_l_value, k_l,
+          it->second.left, true);
+        error.tail<3>() = ErrorTermWheel::computeError(v_v_mw_r_value, k_r,
+          it->second.right, true);
+        const double sr = error.head<3>().cwiseQuotient(Eigen::Vector3d(
+          _options.flwVariance, _options.vyVariance,
+          _options.vzVariance)).dot(error.head<3>()) +
+          error.tail<3>().cwiseQuotient(Eigen::Vector3d(_options.frwVariance,
+          _options.vyVariance, _options.vzVariance)).dot(error.tail<3>());
+        const NsecTime predTimestamp = timestampDelay.toScalar().getNumerator();
+        reportPrediction(FRONT_WHEELS, predTimestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         WheelSpeedsMeasurement data;
-        data.left = k * (v0 / temp + v1 * v1 / (v0 * temp));
-        v0 = v_v_mw_r.toValue()(0);
-        v1 = v_v_mw_r.toValue()(1);
-        k = _odometryDesignVariables->k_fr->toScalar();
-        temp = std::sqrt(v1 * v1 / (v0 * v0) + 1);
-        data.right = k * (v0 / temp + v1 * v1 / (v0 * temp));
+        data.left = ErrorTermWheel::computeMeasurement(v_v_mw_l_value, k_l,
+          true);
+        data.right = ErrorTermWheel::computeMeasurement(v_v_mw_r_value, k_r,
+          true);
         _frontWheelSpeedsMeasurementsPred.push_back(std::make_pair(
-          timestampDelay.toScalar().getNumerator(), data));
-        Eigen::Matrix<double, 6, 1> error;
-        error.head<3>() = error_l;
-        error.tail<3>() = error_r;
+          predTimestamp, data));
         _frontWheelSpeedsMeasurementsPredErrors.push_back(error);
-        _frontWheelSpeedsMeasurementsPredErrors2.push_back(sr_l + sr_r);
+        _frontWheelSpeedsMeasurementsPredErrors2.push_back(sr);
       }
     }
 
     void CarCalibrator::addRearWheelsErrorTerms(const WheelSpeedsMeasurements&
         measurements, const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         if (it->second.left < _options.wheelSpeedSensorCutoff ||
             it->second.right < _options.wheelSpeedSensorCutoff)
-          continue;
+          return;
 
         auto timestamp = it->first;
         auto timeDelay = _odometryDesignVariables->t_r->toExpression();
@@ -875,7 +1109,7 @@ namespace aslam {
           timestampDelay.toScalar().getNumerator();
 
         if(uBound > Tmax || lBound < Tmin)
-          continue;
+          return;
 
         auto translationExpressionFactory =
           _translationSpline->getExpressionFactoryAt<1>(timestampDelay,
@@ -890,7 +1124,7 @@ namespace aslam {
           translationExpressionFactory.getValueExpression(1));
         auto v_v_mv = m_R_v.inverse() * m_v_mv;
         if (v_v_mv.toValue()(0) < 0)
-          continue;
+          return;
         auto m_om_mv = -EuclideanExpression(
           rotationExpressionFactory.getAngularVelocityExpression());
         auto v_om_mv = m_R_v.inverse() * m_om_mv;
@@ -901,17 +1135,18 @@ namespace aslam {
           -EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_r;
         auto w_v_mw_r = v_v_mv + v_om_mv.cross(v_r_wr);
 
-        auto e_rlw = boost::make_shared<ErrorTermWheel>(w_v_mw_l,
+        auto e_rlw = batch->allocate<ErrorTermWheel>(w_v_mw_l,
           ScalarExpression(_odometryDesignVariables->k_rl),
           it->second.left, Eigen::Vector3d(_options.flwVariance,
           _options.vyVariance, _options.vzVariance).asDiagonal());
-        batch->addErrorTerm(e_rlw);
-        auto e_rrw = boost::make_shared<ErrorTermWheel>(w_v_mw_r,
+        errorTerms.push_back(e_rlw);
+        auto e_rrw = batch->allocate<ErrorTermWheel>(w_v_mw_r,
           ScalarExpression(_odometryDesignVariables->k_rr),
           it->second.right, Eigen::Vector3d(_options.frwVariance,
           _options.vyVariance, _options.vzVariance).asDiagonal());
-        batch->addErrorTerm(e_rrw);
-      }
+        errorTerms.push_back(e_rrw);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictRearWheels(const WheelSpeedsMeasurements&
@@ -959,36 +1194,38 @@ namespace aslam {
           -EuclideanExpression(Eigen::Vector3d(0.0, 1.0, 0.0)) * e_r;
         auto w_v_mw_r = v_v_mv + v_om_mv.cross(v_r_wr);
 
-        auto e_rlw = boost::make_shared<ErrorTermWheel>(w_v_mw_l,
-          ScalarExpression(_odometryDesignVariables->k_rl),
-          it->second.left, Eigen::Vector3d(_options.flwVariance,
-          _options.vyVariance, _options.vzVariance).asDiagonal());
-        auto e_rrw = boost::make_shared<ErrorTermWheel>(w_v_mw_r,
-          ScalarExpression(_odometryDesignVariables->k_rr),
-          it->second.right, Eigen::Vector3d(_options.frwVariance,
-          _options.vyVariance, _options.vzVariance).asDiagonal());
-        auto sr_l = e_rlw->evaluateError();
-        auto error_l = e_rlw->error();
-        auto sr_r = e_rrw->evaluateError();
-        auto error_r = e_rrw->error();
+        const Eigen::Vector3d w_v_mw_l_value = w_v_mw_l.toValue();
+        const Eigen::Vector3d w_v_mw_r_value = w_v_mw_r.toValue();
+        const double k_l = _odometryDesignVariables->k_rl->toScalar();
+        const double k_r = _odometryDesignVariables->k_rr->toScalar();
+        Eigen::Matrix<double, 6, 1> error;
+        error.head<3>() = ErrorTermWheel::computeError(w_v_mw_l_value, k_l,
+          it->second.left);
+        error.tail<3>() = ErrorTermWheel::computeError(w_v_mw_r_value, k_r,
+          it->second.right);
+        const double sr = error.head<3>().cwiseQuotient(Eigen::Vector3d(
+          _options.flwVariance, _options.vyVariance,
+          _options.vzVariance)).dot(error.head<3>()) +
+          error.tail<3>().cwiseQuotient(Eigen::Vector3d(_options.frwVariance,
+          _options.vyVariance, _options.vzVariance)).dot(error.tail<3>());
+        const NsecTime predTimestamp = timestampDelay.toScalar().getNumerator();
+        reportPrediction(REAR_WHEELS, predTimestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         WheelSpeedsMeasurement data;
-        data.left = _odometryDesignVariables->k_rl->toScalar() *
-          w_v_mw_l.toValue()(0);
-        data.right = _odometryDesignVariables->k_rr->toScalar() *
-          w_v_mw_r.toValue()(0);
+        data.left = ErrorTermWheel::computeMeasurement(w_v_mw_l_value, k_l);
+        data.right = ErrorTermWheel::computeMeasurement(w_v_mw_r_value, k_r);
         _rearWheelSpeedsMeasurementsPred.push_back(std::make_pair(
-          timestampDelay.toScalar().getNumerator(), data));
-        Eigen::Matrix<double, 6, 1> error;
-        error.head<3>() = error_l;
-        error.tail<3>() = error_r;
+          predTimestamp, data));
         _rearWheelSpeedsMeasurementsPredErrors.push_back(error);
-        _rearWheelSpeedsMeasurementsPredErrors2.push_back(sr_l + sr_r);
+        _rearWheelSpeedsMeasurementsPredErrors2.push_back(sr);
       }
     }
 
     void CarCalibrator::addSteeringErrorTerms(const SteeringMeasurements&
         measurements, const OptimizationProblemSplineSP& batch) {
-      for (auto it = measurements.cbegin(); it != measurements.cend(); ++it) {
+      auto build = [&](size_t i, ErrorTerms& errorTerms) {
+        const auto it = measurements.cbegin() + i;
         auto timestamp = it->first;
         auto timeDelay = _odometryDesignVariables->t_s->toExpression();
         auto timestampDelay = timeDelay +
@@ -1001,7 +1238,7 @@ namespace aslam {
           timestampDelay.toScalar().getNumerator();
 
         if(uBound > Tmax || lBound < Tmin)
-          continue;
+          return;
 
         auto translationExpressionFactory =
           _translationSpline->getExpressionFactoryAt<1>(timestampDelay,
@@ -1023,13 +1260,14 @@ namespace aslam {
         auto v_v_mw = v_v_mv + v_om_mv.cross(v_r_w);
 
         if (std::fabs(v_v_mw.toValue()(0)) < _options.linearVelocityTolerance)
-          continue;
+          return;
 
-        auto e_st = boost::make_shared<ErrorTermSteering>(v_v_mw,
+        auto e_st = batch->allocate<ErrorTermSteering>(v_v_mw,
           it->second.value, _options.steeringVariance,
           _odometryDesignVariables->a.get());
-        batch->addErrorTerm(e_st);
-      }
+        errorTerms.push_back(e_st);
+      };
+      addErrorTerms(measurements.size(), build, batch);
     }
 
     void CarCalibrator::predictSteering(const SteeringMeasurements&
@@ -1071,21 +1309,31 @@ namespace aslam {
         if (std::fabs(v_v_mw.toValue()(0)) < _options.linearVelocityTolerance)
           continue;
 
-        auto e_st = boost::make_shared<ErrorTermSteering>(v_v_mw,
-          it->second.value, _options.steeringVariance,
-          _odometryDesignVariables->a.get());
-        auto sr = e_st->evaluateError();
-        auto error = e_st->error();
+        const Eigen::Vector3d v_v_mw_value = v_v_mw.toValue();
+        Eigen::Matrix<double, 1, 1> error;
+        error(0) = ErrorTermSteering::computeError(v_v_mw_value,
+          _odometryDesignVariables->a->getValue(), it->second.value);
+        const double sr = error(0) * error(0) / _options.steeringVariance;
+        const NsecTime predTimestamp = timestampDelay.toScalar().getNumerator();
+        reportPrediction(STEERING, predTimestamp, error, sr);
+        if (_options.streamPredictions)
+          continue;
         SteeringMeasurement data;
-        const double phi = std::atan2(v_v_mw.toValue()(1), v_v_mw.toValue()(0));
-        data.value = phi;
-        _steeringMeasurementsPred.push_back(std::make_pair(
-          timestampDelay.toScalar().getNumerator(), data));
+        data.value = std::atan2(v_v_mw_value(1), v_v_mw_value(0));
+        _steeringMeasurementsPred.push_back(std::make_pair(predTimestamp,
+          data));
         _steeringMeasurementsPredErrors.push_back(error);
         _steeringMeasurementsPredErrors2.push_back(sr);
       }
     }
 
+    void CarCalibrator::reportPrediction(PredictionSensor sensor, NsecTime
+        timestamp, const Eigen::VectorXd& error, double error2) {
+      _predictionStatistics[sensor].addError(error, error2);
+      if (_predictionSink)
+        _predictionSink(sensor, timestamp, error, error2);
+    }
+
     void CarCalibrator::clearMeasurements() {
       _poseMeasurements.clear();
       _velocitiesMeasurements.clear();
@@ -54,7 +54,11 @@ namespace aslam {
         verbose(true),
         usePose(true),
         useVelocities(false),
-        delayBound(50000000) {
+        delayBound(50000000),
+        asyncProcessing(false),
+        asyncQueueSize(2),
+        errorTermsThreads(1),
+        streamPredictions(false) {
     }
 
     CarCalibratorOptions::CarCalibratorOptions(const PropertyTree& config) {
@@ -63,6 +67,10 @@ namespace aslam {
       usePose = config.getBool("usePose");
       useVelocities = config.getBool("useVelocities");
       delayBound = config.getInt("odometry/timeDelays/delayBound");
+      asyncProcessing = config.getBool("asyncProcessing", false);
+      asyncQueueSize = config.getInt("asyncQueueSize", 2);
+      errorTermsThreads = config.getInt("errorTermsThreads", 1);
+      streamPredictions = config.getBool("streamPredictions", false);
 
       transSplineLambda = config.getDouble("splines/transSplineLambda");
       rotSplineLambda = config.getDouble("splines/rotSplineLambda");
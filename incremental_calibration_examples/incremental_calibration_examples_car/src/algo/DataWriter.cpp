@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/car/algo/DataWriter.h"
+
+#include <iomanip>
+
+using namespace sm::timing;
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    DataWriter::DataWriter(const std::string& fileName, bool binary,
+        const std::vector<std::string>& columns) :
+        _file(new std::ofstream(fileName + (binary ? ".bin" : ".txt"),
+          binary ? std::ios::out | std::ios::binary : std::ios::out)),
+        _stream(*_file) {
+      init(binary, columns);
+    }
+
+    DataWriter::DataWriter(std::ostream& stream, bool binary,
+        const std::vector<std::string>& columns) :
+        _stream(stream) {
+      init(binary, columns);
+    }
+
+    DataWriter::~DataWriter() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    bool DataWriter::isBinary() const {
+      return static_cast<bool>(_columnarWriter);
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void DataWriter::init(bool binary, const std::vector<std::string>&
+        columns) {
+      _separator = false;
+      if (binary) {
+        _columnarWriter.reset(new ColumnarWriter(_stream));
+        _columnarWriter->setColumnNames(columns);
+      }
+      else
+        _stream << std::fixed << std::setprecision(18);
+    }
+
+    DataWriter& DataWriter::operator << (double value) {
+      if (_columnarWriter)
+        _columnarWriter->write(value);
+      else {
+        if (_separator)
+          _stream << " ";
+        _stream << value;
+        _separator = true;
+      }
+      return *this;
+    }
+
+    DataWriter& DataWriter::operator << (NsecTime timestamp) {
+      if (_columnarWriter)
+        _columnarWriter->write(static_cast<int64_t>(timestamp));
+      else
+        *this << nsecToSec(timestamp);
+      return *this;
+    }
+
+    void DataWriter::endRow() {
+      if (_columnarWriter)
+        _columnarWriter->endRow();
+      else {
+        _stream << std::endl;
+        _separator = false;
+      }
+    }
+
+  }
+}
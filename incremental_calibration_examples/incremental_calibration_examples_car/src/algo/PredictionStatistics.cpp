@@ -0,0 +1,105 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "aslam/calibration/car/algo/PredictionStatistics.h"
+
+#include <algorithm>
+
+#include <aslam/calibration/exceptions/OutOfBoundException.h>
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    PredictionStatistics::PredictionStatistics() {
+      reset();
+    }
+
+    PredictionStatistics::~PredictionStatistics() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    size_t PredictionStatistics::getNumErrors() const {
+      return _numErrors;
+    }
+
+    const Eigen::VectorXd& PredictionStatistics::getMean() const {
+      return _mean;
+    }
+
+    Eigen::VectorXd PredictionStatistics::getVariance() const {
+      if (_numErrors == 0)
+        return _m2;
+      return _m2 / _numErrors;
+    }
+
+    double PredictionStatistics::getMeanError2() const {
+      return _meanError2;
+    }
+
+    double PredictionStatistics::getVarianceError2() const {
+      if (_numErrors == 0)
+        return 0.0;
+      return _m2Error2 / _numErrors;
+    }
+
+    double PredictionStatistics::getMaxError2() const {
+      return _maxError2;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void PredictionStatistics::addError(const Eigen::VectorXd& error,
+        double error2) {
+      if (_numErrors == 0) {
+        _mean = Eigen::VectorXd::Zero(error.size());
+        _m2 = Eigen::VectorXd::Zero(error.size());
+      }
+      else if (error.size() != _mean.size())
+        throw OutOfBoundException<size_t>(error.size(), _mean.size(),
+          "PredictionStatistics::addError(): wrong error dimension",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      _numErrors++;
+      const Eigen::VectorXd delta = error - _mean;
+      _mean += delta / _numErrors;
+      _m2 += delta.cwiseProduct(error - _mean);
+      const double deltaError2 = error2 - _meanError2;
+      _meanError2 += deltaError2 / _numErrors;
+      _m2Error2 += deltaError2 * (error2 - _meanError2);
+      _maxError2 = std::max(_maxError2, error2);
+    }
+
+    void PredictionStatistics::reset() {
+      _numErrors = 0;
+      _mean.resize(0);
+      _m2.resize(0);
+      _meanError2 = 0.0;
+      _m2Error2 = 0.0;
+      _maxError2 = 0.0;
+    }
+
+  }
+}
@@ -29,6 +29,7 @@
 #include <bsplines/NsecTimePolicy.hpp>
 
 #include "aslam/calibration/car/algo/OptimizationProblemSpline.h"
+#include "aslam/calibration/car/algo/DataWriter.h"
 
 using namespace sm::timing;
 using namespace sm::kinematics;
@@ -42,6 +43,18 @@ namespace aslam {
 
     void writeSplines(const IncrementalEstimatorSP& estimator, double dt,
         std::ofstream& stream) {
+      DataWriter writer(stream);
+      writeSplines(estimator, dt, writer);
+    }
+
+    void writeSplines(const TranslationSplineSP& transSpline, const
+        RotationSplineSP& rotSpline, double dt, std::ofstream& stream) {
+      DataWriter writer(stream);
+      writeSplines(transSpline, rotSpline, dt, writer);
+    }
+
+    void writeSplines(const IncrementalEstimatorSP& estimator, double dt,
+        DataWriter& writer) {
       auto batches = estimator->getProblem()->getOptimizationProblems();
       for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
         auto transSplines = dynamic_cast<const OptimizationProblemSpline*>(
@@ -51,26 +64,25 @@ namespace aslam {
         for (auto itSplines = transSplines.cbegin(); itSplines !=
             transSplines.cend(); ++itSplines) {
           writeSplines(*itSplines, rotSplines.at(std::distance(
-            transSplines.cbegin(), itSplines)), dt, stream);
+            transSplines.cbegin(), itSplines)), dt, writer);
         }
       }
     }
 
     void writeSplines(const TranslationSplineSP& transSpline, const
-        RotationSplineSP& rotSpline, double dt, std::ofstream& stream) {
+        RotationSplineSP& rotSpline, double dt, DataWriter& writer) {
       auto t = transSpline->getMinTime();
       auto T = transSpline->getMaxTime();
       const EulerAnglesYawPitchRoll ypr;
       while (t < T) {
         auto translationExpressionFactory =
           transSpline->getExpressionFactoryAt<0>(t);
-        stream << translationExpressionFactory.getValueExpression().toValue().
-            transpose() << " ";
+        writer << translationExpressionFactory.getValueExpression().toValue();
         auto rotationExpressionFactory =
           rotSpline->getExpressionFactoryAt<0>(t);
-        stream << ypr.rotationMatrixToParameters(quat2r(
-          rotationExpressionFactory.getValueExpression().toValue())).
-            transpose() << std::endl;
+        writer << ypr.rotationMatrixToParameters(quat2r(
+          rotationExpressionFactory.getValueExpression().toValue()));
+        writer.endRow();
         t += secToNsec(dt);
       }
     }
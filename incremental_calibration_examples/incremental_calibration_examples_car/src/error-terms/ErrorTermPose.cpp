@@ -94,18 +94,22 @@ namespace aslam {
 /* Methods                                                                    */
 /******************************************************************************/
 
-    double ErrorTermPose::evaluateErrorImplementation() {
-      const Eigen::Matrix4d T = _T.toTransformationMatrix();
+    ErrorTermPose::Input ErrorTermPose::computeError(const Eigen::Matrix4d& T,
+        const Input& Tm) {
       Input e;
       e.head<3>() = T.topRightCorner<3, 1>();
       const sm::kinematics::EulerAnglesYawPitchRoll ypr;
       e.tail<3>() =
         ypr.rotationMatrixToParameters(T.topLeftCorner<3, 3>());
-      error_t error = _Tm - e;
+      Input error = Tm - e;
       error(3) = sm::kinematics::angleMod(error(3));
       error(4) = sm::kinematics::angleMod(error(4));
       error(5) = sm::kinematics::angleMod(error(5));
-      setError(error);
+      return error;
+    }
+
+    double ErrorTermPose::evaluateErrorImplementation() {
+      setError(computeError(_T.toTransformationMatrix(), _Tm));
       return evaluateChiSquaredError();
     }
 
@@ -96,18 +96,22 @@ namespace aslam {
 /* Methods                                                                    */
 /******************************************************************************/
 
+    double ErrorTermSteering::computeError(const Eigen::Vector3d& v_v_mw,
+        const Eigen::Vector4d& params, double measurement) {
+      const double a0 = params(0);
+      const double a1 = params(1);
+      const double a2 = params(2);
+      const double a3 = params(3);
+      const double phi = std::atan2(v_v_mw(1), v_v_mw(0));
+      return sm::kinematics::angleMod(a0 + a1 * measurement + a2 *
+        measurement * measurement + a3 * measurement * measurement *
+        measurement - phi);
+    }
+
     double ErrorTermSteering::evaluateErrorImplementation() {
       error_t error;
-      const double a0 = _params->getValue()(0);
-      const double a1 = _params->getValue()(1);
-      const double a2 = _params->getValue()(2);
-      const double a3 = _params->getValue()(3);
-      const double v0 = _v_v_mw.toValue()(0);
-      const double v1 = _v_v_mw.toValue()(1);
-      const double phi = std::atan2(v1, v0);
-      error(0) = a0 + a1 * _measurement + a2 * _measurement * _measurement +
-        a3 * _measurement * _measurement * _measurement - phi;
-      error(0) = sm::kinematics::angleMod(error(0));
+      error(0) = computeError(_v_v_mw.toValue(), _params->getValue(),
+        _measurement);
       setError(error);
       return evaluateChiSquaredError();
     }
@@ -102,24 +102,30 @@ namespace aslam {
 /* Methods                                                                    */
 /******************************************************************************/
 
-    double ErrorTermWheel::evaluateErrorImplementation() {
-      error_t error;
-      const double v0 = _v_v_mw.toValue()(0);
-      const double v1 = _v_v_mw.toValue()(1);
-      const double v2 = _v_v_mw.toValue()(2);
-      const double k = _k.toScalar();
-      if (_frontEnabled) {
+    double ErrorTermWheel::computeMeasurement(const Eigen::Vector3d& v_v_mw,
+        double k, bool frontEnabled) {
+      const double v0 = v_v_mw(0);
+      if (frontEnabled) {
+        const double v1 = v_v_mw(1);
         const double temp = std::sqrt(v1 * v1 / (v0 * v0) + 1);
-        error(0) = _measurement - k * (v0 / temp + v1 * v1 / (v0 * temp));
-        error(1) = 0.0;
-        error(2) = -v2;
-      }
-      else {
-        error(0) = _measurement - k * v0;
-        error(1) = -v1;
-        error(2) = -v2;
+        return k * (v0 / temp + v1 * v1 / (v0 * temp));
       }
-      setError(error);
+      else
+        return k * v0;
+    }
+
+    Eigen::Vector3d ErrorTermWheel::computeError(const Eigen::Vector3d& v_v_mw,
+        double k, double measurement, bool frontEnabled) {
+      Eigen::Vector3d error;
+      error(0) = measurement - computeMeasurement(v_v_mw, k, frontEnabled);
+      error(1) = frontEnabled ? 0.0 : -v_v_mw(1);
+      error(2) = -v_v_mw(2);
+      return error;
+    }
+
+    double ErrorTermWheel::evaluateErrorImplementation() {
+      setError(computeError(_v_v_mw.toValue(), _k.toScalar(), _measurement,
+        _frontEnabled));
       return evaluateChiSquaredError();
     }
 
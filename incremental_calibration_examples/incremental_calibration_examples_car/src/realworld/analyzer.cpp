@@ -23,8 +23,6 @@
 #include <cmath>
 
 #include <iostream>
-#include <iomanip>
-#include <fstream>
 #include <algorithm>
 #include <string>
 #include <vector>
@@ -55,6 +53,7 @@
 
 #include "aslam/calibration/car/algo/CarCalibrator.h"
 #include "aslam/calibration/car/algo/splinesToFile.h"
+#include "aslam/calibration/car/algo/DataWriter.h"
 #include "aslam/calibration/car/data/WheelSpeedsMeasurement.h"
 #include "aslam/calibration/car/data/SteeringMeasurement.h"
 #include "aslam/calibration/car/data/DMIMeasurement.h"
@@ -69,10 +68,12 @@ using namespace aslam::calibration;
 
 int main(int argc, char** argv) {
 
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <bag_file> <conf_file>" << std::endl;
+  if (argc != 3 && (argc != 4 || std::string(argv[3]) != "--binary")) {
+    std::cerr << "Usage: " << argv[0] << " <bag_file> <conf_file> [--binary]"
+      << std::endl;
     return -1;
   }
+  const bool binary = argc == 4;
 
   BoostPropertyTree config;
   config.loadXml(argv[2]);
@@ -88,18 +89,16 @@ int main(int argc, char** argv) {
 
   CarCalibrator calibrator(PropertyTree(config, "car/calibrator"));
 
-  std::ofstream rwDataFile("rwData.txt");
-  rwDataFile << std::fixed << std::setprecision(18);
-  std::ofstream fwDataFile("fwData.txt");
-  fwDataFile << std::fixed << std::setprecision(18);
-  std::ofstream stDataFile("stData.txt");
-  stDataFile << std::fixed << std::setprecision(18);
-  std::ofstream dmiDataFile("dmiData.txt");
-  dmiDataFile << std::fixed << std::setprecision(18);
-  std::ofstream poseDataFile("poseData.txt");
-  poseDataFile << std::fixed << std::setprecision(18);
-  std::ofstream velDataFile("velData.txt");
-  velDataFile << std::fixed << std::setprecision(18);
+  DataWriter rwDataFile("rwData", binary, {"t", "left", "right"});
+  DataWriter fwDataFile("fwData", binary, {"t", "left", "right"});
+  DataWriter stDataFile("stData", binary, {"t", "value"});
+  DataWriter dmiDataFile("dmiData", binary, {"t", "wheelSpeed"});
+  DataWriter poseDataFile("poseData", binary, {"t", "x", "y", "z", "yaw",
+    "pitch", "roll", "sigma2_x", "sigma2_y", "sigma2_z", "sigma2_yaw",
+    "sigma2_pitch", "sigma2_roll"});
+  DataWriter velDataFile("velData", binary, {"t", "v_x", "v_y", "v_z",
+    "om_x", "om_y", "om_z", "sigma2_v_x", "sigma2_v_y", "sigma2_v_z",
+    "sigma2_om_x", "sigma2_om_y", "sigma2_om_z"});
 
   rosbag::Bag bag(argv[1]);
   std::vector<std::string> topics;
@@ -165,10 +164,10 @@ int main(int argc, char** argv) {
         deg2rad(lastVnp->headingRMSError), deg2rad(lastVnp->pitchRMSError) *
         deg2rad(lastVnp->pitchRMSError), deg2rad(lastVnp->rollRMSError) *
         deg2rad(lastVnp->rollRMSError)).asDiagonal();
-      poseDataFile << vns->header.stamp.toSec() << " " <<
-        pose.m_r_mr.transpose() << " " << pose.m_R_r.transpose() <<
-        " " << pose.sigma2_m_r_mr.diagonal().transpose() << " " <<
-        pose.sigma2_m_R_r.diagonal().transpose() << std::endl;
+      poseDataFile << NsecTime(vns->header.stamp.toNSec()) << pose.m_r_mr <<
+        pose.m_R_r << pose.sigma2_m_r_mr.diagonal() <<
+        pose.sigma2_m_R_r.diagonal();
+      poseDataFile.endRow();
       if (firstVns) {
         m_T_r_0 = Transformation(
           r2quat(ypr.parametersToRotationMatrix(pose.m_R_r)), pose.m_r_mr);
@@ -187,10 +186,10 @@ int main(int argc, char** argv) {
         deg2rad(lastVnp->rollRMSError), deg2rad(lastVnp->pitchRMSError) *
         deg2rad(lastVnp->pitchRMSError), deg2rad(lastVnp->headingRMSError) *
         deg2rad(lastVnp->headingRMSError)).asDiagonal();
-      velDataFile << vns->header.stamp.toSec() << " " <<
-        vel.r_v_mr.transpose() << " " << vel.r_om_mr.transpose() <<
-        " " << vel.sigma2_r_v_mr.diagonal().transpose() << " " <<
-        vel.sigma2_r_om_mr.diagonal().transpose() << std::endl;
+      velDataFile << NsecTime(vns->header.stamp.toNSec()) << vel.r_v_mr <<
+        vel.r_om_mr << vel.sigma2_r_v_mr.diagonal() <<
+        vel.sigma2_r_om_mr.diagonal();
+      velDataFile.endRow();
       auto timestamp = std::round(timestampCorrectorVns.correctTimestamp(
         secToNsec(vns->timeDistance.time1), vns->header.stamp.toNSec()));
       calibrator.addPoseMeasurement(pose, timestamp);
@@ -206,8 +205,9 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorFw.correctTimestamp(
         fws->header.seq, fws->header.stamp.toNSec()));
       calibrator.addFrontWheelsMeasurement(data, timestamp);
-      fwDataFile << fws->header.stamp.toSec() << " " << data.left << " "
-        << data.right << std::endl;
+      fwDataFile << NsecTime(fws->header.stamp.toNSec()) << data.left <<
+        data.right;
+      fwDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/rws/topic") && useRw) {
@@ -219,8 +219,9 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorRw.correctTimestamp(
         rws->header.seq, rws->header.stamp.toNSec()));
       calibrator.addRearWheelsMeasurement(data, timestamp);
-      rwDataFile << rws->header.stamp.toSec() << " " << data.left << " "
-        << data.right << std::endl;
+      rwDataFile << NsecTime(rws->header.stamp.toNSec()) << data.left <<
+        data.right;
+      rwDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/st/topic") && useSt) {
@@ -231,7 +232,8 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorSt.correctTimestamp(
         st->header.seq, st->header.stamp.toNSec()));
       calibrator.addSteeringMeasurement(data, timestamp);
-      stDataFile << st->header.stamp.toSec() << " " << data.value << std::endl;
+      stDataFile << NsecTime(st->header.stamp.toNSec()) << data.value;
+      stDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/dmi/topic") && useDMI) {
@@ -244,8 +246,9 @@ int main(int argc, char** argv) {
         calibrator.addDMIMeasurement(data,
           std::round(timestampCorrectorDmi.correctTimestamp(
           secToNsec(dmi->timeDistance.time1), dmi->header.stamp.toNSec())));
-        dmiDataFile << dmi->header.stamp.toSec() << " " << data.wheelSpeed
-          << std::endl;
+        dmiDataFile << NsecTime(dmi->header.stamp.toNSec()) <<
+          data.wheelSpeed;
+        dmiDataFile.endRow();
       }
       lastDMITimestamp = dmi->timeDistance.time1;
       lastDMIDistance = dmi->signedDistanceTraveled;
@@ -255,86 +258,74 @@ int main(int argc, char** argv) {
   if (calibrator.unprocessedMeasurements())
     calibrator.predict();
 
-  std::ofstream m_T_v_estFile("m_T_v.txt");
-  m_T_v_estFile << std::fixed << std::setprecision(18);
+  DataWriter m_T_v_estFile("m_T_v", binary, {"x", "y", "z", "yaw", "pitch",
+    "roll"});
   writeSplines(calibrator.getEstimator(), 0.01, m_T_v_estFile);
 
-  std::ofstream rwDataPredFile("rwDataPred.txt");
-  rwDataPredFile << std::fixed << std::setprecision(18);
+  DataWriter rwDataPredFile("rwDataPred", binary, {"t", "left", "right"});
   std::for_each(calibrator.getRearWheelsPredictions().cbegin(),
     calibrator.getRearWheelsPredictions().cend(), [&](decltype(
     *calibrator.getRearWheelsPredictions().cbegin()) x) {rwDataPredFile
-    << nsecToSec(x.first) << " " << x.second.left << " " << x.second.right <<
-    std::endl;});
-  std::ofstream rwPredError("rwPredError.txt");
-  rwPredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.left << x.second.right; rwDataPredFile.endRow();});
+  DataWriter rwPredError("rwPredError", binary);
   std::for_each(calibrator.getRearWheelsPredictionErrors().cbegin(),
     calibrator.getRearWheelsPredictionErrors().cend(), [&](decltype(
     *calibrator.getRearWheelsPredictionErrors().cbegin()) x) {rwPredError
-    << x.transpose() << std::endl;});
-  std::ofstream fwDataPredFile("fwDataPred.txt");
-  fwDataPredFile << std::fixed << std::setprecision(18);
+    << x; rwPredError.endRow();});
+  DataWriter fwDataPredFile("fwDataPred", binary, {"t", "left", "right"});
   std::for_each(calibrator.getFrontWheelsPredictions().cbegin(),
     calibrator.getFrontWheelsPredictions().cend(), [&](decltype(
     *calibrator.getFrontWheelsPredictions().cbegin()) x) {fwDataPredFile
-    << nsecToSec(x.first) << " " << x.second.left << " " << x.second.right <<
-    std::endl;});
-  std::ofstream fwPredError("fwPredError.txt");
-  fwPredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.left << x.second.right; fwDataPredFile.endRow();});
+  DataWriter fwPredError("fwPredError", binary);
   std::for_each(calibrator.getFrontWheelsPredictionErrors().cbegin(),
     calibrator.getFrontWheelsPredictionErrors().cend(), [&](decltype(
     *calibrator.getFrontWheelsPredictionErrors().cbegin()) x) {fwPredError
-    << x.transpose() << std::endl;});
-  std::ofstream stDataPredFile("stDataPred.txt");
-  stDataPredFile << std::fixed << std::setprecision(18);
+    << x; fwPredError.endRow();});
+  DataWriter stDataPredFile("stDataPred", binary, {"t", "value"});
   std::for_each(calibrator.getSteeringPredictions().cbegin(),
     calibrator.getSteeringPredictions().cend(), [&](decltype(
     *calibrator.getSteeringPredictions().cbegin()) x) {stDataPredFile
-    << nsecToSec(x.first) << " " << x.second.value <<std::endl;});
-  std::ofstream stPredError("stPredError.txt");
-  stPredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.value; stDataPredFile.endRow();});
+  DataWriter stPredError("stPredError", binary);
   std::for_each(calibrator.getSteeringPredictionErrors().cbegin(),
     calibrator.getSteeringPredictionErrors().cend(), [&](decltype(
     *calibrator.getSteeringPredictionErrors().cbegin()) x) {stPredError
-    << x.transpose() << std::endl;});
-  std::ofstream dmiDataPredFile("dmiDataPred.txt");
-  dmiDataPredFile << std::fixed << std::setprecision(18);
+    << x; stPredError.endRow();});
+  DataWriter dmiDataPredFile("dmiDataPred", binary, {"t", "wheelSpeed"});
   std::for_each(calibrator.getDMIPredictions().cbegin(),
     calibrator.getDMIPredictions().cend(), [&](decltype(
     *calibrator.getDMIPredictions().cbegin()) x) {dmiDataPredFile
-    << nsecToSec(x.first) << " " << x.second.wheelSpeed << std::endl;});
-  std::ofstream dmiPredError("dmiPredError.txt");
-  dmiPredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.wheelSpeed; dmiDataPredFile.endRow();});
+  DataWriter dmiPredError("dmiPredError", binary);
   std::for_each(calibrator.getDMIPredictionErrors().cbegin(),
     calibrator.getDMIPredictionErrors().cend(), [&](decltype(
     *calibrator.getDMIPredictionErrors().cbegin()) x) {dmiPredError
-    << x.transpose() << std::endl;});
-  std::ofstream poseDataPredFile("poseDataPred.txt");
-  poseDataPredFile << std::fixed << std::setprecision(18);
+    << x; dmiPredError.endRow();});
+  DataWriter poseDataPredFile("poseDataPred", binary, {"t", "x", "y",
+    "z", "yaw", "pitch", "roll"});
   std::for_each(calibrator.getPosePredictions().cbegin(),
     calibrator.getPosePredictions().cend(), [&](decltype(
     *calibrator.getPosePredictions().cbegin()) x) {poseDataPredFile
-    << nsecToSec(x.first) << " " << x.second.m_r_mr.transpose() << " "
-    << x.second.m_R_r.transpose() << std::endl;});
-  std::ofstream posePredError("posePredError.txt");
-  posePredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.m_r_mr << x.second.m_R_r;
+    poseDataPredFile.endRow();});
+  DataWriter posePredError("posePredError", binary);
   std::for_each(calibrator.getPosePredictionErrors().cbegin(),
     calibrator.getPosePredictionErrors().cend(), [&](decltype(
     *calibrator.getPosePredictionErrors().cbegin()) x) {posePredError
-    << x.transpose() << std::endl;});
-  std::ofstream velDataPredFile("velDataPred.txt");
-  velDataPredFile << std::fixed << std::setprecision(18);
+    << x; posePredError.endRow();});
+  DataWriter velDataPredFile("velDataPred", binary, {"t", "v_x",
+    "v_y", "v_z", "om_x", "om_y", "om_z"});
   std::for_each(calibrator.getVelocitiesPredictions().cbegin(),
     calibrator.getVelocitiesPredictions().cend(), [&](decltype(
     *calibrator.getVelocitiesPredictions().cbegin()) x) {velDataPredFile
-    << nsecToSec(x.first) << " " << x.second.r_v_mr.transpose() << " "
-    << x.second.r_om_mr.transpose() << std::endl;});
-  std::ofstream velPredError("velPredError.txt");
-  velPredError << std::fixed << std::setprecision(18);
+    << x.first << x.second.r_v_mr << x.second.r_om_mr;
+    velDataPredFile.endRow();});
+  DataWriter velPredError("velPredError", binary);
   std::for_each(calibrator.getVelocitiesPredictionErrors().cbegin(),
     calibrator.getVelocitiesPredictionErrors().cend(), [&](decltype(
     *calibrator.getVelocitiesPredictionErrors().cbegin()) x) {velPredError
-    << x.transpose() << std::endl;});
+    << x; velPredError.endRow();});
 
   return 0;
 }
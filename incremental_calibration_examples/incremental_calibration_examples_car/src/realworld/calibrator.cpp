@@ -55,6 +55,7 @@
 
 #include "aslam/calibration/car/algo/CarCalibrator.h"
 #include "aslam/calibration/car/algo/splinesToFile.h"
+#include "aslam/calibration/car/algo/DataWriter.h"
 #include "aslam/calibration/car/data/WheelSpeedsMeasurement.h"
 #include "aslam/calibration/car/data/SteeringMeasurement.h"
 #include "aslam/calibration/car/data/DMIMeasurement.h"
@@ -69,10 +70,12 @@ using namespace aslam::calibration;
 
 int main(int argc, char** argv) {
 
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <bag_file> <conf_file>" << std::endl;
+  if (argc != 3 && (argc != 4 || std::string(argv[3]) != "--binary")) {
+    std::cerr << "Usage: " << argv[0] << " <bag_file> <conf_file> [--binary]"
+      << std::endl;
     return -1;
   }
+  const bool binary = argc == 4;
 
   BoostPropertyTree config;
   config.loadXml(argv[2]);
@@ -88,18 +91,16 @@ int main(int argc, char** argv) {
 
   CarCalibrator calibrator(PropertyTree(config, "car/calibrator"));
 
-  std::ofstream rwDataFile("rwData.txt");
-  rwDataFile << std::fixed << std::setprecision(18);
-  std::ofstream fwDataFile("fwData.txt");
-  fwDataFile << std::fixed << std::setprecision(18);
-  std::ofstream stDataFile("stData.txt");
-  stDataFile << std::fixed << std::setprecision(18);
-  std::ofstream dmiDataFile("dmiData.txt");
-  dmiDataFile << std::fixed << std::setprecision(18);
-  std::ofstream poseDataFile("poseData.txt");
-  poseDataFile << std::fixed << std::setprecision(18);
-  std::ofstream velDataFile("velData.txt");
-  velDataFile << std::fixed << std::setprecision(18);
+  DataWriter rwDataFile("rwData", binary, {"t", "left", "right"});
+  DataWriter fwDataFile("fwData", binary, {"t", "left", "right"});
+  DataWriter stDataFile("stData", binary, {"t", "value"});
+  DataWriter dmiDataFile("dmiData", binary, {"t", "wheelSpeed"});
+  DataWriter poseDataFile("poseData", binary, {"t", "x", "y", "z", "yaw",
+    "pitch", "roll", "sigma2_x", "sigma2_y", "sigma2_z", "sigma2_yaw",
+    "sigma2_pitch", "sigma2_roll"});
+  DataWriter velDataFile("velData", binary, {"t", "v_x", "v_y", "v_z",
+    "om_x", "om_y", "om_z", "sigma2_v_x", "sigma2_v_y", "sigma2_v_z",
+    "sigma2_om_x", "sigma2_om_y", "sigma2_om_z"});
 
   rosbag::Bag bag(argv[1]);
   std::vector<std::string> topics;
@@ -165,10 +166,10 @@ int main(int argc, char** argv) {
         deg2rad(lastVnp->headingRMSError), deg2rad(lastVnp->pitchRMSError) *
         deg2rad(lastVnp->pitchRMSError), deg2rad(lastVnp->rollRMSError) *
         deg2rad(lastVnp->rollRMSError)).asDiagonal();
-      poseDataFile << vns->header.stamp.toSec() << " " <<
-        pose.m_r_mr.transpose() << " " << pose.m_R_r.transpose() <<
-        " " << pose.sigma2_m_r_mr.diagonal().transpose() << " " <<
-        pose.sigma2_m_R_r.diagonal().transpose() << std::endl;
+      poseDataFile << NsecTime(vns->header.stamp.toNSec()) << pose.m_r_mr <<
+        pose.m_R_r << pose.sigma2_m_r_mr.diagonal() <<
+        pose.sigma2_m_R_r.diagonal();
+      poseDataFile.endRow();
       if (firstVns) {
         m_T_r_0 = Transformation(
           r2quat(ypr.parametersToRotationMatrix(pose.m_R_r)), pose.m_r_mr);
@@ -187,10 +188,10 @@ int main(int argc, char** argv) {
         deg2rad(lastVnp->rollRMSError), deg2rad(lastVnp->pitchRMSError) *
         deg2rad(lastVnp->pitchRMSError), deg2rad(lastVnp->headingRMSError) *
         deg2rad(lastVnp->headingRMSError)).asDiagonal();
-      velDataFile << vns->header.stamp.toSec() << " " <<
-        vel.r_v_mr.transpose() << " " << vel.r_om_mr.transpose() <<
-        " " << vel.sigma2_r_v_mr.diagonal().transpose() << " " <<
-        vel.sigma2_r_om_mr.diagonal().transpose() << std::endl;
+      velDataFile << NsecTime(vns->header.stamp.toNSec()) << vel.r_v_mr <<
+        vel.r_om_mr << vel.sigma2_r_v_mr.diagonal() <<
+        vel.sigma2_r_om_mr.diagonal();
+      velDataFile.endRow();
       auto timestamp = std::round(timestampCorrectorVns.correctTimestamp(
         secToNsec(vns->timeDistance.time1), vns->header.stamp.toNSec()));
       calibrator.addPoseMeasurement(pose, timestamp);
@@ -206,8 +207,9 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorFw.correctTimestamp(
         fws->header.seq, fws->header.stamp.toNSec()));
       calibrator.addFrontWheelsMeasurement(data, timestamp);
-      fwDataFile << fws->header.stamp.toSec() << " " << data.left << " "
-        << data.right << std::endl;
+      fwDataFile << NsecTime(fws->header.stamp.toNSec()) << data.left <<
+        data.right;
+      fwDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/rws/topic") && useRw) {
@@ -219,8 +221,9 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorRw.correctTimestamp(
         rws->header.seq, rws->header.stamp.toNSec()));
       calibrator.addRearWheelsMeasurement(data, timestamp);
-      rwDataFile << rws->header.stamp.toSec() << " " << data.left << " "
-        << data.right << std::endl;
+      rwDataFile << NsecTime(rws->header.stamp.toNSec()) << data.left <<
+        data.right;
+      rwDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/st/topic") && useSt) {
@@ -231,7 +234,8 @@ int main(int argc, char** argv) {
       auto timestamp = std::round(timestampCorrectorSt.correctTimestamp(
         st->header.seq, st->header.stamp.toNSec()));
       calibrator.addSteeringMeasurement(data, timestamp);
-      stDataFile << st->header.stamp.toSec() << " " << data.value << std::endl;
+      stDataFile << NsecTime(st->header.stamp.toNSec()) << data.value;
+      stDataFile.endRow();
     }
     if (it->getTopic() == config.getString(
         "car/calibrator/odometry/sensors/dmi/topic") && useDMI) {
@@ -244,8 +248,9 @@ int main(int argc, char** argv) {
         calibrator.addDMIMeasurement(data,
           std::round(timestampCorrectorDmi.correctTimestamp(
           secToNsec(dmi->timeDistance.time1), dmi->header.stamp.toNSec())));
-        dmiDataFile << dmi->header.stamp.toSec() << " " << data.wheelSpeed
-          << std::endl;
+        dmiDataFile << NsecTime(dmi->header.stamp.toNSec()) <<
+          data.wheelSpeed;
+        dmiDataFile.endRow();
       }
       lastDMITimestamp = dmi->timeDistance.time1;
       lastDMIDistance = dmi->signedDistanceTraveled;
@@ -254,6 +259,7 @@ int main(int argc, char** argv) {
 
   if (calibrator.unprocessedMeasurements())
     calibrator.addMeasurements();
+  calibrator.waitForBatches();
 
   std::ofstream devFile("deviations.txt");
   devFile << std::fixed << std::setprecision(18);
@@ -277,21 +283,20 @@ int main(int argc, char** argv) {
   devFile << "v_R_r_2: " << std::sqrt(variances(16)) << std::endl;
   devFile << "v_R_r_3: " << std::sqrt(variances(17)) << std::endl;
 
-  std::ofstream m_T_v_estFile("m_T_v_est.txt");
-  m_T_v_estFile << std::fixed << std::setprecision(18);
+  DataWriter m_T_v_estFile("m_T_v_est", binary, {"x", "y", "z", "yaw",
+    "pitch", "roll"});
   writeSplines(calibrator.getEstimator(), 0.01, m_T_v_estFile);
 
-  std::ofstream infoGainHistFile("infoGainHist.txt");
+  DataWriter infoGainHistFile("infoGainHist", binary, {"infoGain"});
   auto infoGainHist = calibrator.getInformationGainHistory();
-  infoGainHistFile << std::fixed << std::setprecision(18);
   std::for_each(infoGainHist.cbegin(), infoGainHist.cend(), [&](decltype(
-    *infoGainHist.cbegin()) x) {infoGainHistFile << x << std::endl;});
+    *infoGainHist.cbegin()) x) {infoGainHistFile << x;
+    infoGainHistFile.endRow();});
 
-  std::ofstream calibHistFile("calibHist.txt");
+  DataWriter calibHistFile("calibHist", binary);
   auto calibHist = calibrator.getOdometryVariablesHistory();
-  calibHistFile << std::fixed << std::setprecision(18);
   std::for_each(calibHist.cbegin(), calibHist.cend(), [&](decltype(
-    *calibHist.cbegin()) x) {calibHistFile << x.transpose() << std::endl;});
+    *calibHist.cbegin()) x) {calibHistFile << x; calibHistFile.endRow();});
 
   return 0;
 }
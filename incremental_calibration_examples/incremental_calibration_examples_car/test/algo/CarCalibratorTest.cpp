@@ -0,0 +1,342 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file CarCalibratorTest.cpp
+    \brief This file tests the CarCalibrator class.
+  */
+
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <boost/make_shared.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sm/BoostPropertyTree.hpp>
+
+#include <aslam/backend/ErrorTerm.hpp>
+
+#include <aslam/calibration/exceptions/InvalidOperationException.h>
+
+#include "aslam/calibration/car/algo/CarCalibrator.h"
+#include "aslam/calibration/car/algo/OptimizationProblemSpline.h"
+#include "aslam/calibration/car/data/PoseMeasurement.h"
+#include "aslam/calibration/car/data/VelocitiesMeasurement.h"
+#include "aslam/calibration/car/data/DMIMeasurement.h"
+#include "aslam/calibration/car/data/WheelSpeedsMeasurement.h"
+#include "aslam/calibration/car/data/SteeringMeasurement.h"
+
+using namespace aslam::calibration;
+
+namespace {
+
+  // exposes the batch assembly stage
+  class CarCalibratorAssembly :
+    public CarCalibrator {
+  public:
+    CarCalibratorAssembly(const sm::PropertyTree& config) :
+        CarCalibrator(config) {
+    }
+
+    double assemble(const BatchMeasurements& m, size_t numThreads,
+        std::vector<double>& errors) {
+      _options.errorTermsThreads = numThreads;
+      auto batch = boost::make_shared<OptimizationProblemSpline>();
+      const auto start = std::chrono::steady_clock::now();
+      addVelocitiesErrorTerms(m.velocities, batch);
+      addPoseErrorTerms(m.pose, batch);
+      addDMIErrorTerms(m.dmi, batch);
+      addFrontWheelsErrorTerms(m.frontWheelSpeeds, batch);
+      addRearWheelsErrorTerms(m.rearWheelSpeeds, batch);
+      addSteeringErrorTerms(m.steering, batch);
+      const auto end = std::chrono::steady_clock::now();
+      errors.clear();
+      const auto& errorTerms = batch->getErrorTerms();
+      for (auto it = errorTerms.cbegin(); it != errorTerms.cend(); ++it)
+        errors.push_back((*it)->evaluateError());
+      return std::chrono::duration<double>(end - start).count();
+    }
+
+    using CarCalibrator::initSplines;
+  };
+
+  sm::BoostPropertyTree createConfig() {
+    sm::BoostPropertyTree config;
+    config.setDouble("windowDuration", 30.0);
+    config.setBool("verbose", false);
+    config.setBool("usePose", true);
+    config.setBool("useVelocities", true);
+    config.setDouble("splines/transSplineLambda", 1e-1);
+    config.setDouble("splines/rotSplineLambda", 1e-1);
+    config.setInt("splines/splineKnotsPerSecond", 5);
+    config.setInt("splines/transSplineOrder", 4);
+    config.setInt("splines/rotSplineOrder", 4);
+    config.setInt("odometry/sensors/wheelSpeedSensorCutoff", 350);
+    config.setDouble("odometry/sensors/linearVelocityTolerance", 1.0);
+    const char* noises[] = {"fws/noise/flw", "fws/noise/frw", "rws/noise/rlw",
+      "rws/noise/rrw", "dmi/noise/dmi"};
+    for (auto noise : noises) {
+      config.setDouble(std::string("odometry/sensors/") + noise +
+        "PercentError", 0.1);
+      config.setDouble(std::string("odometry/sensors/") + noise + "Variance",
+        1.0);
+    }
+    config.setDouble("odometry/sensors/st/noise/steeringVariance", 0.004);
+    config.setDouble("odometry/constraints/noise/vyVariance", 0.005);
+    config.setDouble("odometry/constraints/noise/vzVariance", 0.006);
+    config.setInt("odometry/timeDelays/rearWheels", 0);
+    config.setInt("odometry/timeDelays/frontWheels", 0);
+    config.setInt("odometry/timeDelays/steering", 0);
+    config.setInt("odometry/timeDelays/dmi", 0);
+    config.setInt("odometry/timeDelays/delayBound", 50000000);
+    config.setBool("odometry/timeDelays/active", true);
+    config.setDouble("odometry/intrinsics/wheelBase", 2.7);
+    config.setDouble("odometry/intrinsics/halfRearTrack", 0.74);
+    config.setDouble("odometry/intrinsics/halfFrontTrack", 0.75);
+    config.setDouble("odometry/intrinsics/steeringCoefficient0", 0.0);
+    config.setDouble("odometry/intrinsics/steeringCoefficient1", 0.0017);
+    config.setDouble("odometry/intrinsics/steeringCoefficient2", 0.0);
+    config.setDouble("odometry/intrinsics/steeringCoefficient3", 0.0);
+    config.setDouble("odometry/intrinsics/rlwCoefficient", 360.0);
+    config.setDouble("odometry/intrinsics/rrwCoefficient", 360.0);
+    config.setDouble("odometry/intrinsics/flwCoefficient", 360.0);
+    config.setDouble("odometry/intrinsics/frwCoefficient", 360.0);
+    config.setDouble("odometry/intrinsics/dmiCoefficient", 1.0);
+    config.setDouble("odometry/extrinsics/translation/x", 0.0);
+    config.setDouble("odometry/extrinsics/translation/y", 0.0);
+    config.setDouble("odometry/extrinsics/translation/z", 0.785);
+    config.setDouble("odometry/extrinsics/rotation/yaw", 0.0);
+    config.setDouble("odometry/extrinsics/rotation/pitch", 0.0);
+    config.setDouble("odometry/extrinsics/rotation/roll", 0.0);
+    config.setInt("estimator/groupId", 1);
+    config.setBool("estimator/verbose", false);
+    config.setDouble("estimator/optimizer/convergenceDeltaJ", 1e-3);
+    config.setDouble("estimator/optimizer/convergenceDeltaX", 1e-3);
+    config.setInt("estimator/optimizer/maxIterations", 20);
+    config.setInt("estimator/optimizer/nThreads", 4);
+    config.setBool("estimator/optimizer/verbose", false);
+    return config;
+  }
+
+  // rate [Hz] measurements on a circle of radius 50 m at 10 m/s
+  CarCalibrator::BatchMeasurements createMeasurements(sm::timing::NsecTime t0,
+      double duration, double rate) {
+    const double radius = 50.0;
+    const double speed = 10.0;
+    const double omega = speed / radius;
+    const size_t numMeasurements = duration * rate;
+    CarCalibrator::BatchMeasurements m;
+    for (size_t i = 0; i < numMeasurements; ++i) {
+      const double t = i / rate;
+      const sm::timing::NsecTime timestamp = t0 +
+        sm::timing::secToNsec(t);
+      PoseMeasurement pose;
+      pose.m_r_mr = Eigen::Vector3d(radius * std::cos(omega * t),
+        radius * std::sin(omega * t), 0.0);
+      pose.m_R_r = Eigen::Vector3d(omega * t + M_PI / 2.0, 0.0, 0.0);
+      pose.sigma2_m_r_mr = Eigen::Matrix3d::Identity() * 1e-4;
+      pose.sigma2_m_R_r = Eigen::Matrix3d::Identity() * 1e-4;
+      m.pose.push_back(std::make_pair(timestamp, pose));
+      VelocitiesMeasurement velocities;
+      velocities.r_v_mr = Eigen::Vector3d(speed, 0.0, 0.0);
+      velocities.r_om_mr = Eigen::Vector3d(0.0, 0.0, omega);
+      velocities.sigma2_r_v_mr = Eigen::Matrix3d::Identity() * 1e-4;
+      velocities.sigma2_r_om_mr = Eigen::Matrix3d::Identity() * 1e-4;
+      m.velocities.push_back(std::make_pair(timestamp, velocities));
+      DMIMeasurement dmi;
+      dmi.wheelSpeed = speed;
+      m.dmi.push_back(std::make_pair(timestamp, dmi));
+      WheelSpeedsMeasurement wheels;
+      wheels.left = 360.0 * speed * (1.0 - 0.74 / radius);
+      wheels.right = 360.0 * speed * (1.0 + 0.74 / radius);
+      m.rearWheelSpeeds.push_back(std::make_pair(timestamp, wheels));
+      m.frontWheelSpeeds.push_back(std::make_pair(timestamp, wheels));
+      SteeringMeasurement steering;
+      steering.value = std::atan(2.7 / radius) / 0.0017;
+      m.steering.push_back(std::make_pair(timestamp, steering));
+    }
+    return m;
+  }
+
+  // stores the measurements in the calibrator without processing them
+  void storeMeasurements(CarCalibrator& calibrator,
+      const CarCalibrator::BatchMeasurements& m) {
+    for (size_t i = 0; i < m.pose.size(); ++i) {
+      calibrator.addPoseMeasurement(m.pose[i].second, m.pose[i].first);
+      calibrator.addVelocitiesMeasurement(m.velocities[i].second,
+        m.velocities[i].first);
+      calibrator.addDMIMeasurement(m.dmi[i].second, m.dmi[i].first);
+      calibrator.addFrontWheelsMeasurement(m.frontWheelSpeeds[i].second,
+        m.frontWheelSpeeds[i].first);
+      calibrator.addRearWheelsMeasurement(m.rearWheelSpeeds[i].second,
+        m.rearWheelSpeeds[i].first);
+      calibrator.addSteeringMeasurement(m.steering[i].second,
+        m.steering[i].first);
+    }
+  }
+
+}
+
+TEST(AslamCalibrationTestSuite, testCarCalibratorParallelErrorTerms) {
+  const CarCalibrator::BatchMeasurements m = createMeasurements(1000000000,
+    30.0, 100.0);
+  const size_t numMeasurements = m.pose.size();
+
+  CarCalibratorAssembly calibrator(createConfig());
+  calibrator.initSplines(m.pose);
+  const size_t numThreads = std::max(4u, std::thread::hardware_concurrency());
+  std::vector<double> serialErrors, parallelErrors;
+  const double serialTime = calibrator.assemble(m, 1, serialErrors);
+  const double parallelTime = calibrator.assemble(m, numThreads,
+    parallelErrors);
+  std::cout << "error terms: " << serialErrors.size() << std::endl;
+  std::cout << "serial assembly: " << serialTime << " [s]" << std::endl;
+  std::cout << "parallel assembly (" << numThreads << " threads): "
+    << parallelTime << " [s]" << std::endl;
+
+  // same error terms in the same order
+  ASSERT_GT(serialErrors.size(), 5 * numMeasurements);
+  ASSERT_EQ(serialErrors.size(), parallelErrors.size());
+  for (size_t i = 0; i < serialErrors.size(); ++i)
+    ASSERT_EQ(serialErrors[i], parallelErrors[i]);
+}
+
+TEST(AslamCalibrationTestSuite, testCarCalibratorAsync) {
+  const double duration = 5.0;
+  const double rate = 20.0;
+  const sm::timing::NsecTime t0 = 1000000000;
+  auto createBatchMeasurements = [&](size_t i) {
+    return createMeasurements(t0 + sm::timing::secToNsec(i * duration),
+      duration, rate);
+  };
+
+  // batches are only processed on explicit requests
+  sm::BoostPropertyTree config = createConfig();
+  config.setDouble("windowDuration", 1e6);
+  config.setBool("asyncProcessing", true);
+  config.setInt("asyncQueueSize", 1);
+  std::mutex futuresMutex;
+  std::vector<CarCalibrator::ReturnValueFuture> futures;
+  size_t numCallbacks = 0;
+  bool inOrder = true;
+  bool waitThrown = false;
+  std::promise<void> gate;
+  const std::shared_future<void> gateFuture = gate.get_future().share();
+  {
+    CarCalibrator calibrator(config);
+    calibrator.setBatchCallback([&](const CarCalibrator::ReturnValue&) {
+      // the previous batches are resolved, the current one is not
+      {
+        std::lock_guard<std::mutex> lock(futuresMutex);
+        for (size_t i = 0; i < futures.size(); ++i)
+          if ((futures[i].wait_for(std::chrono::seconds(0)) ==
+              std::future_status::ready) != (i < numCallbacks))
+            inOrder = false;
+        // the accessors do not wait on the worker thread
+        if (calibrator.getInformationGainHistory().size() != numCallbacks + 1)
+          inOrder = false;
+        ++numCallbacks;
+      }
+      // hold the worker on the first batch
+      if (numCallbacks == 1) {
+        try {
+          calibrator.waitForBatches();
+        }
+        catch (const InvalidOperationException&) {
+          waitThrown = true;
+        }
+        gateFuture.wait();
+      }
+    });
+    for (size_t i = 0; i < 2; ++i) {
+      storeMeasurements(calibrator, createBatchMeasurements(i));
+      const CarCalibrator::ReturnValueFuture future =
+        calibrator.addMeasurements();
+      std::lock_guard<std::mutex> lock(futuresMutex);
+      futures.push_back(future);
+    }
+
+    // one batch in progress and one queued, the next request must block
+    storeMeasurements(calibrator, createBatchMeasurements(2));
+    auto blocked = std::async(std::launch::async, [&]() {
+      return calibrator.addMeasurements();});
+    EXPECT_EQ(blocked.wait_for(std::chrono::milliseconds(200)),
+      std::future_status::timeout);
+    EXPECT_EQ(calibrator.getNumPendingBatches(), 2u);
+    gate.set_value();
+    const CarCalibrator::ReturnValueFuture future = blocked.get();
+    {
+      std::lock_guard<std::mutex> lock(futuresMutex);
+      futures.push_back(future);
+    }
+
+    // the accessors wait for the queued batches instead of racing the worker
+    EXPECT_EQ(calibrator.getInformationGainHistory().size(), 3u);
+    EXPECT_EQ(calibrator.getOdometryVariablesHistory().size(), 4u);
+    EXPECT_EQ(calibrator.getNumPendingBatches(), 0u);
+    calibrator.waitForBatches();
+    EXPECT_EQ(calibrator.getNumPendingBatches(), 0u);
+  }
+  ASSERT_EQ(futures.size(), 3u);
+  for (auto it = futures.cbegin(); it != futures.cend(); ++it) {
+    ASSERT_TRUE(it->valid());
+    ASSERT_EQ(it->wait_for(std::chrono::seconds(0)),
+      std::future_status::ready);
+  }
+  ASSERT_EQ(numCallbacks, 3u);
+  ASSERT_TRUE(inOrder);
+  ASSERT_TRUE(waitThrown);
+
+  // the destructor processes the queued batches before returning
+  config.setInt("asyncQueueSize", 3);
+  futures.clear();
+  numCallbacks = 0;
+  std::promise<void> drainGate;
+  const std::shared_future<void> drainGateFuture =
+    drainGate.get_future().share();
+  {
+    CarCalibrator calibrator(config);
+    calibrator.setBatchCallback([&](const CarCalibrator::ReturnValue&) {
+      if (++numCallbacks == 1)
+        drainGateFuture.wait();
+    });
+    for (size_t i = 0; i < 3; ++i) {
+      storeMeasurements(calibrator, createBatchMeasurements(i));
+      futures.push_back(calibrator.addMeasurements());
+    }
+    EXPECT_EQ(calibrator.getNumPendingBatches(), 3u);
+    drainGate.set_value();
+  }
+  ASSERT_EQ(numCallbacks, 3u);
+  for (auto it = futures.cbegin(); it != futures.cend(); ++it) {
+    ASSERT_EQ(it->wait_for(std::chrono::seconds(0)),
+      std::future_status::ready);
+    ASSERT_NO_THROW(it->get());
+  }
+}
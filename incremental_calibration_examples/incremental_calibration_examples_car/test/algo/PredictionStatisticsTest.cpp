@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file PredictionStatisticsTest.cpp
+    \brief This file tests the PredictionStatistics class.
+  */
+
+#include <cstddef>
+
+#include <algorithm>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <gtest/gtest.h>
+
+#include <aslam/calibration/exceptions/OutOfBoundException.h>
+
+#include "aslam/calibration/car/algo/PredictionStatistics.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testPredictionStatistics) {
+  const size_t numErrors = 1000;
+  std::vector<Eigen::VectorXd> errors;
+  std::vector<double> errors2;
+  for (size_t i = 0; i < numErrors; ++i) {
+    errors.push_back(Eigen::VectorXd::Random(3) +
+      Eigen::VectorXd::Constant(3, 1e6));
+    errors2.push_back(errors.back().squaredNorm());
+  }
+
+  PredictionStatistics statistics;
+  ASSERT_EQ(statistics.getNumErrors(), 0);
+  for (size_t i = 0; i < numErrors; ++i)
+    statistics.addError(errors[i], errors2[i]);
+
+  // two-pass reference
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(3);
+  double meanError2 = 0.0;
+  double maxError2 = 0.0;
+  for (size_t i = 0; i < numErrors; ++i) {
+    mean += errors[i];
+    meanError2 += errors2[i];
+    maxError2 = std::max(maxError2, errors2[i]);
+  }
+  mean /= numErrors;
+  meanError2 /= numErrors;
+  Eigen::VectorXd variance = Eigen::VectorXd::Zero(3);
+  double varianceError2 = 0.0;
+  for (size_t i = 0; i < numErrors; ++i) {
+    variance += (errors[i] - mean).cwiseAbs2();
+    varianceError2 += (errors2[i] - meanError2) * (errors2[i] - meanError2);
+  }
+  variance /= numErrors;
+  varianceError2 /= numErrors;
+
+  ASSERT_EQ(statistics.getNumErrors(), numErrors);
+  ASSERT_TRUE(statistics.getMean().isApprox(mean, 1e-12));
+  ASSERT_TRUE(statistics.getVariance().isApprox(variance, 1e-6));
+  ASSERT_NEAR(statistics.getMeanError2(), meanError2, 1e-12 * meanError2);
+  ASSERT_NEAR(statistics.getVarianceError2(), varianceError2,
+    1e-6 * varianceError2);
+  ASSERT_EQ(statistics.getMaxError2(), maxError2);
+
+  ASSERT_THROW(statistics.addError(Eigen::VectorXd::Zero(2), 0.0),
+    OutOfBoundException<size_t>);
+
+  statistics.reset();
+  ASSERT_EQ(statistics.getNumErrors(), 0);
+  statistics.addError(Eigen::VectorXd::Zero(2), 0.0);
+  ASSERT_EQ(statistics.getMean().size(), 2);
+}
@@ -41,6 +41,8 @@
 #include <bsplines/EuclideanBSpline.hpp>
 #include <bsplines/UnitQuaternionBSpline.hpp>
 
+#include <aslam/calibration/algorithms/SplineInitializer.h>
+
 #include "aslam/calibration/egomotion/algo/CalibratorOptions.h"
 #include "aslam/calibration/egomotion/data/MeasurementsContainer.h"
 #include "aslam/calibration/egomotion/data/MotionMeasurement.h"
@@ -86,6 +88,9 @@ namespace aslam {
         bsplines::NsecTimePolicy>::CONF>::BSpline TranslationSpline;
       /// Euclidean spline shared pointer
       typedef boost::shared_ptr<TranslationSpline> TranslationSplineSP;
+      /// Splines initializer
+      typedef SplineInitializer<sm::timing::NsecTime, TranslationSpline,
+        RotationSpline> PoseSplineInitializer;
       /// Optimization problem shared pointer
       typedef boost::shared_ptr<OptimizationProblemSpline>
         OptimizationProblemSplineSP;
@@ -191,7 +196,17 @@ namespace aslam {
       /// Adds a new measurement
       void addMeasurement(sm::timing::NsecTime timestamp);
       /// Initializes the splines
-      void initSplines(size_t idx = 0);
+      void initSplines(size_t idx = 0, bool reuse = false);
+      /// Fits a translation spline to samples
+      TranslationSplineSP fitTranslationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const;
+      /// Fits a rotation spline to samples
+      RotationSplineSP fitRotationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const;
       /// Adds motion error terms
       void addMotionErrorTerms(const OptimizationProblemSplineSP& batch, size_t
         idx = 0);
@@ -213,6 +228,8 @@ namespace aslam {
       TranslationSplineSP translationSpline_;
       /// Current rotation spline
       RotationSplineSP rotationSpline_;
+      /// Splines initializer
+      PoseSplineInitializer splineInitializer_;
       /// Current batch starting timestamp
       sm::timing::NsecTime currentBatchStartTimestamp_;
       /// Last timestamp
@@ -59,6 +59,15 @@ namespace aslam {
 /******************************************************************************/
 
     Calibrator::Calibrator(const PropertyTree& config) :
+        splineInitializer_(
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::TranslationPoses& transPoses,
+              int numSegments) {
+            return fitTranslationSpline(timestamps, transPoses, numSegments);},
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::RotationPoses& rotPoses,
+              int numSegments) {
+            return fitRotationSpline(timestamps, rotPoses, numSegments);}),
         currentBatchStartTimestamp_(-1),
         lastTimestamp_(-1) {
       // create the underlying estimator
@@ -89,7 +98,7 @@ namespace aslam {
     }
 
     void Calibrator::predict() {
-      initSplines(options_.referenceSensor);
+      initSplines(options_.referenceSensor, true);
       for (const auto& measurements : motionMeasurements_)
         predictMotion(measurements.first);
     }
@@ -133,25 +142,26 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *designVariables_ << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << ret.marginal->singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
+        const Eigen::MatrixXd& obsBasis = ret.marginal->obsBasisScaled;
         size_t idx = 0;
         for (const auto& designVariable :
             designVariables_->calibrationVariables_) {
           std::cout << "t_" << designVariable.first << ": "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_1 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_2 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_3 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_1 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_2 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_3 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << obsBasis.row(idx++).norm() << std::endl;
         }
       }
       for (const auto& designVariable : designVariables_->calibrationVariables_)
@@ -164,7 +174,7 @@ namespace aslam {
       motionMeasurements_.clear();
     }
 
-    void Calibrator::initSplines(size_t idx) {
+    void Calibrator::initSplines(size_t idx, bool reuse) {
       const auto& measurements = motionMeasurements_.at(idx);
       const auto numMeasurements = measurements.size();
       std::vector<NsecTime> timestamps;
@@ -200,19 +210,36 @@ namespace aslam {
       else
         numSegments = numMeasurements;
 
-      translationSpline_ = boost::make_shared<TranslationSpline>(
+      splineInitializer_.initSplines(timestamps, transPoses, rotPoses,
+        numSegments, reuse);
+      translationSpline_ = splineInitializer_.getTranslationSpline();
+      rotationSpline_ = splineInitializer_.getRotationSpline();
+    }
+
+    Calibrator::TranslationSplineSP Calibrator::fitTranslationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const {
+      auto translationSpline = boost::make_shared<TranslationSpline>(
         EuclideanBSpline<Eigen::Dynamic, 3, NsecTimePolicy>::CONF(
         EuclideanBSpline<Eigen::Dynamic, 3,
         NsecTimePolicy>::CONF::ManifoldConf(3), options_.transSplineOrder));
-      BSplineFitter<TranslationSpline>::initUniformSpline(*translationSpline_,
+      BSplineFitter<TranslationSpline>::initUniformSpline(*translationSpline,
         timestamps, transPoses, numSegments, options_.transSplineLambda);
+      return translationSpline;
+    }
 
-      rotationSpline_ = boost::make_shared<RotationSpline>(
+    Calibrator::RotationSplineSP Calibrator::fitRotationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const {
+      auto rotationSpline = boost::make_shared<RotationSpline>(
         UnitQuaternionBSpline<Eigen::Dynamic, NsecTimePolicy>::CONF(
         UnitQuaternionBSpline<Eigen::Dynamic,
         NsecTimePolicy>::CONF::ManifoldConf(), options_.rotSplineOrder));
-      BSplineFitter<RotationSpline>::initUniformSpline(*rotationSpline_,
+      BSplineFitter<RotationSpline>::initUniformSpline(*rotationSpline,
         timestamps, rotPoses, numSegments, options_.rotSplineLambda);
+      return rotationSpline;
     }
 
     void Calibrator::addMotionErrorTerms(const OptimizationProblemSplineSP&
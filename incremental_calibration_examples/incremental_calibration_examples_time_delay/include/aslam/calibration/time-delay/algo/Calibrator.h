@@ -40,6 +40,8 @@
 #include <bsplines/EuclideanBSpline.hpp>
 #include <bsplines/UnitQuaternionBSpline.hpp>
 
+#include <aslam/calibration/algorithms/SplineInitializer.h>
+
 #include "aslam/calibration/time-delay/data/MeasurementsContainer.h"
 #include "aslam/calibration/time-delay/algo/CalibratorOptions.h"
 
@@ -84,6 +86,9 @@ namespace aslam {
         bsplines::NsecTimePolicy>::CONF>::BSpline TranslationSpline;
       /// Euclidean spline shared pointer
       typedef boost::shared_ptr<TranslationSpline> TranslationSplineSP;
+      /// Splines initializer
+      typedef SplineInitializer<sm::timing::NsecTime, TranslationSpline,
+        RotationSpline> PoseSplineInitializer;
       /// Optimization problem shared pointer
       typedef boost::shared_ptr<OptimizationProblemSpline>
         OptimizationProblemSplineSP;
@@ -214,7 +219,18 @@ namespace aslam {
       /// Predicts right wheel measurements
       void predictRightWheel(const WheelSpeedMeasurements& measurements);
       /// Initializes the splines from a batch of pose measurements
-      void initSplines(const PoseMeasurements& measurements);
+      void initSplines(const PoseMeasurements& measurements,
+        bool reuse = false);
+      /// Fits a translation spline to samples
+      TranslationSplineSP fitTranslationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const;
+      /// Fits a rotation spline to samples
+      RotationSplineSP fitRotationSpline(const
+        PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const;
       /** @}
         */
 
@@ -259,6 +275,8 @@ namespace aslam {
       RotationSplineSP _rotationSpline;
       /// Current translation spline
       TranslationSplineSP _translationSpline;
+      /// Splines initializer
+      PoseSplineInitializer _splineInitializer;
       /// Information gain history
       std::vector<double> _infoGainHistory;
       /// Calibration variables history
@@ -67,7 +67,16 @@ namespace aslam {
 
     Calibrator::Calibrator(const PropertyTree& config) :
         _currentBatchStartTimestamp(-1),
-        _lastTimestamp(-1) {
+        _lastTimestamp(-1),
+        _splineInitializer(
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::TranslationPoses& transPoses,
+              int numSegments) {
+            return fitTranslationSpline(timestamps, transPoses, numSegments);},
+          [this](const PoseSplineInitializer::Timestamps& timestamps,
+              const PoseSplineInitializer::RotationPoses& rotPoses,
+              int numSegments) {
+            return fitRotationSpline(timestamps, rotPoses, numSegments);}) {
       // create the underlying estimator
       _estimator = boost::make_shared<IncrementalEstimator>(
         sm::PropertyTree(config, "estimator"));
@@ -223,7 +232,7 @@ namespace aslam {
     void Calibrator::predict() {
       auto batch = boost::make_shared<OptimizationProblemSpline>();
       _odometryDesignVariables->addToBatch(batch, 1);
-      initSplines(_poseMeasurements);
+      initSplines(_poseMeasurements, true);
       predictPoses(_poseMeasurements);
       predictLeftWheel(_leftWheelSpeedMeasurements);
       predictRightWheel(_rightWheelSpeedMeasurements);
@@ -283,24 +292,25 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *_odometryDesignVariables << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << ret.marginal->singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
-        std::cout << "b: " << ret.obsBasisScaled.row(0).norm() << std::endl;
-        std::cout << "k_l: " << ret.obsBasisScaled.row(1).norm() << std::endl;
-        std::cout << "t_l: " << ret.obsBasisScaled.row(2).norm() << std::endl;
-        std::cout << "k_r: " << ret.obsBasisScaled.row(3).norm() << std::endl;
-        std::cout << "t_r: " << ret.obsBasisScaled.row(4).norm() << std::endl;
-        std::cout << "v_r_vp_1: " << ret.obsBasisScaled.row(5).norm()
+        const Eigen::MatrixXd& obsBasis = ret.marginal->obsBasisScaled;
+        std::cout << "b: " << obsBasis.row(0).norm() << std::endl;
+        std::cout << "k_l: " << obsBasis.row(1).norm() << std::endl;
+        std::cout << "t_l: " << obsBasis.row(2).norm() << std::endl;
+        std::cout << "k_r: " << obsBasis.row(3).norm() << std::endl;
+        std::cout << "t_r: " << obsBasis.row(4).norm() << std::endl;
+        std::cout << "v_r_vp_1: " << obsBasis.row(5).norm()
           << std::endl;
-        std::cout << "v_r_vp_2: " << ret.obsBasisScaled.row(6).norm()
+        std::cout << "v_r_vp_2: " << obsBasis.row(6).norm()
           << std::endl;
-        std::cout << "v_r_vp_3: " << ret.obsBasisScaled.row(7).norm()
+        std::cout << "v_r_vp_3: " << obsBasis.row(7).norm()
           << std::endl;
-        std::cout << "v_R_p_1: " << ret.obsBasisScaled.row(8).norm()
+        std::cout << "v_R_p_1: " << obsBasis.row(8).norm()
           << std::endl;
-        std::cout << "v_R_p_2: " << ret.obsBasisScaled.row(9).norm()
+        std::cout << "v_R_p_2: " << obsBasis.row(9).norm()
           << std::endl;
-        std::cout << "v_R_p_3: " << ret.obsBasisScaled.row(10).norm()
+        std::cout << "v_R_p_3: " << obsBasis.row(10).norm()
           << std::endl;
       }
       _infoGainHistory.push_back(ret.informationGain);
@@ -308,7 +318,8 @@ namespace aslam {
         _odometryDesignVariables->getParameters());
     }
 
-    void Calibrator::initSplines(const PoseMeasurements& measurements) {
+    void Calibrator::initSplines(const PoseMeasurements& measurements,
+        bool reuse) {
       const size_t numMeasurements = measurements.size();
       std::vector<NsecTime> timestamps;
       timestamps.reserve(numMeasurements);
@@ -345,19 +356,36 @@ namespace aslam {
       else
         numSegments = numMeasurements;
 
-      _translationSpline = boost::make_shared<TranslationSpline>(
+      _splineInitializer.initSplines(timestamps, transPoses, rotPoses,
+        numSegments, reuse);
+      _translationSpline = _splineInitializer.getTranslationSpline();
+      _rotationSpline = _splineInitializer.getRotationSpline();
+    }
+
+    Calibrator::TranslationSplineSP Calibrator::fitTranslationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::TranslationPoses& transPoses, int numSegments)
+        const {
+      auto translationSpline = boost::make_shared<TranslationSpline>(
         EuclideanBSpline<Eigen::Dynamic, 3, NsecTimePolicy>::CONF(
         EuclideanBSpline<Eigen::Dynamic, 3,
         NsecTimePolicy>::CONF::ManifoldConf(3), _options.transSplineOrder));
-      BSplineFitter<TranslationSpline>::initUniformSpline(*_translationSpline,
+      BSplineFitter<TranslationSpline>::initUniformSpline(*translationSpline,
         timestamps, transPoses, numSegments, _options.transSplineLambda);
+      return translationSpline;
+    }
 
-      _rotationSpline = boost::make_shared<RotationSpline>(
+    Calibrator::RotationSplineSP Calibrator::fitRotationSpline(
+        const PoseSplineInitializer::Timestamps& timestamps, const
+        PoseSplineInitializer::RotationPoses& rotPoses, int numSegments)
+        const {
+      auto rotationSpline = boost::make_shared<RotationSpline>(
         UnitQuaternionBSpline<Eigen::Dynamic, NsecTimePolicy>::CONF(
         UnitQuaternionBSpline<Eigen::Dynamic,
         NsecTimePolicy>::CONF::ManifoldConf(), _options.rotSplineOrder));
-      BSplineFitter<RotationSpline>::initUniformSpline(*_rotationSpline,
+      BSplineFitter<RotationSpline>::initUniformSpline(*rotationSpline,
         timestamps, rotPoses, numSegments, _options.rotSplineLambda);
+      return rotationSpline;
     }
 
     void Calibrator::addPoseErrorTerms(const PoseMeasurements& measurements,
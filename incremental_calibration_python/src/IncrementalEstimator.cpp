@@ -21,6 +21,9 @@
            class.
   */
 
+#include <string>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 
 #include <numpy_eigen/boost_python_headers.hpp>
@@ -28,9 +31,12 @@
 #include <aslam/backend/CompressedColumnMatrix.hpp>
 #include <aslam/backend/Optimizer2Options.hpp>
 
+#include <cholmod.h>
+
 #include <aslam-tsvd-solver/aslam-tsvd-solver.h>
 #include <aslam/calibration/core/IncrementalEstimator.h>
 #include <aslam/calibration/core/IncrementalOptimizationProblem.h>
+#include <aslam/calibration/core/OptimizationProblem.h>
 
 using namespace boost::python;
 using namespace aslam::backend;
@@ -86,6 +92,123 @@ Eigen::MatrixXd getScaledSingularValues(const IncrementalEstimator* ie) {
   return ie->getSingularValues(true);
 }
 
+object createMatrixView(const Eigen::MatrixXd& matrix, const object& owner);
+object createVectorView(const Eigen::VectorXd& vector, const object& owner);
+tuple createCscTriple(const cholmod_sparse& matrix);
+
+/// Name of the capsules holding marginal results snapshots
+const char* const marginalResultsCapsuleName =
+  "aslam.calibration.MarginalResults";
+
+/// Releases the snapshot held by a capsule
+void destroyMarginalResultsCapsule(PyObject* capsule) {
+  delete static_cast<IncrementalEstimator::MarginalResultsCSP*>(
+    PyCapsule_GetPointer(capsule, marginalResultsCapsuleName));
+}
+
+/// Returns a capsule keeping a marginal results snapshot alive
+object createMarginalResultsOwner(
+    const IncrementalEstimator::MarginalResultsCSP& marginal) {
+  IncrementalEstimator::MarginalResultsCSP* snapshot =
+    new IncrementalEstimator::MarginalResultsCSP(marginal);
+  PyObject* capsule = PyCapsule_New(snapshot, marginalResultsCapsuleName,
+    &destroyMarginalResultsCapsule);
+  if (capsule == NULL) {
+    delete snapshot;
+    throw_error_already_set();
+  }
+  return object(handle<>(capsule));
+}
+
+/// Read-only view on an estimator matrix, owning the current snapshot
+template <Eigen::MatrixXd IncrementalEstimator::MarginalResults::*Member>
+object getMatrixView(const IncrementalEstimator& ie) {
+  const IncrementalEstimator::MarginalResultsCSP marginal =
+    ie.getMarginalResults();
+  return createMatrixView((*marginal).*Member,
+    createMarginalResultsOwner(marginal));
+}
+
+/// Read-only view on an estimator vector, owning the current snapshot
+template <Eigen::VectorXd IncrementalEstimator::MarginalResults::*Member>
+object getVectorView(const IncrementalEstimator& ie) {
+  const IncrementalEstimator::MarginalResultsCSP marginal =
+    ie.getMarginalResults();
+  return createVectorView((*marginal).*Member,
+    createMarginalResultsOwner(marginal));
+}
+
+/// Returns a marginal result of a return value, empty if not available
+template <typename T, T IncrementalEstimator::MarginalResults::*Member>
+const T& getMarginalResult(const IncrementalEstimator::ReturnValue& ret) {
+  static const T empty;
+  return ret.marginal ? (*ret.marginal).*Member : empty;
+}
+
+/// Copies a marginal result of a return value
+template <typename T, T IncrementalEstimator::MarginalResults::*Member>
+T getMarginalResultCopy(const IncrementalEstimator::ReturnValue& ret) {
+  return getMarginalResult<T, Member>(ret);
+}
+
+/// Read-only view on a return value matrix, owning the return value snapshot
+template <Eigen::MatrixXd IncrementalEstimator::MarginalResults::*Member>
+object getReturnValueMatrixView(const IncrementalEstimator::ReturnValue& ret) {
+  return createMatrixView(getMarginalResult<Eigen::MatrixXd, Member>(ret),
+    createMarginalResultsOwner(ret.marginal));
+}
+
+/// Read-only view on a return value vector, owning the return value snapshot
+template <Eigen::VectorXd IncrementalEstimator::MarginalResults::*Member>
+object getReturnValueVectorView(const IncrementalEstimator::ReturnValue& ret) {
+  return createVectorView(getMarginalResult<Eigen::VectorXd, Member>(ret),
+    createMarginalResultsOwner(ret.marginal));
+}
+
+/// Copies the Jacobian transpose into a SciPy CSC triple
+tuple getJacobianTransposeCsc(const IncrementalEstimator* ie) {
+  cholmod_sparse view;
+  ie->getLinearSolver()->getJacobianTransposeView(&view);
+  return createCscTriple(view);
+}
+
+/// Converts a list of batches
+std::vector<IncrementalEstimator::BatchSP> getBatches(const list& batches) {
+  std::vector<IncrementalEstimator::BatchSP> batchesSP;
+  for (ssize_t i = 0; i < len(batches); ++i)
+    batchesSP.push_back(extract<IncrementalEstimator::BatchSP>(batches[i]));
+  return batchesSP;
+}
+
+/// Converts return values into a list
+list getReturnValues(const std::vector<IncrementalEstimator::ReturnValue>&
+    rets) {
+  list retsList;
+  for (auto it = rets.cbegin(); it != rets.cend(); ++it)
+    retsList.append(*it);
+  return retsList;
+}
+
+/// Scores candidate batches given as a list
+list scoreBatches(const IncrementalEstimator* ie, const list& batches) {
+  return getReturnValues(ie->scoreBatches(getBatches(batches)));
+}
+
+/// Adds candidate batches given as a list
+list addBatches(IncrementalEstimator* ie, const list& batches, bool force) {
+  return getReturnValues(ie->addBatches(getBatches(batches), force));
+}
+
+/// Restores a checkpoint with the design variables given as a list
+void loadCheckpoint(IncrementalEstimator* ie, const std::string& filename,
+    const list& designVariables) {
+  IncrementalEstimator::DesignVariablesSP dvs;
+  for (ssize_t i = 0; i < len(designVariables); ++i)
+    dvs.push_back(extract<IncrementalEstimator::DesignVariableSP>(
+      designVariables[i]));
+  ie->loadCheckpoint(filename, dvs);
+}
+
 void exportIncrementalEstimator() {
   /// Export options for the IncrementalEstimator class
   class_<IncrementalEstimator::Options>("IncrementalEstimatorOptions", init<>())
@@ -93,6 +216,22 @@ void exportIncrementalEstimator() {
       &IncrementalEstimator::Options::infoGainDelta)
     .def_readwrite("checkValidity",
       &IncrementalEstimator::Options::checkValidity)
+    .def_readwrite("incrementalMarginal",
+      &IncrementalEstimator::Options::incrementalMarginal)
+    .def_readwrite("marginalRelinearizationThreshold",
+      &IncrementalEstimator::Options::marginalRelinearizationThreshold)
+    .def_readwrite("preScreening",
+      &IncrementalEstimator::Options::preScreening)
+    .def_readwrite("preScreeningInfoGainDelta",
+      &IncrementalEstimator::Options::preScreeningInfoGainDelta)
+    .def_readwrite("maxNumBatches",
+      &IncrementalEstimator::Options::maxNumBatches)
+    .def_readwrite("maxNumErrorTerms",
+      &IncrementalEstimator::Options::maxNumErrorTerms)
+    .def_readwrite("evictLowestInformation",
+      &IncrementalEstimator::Options::evictLowestInformation)
+    .def_readwrite("scoringThreads",
+      &IncrementalEstimator::Options::scoringThreads)
     .def_readwrite("verbose", &IncrementalEstimator::Options::verbose)
     ;
 
@@ -101,6 +240,8 @@ void exportIncrementalEstimator() {
     init<>())
     .def_readwrite("batchAccepted",
       &IncrementalEstimator::ReturnValue::batchAccepted)
+    .def_readwrite("preScreened",
+      &IncrementalEstimator::ReturnValue::preScreened)
     .def_readwrite("informationGain",
       &IncrementalEstimator::ReturnValue::informationGain)
     .def_readwrite("rankPsi", &IncrementalEstimator::ReturnValue::rankPsi)
@@ -114,31 +255,80 @@ void exportIncrementalEstimator() {
       &IncrementalEstimator::ReturnValue::svdTolerance)
     .def_readwrite("qrTolerance",
       &IncrementalEstimator::ReturnValue::qrTolerance)
-    .def_readwrite("nobsBasis", &IncrementalEstimator::ReturnValue::nobsBasis)
-    .def_readwrite("nobsBasisScaled",
-      &IncrementalEstimator::ReturnValue::nobsBasisScaled)
-    .def_readwrite("obsBasis",
-      &IncrementalEstimator::ReturnValue::obsBasis)
-    .def_readwrite("obsBasisScaled",
-      &IncrementalEstimator::ReturnValue::obsBasisScaled)
-    .def_readwrite("sigma2Theta",
-      &IncrementalEstimator::ReturnValue::sigma2Theta)
-    .def_readwrite("sigma2ThetaScaled",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaScaled)
-    .def_readwrite("sigma2ThetaObs",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaObs)
-    .def_readwrite("sigma2ThetaObsScaled",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaObsScaled)
-    .def_readwrite("singularValues",
-      &IncrementalEstimator::ReturnValue::singularValues)
-    .def_readwrite("singularValuesScaled",
-      &IncrementalEstimator::ReturnValue::singularValuesScaled)
+    .add_property("nobsBasis", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::nobsBasis>)
+    .add_property("nobsBasisScaled", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::nobsBasisScaled>)
+    .add_property("obsBasis", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::obsBasis>)
+    .add_property("obsBasisScaled", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::obsBasisScaled>)
+    .add_property("sigma2Theta", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::sigma2Theta>)
+    .add_property("sigma2ThetaScaled", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::sigma2ThetaScaled>)
+    .add_property("sigma2ThetaObs", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObs>)
+    .add_property("sigma2ThetaObsScaled", &getMarginalResultCopy<Eigen::MatrixXd,
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObsScaled>)
+    .add_property("singularValues", &getMarginalResultCopy<Eigen::VectorXd,
+      &IncrementalEstimator::MarginalResults::singularValues>)
+    .add_property("singularValuesScaled", &getMarginalResultCopy<Eigen::VectorXd,
+      &IncrementalEstimator::MarginalResults::singularValuesScaled>)
     .def_readwrite("numIterations",
       &IncrementalEstimator::ReturnValue::numIterations)
     .def_readwrite("JStart", &IncrementalEstimator::ReturnValue::JStart)
     .def_readwrite("JFinal", &IncrementalEstimator::ReturnValue::JFinal)
     .def_readwrite("elapsedTime",
       &IncrementalEstimator::ReturnValue::elapsedTime)
+    .def_readwrite("preScreeningTime",
+      &IncrementalEstimator::ReturnValue::preScreeningTime)
+    .def_readwrite("insertionTime",
+      &IncrementalEstimator::ReturnValue::insertionTime)
+    .def_readwrite("orderingTime",
+      &IncrementalEstimator::ReturnValue::orderingTime)
+    .def_readwrite("jacobianTime",
+      &IncrementalEstimator::ReturnValue::jacobianTime)
+    .def_readwrite("linearSolverTime",
+      &IncrementalEstimator::ReturnValue::linearSolverTime)
+    .def_readwrite("optimizationTime",
+      &IncrementalEstimator::ReturnValue::optimizationTime)
+    .def_readwrite("marginalAnalysisTime",
+      &IncrementalEstimator::ReturnValue::marginalAnalysisTime)
+    .def_readwrite("rollbackTime",
+      &IncrementalEstimator::ReturnValue::rollbackTime)
+    .def_readwrite("evictionTime",
+      &IncrementalEstimator::ReturnValue::evictionTime)
+    .def_readwrite("numEvictedBatches",
+      &IncrementalEstimator::ReturnValue::numEvictedBatches)
+    .def_readwrite("numErrorTerms",
+      &IncrementalEstimator::ReturnValue::numErrorTerms)
+    .def_readwrite("numDesignVariables",
+      &IncrementalEstimator::ReturnValue::numDesignVariables)
+    .def_readwrite("jacobianNnz",
+      &IncrementalEstimator::ReturnValue::jacobianNnz)
+    .def_readwrite("numFlops",
+      &IncrementalEstimator::ReturnValue::numFlops)
+    .add_property("nobsBasisView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::nobsBasis>)
+    .add_property("nobsBasisScaledView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::nobsBasisScaled>)
+    .add_property("obsBasisView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::obsBasis>)
+    .add_property("obsBasisScaledView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::obsBasisScaled>)
+    .add_property("sigma2ThetaView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2Theta>)
+    .add_property("sigma2ThetaScaledView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaScaled>)
+    .add_property("sigma2ThetaObsView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObs>)
+    .add_property("sigma2ThetaObsScaledView", &getReturnValueMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObsScaled>)
+    .add_property("singularValuesView", &getReturnValueVectorView<
+      &IncrementalEstimator::MarginalResults::singularValues>)
+    .add_property("singularValuesScaledView", &getReturnValueVectorView<
+      &IncrementalEstimator::MarginalResults::singularValuesScaled>)
     ;
 
   /// Functions for querying the options
@@ -170,8 +360,14 @@ void exportIncrementalEstimator() {
     .def("getLinearSolverOptions", getLinearSolverOptions,
       return_internal_reference<>())
     .def("addBatch", &IncrementalEstimator::addBatch)
+    .def("scoreBatches", &scoreBatches)
+    .def("addBatches", &addBatches)
     .def("reoptimize", &IncrementalEstimator::reoptimize)
+    .def("saveCheckpoint", &IncrementalEstimator::saveCheckpoint)
+    .def("loadCheckpoint", &loadCheckpoint)
     .def("getNumBatches", &IncrementalEstimator::getNumBatches)
+    .def("getPriorBatch", &IncrementalEstimator::getPriorBatch)
+    .def("getNumEvictedBatches", &IncrementalEstimator::getNumEvictedBatches)
     .def("removeBatch", removeBatch1)
     .def("removeBatch", removeBatch2)
     .def("getMargGroupId", &IncrementalEstimator::getMargGroupId)
@@ -188,6 +384,8 @@ void exportIncrementalEstimator() {
     .def("getPeakMemoryUsage", &IncrementalEstimator::getPeakMemoryUsage)
     .def("getMemoryUsage", &IncrementalEstimator::getMemoryUsage)
     .def("getNumFlops", &IncrementalEstimator::getNumFlops)
+    .def("getNumSymbolicFactorizations",
+      &IncrementalEstimator::getNumSymbolicFactorizations)
     .def("getNobsBasis", &getNobsBasis)
     .def("getNobsBasisScaled", &getNobsBasisScaled)
     .def("getObsBasis", &getObsBasis)
@@ -200,5 +398,30 @@ void exportIncrementalEstimator() {
     .def("getScaledSingularValues", &getScaledSingularValues)
     .def("getProblem", &IncrementalEstimator::getProblem,
       boost::python::return_internal_reference<>())
+    .def("getJacobianTransposeCsc", &getJacobianTransposeCsc,
+      "getJacobianTransposeCsc() -- (data, indices, indptr, shape) of J^T "
+      "for scipy.sparse.csc_matrix")
+    .def("getNobsBasisView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::nobsBasis>,
+      "getNobsBasisView() -- Read-only view, keeps the current marginal "
+      "results alive")
+    .def("getNobsBasisScaledView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::nobsBasisScaled>)
+    .def("getObsBasisView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::obsBasis>)
+    .def("getObsBasisScaledView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::obsBasisScaled>)
+    .def("getSigma2ThetaView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2Theta>)
+    .def("getSigma2ThetaScaledView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaScaled>)
+    .def("getSigma2ThetaObsView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObs>)
+    .def("getSigma2ThetaObsScaledView", &getMatrixView<
+      &IncrementalEstimator::MarginalResults::sigma2ThetaObsScaled>)
+    .def("getSingularValuesView", &getVectorView<
+      &IncrementalEstimator::MarginalResults::singularValues>)
+    .def("getScaledSingularValuesView", &getVectorView<
+      &IncrementalEstimator::MarginalResults::singularValuesScaled>)
     ;
 }
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Paul Furgale and Jerome Maye                         *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file NumpyViews.cpp
+    \brief This file defines read-only NumPy views on Eigen data and the
+           export of sparse matrices as SciPy CSC triples.
+  */
+
+#include <cstring>
+
+#include <boost/python.hpp>
+
+#include <numpy/arrayobject.h>
+
+#include <Eigen/Core>
+
+#include <cholmod.h>
+
+using namespace boost::python;
+
+/// Imports the NumPy C API for this translation unit
+void importNumpyViews() {
+  if (_import_array() < 0)
+    throw_error_already_set();
+}
+
+/// Wraps data in a read-only array keeping owner alive
+object createView(int numDims, npy_intp* dims, npy_intp* strides,
+    const double* data, const object& owner) {
+  if (data == NULL)
+    return object(handle<>(PyArray_ZEROS(numDims, dims, NPY_DOUBLE, 1)));
+  PyObject* array = PyArray_New(&PyArray_Type, numDims, dims, NPY_DOUBLE,
+    strides, const_cast<double*>(data), 0, NPY_ARRAY_F_CONTIGUOUS, NULL);
+  if (array == NULL)
+    throw_error_already_set();
+  Py_INCREF(owner.ptr());
+  if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array),
+      owner.ptr()) < 0) {
+    Py_DECREF(array);
+    throw_error_already_set();
+  }
+  return object(handle<>(array));
+}
+
+/// Returns a read-only view on a column-major matrix owned by owner
+object createMatrixView(const Eigen::MatrixXd& matrix, const object& owner) {
+  npy_intp dims[2] = {matrix.rows(), matrix.cols()};
+  npy_intp strides[2] = {sizeof(double), matrix.rows() *
+    static_cast<npy_intp>(sizeof(double))};
+  return createView(2, dims, strides, matrix.data(), owner);
+}
+
+/// Returns a read-only view on a vector owned by owner
+object createVectorView(const Eigen::VectorXd& vector, const object& owner) {
+  npy_intp dims[1] = {vector.size()};
+  npy_intp strides[1] = {sizeof(double)};
+  return createView(1, dims, strides, vector.data(), owner);
+}
+
+/// Copies a packed cholmod matrix into a (data, indices, indptr, shape) tuple
+tuple createCscTriple(const cholmod_sparse& matrix) {
+  npy_intp numCols = matrix.ncol;
+  npy_intp numColPtrs = numCols + 1;
+  const SuiteSparse_long* colPtr =
+    static_cast<const SuiteSparse_long*>(matrix.p);
+  npy_intp nnz = colPtr != NULL ? colPtr[numCols] : 0;
+  object data(handle<>(PyArray_SimpleNew(1, &nnz, NPY_DOUBLE)));
+  object indices(handle<>(PyArray_SimpleNew(1, &nnz, NPY_INT64)));
+  object indptr(handle<>(PyArray_SimpleNew(1, &numColPtrs, NPY_INT64)));
+  if (nnz > 0) {
+    std::memcpy(PyArray_DATA(reinterpret_cast<PyArrayObject*>(data.ptr())),
+      matrix.x, nnz * sizeof(double));
+    std::memcpy(PyArray_DATA(reinterpret_cast<PyArrayObject*>(
+      indices.ptr())), matrix.i, nnz * sizeof(SuiteSparse_long));
+  }
+  if (colPtr != NULL)
+    std::memcpy(PyArray_DATA(reinterpret_cast<PyArrayObject*>(
+      indptr.ptr())), colPtr, numColPtrs * sizeof(SuiteSparse_long));
+  else
+    PyArray_FILLWBYTE(reinterpret_cast<PyArrayObject*>(indptr.ptr()), 0);
+  return make_tuple(data, indices, indptr, make_tuple(matrix.nrow,
+    matrix.ncol));
+}
@@ -0,0 +1,90 @@
+"""Loader for the chunked columnar files written by ColumnarWriter.
+
+The header holds the magic word, the format version, the number of columns
+and, for each column, its type, the length of its name and the name padded
+with zeros to 8 bytes. Each chunk then holds its number of rows followed by
+the values of every column in turn. Everything is stored as little-endian
+8-byte words, such that the columns of a chunk are views into a memory map.
+
+This module only depends on numpy and can be used without the compiled
+package, e.g., python columnar.py fwData.bin
+"""
+
+import sys
+
+import numpy as np
+
+MAGIC = b'ASLMCOLS'
+VERSION = 1
+TYPES = {0: np.dtype('<f8'), 1: np.dtype('<i8')}
+
+
+def _parseHeader(words, data):
+    if data[:8].tobytes() != MAGIC:
+        raise ValueError('not a columnar file')
+    if words[1] != VERSION:
+        raise ValueError('unsupported columnar version %d' % words[1])
+    numColumns = int(words[2])
+    offset = 3
+    columns = []
+    for i in range(numColumns):
+        columnType = int(words[offset])
+        nameLength = int(words[offset + 1])
+        if columnType not in TYPES:
+            raise ValueError('unknown column type %d' % columnType)
+        start = (offset + 2) * 8
+        name = data[start:start + nameLength].tobytes().decode('utf-8')
+        columns.append((name, TYPES[columnType]))
+        offset += 2 + (nameLength + 7) // 8
+    return columns, offset
+
+
+def chunks(fileName):
+    """Yields one dictionary of column views per chunk, without copying."""
+    data = np.memmap(fileName, dtype=np.uint8, mode='r')
+    if data.size % 8:
+        raise ValueError('truncated columnar file')
+    words = data.view('<u8')
+    columns, offset = _parseHeader(words, data)
+    while offset < words.size:
+        numRows = int(words[offset])
+        offset += 1
+        if offset + numRows * len(columns) > words.size:
+            raise ValueError('truncated columnar chunk')
+        chunk = {}
+        for name, dtype in columns:
+            chunk[name] = words[offset:offset + numRows].view(dtype)
+            offset += numRows
+        yield chunk
+
+
+def columns(fileName):
+    """Returns the (name, dtype) pairs of the columns of a file."""
+    data = np.memmap(fileName, dtype=np.uint8, mode='r')
+    return _parseHeader(data[:data.size - data.size % 8].view('<u8'), data)[0]
+
+
+def load(fileName):
+    """Returns a dictionary of columns, concatenated over the chunks."""
+    names = columns(fileName)
+    parts = dict((name, []) for name, dtype in names)
+    for chunk in chunks(fileName):
+        for name in chunk:
+            parts[name].append(chunk[name])
+    table = {}
+    for name, dtype in names:
+        if len(parts[name]) == 1:
+            table[name] = parts[name][0]
+        elif parts[name]:
+            table[name] = np.concatenate(parts[name])
+        else:
+            table[name] = np.empty(0, dtype=dtype)
+    return table
+
+
+if __name__ == '__main__':
+    for fileName in sys.argv[1:]:
+        table = load(fileName)
+        for name, dtype in columns(fileName):
+            print('%s %s: %s [%d rows]' % (fileName, name, dtype,
+                table[name].size))
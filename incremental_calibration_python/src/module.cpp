@@ -23,11 +23,13 @@
 #include <numpy_eigen/boost_python_headers.hpp>
 
 //void exportVisionDataAssociation();
+void importNumpyViews();
 void exportOptimizationProblem();
 void exportIncrementalEstimator();
 void exportLinearSolver();
 
 BOOST_PYTHON_MODULE(libincremental_calibration_python) {
+  importNumpyViews();
   exportOptimizationProblem();
   exportIncrementalEstimator();
   exportLinearSolver();